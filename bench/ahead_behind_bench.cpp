@@ -0,0 +1,147 @@
+#include "bench.hpp"
+
+#include "core/ahead_behind.hpp"
+#include "core/branches.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr int runs = 3;
+// Pairs checked against git, one fork each
+constexpr size_t max_checked_pairs = 50;
+
+std::string rev_parse(infra::GitProcessExecutor &executor,
+                      const std::string &rev) {
+  auto result = executor.execute({"rev-parse", rev});
+  if (result.exit_code != 0) {
+    throw SlayerGitException("rev-parse " + rev + " failed");
+  }
+  return result.stdout_output.substr(0, result.stdout_output.find('\n'));
+}
+
+core::AheadBehind git_count(infra::GitProcessExecutor &executor,
+                            const core::TrackingPair &pair) {
+  auto result = executor.execute(
+      {"rev-list", "--left-right", "--count", pair.tip + "..." + pair.upstream});
+  core::AheadBehind counts;
+  std::istringstream(result.stdout_output) >> counts.ahead >> counts.behind;
+  return counts;
+}
+
+std::vector<core::AheadBehind> cold_count(infra::GitProcessExecutor &executor,
+                                          const std::vector<core::TrackingPair>
+                                              &pairs) {
+  core::AheadBehindCounter counter(executor);
+  return counter.count(pairs);
+}
+
+void check(const std::vector<core::AheadBehind> &expected,
+           const std::vector<core::AheadBehind> &actual,
+           const std::vector<core::TrackingPair> &pairs,
+           const std::string &what) {
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (!(expected[i] == actual[i])) {
+      throw SlayerGitException(
+          what + " disagrees on " + pairs[i].tip + "..." + pairs[i].upstream +
+          ": " + std::to_string(actual[i].ahead) + "/" +
+          std::to_string(actual[i].behind) + " instead of " +
+          std::to_string(expected[i].ahead) + "/" +
+          std::to_string(expected[i].behind));
+    }
+  }
+}
+
+} // namespace
+
+// Every local branch against HEAD, as if HEAD's branch were their
+// upstream: one batched walk (with and without a commit-graph) against one
+// `git rev-list --left-right --count` per branch. Fails if any count
+// differs from git's.
+SLAYERGIT_BENCH(ahead_behind) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  std::string head = rev_parse(executor, "HEAD");
+  std::vector<core::TrackingPair> pairs;
+  for (const auto &branch : core::list_branches(executor)) {
+    pairs.push_back({branch.hash, head});
+  }
+  if (pairs.empty()) {
+    throw SlayerGitException("repository has no branches");
+  }
+  context.report("branches", static_cast<double>(pairs.size()), "count");
+
+  // The naive path, on a sample
+  size_t checked = std::min(pairs.size(), max_checked_pairs);
+  std::vector<core::AheadBehind> expected(checked);
+  double fork = time_us([&] {
+    for (size_t i = 0; i < checked; ++i) {
+      expected[i] = git_count(executor, pairs[i]);
+    }
+  });
+  context.report("fork_per_branch", fork / 1000.0 / checked, "ms");
+  context.report("fork_all_estimate", fork / 1000.0 / checked * pairs.size(),
+                 "ms");
+
+  std::vector<core::AheadBehind> without_graph;
+  double loaded = median_us(
+      runs, [&] { without_graph = cold_count(executor, pairs); });
+  check(expected, without_graph, pairs, "batch without commit-graph");
+  context.report("batch_without_graph", loaded / 1000.0, "ms");
+
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-ahead-behind-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  // A --shared clone gets the graph, so the repository is left alone
+  std::string clone = (scratch / "graph.git").string();
+  if (executor.execute({"clone", "-q", "--bare", "--shared", ".", clone})
+              .exit_code != 0 ||
+      infra::GitProcessExecutor(clone)
+              .execute({"commit-graph", "write", "--reachable"})
+              .exit_code != 0) {
+    throw SlayerGitException("cannot write a commit-graph");
+  }
+  infra::GitProcessExecutor graph_executor(clone);
+  std::vector<core::AheadBehind> with_graph;
+  double walked = median_us(
+      runs, [&] { with_graph = cold_count(graph_executor, pairs); });
+  check(without_graph, with_graph, pairs, "batch with commit-graph");
+  context.report("batch_with_graph", walked / 1000.0, "ms");
+
+  // After a "fetch" that moved one upstream, only its pair is walked again
+  core::AheadBehindCounter counter(graph_executor);
+  counter.count(pairs);
+  auto moved = pairs;
+  moved.front().tip = rev_parse(executor, moved.front().tip + "~1");
+  core::AheadBehindCounter::Stats before = counter.stats();
+  double refresh = time_us([&] { counter.count(moved); });
+  core::AheadBehindCounter::Stats after = counter.stats();
+  if (after.computed - before.computed != 1) {
+    throw SlayerGitException("cache recomputed unchanged pairs");
+  }
+  check({git_count(executor, moved.front())}, {counter.count(moved).front()},
+        moved, "refresh");
+  context.report("refresh_one_moved", refresh / 1000.0, "ms");
+  context.report("commits_walked",
+                 static_cast<double>(after.commits_walked -
+                                     before.commits_walked),
+                 "count");
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace slayergit::bench {
+
+struct BenchOptions {
+  std::string repo_path = ".";
+  // Names the repository in results: a preset, a shape key or the path
+  std::string repo_label = ".";
+  std::string filter;
+  // Snapshot directory for render benchmarks; empty disables comparisons
+  std::string golden_dir;
+  bool update_golden = false;
+};
+
+// Handed to each benchmark; collects its measurements
+class BenchContext {
+public:
+  struct Measurement {
+    std::string metric;
+    double value;
+    std::string unit;
+  };
+
+  BenchContext(std::string name, BenchOptions options)
+      : name_(std::move(name)), options_(std::move(options)) {}
+
+  [[nodiscard]] const std::string &name() const { return name_; }
+  [[nodiscard]] const std::string &repo_path() const {
+    return options_.repo_path;
+  }
+  [[nodiscard]] const std::string &repo_label() const {
+    return options_.repo_label;
+  }
+  [[nodiscard]] const std::string &golden_dir() const {
+    return options_.golden_dir;
+  }
+  [[nodiscard]] bool update_golden() const { return options_.update_golden; }
+
+  void report(const std::string &metric, double value,
+              const std::string &unit);
+
+  [[nodiscard]] const std::vector<Measurement> &measurements() const {
+    return measurements_;
+  }
+
+private:
+  std::string name_;
+  BenchOptions options_;
+  std::vector<Measurement> measurements_;
+};
+
+using BenchFunction = std::function<void(BenchContext &)>;
+
+bool register_bench(const std::string &name, BenchFunction function);
+std::vector<std::pair<std::string, BenchFunction>> &registered_benches();
+
+// Wall time of `function` in microseconds
+template <typename Function> double time_us(Function &&function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Median wall time of `runs` calls, in microseconds
+template <typename Function> double median_us(int runs, Function &&function) {
+  std::vector<double> samples;
+  for (int i = 0; i < runs; ++i) {
+    samples.push_back(time_us(function));
+  }
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+} // namespace slayergit::bench
+
+#define SLAYERGIT_BENCH(name)                                                  \
+  static void bench_##name(::slayergit::bench::BenchContext &);               \
+  static const bool bench_##name##_registered =                               \
+      ::slayergit::bench::register_bench(#name, bench_##name);                \
+  static void bench_##name(::slayergit::bench::BenchContext &context)
@@ -0,0 +1,218 @@
+#include "bench.hpp"
+#include "repo_generator.hpp"
+
+#include "infra/git_process_executor.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace slayergit::bench {
+
+void BenchContext::report(const std::string &metric, double value,
+                          const std::string &unit) {
+  measurements_.push_back(Measurement{metric, value, unit});
+  std::printf("  %-40s %14.3f %s\n", metric.c_str(), value, unit.c_str());
+}
+
+std::vector<std::pair<std::string, BenchFunction>> &registered_benches() {
+  static std::vector<std::pair<std::string, BenchFunction>> benches;
+  return benches;
+}
+
+bool register_bench(const std::string &name, BenchFunction function) {
+  registered_benches().emplace_back(name, std::move(function));
+  return true;
+}
+
+} // namespace slayergit::bench
+
+using namespace slayergit;
+using namespace slayergit::bench;
+
+namespace {
+
+struct Result {
+  std::string bench;
+  std::string repo;
+  BenchContext::Measurement measurement;
+};
+
+std::string json_string(const std::string &text) {
+  std::string out = "\"";
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      } else {
+        out += c;
+      }
+    }
+  }
+  return out + "\"";
+}
+
+// One flat record per measurement so runs can be joined on
+// (bench, repo, metric) and compared
+void write_json(const std::string &path, const std::vector<Result> &results) {
+  infra::GitProcessExecutor executor(".");
+  std::string git_version = executor.execute({"--version"}).stdout_output;
+  while (!git_version.empty() && git_version.back() == '\n') {
+    git_version.pop_back();
+  }
+
+  std::ofstream out(path);
+  out << "{\n  \"git_version\": " << json_string(git_version)
+      << ",\n  \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto &r = results[i];
+    char value[64];
+    std::snprintf(value, sizeof(value), "%.6g", r.measurement.value);
+    out << (i == 0 ? "\n" : ",\n") << "    {\"bench\": " << json_string(r.bench)
+        << ", \"repo\": " << json_string(r.repo)
+        << ", \"metric\": " << json_string(r.measurement.metric)
+        << ", \"value\": " << value
+        << ", \"unit\": " << json_string(r.measurement.unit) << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+void print_usage() {
+  std::fprintf(
+      stderr,
+      "usage: slayergit_bench [--repo PATH] [--size NAME]... [--shape SPEC]...\n"
+      "                       [--work-dir DIR] [--json FILE] [--filter TEXT]\n"
+      "                       [--golden-dir DIR [--update-golden]]\n"
+      "                       [--generate-only] [--list]\n"
+      "  --size   generated repository preset: small, medium, large, merges\n"
+      "  --shape  custom shape, e.g. files=500000,commits=1000000,merge_every=4\n"
+      "  --golden-dir  compare rendered frames with snapshots in DIR; missing\n"
+      "                snapshots are written, --update-golden rewrites all\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  std::vector<std::pair<std::string, RepoShape>> shapes;
+  std::string work_dir =
+      (std::filesystem::temp_directory_path() / "slayergit-bench").string();
+  std::string json_path;
+  bool list_only = false;
+  bool generate_only = false;
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--repo" && i + 1 < argc) {
+        options.repo_path = argv[++i];
+        options.repo_label = options.repo_path;
+      } else if (arg == "--size" && i + 1 < argc) {
+        std::string name = argv[++i];
+        shapes.emplace_back(name, RepoShape::preset(name));
+      } else if (arg == "--shape" && i + 1 < argc) {
+        auto shape = RepoShape::parse(argv[++i]);
+        shapes.emplace_back(shape.key(), shape);
+      } else if (arg == "--work-dir" && i + 1 < argc) {
+        work_dir = argv[++i];
+      } else if (arg == "--json" && i + 1 < argc) {
+        json_path = argv[++i];
+      } else if (arg == "--filter" && i + 1 < argc) {
+        options.filter = argv[++i];
+      } else if (arg == "--golden-dir" && i + 1 < argc) {
+        options.golden_dir = argv[++i];
+      } else if (arg == "--update-golden") {
+        options.update_golden = true;
+      } else if (arg == "--generate-only") {
+        generate_only = true;
+      } else if (arg == "--list") {
+        list_only = true;
+      } else {
+        print_usage();
+        return 2;
+      }
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 2;
+  }
+
+  if (list_only) {
+    for (const auto &[name, function] : registered_benches()) {
+      std::printf("%s\n", name.c_str());
+    }
+    return 0;
+  }
+
+  // Each benchmark runs once per repository
+  std::vector<BenchOptions> targets;
+  if (shapes.empty()) {
+    targets.push_back(options);
+  }
+  for (const auto &[label, shape] : shapes) {
+    BenchOptions target = options;
+    target.repo_path =
+        (std::filesystem::path(work_dir) / shape.key()).string();
+    target.repo_label = label;
+    std::printf("generating %s in %s\n", label.c_str(),
+                target.repo_path.c_str());
+    std::fflush(stdout);
+    try {
+      double seconds = time_us([&] {
+                         generate_repo(target.repo_path, shape);
+                       }) /
+                       1e6;
+      std::printf("  ready after %.1fs\n", seconds);
+    } catch (const std::exception &e) {
+      std::fprintf(stderr, "  FAILED: %s\n", e.what());
+      return 1;
+    }
+    targets.push_back(target);
+  }
+  if (generate_only) {
+    return 0;
+  }
+
+  int failures = 0;
+  std::vector<Result> results;
+  for (const auto &target : targets) {
+    for (const auto &[name, function] : registered_benches()) {
+      if (!options.filter.empty() &&
+          name.find(options.filter) == std::string::npos) {
+        continue;
+      }
+
+      std::printf("%s [%s]\n", name.c_str(), target.repo_label.c_str());
+      BenchContext context(name, target);
+      try {
+        function(context);
+      } catch (const std::exception &e) {
+        std::fprintf(stderr, "  FAILED: %s\n", e.what());
+        ++failures;
+      }
+      for (const auto &measurement : context.measurements()) {
+        results.push_back(Result{name, target.repo_label, measurement});
+      }
+    }
+  }
+
+  if (!json_path.empty()) {
+    write_json(json_path, results);
+  }
+  return failures == 0 ? 0 : 1;
+}
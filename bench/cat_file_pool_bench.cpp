@@ -0,0 +1,86 @@
+#include "bench.hpp"
+
+#include "infra/cat_file_pool.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr size_t object_count = 200;
+
+std::vector<std::string> list_objects(infra::GitProcessExecutor &executor) {
+  auto result = executor.execute({"rev-list", "--objects", "--all",
+                                  "--max-count=" +
+                                      std::to_string(object_count)});
+  std::vector<std::string> oids;
+  std::istringstream stream(result.stdout_output);
+  std::string line;
+  while (oids.size() < object_count && std::getline(stream, line)) {
+    oids.push_back(line.substr(0, line.find(' ')));
+  }
+  return oids;
+}
+
+} // namespace
+
+// Per-object latency of one `git cat-file -p` fork versus the coprocess pool
+SLAYERGIT_BENCH(cat_file_pool) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  auto oids = list_objects(executor);
+  if (oids.empty()) {
+    throw SlayerGitException("repository has no objects");
+  }
+  const auto count = static_cast<double>(oids.size());
+  context.report("objects", count, "count");
+
+  double fork_us = time_us([&] {
+    for (const auto &oid : oids) {
+      executor.execute({"cat-file", "-p", oid});
+    }
+  });
+  context.report("fork_per_object", fork_us / count, "us/object");
+
+  infra::CatFilePool pool(context.repo_path());
+  // Warm the workers so process start-up is not attributed to the first read
+  pool.read_object(oids.front()).get();
+
+  double sequential_us = time_us([&] {
+    for (const auto &oid : oids) {
+      pool.read_object(oid).get();
+    }
+  });
+  context.report("pool_sequential", sequential_us / count, "us/object");
+
+  double pipelined_us = time_us([&] {
+    std::vector<std::future<infra::GitObject>> futures;
+    futures.reserve(oids.size());
+    for (const auto &oid : oids) {
+      futures.push_back(pool.read_object(oid));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+  });
+  context.report("pool_pipelined", pipelined_us / count, "us/object");
+
+  double info_us = time_us([&] {
+    std::vector<std::future<infra::ObjectInfo>> futures;
+    futures.reserve(oids.size());
+    for (const auto &oid : oids) {
+      futures.push_back(pool.object_info(oid));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+  });
+  context.report("pool_info_pipelined", info_us / count, "us/object");
+  context.report("speedup_sequential", fork_us / sequential_us, "x");
+}
@@ -0,0 +1,205 @@
+#include "bench.hpp"
+
+#include "core/commit_graph.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+#include "infra/process.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+
+namespace {
+
+constexpr int runs = 5;
+
+struct LogEntry {
+  std::string hash;
+  int64_t commit_time = 0;
+  std::vector<std::string> parents;
+};
+
+// What the fork path costs: git formats, we parse
+std::vector<LogEntry> git_log(infra::GitProcessExecutor &executor) {
+  auto result = executor.execute({"log", "--all", "--format=%H %ct %P"});
+  std::vector<LogEntry> entries;
+  std::istringstream stream(result.stdout_output);
+  std::string line;
+  while (std::getline(stream, line)) {
+    std::istringstream fields(line);
+    LogEntry entry;
+    fields >> entry.hash >> entry.commit_time;
+    std::string parent;
+    while (fields >> parent) {
+      entry.parents.push_back(parent);
+    }
+    entries.push_back(std::move(entry));
+  }
+  return entries;
+}
+
+void check_exit(const infra::ProcessResult &result, const std::string &what) {
+  if (result.exit_code != 0) {
+    throw SlayerGitException(what + " failed: " + result.stderr_output);
+  }
+}
+
+// A --shared bare clone borrows the objects, so writing its commit-graph
+// leaves the repository under test alone
+std::string make_clone(const std::string &repo_path,
+                       const std::filesystem::path &scratch,
+                       const std::string &name) {
+  std::string clone = (scratch / name).string();
+  infra::GitProcessExecutor executor(repo_path);
+  check_exit(executor.execute({"clone", "-q", "--bare", "--shared", ".",
+                               clone}),
+             "clone");
+  return clone;
+}
+
+// Two layers: everything reachable from `base_commit`, then the rest
+void write_split_chain(const std::string &clone,
+                       const std::string &base_commit) {
+  infra::SpawnOptions options;
+  options.pipe_stdin = true;
+  options.pipe_stdout = false;
+  options.pipe_stderr = false;
+  auto child = infra::ChildProcess::spawn(
+      {"git", "-C", clone, "commit-graph", "write", "--split",
+       "--stdin-commits"},
+      options);
+  std::string line = base_commit + "\n";
+  // One line always fits in the pipe buffer
+  if (::write(child.stdin_fd(), line.data(), line.size()) !=
+      static_cast<ssize_t>(line.size())) {
+    throw SlayerGitException("cannot write to git");
+  }
+  child.close_stdin();
+  if (child.wait() != 0) {
+    throw SlayerGitException("commit-graph write --split failed");
+  }
+
+  infra::GitProcessExecutor executor(clone);
+  check_exit(executor.execute({"commit-graph", "write", "--reachable",
+                               "--split=no-merge"}),
+             "commit-graph write");
+}
+
+// Every commit git reports must be in the graph with the same parents and
+// date, and generations must grow from parent to child
+void check_conformance(const core::CommitGraph &graph,
+                       const std::vector<LogEntry> &log) {
+  std::vector<uint32_t> parents;
+  for (const auto &entry : log) {
+    uint32_t position = graph.find_hex(entry.hash);
+    if (position == core::CommitGraph::no_position) {
+      throw SlayerGitException("commit-graph misses " + entry.hash);
+    }
+    if (core::CommitGraph::to_hex(graph.oid(position)) != entry.hash ||
+        graph.commit_time(position) != entry.commit_time) {
+      throw SlayerGitException("commit-graph disagrees on " + entry.hash);
+    }
+    graph.parents(position, parents);
+    if (parents.size() != entry.parents.size()) {
+      throw SlayerGitException("parent count differs for " + entry.hash);
+    }
+    for (size_t i = 0; i < parents.size(); ++i) {
+      if (core::CommitGraph::to_hex(graph.oid(parents[i])) !=
+              entry.parents[i] ||
+          graph.generation(parents[i]) >= graph.generation(position)) {
+        throw SlayerGitException("parent " + std::to_string(i) +
+                                 " differs for " + entry.hash);
+      }
+    }
+  }
+}
+
+void measure(bench::BenchContext &context, const std::string &prefix,
+             const std::string &repo, const std::vector<LogEntry> &log) {
+  auto graph = core::CommitGraph::open_repository(repo);
+  if (!graph) {
+    throw SlayerGitException("no commit-graph in " + repo);
+  }
+  check_conformance(*graph, log);
+  context.report(prefix + ".layers", static_cast<double>(graph->layer_count()),
+                 "count");
+
+  // Open, then visit every commit's parents and date, as a history walk
+  // would
+  double walk = median_us(runs, [&] {
+    auto opened = core::CommitGraph::open_repository(repo);
+    std::vector<uint32_t> parents;
+    int64_t newest = 0;
+    for (uint32_t position = 0; position < opened->size(); ++position) {
+      opened->parents(position, parents);
+      newest = std::max(newest, opened->commit_time(position));
+    }
+    if (newest == 0) {
+      throw SlayerGitException("empty walk");
+    }
+  });
+  context.report(prefix + ".walk", walk / 1000.0, "ms");
+
+  std::vector<std::string> oids;
+  for (const auto &entry : log) {
+    oids.push_back(core::CommitGraph::from_hex(entry.hash));
+  }
+  double lookup = median_us(runs, [&] {
+    for (const auto &oid : oids) {
+      if (graph->find(oid) == core::CommitGraph::no_position) {
+        throw SlayerGitException("lookup failed");
+      }
+    }
+  });
+  context.report(prefix + ".lookup", lookup * 1000.0 / oids.size(),
+                 "ns/oid");
+}
+
+} // namespace
+
+// Parents and dates for the whole history from the commit-graph file
+// against `git log`, for a single file and a two-layer split chain. Fails
+// if the graph disagrees with git about any commit.
+SLAYERGIT_BENCH(commit_graph) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  std::vector<LogEntry> log;
+  double fork = median_us(runs, [&] { log = git_log(executor); });
+  if (log.size() < 2) {
+    throw SlayerGitException("repository has too few commits");
+  }
+  context.report("commits", static_cast<double>(log.size()), "count");
+  context.report("git_log", fork / 1000.0, "ms");
+
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-graph-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  std::string single = make_clone(context.repo_path(), scratch, "single.git");
+  check_exit(infra::GitProcessExecutor(single).execute(
+                 {"commit-graph", "write", "--reachable"}),
+             "commit-graph write");
+  measure(context, "single", single, log);
+
+  std::string split = make_clone(context.repo_path(), scratch, "split.git");
+  write_split_chain(split, log[log.size() / 2].hash);
+  measure(context, "split", split, log);
+
+  // Without a graph, callers must get nullptr and use git instead
+  std::string bare = make_clone(context.repo_path(), scratch, "none.git");
+  if (core::CommitGraph::open_repository(bare)) {
+    throw SlayerGitException("found a commit-graph in a fresh clone");
+  }
+}
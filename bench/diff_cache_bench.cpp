@@ -0,0 +1,245 @@
+#include "bench.hpp"
+
+#include "core/diff_cache.hpp"
+#include "infra/cat_file_pool.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/diff/diff_engine.hpp"
+#include "infra/git_process_executor.hpp"
+#include "infra/parsers/diff_parser.hpp"
+#include "infra/task_executor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr size_t max_rows = 120;
+// Time between cursor moves, roughly a held-down arrow key
+constexpr auto key_repeat = std::chrono::milliseconds(30);
+// The tight-budget walk keeps a quarter of what the full walk cached
+constexpr size_t small_budget_divisor = 4;
+// Recent commits whose cached diffs are checked against `git show`
+constexpr size_t checked_commits = 20;
+
+// Blob pairs of files modified in recent history, one per "row"
+std::vector<core::DiffKey> history_keys(infra::GitProcessExecutor &executor) {
+  auto result = executor.execute({"log", "--no-merges", "--raw", "--no-abbrev",
+                                  "--format=", "--diff-filter=M", "-n", "500",
+                                  "HEAD"});
+  std::set<std::pair<std::string, std::string>> seen;
+  std::vector<core::DiffKey> keys;
+  std::istringstream stream(result.stdout_output);
+  std::string line;
+  while (keys.size() < max_rows && std::getline(stream, line)) {
+    std::istringstream fields(line);
+    std::string old_mode, new_mode, old_oid, new_oid;
+    fields >> old_mode >> new_mode >> old_oid >> new_oid;
+    if (old_mode == ":100644" && new_mode == "100644" &&
+        seen.emplace(old_oid, new_oid).second) {
+      keys.push_back({old_oid, new_oid, {}, {}});
+    }
+  }
+  return keys;
+}
+
+// What the Log tab shows for each recent commit, from commit_changes() and
+// the loader, against `git show` of the same commit
+void check_commits(infra::GitProcessExecutor &executor,
+                   const core::DiffCache::Loader &loader) {
+  auto result = executor.execute(
+      {"rev-list", "-n", std::to_string(checked_commits), "HEAD"});
+  std::istringstream stream(result.stdout_output);
+  std::string commit;
+  while (std::getline(stream, commit)) {
+    std::vector<std::string> args{"show", "--format=",
+                                  "--diff-merges=first-parent"};
+    auto diff_args = infra::DiffParser::diff_args();
+    args.insert(args.end(), diff_args.begin() + 1, diff_args.end());
+    args.push_back(commit);
+    auto expected =
+        infra::DiffParser::parse(executor.execute(args).stdout_output).files;
+    auto entries = core::commit_changes(executor, commit);
+    if (entries.size() != expected.size()) {
+      throw SlayerGitException(commit + ": " + std::to_string(entries.size()) +
+                               " files, git shows " +
+                               std::to_string(expected.size()));
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+      auto actual = core::with_paths(entries[i], loader(entries[i].key, {}));
+      const auto &file = expected[i];
+      if (actual.new_path != file.new_path ||
+          (!file.is_binary &&
+           infra::DiffEngine::format_hunks(actual) !=
+               infra::DiffEngine::format_hunks(file))) {
+        throw SlayerGitException(commit + ": " + file.new_path +
+                                 " differs from git show");
+      }
+    }
+  }
+}
+
+// A get() that joins another caller's load follows its own token: it
+// loads the diff itself when that caller is cancelled, and gives up as
+// soon as it is cancelled itself
+void check_joined_cancellation(infra::TaskExecutor &tasks) {
+  std::mutex mutex;
+  std::condition_variable changed;
+  int started = 0;
+  core::DiffCache cache(tasks, [&](const core::DiffKey &,
+                                   const infra::CancellationToken &token) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ++started;
+    changed.notify_all();
+    // The first load runs until its caller is cancelled
+    if (started == 1) {
+      while (!token.cancelled()) {
+        changed.wait_for(lock, std::chrono::milliseconds(1));
+      }
+      token.throw_if_cancelled();
+    }
+    return core::FileDiff{};
+  });
+  core::DiffKey key{"old", "new", {}, {}};
+  auto wait_for_loads = [&](int count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return started >= count; });
+  };
+
+  infra::CancellationSource owner;
+  auto owned = std::async(std::launch::async,
+                          [&] { return cache.get(key, owner.token()); });
+  wait_for_loads(1);
+  auto joined = std::async(std::launch::async, [&] { return cache.get(key); });
+  std::this_thread::sleep_for(key_repeat);
+  owner.cancel();
+  try {
+    owned.get();
+    throw SlayerGitException("a cancelled get() returned a diff");
+  } catch (const CancelledException &) {
+  }
+  if (!joined.get() || started != 2) {
+    throw SlayerGitException("a get() gave up with another caller's load");
+  }
+
+  // Cancelled while waiting: returns without waiting for the load
+  cache.clear();
+  started = 0;
+  infra::CancellationSource first;
+  infra::CancellationSource second;
+  auto slow = std::async(std::launch::async,
+                         [&] { return cache.get(key, first.token()); });
+  wait_for_loads(1);
+  auto waiting = std::async(std::launch::async,
+                            [&] { return cache.get(key, second.token()); });
+  std::this_thread::sleep_for(key_repeat);
+  second.cancel();
+  if (waiting.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+    throw SlayerGitException("a cancelled get() kept waiting for a load");
+  }
+  first.cancel();
+  for (auto *result : {&slow, &waiting}) {
+    try {
+      result->get();
+    } catch (const CancelledException &) {
+    }
+  }
+}
+
+double percentile(std::vector<double> samples, double fraction) {
+  std::sort(samples.begin(), samples.end());
+  auto index = static_cast<size_t>(fraction * (samples.size() - 1));
+  return samples[index];
+}
+
+// Walks the cursor over `keys` (down, then back up), prefetching the
+// neighbours after every move like a tab would
+std::vector<double> walk(core::DiffCache &cache,
+                         const std::vector<core::DiffKey> &keys) {
+  std::vector<size_t> path;
+  for (size_t row = 0; row < keys.size(); ++row) {
+    path.push_back(row);
+  }
+  for (size_t row = keys.size(); row-- > 0;) {
+    path.push_back(row);
+  }
+
+  std::vector<double> latencies;
+  for (size_t row : path) {
+    latencies.push_back(time_us([&] { cache.get(keys[row]); }));
+    std::vector<core::DiffKey> neighbours;
+    for (size_t other : core::rows_around(row, keys.size())) {
+      neighbours.push_back(keys[other]);
+    }
+    cache.prefetch(neighbours);
+    std::this_thread::sleep_for(key_repeat);
+  }
+  return latencies;
+}
+
+void report_walk(bench::BenchContext &context, const std::string &prefix,
+                 const std::vector<double> &latencies,
+                 const core::DiffCache::Stats &stats) {
+  context.report(prefix + ".first", latencies.front(), "us");
+  context.report(prefix + ".p50", percentile(latencies, 0.50), "us");
+  context.report(prefix + ".p95", percentile(latencies, 0.95), "us");
+  context.report(prefix + ".hit_ratio", stats.hit_ratio(), "ratio");
+  context.report(prefix + ".evictions", static_cast<double>(stats.evictions),
+                 "count");
+  context.report(prefix + ".prefetched", static_cast<double>(stats.prefetched),
+                 "count");
+  context.report(prefix + ".bytes", static_cast<double>(stats.bytes), "bytes");
+}
+
+} // namespace
+
+// Commit diffs through the cache against `git show`, then cursor-move
+// latency in a diff-showing list: loading every diff on demand versus
+// DiffCache with neighbour prefetch, and under a tight byte budget
+SLAYERGIT_BENCH(diff_cache) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  auto keys = history_keys(executor);
+  if (keys.size() < 2) {
+    throw SlayerGitException("repository has too few modified files");
+  }
+  context.report("rows", static_cast<double>(keys.size()), "count");
+
+  infra::CatFilePool pool(context.repo_path());
+  infra::TaskExecutor tasks;
+  auto loader = core::DiffCache::blob_loader(pool);
+  // Warm the pool so worker start-up is not charged to the first row
+  loader(keys.front(), {});
+  check_commits(executor, loader);
+  check_joined_cancellation(tasks);
+
+  std::vector<double> uncached;
+  for (const auto &key : keys) {
+    uncached.push_back(time_us([&] { loader(key, {}); }));
+  }
+  context.report("uncached.p50", percentile(uncached, 0.50), "us");
+  context.report("uncached.p95", percentile(uncached, 0.95), "us");
+
+  size_t full_bytes = 0;
+  {
+    core::DiffCache cache(tasks, loader);
+    auto latencies = walk(cache, keys);
+    full_bytes = cache.stats().bytes;
+    report_walk(context, "prefetch", latencies, cache.stats());
+  }
+  {
+    core::DiffCache cache(tasks, loader, {full_bytes / small_budget_divisor});
+    auto latencies = walk(cache, keys);
+    report_walk(context, "small_budget", latencies, cache.stats());
+  }
+  tasks.wait_all();
+}
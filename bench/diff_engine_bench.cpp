@@ -0,0 +1,334 @@
+#include "bench.hpp"
+
+#include "infra/cat_file_pool.hpp"
+#include "infra/diff/diff_engine.hpp"
+#include "infra/diff/line_hash.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+#include "infra/parsers/diff_parser.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr size_t max_history_pairs = 200;
+constexpr size_t max_mutated_files = 120;
+constexpr size_t max_blob_bytes = size_t{1} << 20;
+constexpr size_t huge_lines = 60000;
+constexpr size_t reported_mismatches = 5;
+
+// One old/new pair; `fork_args` reproduces it with git
+struct DiffCase {
+  std::string name;
+  std::string old_text;
+  std::string new_text;
+  std::vector<std::string> fork_args;
+};
+
+struct Algorithm {
+  infra::DiffAlgorithm algorithm;
+  const char *name;
+};
+
+constexpr Algorithm algorithms[] = {
+    {infra::DiffAlgorithm::Myers, "myers"},
+    {infra::DiffAlgorithm::Histogram, "histogram"},
+};
+
+bool is_text(const std::string &data) {
+  return data.size() <= max_blob_bytes &&
+         data.find('\0') == std::string::npos;
+}
+
+std::vector<std::string> split_lines(const std::string &text) {
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    end = end == std::string::npos ? text.size() : end + 1;
+    lines.push_back(text.substr(start, end - start));
+    start = end;
+  }
+  return lines;
+}
+
+// Edits of the kinds that stress slider placement: duplicated and blank
+// lines, re-indented blocks, moves and a missing final newline
+std::string mutate(const std::string &text, std::mt19937_64 &rng) {
+  auto lines = split_lines(text);
+  if (lines.empty()) {
+    lines.emplace_back("\n");
+  }
+  auto pick = [&](size_t bound) {
+    return static_cast<size_t>(rng() % std::max<size_t>(bound, 1));
+  };
+
+  size_t edits = 1 + pick(8);
+  for (size_t e = 0; e < edits && !lines.empty(); ++e) {
+    size_t at = pick(lines.size());
+    size_t length = std::min(1 + pick(6), lines.size() - at);
+    switch (pick(7)) {
+    case 0:
+      lines.erase(lines.begin() + static_cast<long>(at),
+                  lines.begin() + static_cast<long>(at + length));
+      break;
+    case 1: {
+      // Copy a block from elsewhere, so the inserted lines have matches
+      size_t from = pick(lines.size());
+      size_t count = std::min(length, lines.size() - from);
+      std::vector<std::string> block(
+          lines.begin() + static_cast<long>(from),
+          lines.begin() + static_cast<long>(from + count));
+      lines.insert(lines.begin() + static_cast<long>(at), block.begin(),
+                   block.end());
+      break;
+    }
+    case 2:
+      lines.insert(lines.begin() + static_cast<long>(at), length, "\n");
+      break;
+    case 3:
+      for (size_t i = at; i < at + length; ++i) {
+        lines[i].insert(0, pick(2) == 0 ? "    " : "\t");
+      }
+      break;
+    case 4:
+      for (size_t i = at; i < at + length; ++i) {
+        lines[i].insert(0, "// changed ");
+      }
+      break;
+    case 5: {
+      std::vector<std::string> block(
+          lines.begin() + static_cast<long>(at),
+          lines.begin() + static_cast<long>(at + length));
+      lines.erase(lines.begin() + static_cast<long>(at),
+                  lines.begin() + static_cast<long>(at + length));
+      size_t to = pick(lines.size() + 1);
+      lines.insert(lines.begin() + static_cast<long>(to), block.begin(),
+                   block.end());
+      break;
+    }
+    default:
+      lines.insert(lines.begin() + static_cast<long>(at),
+                   "}\n\nstatic int added_" + std::to_string(rng() % 1000) +
+                       " = 0;\n");
+      break;
+    }
+  }
+
+  std::string out;
+  for (const auto &line : lines) {
+    out += line;
+  }
+  if (pick(10) == 0 && !out.empty() && out.back() == '\n') {
+    out.pop_back();
+  }
+  return out;
+}
+
+// Modified files from recent history, diffed by blob id
+void add_history_cases(infra::GitProcessExecutor &executor,
+                       infra::CatFilePool &pool, std::vector<DiffCase> &cases) {
+  auto result = executor.execute({"log", "--no-merges", "--raw", "--no-abbrev",
+                                  "--format=", "--diff-filter=M", "-n",
+                                  "1000", "HEAD"});
+  std::set<std::pair<std::string, std::string>> seen;
+  std::istringstream stream(result.stdout_output);
+  std::string line;
+  size_t added = 0;
+  while (added < max_history_pairs && std::getline(stream, line)) {
+    // ":100644 100644 <old> <new> M\t<path>"
+    std::istringstream fields(line);
+    std::string old_mode, new_mode, old_oid, new_oid;
+    fields >> old_mode >> new_mode >> old_oid >> new_oid;
+    if (old_mode != ":100644" || new_mode != "100644" ||
+        !seen.emplace(old_oid, new_oid).second) {
+      continue;
+    }
+    auto old_object = pool.read_object(old_oid).get();
+    auto new_object = pool.read_object(new_oid).get();
+    if (!is_text(old_object.data) || !is_text(new_object.data)) {
+      continue;
+    }
+    cases.push_back({line.substr(line.find('\t') + 1),
+                     std::move(old_object.data), std::move(new_object.data),
+                     {old_oid, new_oid}});
+    ++added;
+  }
+}
+
+// Files at HEAD with seeded random edits, plus one huge pair, diffed with
+// --no-index from a scratch directory
+void add_mutated_cases(infra::GitProcessExecutor &executor,
+                       infra::CatFilePool &pool,
+                       const std::filesystem::path &scratch,
+                       std::vector<DiffCase> &cases) {
+  auto result = executor.execute({"ls-tree", "-r", "HEAD"});
+  std::istringstream stream(result.stdout_output);
+  std::string line;
+  std::mt19937_64 rng(20240601);
+  std::vector<std::string> sources;
+  while (sources.size() < max_mutated_files && std::getline(stream, line)) {
+    std::istringstream fields(line);
+    std::string mode, type, oid;
+    fields >> mode >> type >> oid;
+    if (type != "blob" || mode != "100644") {
+      continue;
+    }
+    auto object = pool.read_object(oid).get();
+    if (is_text(object.data)) {
+      sources.push_back(std::move(object.data));
+    }
+  }
+
+  // Shuffled, heavily edited lines: enough differences that Myers hits its
+  // cost limit and takes the heuristic exits
+  std::string huge;
+  for (size_t i = 0; i < huge_lines; ++i) {
+    huge += "line " + std::to_string(rng() % (huge_lines / 4)) + "\n";
+  }
+  sources.push_back(huge);
+
+  size_t index = 0;
+  for (const auto &source : sources) {
+    std::string mutated = mutate(source, rng);
+    if (&source == &sources.back()) {
+      for (int i = 0; i < 400; ++i) {
+        mutated = mutate(mutated, rng);
+      }
+    }
+    auto old_path = scratch / (std::to_string(index) + ".old");
+    auto new_path = scratch / (std::to_string(index) + ".new");
+    std::ofstream(old_path, std::ios::binary) << source;
+    std::ofstream(new_path, std::ios::binary) << mutated;
+    cases.push_back({"mutated-" + std::to_string(index), source, mutated,
+                     {"--no-index", old_path.string(), new_path.string()}});
+    ++index;
+  }
+}
+
+bool same_hunks(const core::FileDiff &a, const core::FileDiff &b) {
+  return infra::DiffEngine::format_hunks(a) ==
+         infra::DiffEngine::format_hunks(b);
+}
+
+} // namespace
+
+// Conformance of the in-process diff engine with `git diff` and its cost
+// against forking git. Any hunk that differs from git's fails the run.
+SLAYERGIT_BENCH(diff_engine) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  infra::CatFilePool pool(context.repo_path());
+
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-diff-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  std::vector<DiffCase> cases;
+  add_history_cases(executor, pool, cases);
+  size_t history_cases = cases.size();
+  add_mutated_cases(executor, pool, scratch, cases);
+  context.report("history_pairs", static_cast<double>(history_cases), "count");
+  context.report("mutated_pairs",
+                 static_cast<double>(cases.size() - history_cases), "count");
+
+  double input_bytes = 0;
+  for (const auto &diff_case : cases) {
+    input_bytes += static_cast<double>(diff_case.old_text.size() +
+                                       diff_case.new_text.size());
+  }
+  double hash_us = time_us([&] {
+    for (const auto &diff_case : cases) {
+      infra::hash_lines(diff_case.old_text);
+      infra::hash_lines(diff_case.new_text);
+    }
+  });
+  context.report(std::string("line_hash.") + infra::line_hash_backend(),
+                 input_bytes / hash_us, "MB/s");
+
+  size_t mismatches = 0;
+  for (const auto &algorithm : algorithms) {
+    infra::DiffOptions options;
+    options.algorithm = algorithm.algorithm;
+
+    std::vector<core::FileDiff> forked(cases.size());
+    double fork_us = time_us([&] {
+      for (size_t i = 0; i < cases.size(); ++i) {
+        auto args = infra::DiffParser::diff_args();
+        args.push_back(std::string("--diff-algorithm=") + algorithm.name);
+        args.emplace_back("--indent-heuristic");
+        args.emplace_back("--inter-hunk-context=0");
+        args.insert(args.end(), cases[i].fork_args.begin(),
+                    cases[i].fork_args.end());
+        auto result = executor.execute(args);
+        // --no-index exits with 1 when the files differ
+        if (result.exit_code != 0 && result.exit_code != 1) {
+          throw GitCommandException("git diff", result.exit_code,
+                                    result.stderr_output);
+        }
+        auto parsed = infra::DiffParser::parse(result.stdout_output);
+        if (!parsed.files.empty()) {
+          forked[i] = std::move(parsed.files.front());
+        }
+      }
+    });
+
+    std::vector<core::FileDiff> computed(cases.size());
+    double engine_us = time_us([&] {
+      for (size_t i = 0; i < cases.size(); ++i) {
+        computed[i] = infra::DiffEngine::diff(cases[i].old_text,
+                                              cases[i].new_text, options);
+      }
+    });
+
+    size_t hunks = 0;
+    for (size_t i = 0; i < cases.size(); ++i) {
+      hunks += computed[i].hunks.size();
+      if (same_hunks(forked[i], computed[i])) {
+        continue;
+      }
+      if (++mismatches <= reported_mismatches) {
+        std::cerr << "diff_engine: " << algorithm.name << " differs from git on "
+                  << cases[i].name << "\n--- git\n"
+                  << infra::DiffEngine::format_hunks(forked[i])
+                  << "--- engine\n"
+                  << infra::DiffEngine::format_hunks(computed[i]);
+      }
+    }
+
+    auto count = static_cast<double>(cases.size());
+    std::string prefix = algorithm.name;
+    context.report(prefix + ".hunks", static_cast<double>(hunks), "count");
+    context.report(prefix + ".fork", fork_us / count, "us/file");
+    context.report(prefix + ".engine", engine_us / count, "us/file");
+    context.report(prefix + ".engine_throughput", input_bytes / engine_us,
+                   "MB/s");
+    context.report(prefix + ".speedup", fork_us / engine_us, "x");
+  }
+
+  context.report("mismatches", static_cast<double>(mismatches), "count");
+  if (mismatches > 0) {
+    throw SlayerGitException(std::to_string(mismatches) +
+                             " diffs differ from git diff");
+  }
+}
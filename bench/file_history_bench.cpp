@@ -0,0 +1,221 @@
+#include "bench.hpp"
+
+#include "core/commit_graph.hpp"
+#include "core/file_history.hpp"
+#include "core/object_database.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::time_us;
+
+namespace {
+
+// Files whose history is checked and timed, spread over the tree
+constexpr size_t sampled_files = 24;
+
+std::string run(infra::GitProcessExecutor &executor,
+                const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    throw SlayerGitException("git " + args.front() +
+                             " failed: " + result.stderr_output);
+  }
+  return result.stdout_output;
+}
+
+std::vector<std::string> lines_of(const std::string &output) {
+  std::vector<std::string> lines;
+  std::istringstream stream(output);
+  std::string line;
+  while (std::getline(stream, line)) {
+    if (!line.empty()) {
+      lines.push_back(line);
+    }
+  }
+  return lines;
+}
+
+// Some files, their directories, and a path that never existed. Commits
+// that add or remove a directory on the way to a file must not count as
+// changing it.
+std::vector<std::string> sample_paths(infra::GitProcessExecutor &executor) {
+  auto files = lines_of(run(executor, {"ls-tree", "-r", "--name-only", "HEAD"}));
+  std::vector<std::string> paths;
+  size_t step = std::max<size_t>(1, files.size() / sampled_files);
+  for (size_t i = 0; i < files.size() && paths.size() < sampled_files;
+       i += step) {
+    paths.push_back(files[i]);
+  }
+  size_t sampled = paths.size();
+  for (size_t i = 0; i < sampled; ++i) {
+    size_t slash = paths[i].rfind('/');
+    if (slash != std::string::npos &&
+        std::find(paths.begin(), paths.end(), paths[i].substr(0, slash)) ==
+            paths.end()) {
+      paths.push_back(paths[i].substr(0, slash));
+    }
+  }
+  paths.push_back("no/such/path");
+  return paths;
+}
+
+struct Walked {
+  std::vector<std::string> lines; // "hash parent...", as git --parents prints
+  core::FileHistory::Stats stats;
+};
+
+Walked walk(const std::string &repo, const std::string &tip,
+            const std::string &path) {
+  auto graph = core::CommitGraph::open_repository(repo);
+  if (!graph) {
+    throw SlayerGitException("no commit-graph was written");
+  }
+  auto objects = core::ObjectDatabase::open_repository(
+      repo, core::HashAlgorithm::Sha1);
+  core::FileHistory history(*graph, *objects);
+  Walked walked;
+  std::unordered_map<std::string, size_t> rows;
+  walked.stats = history.run(tip, path, [&](std::vector<core::Commit> batch) {
+    for (const auto &commit : batch) {
+      // Children first: no parent may have been listed already
+      for (const auto &parent : commit.parent_hashes) {
+        if (rows.count(parent) != 0) {
+          throw SlayerGitException(path + ": " + commit.hash +
+                                   " listed after its parent");
+        }
+      }
+      rows.emplace(commit.hash, rows.size());
+      std::string line = commit.hash;
+      for (const auto &parent : commit.parent_hashes) {
+        line += " " + parent;
+      }
+      walked.lines.push_back(std::move(line));
+    }
+  });
+  return walked;
+}
+
+// Commits and rewritten parents against `git log --parents -- <path>`
+void check_path(infra::GitProcessExecutor &executor, const std::string &tip,
+                const std::string &path, const std::string &what) {
+  auto expected = lines_of(
+      run(executor, {"log", "--format=%H %P", "--parents", tip, "--", path}));
+  for (auto &line : expected) {
+    // %P is empty for a root
+    line.erase(line.find_last_not_of(' ') + 1);
+  }
+  auto actual = walk(executor.repo_path(), tip, path).lines;
+  std::sort(expected.begin(), expected.end());
+  std::sort(actual.begin(), actual.end());
+  if (expected != actual) {
+    throw SlayerGitException(what + ": history of " + path + " has " +
+                             std::to_string(actual.size()) +
+                             " commits, git lists " +
+                             std::to_string(expected.size()));
+  }
+}
+
+void write(const std::string &path, const std::string &text) {
+  std::ofstream(path, std::ios::binary | std::ios::app) << text;
+}
+
+} // namespace
+
+// Per-file history from the commit-graph's Bloom filters against
+// `git log --parents -- <path>`: with and without filters, with commits
+// newer than the graph, and with a split graph. Then each path is timed
+// with filters, without them, and through git log (which uses them too).
+SLAYERGIT_BENCH(file_history) {
+  auto scratch =
+      std::filesystem::temp_directory_path() /
+      ("slayergit-file-history-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  // The clone gets the commit-graphs, so the repository under test keeps
+  // whatever it has
+  infra::GitProcessExecutor source(context.repo_path());
+  std::string clone = (scratch / "clone").string();
+  run(source, {"clone", "-q", "--shared", ".", clone});
+  infra::GitProcessExecutor executor(clone);
+  std::string tip = lines_of(run(executor, {"rev-parse", "HEAD"})).front();
+  auto paths = sample_paths(executor);
+
+  run(executor,
+      {"commit-graph", "write", "--reachable", "--no-changed-paths"});
+  double plain_us = 0;
+  for (const auto &path : paths) {
+    check_path(executor, tip, path, "without filters");
+    plain_us += time_us([&] { walk(clone, tip, path); });
+  }
+
+  run(executor, {"commit-graph", "write", "--reachable", "--changed-paths"});
+  core::FileHistory::Stats totals;
+  double bloom_us = 0;
+  double git_us = 0;
+  size_t matches = 0;
+  for (const auto &path : paths) {
+    check_path(executor, tip, path, "with filters");
+    bloom_us += time_us([&] {
+      auto stats = walk(clone, tip, path).stats;
+      matches += stats.matches;
+      totals.bloom_definitely_not += stats.bloom_definitely_not;
+      totals.bloom_maybe += stats.bloom_maybe;
+      totals.bloom_false_positives += stats.bloom_false_positives;
+      totals.trees_read += stats.trees_read;
+      totals.commits_walked += stats.commits_walked;
+    });
+    git_us += time_us(
+        [&] { run(executor, {"log", "--format=%H", tip, "--", path}); });
+  }
+
+  // Commits after the graph was written are read as objects, then
+  // covered by a second layer
+  for (int i = 0; i < 3; ++i) {
+    write(clone + "/" + paths.front(), "late change " + std::to_string(i) + "\n");
+    run(executor, {"-c", "user.name=bench", "-c", "user.email=bench@example.com",
+                   "commit", "-q", "-a", "-m", "late " + std::to_string(i)});
+  }
+  std::string late_tip = lines_of(run(executor, {"rev-parse", "HEAD"})).front();
+  check_path(executor, late_tip, paths.front(), "newer than the graph");
+  if (walk(clone, late_tip, paths.front()).stats.commits_loaded != 3) {
+    throw SlayerGitException("the late commits were not loaded as objects");
+  }
+  run(executor, {"commit-graph", "write", "--reachable", "--split=no-merge",
+                 "--changed-paths"});
+  check_path(executor, late_tip, paths.front(), "split graph");
+
+  const auto count = static_cast<double>(paths.size());
+  context.report("paths", count, "count");
+  context.report("matches", static_cast<double>(matches), "count");
+  context.report("commits_walked", static_cast<double>(totals.commits_walked),
+                 "count");
+  context.report("bloom_definitely_not",
+                 static_cast<double>(totals.bloom_definitely_not), "count");
+  context.report("bloom_maybe", static_cast<double>(totals.bloom_maybe),
+                 "count");
+  context.report("bloom_false_positive_rate",
+                 100.0 * totals.false_positive_rate(), "%");
+  context.report("trees_read", static_cast<double>(totals.trees_read),
+                 "count");
+  context.report("history_bloom", bloom_us / count / 1000.0, "ms/path");
+  context.report("history_no_bloom", plain_us / count / 1000.0, "ms/path");
+  context.report("git_log", git_us / count / 1000.0, "ms/path");
+}
@@ -0,0 +1,165 @@
+#include "bench.hpp"
+
+#include "core/fsmonitor.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr int runs = 5;
+constexpr size_t edited_files = 10;
+
+std::string run(infra::GitProcessExecutor &executor,
+                const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    throw SlayerGitException("git " + args.front() +
+                             " failed: " + result.stderr_output);
+  }
+  return result.stdout_output;
+}
+
+std::vector<std::string> lines(const std::string &output) {
+  std::vector<std::string> result;
+  std::istringstream stream(output);
+  std::string line;
+  while (std::getline(stream, line)) {
+    result.push_back(line);
+  }
+  return result;
+}
+
+// git runs the hook from the main binary, built next to this one
+std::string slayergit_binary() {
+  auto path = std::filesystem::read_symlink("/proc/self/exe").parent_path() /
+              "slayergit";
+  if (!std::filesystem::exists(path)) {
+    throw SlayerGitException(path.string() + " not found; build slayergit");
+  }
+  return path.string();
+}
+
+} // namespace
+
+// `git status` in a clone, first scanning the whole work tree and then with
+// core.fsmonitor answered by the daemon, before and after a few edits.
+// Fails if git never asks the daemon, if the edits need a full rescan, or
+// if status with the hook differs from status without it. Generate a large
+// tree with `--shape files=500000` to see the gap grow.
+SLAYERGIT_BENCH(fsmonitor) {
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-fsmonitor-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  std::string hook = slayergit_binary();
+  std::string clone = (scratch / "work").string();
+  infra::GitProcessExecutor source(context.repo_path());
+  run(source, {"clone", "-q", "--shared", ".", clone});
+  infra::GitProcessExecutor executor(clone);
+  auto tracked = lines(run(executor, {"ls-files"}));
+  context.report("tracked_files", static_cast<double>(tracked.size()),
+                 "count");
+  if (tracked.size() < edited_files + 1) {
+    throw SlayerGitException("too few files");
+  }
+  // Both modes keep the untracked cache, so only the hook differs
+  run(executor, {"config", "core.untrackedCache", "true"});
+
+  const std::vector<std::string> status{"status", "--porcelain=v2", "-z"};
+  run(executor, status); // Writes the untracked cache
+  context.report("status_full_scan",
+                 median_us(runs, [&] { run(executor, status); }) / 1000.0,
+                 "ms");
+
+  core::FsMonitorDaemon daemon(clone);
+  context.report("daemon_start", time_us([&] { daemon.start(); }) / 1000.0,
+                 "ms");
+  context.report("watches", static_cast<double>(daemon.stats().watches),
+                 "count");
+  if (daemon.stats().watch_limit_reached) {
+    throw SlayerGitException("fs.inotify.max_user_watches is too low");
+  }
+  run(executor, {"config", "core.fsmonitor", "'" + hook + "' fsmonitor"});
+  run(executor, {"config", "core.fsmonitorHookVersion", "2"});
+  // The first query gets "/"; the index then records the daemon's token
+  run(executor, status);
+  run(executor, status);
+  context.report("status_fsmonitor",
+                 median_us(runs, [&] { run(executor, status); }) / 1000.0,
+                 "ms");
+
+  auto before = daemon.stats();
+  if (before.queries < static_cast<uint64_t>(runs)) {
+    throw SlayerGitException("git did not ask the daemon");
+  }
+  for (size_t i = 0; i < edited_files; ++i) {
+    std::ofstream(clone + "/" + tracked[i * tracked.size() / edited_files],
+                  std::ios::app)
+        << "edit\n";
+  }
+  std::filesystem::remove(clone + "/" + tracked.back());
+  std::filesystem::create_directories(clone + "/fsmonitor-new");
+  std::ofstream(clone + "/fsmonitor-new/file") << "new\n";
+
+  std::string with_hook;
+  context.report("status_after_edits", time_us([&] {
+                   with_hook = run(executor, status);
+                 }) / 1000.0,
+                 "ms");
+  auto after = daemon.stats();
+  if (after.full_rescans != before.full_rescans) {
+    throw SlayerGitException("edits needed a full rescan");
+  }
+  context.report("hook_query", median_us(runs, [&] {
+                   daemon.answer("");
+                 }) / 1000.0,
+                 "ms");
+
+  std::string without_hook =
+      run(executor, {"-c", "core.fsmonitor=false", "status", "--porcelain=v2",
+                     "-z"});
+  if (with_hook != without_hook) {
+    throw SlayerGitException("status differs with the fsmonitor hook");
+  }
+  if (std::count(with_hook.begin(), with_hook.end(), '\0') <
+      static_cast<long>(edited_files + 2)) {
+    throw SlayerGitException("status missed the edits");
+  }
+
+  // A write through a descriptor that stays open and a truncate(2) close
+  // nothing, so only IN_MODIFY reports them
+  run(executor, status);
+  std::string kept_open = clone + "/" + tracked[1];
+  int fd = ::open(kept_open.c_str(), O_WRONLY | O_APPEND);
+  if (fd < 0 || ::write(fd, "open\n", 5) != 5 ||
+      ::truncate((clone + "/" + tracked[2]).c_str(), 0) != 0) {
+    throw SlayerGitException("cannot write in place");
+  }
+  std::string in_place = run(executor, status);
+  ::close(fd);
+  if (in_place != run(executor, {"-c", "core.fsmonitor=false", "status",
+                                 "--porcelain=v2", "-z"})) {
+    throw SlayerGitException("status missed writes to an open file");
+  }
+}
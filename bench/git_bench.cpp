@@ -0,0 +1,199 @@
+#include "bench.hpp"
+
+#include "core/log_stream.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+#include "infra/parsers/log_parser.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr int runs = 5;
+
+infra::ProcessResult checked(infra::GitProcessExecutor &executor,
+                             const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    throw GitCommandException("git " + args.front(), result.exit_code,
+                              result.stderr_output);
+  }
+  return result;
+}
+
+size_t count_char(const std::string &text, char c) {
+  return static_cast<size_t>(std::count(text.begin(), text.end(), c));
+}
+
+size_t commit_count(infra::GitProcessExecutor &executor) {
+  auto result = checked(executor, {"rev-list", "--count", "HEAD"});
+  return std::stoull(result.stdout_output);
+}
+
+} // namespace
+
+// `git status` as the Status tab would run it
+SLAYERGIT_BENCH(status) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  size_t entries = 0;
+  context.report("porcelain_v2", median_us(runs, [&] {
+                   auto result = checked(executor, {"status", "--porcelain=v2",
+                                                    "-z", "--branch"});
+                   entries = count_char(result.stdout_output, '\0');
+                 }),
+                 "us");
+  context.report("porcelain_v2.entries", static_cast<double>(entries),
+                 "count");
+  context.report("no_untracked", median_us(runs, [&] {
+                   checked(executor, {"status", "--porcelain=v2", "-z",
+                                      "--untracked-files=no"});
+                 }),
+                 "us");
+}
+
+// Time to the first screenful through LogStream, and full-history parsing
+SLAYERGIT_BENCH(log) {
+  infra::GitProcessExecutor executor(context.repo_path());
+
+  double first_batch_us = median_us(runs, [&] {
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool received = false;
+    core::LogStream stream(executor);
+    stream.start([&](std::vector<core::Commit>) {
+      std::lock_guard<std::mutex> lock(mutex);
+      received = true;
+      ready.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [&] { return received; });
+  });
+  context.report("first_batch", first_batch_us, "us");
+
+  // A stream replaced by start() must stay silent instead of reporting
+  // "stopped" on top of its successor
+  {
+    core::LogStream::Options paused;
+    paused.first_batch_rows = 1;
+    paused.max_rows_ahead = 1;
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool received = false;
+    int replaced_done = 0;
+    bool finished = false;
+    core::LogStream stream(executor, paused);
+    stream.start(
+        [&](std::vector<core::Commit>) {
+          std::lock_guard<std::mutex> lock(mutex);
+          received = true;
+          changed.notify_one();
+        },
+        [&](int, const std::string &) {
+          std::lock_guard<std::mutex> lock(mutex);
+          ++replaced_done;
+        });
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&] { return received; });
+    }
+    stream.start([](std::vector<core::Commit>) {},
+                 [&](int, const std::string &) {
+                   std::lock_guard<std::mutex> lock(mutex);
+                   finished = true;
+                   changed.notify_one();
+                 });
+    stream.set_cursor(SIZE_MAX / 2);
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return finished; });
+    if (replaced_done != 0) {
+      throw SlayerGitException("replaced log stream reported done");
+    }
+  }
+
+  // No read-ahead limit: measures git plus parsing at full speed
+  core::LogStream::Options options;
+  options.max_rows_ahead = SIZE_MAX;
+  size_t commits = 0;
+  double stream_us = time_us([&] {
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+    core::LogStream stream(executor, options);
+    stream.start(
+        [&](std::vector<core::Commit> batch) { commits += batch.size(); },
+        [&](int, const std::string &) {
+          std::lock_guard<std::mutex> lock(mutex);
+          finished = true;
+          done.notify_one();
+        });
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return finished; });
+  });
+  context.report("full_stream", stream_us, "us");
+  context.report("full_stream.commits", static_cast<double>(commits), "count");
+  context.report("full_stream.rate",
+                 static_cast<double>(commits) / (stream_us / 1e6), "commits/s");
+
+  auto output = checked(executor, infra::LogParser::log_args()).stdout_output;
+  double parse_us = median_us(runs, [&] {
+    auto parsed = infra::LogParser::parse(output);
+    commits = parsed.size();
+  });
+  context.report("parse_only",
+                 static_cast<double>(output.size()) / parse_us, "MB/s");
+}
+
+// Branch list as the Branches tab would load it
+SLAYERGIT_BENCH(refs) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  size_t refs = 0;
+  context.report("for_each_ref", median_us(runs, [&] {
+                   auto result = checked(
+                       executor,
+                       {"for-each-ref", "--format=%(objectname) %(refname)"});
+                   refs = count_char(result.stdout_output, '\n');
+                 }),
+                 "us");
+  context.report("for_each_ref.refs", static_cast<double>(refs), "count");
+  context.report("branch_list", median_us(runs, [&] {
+                   checked(executor, {"branch", "--list", "--no-color"});
+                 }),
+                 "us");
+}
+
+// Single-commit diffs and a wider range diff
+SLAYERGIT_BENCH(diff) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  size_t history = commit_count(executor);
+  if (history < 2) {
+    throw SlayerGitException("diff benchmark needs at least two commits");
+  }
+
+  context.report("commit_patch", median_us(runs, [&] {
+                   checked(executor, {"diff", "HEAD~1", "HEAD"});
+                 }),
+                 "us");
+
+  std::string range_base =
+      "HEAD~" + std::to_string(std::min<size_t>(history - 1, 100));
+  size_t bytes = 0;
+  context.report("range_patch", median_us(runs, [&] {
+                   bytes = checked(executor, {"diff", range_base, "HEAD"})
+                               .stdout_output.size();
+                 }),
+                 "us");
+  context.report("range_patch.bytes", static_cast<double>(bytes), "bytes");
+  context.report("worktree_numstat", median_us(runs, [&] {
+                   checked(executor, {"diff", "--numstat"});
+                 }),
+                 "us");
+}
@@ -0,0 +1,175 @@
+#include "bench.hpp"
+
+#include "core/graph_layout.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+#include "infra/parsers/log_parser.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr size_t batch_rows = 2000;
+constexpr size_t viewport_rows = 50;
+constexpr int runs = 9;
+
+std::vector<core::Commit> log(const std::string &repo_path, bool topological) {
+  infra::GitProcessExecutor executor(repo_path);
+  auto args = infra::LogParser::log_args();
+  if (topological) {
+    args.push_back("--topo-order");
+  }
+  args.push_back("--all");
+  auto result = executor.execute(args);
+  return infra::LogParser::parse(result.stdout_output);
+}
+
+void append_all(core::GraphLayout &layout,
+                const std::vector<core::Commit> &commits) {
+  for (size_t first = 0; first < commits.size(); first += batch_rows) {
+    size_t last = std::min(first + batch_rows, commits.size());
+    layout.append({commits.begin() + first, commits.begin() + last});
+  }
+}
+
+void lay_out_viewport(core::GraphLayout &layout, size_t first,
+                      const core::GraphLayout::CommitAt &commit_at) {
+  size_t last = std::min(first + viewport_rows, layout.row_count());
+  for (size_t row = first; row < last; ++row) {
+    layout.row(row, commit_at);
+  }
+}
+
+// Rows reached by jumping must match a top-to-bottom pass, and every lane
+// must have ended after the last root
+void check_random_access(const std::vector<core::Commit> &commits,
+                         const core::GraphLayout::CommitAt &commit_at,
+                         bool topological) {
+  core::GraphLayout sequential(commits.size() + 1);
+  sequential.set_topological(topological);
+  append_all(sequential, commits);
+  if (sequential.stats().active_lanes != 0) {
+    throw SlayerGitException(
+        std::to_string(sequential.stats().active_lanes) +
+        " lanes still open after the whole history");
+  }
+  std::vector<core::GraphRow> expected;
+  for (size_t row = 0; row < commits.size(); ++row) {
+    expected.push_back(sequential.row(row, commit_at));
+  }
+
+  core::GraphLayout jumping(64);
+  jumping.set_topological(topological);
+  append_all(jumping, commits);
+  std::mt19937 random(5);
+  for (int i = 0; i < 2000; ++i) {
+    size_t row = random() % commits.size();
+    const auto &actual = jumping.row(row, commit_at);
+    if (actual.cells != expected[row].cells ||
+        actual.commit_column != expected[row].commit_column) {
+      throw SlayerGitException("graph mismatch at row " +
+                               std::to_string(row));
+    }
+  }
+}
+
+// Date order with a skewed clock: the parent of two children is listed
+// between them, and the second child must not open a lane that waits for
+// it forever
+void check_skewed_parent() {
+  auto commit = [](std::string hash, std::vector<std::string> parents) {
+    core::Commit commit;
+    commit.hash = std::move(hash);
+    commit.parent_hashes = std::move(parents);
+    return commit;
+  };
+  std::vector<core::Commit> commits{commit("child1", {"parent"}),
+                                    commit("parent", {"root"}),
+                                    commit("child2", {"parent"}),
+                                    commit("root", {})};
+  core::GraphLayout layout;
+  layout.set_topological(false);
+  layout.append(commits);
+  if (layout.stats().active_lanes != 0) {
+    throw SlayerGitException("a lane waits for a parent listed above it");
+  }
+  const auto &row = layout.row(
+      2, [&commits](size_t row) -> const core::Commit & { return commits[row]; });
+  if ((row.cells[row.commit_column] & core::GraphDown) != 0) {
+    throw SlayerGitException("a line leaves a commit whose parent is above");
+  }
+}
+
+} // namespace
+
+// Lane layout over the whole history: streaming append throughput, and the
+// cost of laying out one screen of graph anywhere in it. Layouts of a log
+// in date order, as streamed without a commit-graph, are checked too.
+SLAYERGIT_BENCH(graph_layout) {
+  auto commits = log(context.repo_path(), true);
+  if (commits.size() < 2) {
+    throw SlayerGitException("repository has too few commits");
+  }
+  core::GraphLayout::CommitAt commit_at =
+      [&commits](size_t row) -> const core::Commit & { return commits[row]; };
+  check_random_access(commits, commit_at, true);
+  {
+    auto dated = log(context.repo_path(), false);
+    check_random_access(
+        dated,
+        [&dated](size_t row) -> const core::Commit & { return dated[row]; },
+        false);
+  }
+  check_skewed_parent();
+  context.report("commits", static_cast<double>(commits.size()), "count");
+
+  double append = median_us(runs, [&] {
+    core::GraphLayout layout;
+    append_all(layout, commits);
+  });
+  context.report("append", append * 1000.0 / commits.size(), "ns/commit");
+
+  core::GraphLayout layout;
+  append_all(layout, commits);
+  auto stats = layout.stats();
+  context.report("max_lanes", static_cast<double>(stats.max_lanes), "lanes");
+  context.report("checkpoints", static_cast<double>(stats.checkpoints),
+                 "count");
+
+  context.report("top_viewport", median_us(runs, [&] {
+                   core::GraphLayout fresh;
+                   fresh.append({commits.begin(),
+                                 commits.begin() + std::min(commits.size(),
+                                                            viewport_rows)});
+                   lay_out_viewport(fresh, 0, commit_at);
+                 }),
+                 "us");
+
+  // Jumps land between checkpoints, so each replays part of an interval
+  std::mt19937 random(9);
+  std::vector<double> jumps;
+  for (int i = 0; i < 101; ++i) {
+    size_t row = random() % layout.row_count();
+    jumps.push_back(time_us([&] { lay_out_viewport(layout, row, commit_at); }));
+  }
+  std::sort(jumps.begin(), jumps.end());
+  context.report("jump.p50", jumps[jumps.size() / 2], "us");
+  context.report("jump.max", jumps.back(), "us");
+
+  size_t middle = layout.row_count() / 2;
+  lay_out_viewport(layout, middle, commit_at);
+  size_t steps = std::min<size_t>(1000, layout.row_count() - middle);
+  double scroll = time_us([&] {
+    for (size_t step = 1; step <= steps; ++step) {
+      lay_out_viewport(layout, middle + step, commit_at);
+    }
+  });
+  context.report("scroll_step", scroll / steps, "us");
+}
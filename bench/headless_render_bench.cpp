@@ -0,0 +1,125 @@
+#include "bench.hpp"
+
+#include "infra/exceptions.hpp"
+#include "ui/headless_renderer.hpp"
+#include "ui/input_handler.hpp"
+#include "ui/tabs/commits_tab.hpp"
+#include "ui/window_manager.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+
+namespace {
+
+constexpr size_t commit_count = 5000;
+constexpr int scroll_steps = 60;
+
+// Fixed content so snapshots do not depend on the repository
+std::vector<core::Commit> synthetic_commits() {
+  std::vector<core::Commit> commits;
+  commits.reserve(commit_count);
+  for (size_t i = 0; i < commit_count; ++i) {
+    core::Commit commit;
+    commit.hash = std::string(40, static_cast<char>('a' + i % 6));
+    commit.short_hash = commit.hash.substr(0, 7);
+    commit.author_name = "Author " + std::to_string(i % 17);
+    commit.author_date = static_cast<std::time_t>(1577836800 + i * 3600);
+    commit.subject = "Commit number " + std::to_string(commit_count - i);
+    commits.push_back(std::move(commit));
+  }
+  return commits;
+}
+
+// The window layout of the interactive app
+void build_layout(ui::WindowManager &wm) {
+  auto status = wm.add_window("Window 1");
+  status->add_tab("Status");
+  status->add_tab("Changes");
+  status->add_tab("Staged");
+
+  auto log = wm.add_window("Window 2");
+  auto commits_tab = std::make_shared<ui::CommitsTab>("Log");
+  commits_tab->append_commits(synthetic_commits());
+  commits_tab->set_status("");
+  log->add_tab(commits_tab);
+  log->add_tab("Branches");
+
+  auto diff = wm.add_window("Window 3");
+  diff->add_tab("Diff");
+  diff->add_tab("Stash");
+}
+
+void check_golden(bench::BenchContext &context, ui::HeadlessRenderer &renderer,
+                  const std::string &name) {
+  if (context.golden_dir().empty()) {
+    return;
+  }
+  std::filesystem::create_directories(context.golden_dir());
+  std::string path =
+      (std::filesystem::path(context.golden_dir()) / (name + ".txt")).string();
+  std::string diff;
+  if (renderer.compare_golden(path, context.update_golden(), &diff) ==
+      ui::HeadlessRenderer::GoldenResult::Mismatch) {
+    throw SlayerGitException("golden mismatch in " + path + " at " + diff);
+  }
+}
+
+} // namespace
+
+// Scripted session (focus, tab switches, scrolling) at several terminal
+// sizes; with --golden-dir, key frames are compared to stored snapshots
+SLAYERGIT_BENCH(headless_render) {
+  // Commit dates are formatted in local time
+  setenv("TZ", "UTC", 1);
+  tzset();
+
+  for (auto [width, height] : {std::pair{80, 24}, std::pair{120, 40},
+                               std::pair{200, 60}, std::pair{400, 120}}) {
+    std::string size = std::to_string(width) + "x" + std::to_string(height);
+    ui::WindowManager wm;
+    build_layout(wm);
+    ui::InputHandler input(wm);
+    ui::HeadlessRenderer renderer(wm, input, width, height);
+
+    renderer.render_frame();
+    check_golden(context, renderer, size + "-initial");
+
+    renderer.send_keys("2");
+    renderer.render_frame();
+    for (int i = 0; i < scroll_steps; ++i) {
+      renderer.send(ftxui::Event::ArrowDown);
+      renderer.render_frame();
+    }
+    renderer.send(ftxui::Event::PageDown);
+    renderer.render_frame();
+    check_golden(context, renderer, size + "-scrolled");
+
+    renderer.send(ftxui::Event::End);
+    renderer.render_frame();
+    renderer.send(ftxui::Event::Tab);
+    renderer.render_frame();
+    renderer.send_keys("3");
+    renderer.render_frame();
+    renderer.send(ftxui::Event::TabReverse);
+    renderer.render_frame();
+    check_golden(context, renderer, size + "-final");
+
+    // Frames with nothing changed
+    for (int i = 0; i < scroll_steps; ++i) {
+      renderer.render_frame();
+    }
+
+    const auto &stats = renderer.stats();
+    context.report(size + ".fps", stats.fps(), "frames/s");
+    context.report(size + ".bytes_per_frame", stats.bytes_per_frame(),
+                   "bytes");
+    context.report(size + ".frames", static_cast<double>(stats.frames),
+                   "count");
+  }
+}
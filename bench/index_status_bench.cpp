@@ -0,0 +1,367 @@
+#include "bench.hpp"
+
+#include "core/index_file.hpp"
+#include "core/index_status.hpp"
+#include "core/object_database.hpp"
+#include "core/untracked.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+
+namespace {
+
+constexpr int runs = 5;
+// Every kind of change is made to this many files
+constexpr size_t files_per_kind = 20;
+
+const infra::CancellationToken never;
+
+using Entries = std::set<std::pair<std::string, char>>;
+
+std::string run(infra::GitProcessExecutor &executor,
+                const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    throw SlayerGitException("git " + args.front() +
+                             " failed: " + result.stderr_output);
+  }
+  return result.stdout_output;
+}
+
+void write(const std::string &path, const std::string &text) {
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+}
+
+std::string read(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+void set_mtime(const std::string &path, const struct timespec &mtime) {
+  struct timespec times[2] = {mtime, mtime};
+  ::utimensat(AT_FDCWD, path.c_str(), times, AT_SYMLINK_NOFOLLOW);
+}
+
+// Both columns of `git status --porcelain`, read without letting git
+// refresh the index behind our back
+std::pair<Entries, Entries> git_status(infra::GitProcessExecutor &executor) {
+  std::string output =
+      run(executor, {"--no-optional-locks", "status", "--porcelain", "-z",
+                     "--untracked-files=no", "--no-renames"});
+  Entries staged;
+  Entries unstaged;
+  size_t start = 0;
+  while (start < output.size()) {
+    size_t end = output.find('\0', start);
+    std::string entry = output.substr(start, end - start);
+    start = end + 1;
+    char x = entry[0];
+    char y = entry[1];
+    std::string path = entry.substr(3);
+    std::string xy = entry.substr(0, 2);
+    if (x == 'U' || y == 'U' || xy == "AA" || xy == "DD") {
+      unstaged.emplace(path, 'U');
+      continue;
+    }
+    if (x != ' ') {
+      staged.emplace(path, x);
+    }
+    if (y != ' ') {
+      unstaged.emplace(path, y);
+    }
+  }
+  return {staged, unstaged};
+}
+
+Entries entries(const std::vector<core::FileStatus> &files, bool staged) {
+  Entries result;
+  for (const auto &file : files) {
+    result.emplace(file.path, core::status_code(staged ? file.staged_status
+                                                       : file.unstaged_status));
+  }
+  return result;
+}
+
+void check(const Entries &ours, const Entries &git, const std::string &what) {
+  for (const auto &[path, code] : ours) {
+    if (git.count({path, code}) == 0) {
+      throw SlayerGitException(what + ": git does not list " +
+                               std::string(1, code) + " " + path);
+    }
+  }
+  for (const auto &[path, code] : git) {
+    if (ours.count({path, code}) == 0) {
+      throw SlayerGitException(what + ": missing " + std::string(1, code) +
+                               " " + path);
+    }
+  }
+}
+
+// Status from the index against git's, for both columns; staged both
+// with HEAD's trees read in process and listed by git
+void check_status(infra::GitProcessExecutor &executor,
+                  const std::string &what) {
+  auto options = core::read_status_options(executor);
+  auto objects = core::ObjectDatabase::open_repository(executor.repo_path(),
+                                                       options.algorithm);
+  core::IndexStatus status(executor, options, objects.get());
+  core::IndexStatus listing(executor, options);
+  auto index = core::IndexFile::read_repository(executor.repo_path(),
+                                                options.algorithm);
+  auto [staged, unstaged] = git_status(executor);
+  check(entries(status.unstaged(*index, never), false), unstaged,
+        what + " unstaged");
+  check(entries(status.staged(*index, never), true), staged,
+        what + " staged");
+  check(entries(listing.staged(*index, never), true), staged,
+        what + " staged (ls-tree)");
+}
+
+// Regular files of the index that no other change touches
+std::vector<std::string> pick_files(const core::IndexFile &index,
+                                    size_t count) {
+  std::vector<std::string> files;
+  size_t step = std::max<size_t>(1, index.size() / (count * 8));
+  for (size_t i = 0; i < index.size() && files.size() < count; i += step) {
+    const auto &entry = index.entry(i);
+    if (entry.mode == 0100644 && entry.stat.size > 1) {
+      files.emplace_back(entry.path);
+    }
+  }
+  return files;
+}
+
+// Work tree changes of every kind git status tells apart
+void change_work_tree(infra::GitProcessExecutor &executor,
+                      const std::string &clone,
+                      const std::vector<std::string> &files) {
+  auto group = [&](size_t kind) {
+    std::vector<std::string> result;
+    for (size_t i = kind; i < files.size(); i += 8) {
+      result.push_back(clone + "/" + files[i]);
+    }
+    return result;
+  };
+  for (const auto &path : group(0)) { // Same size, new contents
+    std::string text = read(path);
+    text[0] = text[0] == 'x' ? 'y' : 'x';
+    write(path, text);
+  }
+  for (const auto &path : group(1)) { // Grown
+    write(path, read(path) + "more\n");
+  }
+  for (const auto &path : group(2)) {
+    std::filesystem::remove(path);
+  }
+  for (const auto &path : group(3)) { // Executable
+    std::filesystem::permissions(path, std::filesystem::perms::owner_exec,
+                                 std::filesystem::perm_options::add);
+  }
+  for (const auto &path : group(4)) { // Now a symlink
+    std::filesystem::remove(path);
+    std::filesystem::create_symlink("target", path);
+  }
+  for (const auto &path : group(5)) { // Touched, unchanged
+    write(path, read(path));
+  }
+  // Staged: a modification, a removal, a new file and an intent to add
+  auto staged = group(6);
+  if (staged.size() >= 2) {
+    write(staged[0], read(staged[0]) + "staged\n");
+    run(executor, {"add", "--", staged[0]});
+    run(executor, {"rm", "-q", "--cached", "--", staged[1]});
+  }
+  write(clone + "/added-file", "new\n");
+  write(clone + "/intent-file", "later\n");
+  run(executor, {"add", "added-file"});
+  run(executor, {"add", "-N", "intent-file"});
+  // A file staged and then changed again
+  for (const auto &path : group(7)) {
+    write(path, read(path) + "staged\n");
+    run(executor, {"add", "--", path});
+    write(path, read(path) + "and changed\n");
+  }
+}
+
+// An entry racily clean for good: its mtime lies after the index was
+// written, so only its contents can show that it changed
+void make_racy(infra::GitProcessExecutor &executor, const std::string &clone,
+               const std::string &file) {
+  std::string path = clone + "/" + file;
+  struct timespec future {
+    std::time(nullptr) + 3600, 0
+  };
+  set_mtime(path, future);
+  run(executor, {"add", "--", file});
+  std::string text = read(path);
+  text[0] = text[0] == 'x' ? 'y' : 'x';
+  write(path, text);
+  set_mtime(path, future);
+}
+
+// Contents a clean filter changes without changing their size: only git
+// can tell whether such a file changed
+void add_filtered(infra::GitProcessExecutor &executor,
+                  const std::string &clone) {
+  run(executor, {"config", "filter.upper.clean", "tr a-z A-Z"});
+  write(clone + "/.gitattributes", "*.up filter=upper\n");
+  write(clone + "/same.up", "hello\n");
+  write(clone + "/changed.up", "hello\n");
+  run(executor, {"add", ".gitattributes", "same.up", "changed.up"});
+  run(executor, {"commit", "-q", "-m", "filtered"});
+  sleep(1); // Out of the index's second, so stat data alone decides
+  write(clone + "/same.up", "hello\n");
+  write(clone + "/changed.up", "world\n");
+}
+
+// A small SHA-256 repository with a few changes of each kind
+void check_sha256(const std::filesystem::path &scratch) {
+  std::string repo = (scratch / "sha256").string();
+  infra::GitProcessExecutor init(scratch.string());
+  run(init, {"init", "-q", "--object-format=sha256", repo});
+  infra::GitProcessExecutor executor(repo);
+  for (int i = 0; i < 50; ++i) {
+    write(repo + "/f" + std::to_string(i), "file " + std::to_string(i) + "\n");
+  }
+  run(executor, {"add", "."});
+  run(executor, {"-c", "user.name=bench", "-c", "user.email=bench@example.com",
+                 "commit", "-q", "-m", "initial"});
+  write(repo + "/f1", "file X\n");
+  write(repo + "/f2", "grown\nfile 2\n");
+  std::filesystem::remove(repo + "/f3");
+  write(repo + "/f4", "staged\n");
+  run(executor, {"add", "f4"});
+  check_status(executor, "sha256");
+}
+
+} // namespace
+
+// git status from the index, checked against `git status --porcelain`
+// after changes of every kind, in index versions 2/3 and 4, with a racily
+// clean entry, with a clean filter and in a SHA-256 repository; then timed
+// against git on the unchanged and the changed clone.
+SLAYERGIT_BENCH(index_status) {
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-index-status-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  std::string clone = (scratch / "work").string();
+  infra::GitProcessExecutor source(context.repo_path());
+  run(source, {"clone", "-q", "--shared", ".", clone});
+  infra::GitProcessExecutor executor(clone);
+  run(executor, {"config", "user.name", "bench"});
+  run(executor, {"config", "user.email", "bench@example.com"});
+
+  auto options = core::read_status_options(executor);
+  auto index = core::IndexFile::read_repository(clone, options.algorithm);
+  if (core::list_tracked_paths(*index) !=
+      core::list_tracked_paths(executor, never)) {
+    throw SlayerGitException("tracked paths differ from git ls-files");
+  }
+  context.report("entries", static_cast<double>(index->size()), "count");
+  context.report("read_index", median_us(runs, [&] {
+                   core::IndexFile::read_repository(clone, options.algorithm);
+                 }) / 1000.0,
+                 "ms");
+
+  // Clean: stat data alone, and the cache tree for staged
+  core::IndexStatus clean(executor, options);
+  check_status(executor, "clean");
+  context.report("unstaged_clean", median_us(runs, [&] {
+                   clean.unstaged(*index, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("staged_clean", median_us(runs, [&] {
+                   clean.staged(*index, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("git_status_clean", median_us(runs, [&] {
+                   git_status(executor);
+                 }) / 1000.0,
+                 "ms");
+
+  change_work_tree(executor, clone, pick_files(*index, files_per_kind * 8));
+  check_status(executor, "version " + std::to_string(
+      core::IndexFile::read_repository(clone, options.algorithm)->version()));
+  run(executor, {"update-index", "--index-version", "4"});
+  index = core::IndexFile::read_repository(clone, options.algorithm);
+  if (index->version() != 4) {
+    throw SlayerGitException("index is not version 4");
+  }
+  check_status(executor, "version 4");
+
+  auto objects = core::ObjectDatabase::open_repository(clone, options.algorithm);
+  core::IndexStatus changed(executor, options, objects.get());
+  core::IndexStatus listing(executor, options);
+  context.report("unstaged_first", bench::time_us([&] {
+                   changed.unstaged(*index, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("hashed_first", static_cast<double>(changed.stats().hashed),
+                 "count");
+  context.report("unstaged_changed", median_us(runs, [&] {
+                   changed.unstaged(*index, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("staged_changed", median_us(runs, [&] {
+                   changed.staged(*index, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("staged_changed_ls_tree", median_us(runs, [&] {
+                   listing.staged(*index, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("git_status_changed", median_us(runs, [&] {
+                   git_status(executor);
+                 }) / 1000.0,
+                 "ms");
+  for (size_t threads : {size_t{1}, size_t{4}}) {
+    auto fixed_options = options;
+    fixed_options.threads = threads;
+    core::IndexStatus fixed(executor, fixed_options);
+    context.report("unstaged_threads_" + std::to_string(threads),
+                   median_us(runs, [&] {
+                     fixed.unstaged(*index, never);
+                   }) / 1000.0,
+                   "ms");
+  }
+
+  // Racily clean, which needs the contents even though lstat matches
+  auto racy_file = pick_files(*index, 1).front();
+  run(executor, {"config", "core.trustctime", "false"});
+  make_racy(executor, clone, racy_file);
+  check_status(executor, "racy");
+  core::IndexStatus racy(executor, core::read_status_options(executor));
+  index = core::IndexFile::read_repository(clone, options.algorithm);
+  racy.unstaged(*index, never);
+  if (racy.stats().racy == 0) {
+    throw SlayerGitException("no entry was racily clean");
+  }
+
+  add_filtered(executor, clone);
+  check_status(executor, "filtered");
+  check_sha256(scratch);
+}
@@ -0,0 +1,265 @@
+#include "bench.hpp"
+
+#include "core/commit_graph.hpp"
+#include "core/object_database.hpp"
+#include "infra/cat_file_pool.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_dir.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr int runs = 3;
+// Objects compared with git and timed, spread over the whole repository
+constexpr size_t sample_size = 20'000;
+constexpr size_t reader_threads = 4;
+
+std::string run(infra::GitProcessExecutor &executor,
+                const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    throw SlayerGitException("git " + args.front() +
+                             " failed: " + result.stderr_output);
+  }
+  return result.stdout_output;
+}
+
+void write(const std::string &path, const std::string &text) {
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+}
+
+void commit(infra::GitProcessExecutor &executor, const std::string &message) {
+  run(executor, {"-c", "user.name=bench", "-c", "user.email=bench@example.com",
+                 "commit", "-q", "-m", message});
+}
+
+// Every `step`-th object git knows of, hex; loose, packed and alternates
+std::vector<std::string> sample_objects(infra::GitProcessExecutor &executor,
+                                        size_t limit) {
+  std::string output = run(executor, {"cat-file", "--batch-all-objects",
+                                      "--batch-check=%(objectname)"});
+  std::vector<std::string> all;
+  std::istringstream lines(output);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (!line.empty()) {
+      all.push_back(line);
+    }
+  }
+  size_t step = std::max<size_t>(1, all.size() / limit);
+  std::vector<std::string> sample;
+  for (size_t i = 0; i < all.size(); i += step) {
+    sample.push_back(all[i]);
+  }
+  return sample;
+}
+
+// Type and contents of every sampled object against `git cat-file`
+void check_objects(const core::ObjectDatabase &objects,
+                   infra::CatFilePool &pool,
+                   const std::vector<std::string> &sample,
+                   const std::string &what) {
+  std::vector<std::future<infra::GitObject>> futures;
+  futures.reserve(sample.size());
+  for (const auto &hex : sample) {
+    futures.push_back(pool.read_object(hex));
+  }
+  for (size_t i = 0; i < sample.size(); ++i) {
+    infra::GitObject expected = futures[i].get();
+    auto object = objects.read(core::CommitGraph::from_hex(sample[i]));
+    if (!object) {
+      throw SlayerGitException(what + ": " + sample[i] + " not found");
+    }
+    if (expected.info.type != core::object_type_name(object->type) ||
+        expected.data != object->data) {
+      throw SlayerGitException(what + ": " + sample[i] + " differs from git");
+    }
+  }
+}
+
+void read_all(const core::ObjectDatabase &objects,
+              const std::vector<std::string> &raw, size_t first, size_t step) {
+  for (size_t i = first; i < raw.size(); i += step) {
+    if (!objects.read(raw[i])) {
+      throw SlayerGitException("object vanished while timing");
+    }
+  }
+}
+
+std::vector<std::string> to_raw(const std::vector<std::string> &hex) {
+  std::vector<std::string> raw;
+  raw.reserve(hex.size());
+  for (const auto &oid : hex) {
+    raw.push_back(core::CommitGraph::from_hex(oid));
+  }
+  return raw;
+}
+
+// A clone sharing the repository's objects through alternates, with
+// objects of its own loose and in several packs tied by a
+// multi-pack-index, and a pack written after the database was opened
+void check_layouts(infra::GitProcessExecutor &source,
+                   const std::filesystem::path &scratch) {
+  std::string clone = (scratch / "layouts").string();
+  run(source, {"clone", "-q", "--shared", ".", clone});
+  infra::GitProcessExecutor executor(clone);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 20; ++i) {
+      std::string text(2000, static_cast<char>('a' + (i + round) % 26));
+      text += "round " + std::to_string(round) + "\n";
+      write(clone + "/layout-" + std::to_string(i), text);
+    }
+    run(executor, {"add", "."});
+    commit(executor, "round " + std::to_string(round));
+    if (round < 2) {
+      run(executor, {"repack", "-q", "-d"});
+    }
+  }
+  run(executor, {"multi-pack-index", "write"});
+
+  auto objects = core::ObjectDatabase::open_repository(clone,
+                                                       core::HashAlgorithm::Sha1);
+  infra::CatFilePool pool(clone);
+  check_objects(*objects, pool, sample_objects(executor, 2'000), "layouts");
+
+  write(clone + "/late", "written after open\n");
+  run(executor, {"add", "late"});
+  commit(executor, "late");
+  run(executor, {"repack", "-q", "-d"});
+  std::string late = run(executor, {"rev-parse", "HEAD:late"});
+  late = late.substr(0, late.find('\n'));
+  if (!objects->read(core::CommitGraph::from_hex(late))) {
+    throw SlayerGitException("layouts: a pack written after open not found");
+  }
+}
+
+// Every object of a small SHA-256 repository, loose and packed
+void check_sha256(infra::GitProcessExecutor &source,
+                  const std::filesystem::path &scratch) {
+  std::string repo = (scratch / "sha256").string();
+  run(source, {"init", "-q", "--object-format=sha256", repo});
+  infra::GitProcessExecutor executor(repo);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 30; ++i) {
+      write(repo + "/f" + std::to_string(i),
+            std::string(500, 'x') + std::to_string(round * 100 + i) + "\n");
+    }
+    run(executor, {"add", "."});
+    commit(executor, "round " + std::to_string(round));
+    if (round == 1) {
+      run(executor, {"gc", "-q", "--aggressive"});
+    }
+  }
+  auto objects = core::ObjectDatabase::open_repository(
+      repo, core::HashAlgorithm::Sha256);
+  infra::CatFilePool pool(repo);
+  check_objects(*objects, pool, sample_objects(executor, 1'000), "sha256");
+}
+
+} // namespace
+
+// Objects read in process against `git cat-file`: a sample of the
+// repository (through normal and through tiny windows), a clone with loose
+// objects, several packs and a multi-pack-index, and a SHA-256 repository.
+// Then the sample is timed cold, warm, from several threads and through
+// the cat-file pool.
+SLAYERGIT_BENCH(object_database) {
+  auto scratch =
+      std::filesystem::temp_directory_path() /
+      ("slayergit-object-database-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  infra::GitProcessExecutor source(context.repo_path());
+  check_layouts(source, scratch);
+  check_sha256(source, scratch);
+
+  auto sample = sample_objects(source, sample_size);
+  auto raw = to_raw(sample);
+  context.report("objects", static_cast<double>(sample.size()), "count");
+  infra::CatFilePool pool(context.repo_path());
+  {
+    auto objects = core::ObjectDatabase::open_repository(
+        context.repo_path(), core::HashAlgorithm::Sha1);
+    check_objects(*objects, pool, sample, "repository");
+  }
+  {
+    // Windows far smaller than the objects, and few of them mapped
+    core::ObjectDatabase::Options small;
+    small.window_bytes = 64 << 10;
+    small.mapped_bytes_limit = 1 << 20;
+    small.delta_base_cache_bytes = 256 << 10;
+    auto objects = core::ObjectDatabase::open(
+        infra::resolve_git_dirs(context.repo_path()).objects_dir,
+        core::HashAlgorithm::Sha1, small);
+    check_objects(*objects, pool, sample, "small windows");
+    context.report("small_windows_unmapped",
+                   static_cast<double>(objects->stats().windows_unmapped),
+                   "count");
+  }
+
+  const auto count = static_cast<double>(raw.size());
+  std::unique_ptr<core::ObjectDatabase> objects;
+  double cold_us = time_us([&] {
+    objects = core::ObjectDatabase::open_repository(context.repo_path(),
+                                                    core::HashAlgorithm::Sha1);
+    read_all(*objects, raw, 0, 1);
+  });
+  context.report("read_cold", cold_us / count, "us/object");
+  context.report("read_warm", median_us(runs, [&] {
+                   read_all(*objects, raw, 0, 1);
+                 }) / count,
+                 "us/object");
+  context.report("read_threads_" + std::to_string(reader_threads),
+                 median_us(runs, [&] {
+                   std::vector<std::thread> threads;
+                   for (size_t t = 0; t < reader_threads; ++t) {
+                     threads.emplace_back(read_all, std::cref(*objects),
+                                          std::cref(raw), t, reader_threads);
+                   }
+                   for (auto &thread : threads) {
+                     thread.join();
+                   }
+                 }) / count,
+                 "us/object");
+  auto stats = objects->stats();
+  context.report("deltas_applied", static_cast<double>(stats.deltas_applied),
+                 "count");
+  context.report("base_cache_hit_rate",
+                 100.0 * static_cast<double>(stats.base_cache_hits) /
+                     static_cast<double>(std::max<size_t>(
+                         1, stats.base_cache_hits + stats.base_cache_misses)),
+                 "%");
+  context.report("cat_file_pipelined", time_us([&] {
+                   std::vector<std::future<infra::GitObject>> futures;
+                   futures.reserve(sample.size());
+                   for (const auto &hex : sample) {
+                     futures.push_back(pool.read_object(hex));
+                   }
+                   for (auto &future : futures) {
+                     future.get();
+                   }
+                 }) / count,
+                 "us/object");
+}
@@ -0,0 +1,167 @@
+#include "bench.hpp"
+
+#include "core/commit_graph.hpp"
+#include "core/object_hash.hpp"
+#include "infra/exceptions.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+
+namespace {
+
+constexpr int runs = 5;
+// Bytes hashed per throughput measurement
+constexpr size_t batch_bytes = 16 << 20;
+
+struct Vector {
+  std::string input;
+  const char *sha1;
+  const char *sha256;
+};
+
+// The digests git's t0015-hash.sh checks, plus the 448-bit NIST message
+std::vector<Vector> test_vectors() {
+  return {
+      {"", "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+       "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+      {"a", "86f7e437faa5a7fce15d1ddcb9eaeaea377667b8",
+       "ca978112ca1bbdcafac231b39a23dc4da786eff8147c4e72b9807785afee48bb"},
+      {"abc", "a9993e364706816aba3e25717850c26c9cd0d89d",
+       "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+      {"message digest", "c12252ceda8be8994d5fa0290a47231c1d16aae3",
+       "f7846f55cf23e14eebeab5b4e1550cad5b509e3348fbc4efa3a1413d393cb650"},
+      {"abcdefghijklmnopqrstuvwxyz",
+       "32d10c7b8cf96570ca04ce37f2a19d84240d3a89",
+       "71c480df93d6ae2f1efad1447c66c9525e316218cf51fc8d9ed832f2daf18b73"},
+      {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+       "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+       "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+      {std::string(1'000'000, 'a'), "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+       "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+      {std::string("blob 0\0", 7), "e69de29bb2d1d6434b8b29ae775ad8c2e48c5391",
+       "473a0f4c3be8a93681a267e3b1e9a7dcda1185436fe141f7749120a303721813"},
+      {std::string("blob 3\0abc", 10),
+       "f2ba8f84ab5c1bce84a7b441cb1959cfc7093b7f",
+       "c1cf6e465077930e88dc5136641d402f72a229ddd996f627d60e9639eaba35a6"},
+      {std::string("tree 0\0", 7), "4b825dc642cb6eb9a060e54bf8d69288fbee4904",
+       "6ef19b41225c5369f1c104d45d8d85efa9b057b53b14b4b9b939dd74decc5321"},
+  };
+}
+
+const char *algorithm_name(core::HashAlgorithm algorithm) {
+  return algorithm == core::HashAlgorithm::Sha1 ? "sha1" : "sha256";
+}
+
+std::vector<core::HashBackend> supported_backends() {
+  std::vector<core::HashBackend> backends;
+  for (auto backend :
+       {core::HashBackend::Scalar, core::HashBackend::ShaExtensions,
+        core::HashBackend::MultiBuffer}) {
+    if (core::hash_backend_supported(backend)) {
+      backends.push_back(backend);
+    }
+  }
+  return backends;
+}
+
+void check_vectors(core::HashAlgorithm algorithm, core::HashBackend backend) {
+  for (const auto &vector : test_vectors()) {
+    // Split unevenly to go through the hasher's partial block buffer
+    core::Hasher hasher(algorithm, backend);
+    size_t split = vector.input.size() / 3;
+    hasher.update(std::string_view(vector.input).substr(0, split));
+    hasher.update(std::string_view(vector.input).substr(split));
+    std::string expected = algorithm == core::HashAlgorithm::Sha1
+                               ? vector.sha1
+                               : vector.sha256;
+    if (core::CommitGraph::to_hex(hasher.finish()) != expected) {
+      throw SlayerGitException(std::string(algorithm_name(algorithm)) +
+                               " on " + core::hash_backend_name(backend) +
+                               " gave a wrong digest for a " +
+                               std::to_string(vector.input.size()) +
+                               "-byte test vector");
+    }
+  }
+}
+
+// Every length around the padding boundaries, in one batch so lanes start
+// and finish at different blocks, against the scalar hasher
+void check_batches(core::HashAlgorithm algorithm, core::HashBackend backend) {
+  std::mt19937 random(23);
+  std::vector<std::string> buffers;
+  for (size_t size = 0; size <= 300; ++size) {
+    buffers.emplace_back(size, '\0');
+  }
+  for (size_t size : {4096u, 65'536u, 100'003u, 1u << 20}) {
+    buffers.emplace_back(size, '\0');
+  }
+  for (auto &buffer : buffers) {
+    for (char &c : buffer) {
+      c = static_cast<char>(random());
+    }
+  }
+  std::shuffle(buffers.begin(), buffers.end(), random);
+  std::vector<std::string_view> views(buffers.begin(), buffers.end());
+
+  auto digests = core::hash_objects(algorithm, "blob", views, backend);
+  for (size_t i = 0; i < views.size(); ++i) {
+    core::Hasher scalar(algorithm, core::HashBackend::Scalar);
+    scalar.update(core::object_header("blob", views[i].size()));
+    scalar.update(views[i]);
+    if (digests[i] != scalar.finish()) {
+      throw SlayerGitException(
+          std::string(algorithm_name(algorithm)) + " batch on " +
+          core::hash_backend_name(backend) + " disagrees for a " +
+          std::to_string(views[i].size()) + "-byte blob");
+    }
+  }
+}
+
+} // namespace
+
+// Checks every supported backend against git's test vectors and the
+// scalar code, then reports single-threaded throughput (GB/s per core)
+// for batches of small files and of large ones
+SLAYERGIT_BENCH(object_hash) {
+  std::mt19937 random(5);
+  std::string pool(batch_bytes, '\0');
+  for (char &c : pool) {
+    c = static_cast<char>(random());
+  }
+  struct Shape {
+    const char *name;
+    size_t file_size;
+  };
+  const Shape shapes[] = {{"1k", 1024}, {"8k", 8192}, {"1m", 1 << 20}};
+
+  for (auto algorithm : {core::HashAlgorithm::Sha1, core::HashAlgorithm::Sha256}) {
+    context.report(std::string(algorithm_name(algorithm)) + "_default_backend",
+                   static_cast<double>(core::default_hash_backend(algorithm)),
+                   "enum");
+    for (auto backend : supported_backends()) {
+      check_vectors(algorithm, backend);
+      check_batches(algorithm, backend);
+      for (const auto &shape : shapes) {
+        std::vector<std::string_view> files;
+        for (size_t offset = 0; offset + shape.file_size <= pool.size();
+             offset += shape.file_size) {
+          files.emplace_back(pool.data() + offset, shape.file_size);
+        }
+        double us = median_us(runs, [&] {
+          core::hash_objects(algorithm, "blob", files, backend);
+        });
+        context.report(std::string(algorithm_name(algorithm)) + "_" +
+                           core::hash_backend_name(backend) + "_" + shape.name,
+                       static_cast<double>(files.size() * shape.file_size) /
+                           (us * 1000.0),
+                       "GB/s");
+      }
+    }
+  }
+}
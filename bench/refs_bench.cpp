@@ -0,0 +1,178 @@
+#include "bench.hpp"
+
+#include "core/ref_snapshot.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+
+namespace {
+
+constexpr int runs = 5;
+constexpr size_t tag_count = 60000;
+constexpr size_t annotated_tags = 20;
+constexpr size_t page_rows = 50;
+
+void run(infra::GitProcessExecutor &executor,
+         const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    throw SlayerGitException("git " + args.front() +
+                             " failed: " + result.stderr_output);
+  }
+}
+
+std::vector<std::string> lines(const std::string &output) {
+  std::vector<std::string> result;
+  std::istringstream stream(output);
+  std::string line;
+  while (std::getline(stream, line)) {
+    result.push_back(line);
+  }
+  return result;
+}
+
+std::string tag_name(size_t i) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "bench/%05zu", i);
+  return name;
+}
+
+// Packed tags (some annotated), then loose refs on top: an override of a
+// packed ref, a deletion, a loose annotated tag and a symref
+void populate(const std::string &clone) {
+  infra::GitProcessExecutor executor(clone);
+  auto commits = lines(
+      executor.execute({"rev-list", "--max-count=100", "HEAD"}).stdout_output);
+  auto tags_dir = std::filesystem::path(clone) / "refs" / "tags" / "bench";
+  std::filesystem::create_directories(tags_dir);
+  for (size_t i = annotated_tags; i < tag_count; ++i) {
+    std::ofstream(tags_dir / tag_name(i).substr(6))
+        << commits[i % commits.size()] << "\n";
+  }
+  for (size_t i = 0; i < annotated_tags; ++i) {
+    run(executor, {"-c", "user.name=bench", "-c", "user.email=bench@example",
+                   "tag", "-a", "-m", "bench", tag_name(i),
+                   commits[i % commits.size()]});
+  }
+  run(executor, {"pack-refs", "--all"});
+
+  run(executor,
+      {"update-ref", "refs/tags/" + tag_name(annotated_tags), commits.back()});
+  run(executor, {"update-ref", "-d", "refs/tags/" + tag_name(tag_count - 1)});
+  run(executor, {"-c", "user.name=bench", "-c", "user.email=bench@example",
+                 "tag", "-a", "-m", "bench", "bench/loose-annotated"});
+  run(executor, {"symbolic-ref", "refs/remotes/origin/HEAD",
+                 "refs/tags/" + tag_name(annotated_tags + 1)});
+}
+
+// Same names, ids and symrefs as for-each-ref, in the same order.
+// Peeled ids must match where recorded; loose tags have none.
+void check(const core::RefSnapshot &refs, infra::GitProcessExecutor &executor) {
+  auto expected = lines(executor
+                            .execute({"for-each-ref",
+                                      "--format=%(refname) %(objectname) "
+                                      "%(*objectname) %(symref)"})
+                            .stdout_output);
+  if (expected.size() != refs.size()) {
+    throw SlayerGitException(
+        "snapshot has " + std::to_string(refs.size()) + " refs, git " +
+        std::to_string(expected.size()));
+  }
+  size_t peeled = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    std::istringstream fields(expected[i]);
+    std::string name;
+    std::string oid;
+    fields >> name >> oid;
+    std::string rest;
+    std::getline(fields, rest);
+    // " <peeled> <symref>" with either part possibly empty
+    std::string expected_peeled = rest.substr(1, rest.find(' ', 1) - 1);
+    std::string expected_symref = rest.substr(rest.find(' ', 1) + 1);
+    if (refs.name(i) != name || refs.oid(i) != oid ||
+        refs.symref(i) != expected_symref ||
+        (!refs.peeled(i).empty() && refs.peeled(i) != expected_peeled)) {
+      throw SlayerGitException("snapshot disagrees on " + name);
+    }
+    peeled += refs.peeled(i).empty() ? 0 : 1;
+  }
+  if (peeled < annotated_tags) {
+    throw SlayerGitException("packed peeled ids missing");
+  }
+
+  std::string head = lines(executor.execute({"rev-parse", "HEAD"}).stdout_output)
+                         .front();
+  auto symbolic = lines(
+      executor.execute({"symbolic-ref", "-q", "HEAD"}).stdout_output);
+  if (refs.head().oid != head ||
+      refs.head().symref != (symbolic.empty() ? "" : symbolic.front())) {
+    throw SlayerGitException("snapshot disagrees on HEAD");
+  }
+}
+
+} // namespace
+
+// Reads 60k tags, mostly packed with a few loose refs over them, and
+// compares with forking `git for-each-ref`. Fails if the snapshot differs
+// from git in any ref, object id, peeled id or symref.
+SLAYERGIT_BENCH(refs_snapshot) {
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-refs-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  std::string clone = (scratch / "refs.git").string();
+  infra::GitProcessExecutor source(context.repo_path());
+  run(source, {"clone", "-q", "--bare", "--shared", ".", clone});
+  populate(clone);
+
+  infra::GitProcessExecutor executor(clone);
+  auto snapshot = core::RefSnapshot::read(clone);
+  check(*snapshot, executor);
+  context.report("refs", static_cast<double>(snapshot->size()), "count");
+
+  double read = median_us(runs, [&] { core::RefSnapshot::read(clone); });
+  context.report("snapshot_read", read / 1000.0, "ms");
+
+  double fork = median_us(runs, [&] {
+    auto refs = lines(executor
+                          .execute({"for-each-ref",
+                                    "--format=%(refname) %(objectname)"})
+                          .stdout_output);
+    if (refs.size() != snapshot->size()) {
+      throw SlayerGitException("for-each-ref changed");
+    }
+  });
+  context.report("git_for_each_ref", fork / 1000.0, "ms");
+
+  // What a tab does per frame: find its range, read one screen of names
+  size_t sink = 0;
+  double page = median_us(runs, [&] {
+    auto [first, last] = snapshot->range("refs/tags/");
+    size_t middle = first + (last - first) / 2;
+    for (size_t i = middle; i < std::min(last, middle + page_rows); ++i) {
+      sink += snapshot->name(i).size() + snapshot->oid(i).size();
+    }
+  });
+  if (sink == 0) {
+    throw SlayerGitException("empty page");
+  }
+  context.report("tags_page", page, "us");
+}
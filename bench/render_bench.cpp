@@ -0,0 +1,65 @@
+#include "bench.hpp"
+
+#include "infra/git_process_executor.hpp"
+#include "infra/parsers/log_parser.hpp"
+#include "ui/tabs/commits_tab.hpp"
+#include "ui/window_manager.hpp"
+
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace slayergit;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr int frames = 200;
+// Enough history to make the list long without holding 1M commits in memory
+constexpr size_t max_commits = 200'000;
+
+} // namespace
+
+// Full window-manager frames with the repository's history in the Log tab
+SLAYERGIT_BENCH(render) {
+  infra::GitProcessExecutor executor(context.repo_path());
+  auto args = infra::LogParser::log_args();
+  args.push_back("--max-count=" + std::to_string(max_commits));
+  auto commits =
+      infra::LogParser::parse(executor.execute(args).stdout_output);
+
+  ui::WindowManager wm;
+  auto window = wm.add_window("Log");
+  auto commits_tab = std::make_shared<ui::CommitsTab>("Log");
+  commits_tab->append_commits(std::move(commits));
+  window->add_tab(commits_tab);
+  wm.add_window("Status")->add_tab("Status");
+  wm.focus_window(0);
+  auto component = wm.create_component();
+  context.report("commits", static_cast<double>(commits_tab->commit_count()),
+                 "count");
+
+  for (auto [width, height] : {std::pair{80, 24}, std::pair{200, 60}}) {
+    std::string size = std::to_string(width) + "x" + std::to_string(height);
+    auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(width),
+                                        ftxui::Dimension::Fixed(height));
+
+    double idle_us = time_us([&] {
+      for (int i = 0; i < frames; ++i) {
+        ftxui::Render(screen, component->Render());
+      }
+    });
+    context.report(size + ".idle", idle_us / frames, "us/frame");
+
+    // Every frame moves the cursor, so the Log tab's content is rebuilt
+    double scroll_us = time_us([&] {
+      for (int i = 0; i < frames; ++i) {
+        commits_tab->list()->select_next();
+        ftxui::Render(screen, component->Render());
+      }
+    });
+    context.report(size + ".scrolling", scroll_us / frames, "us/frame");
+  }
+}
@@ -0,0 +1,339 @@
+#include "repo_generator.hpp"
+
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+#include "infra/process.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <poll.h>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+namespace slayergit::bench {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char *marker_name = "slayergit-bench-shape";
+constexpr int64_t base_time = 1577836800; // 2020-01-01
+
+// Buffers the fast-import stream and writes it to git's (non-blocking)
+// stdin in large pieces
+class StreamWriter {
+public:
+  explicit StreamWriter(int fd) : fd_(fd) { buffer_.reserve(capacity); }
+
+  StreamWriter &operator<<(std::string_view text) {
+    buffer_.append(text);
+    if (buffer_.size() >= capacity) {
+      flush();
+    }
+    return *this;
+  }
+  StreamWriter &operator<<(uint64_t value) {
+    return *this << std::string_view(std::to_string(value));
+  }
+
+  void data(std::string_view payload) {
+    *this << "data " << payload.size() << "\n" << payload << "\n";
+  }
+
+  void flush() {
+    size_t offset = 0;
+    while (offset < buffer_.size()) {
+      ssize_t n =
+          ::write(fd_, buffer_.data() + offset, buffer_.size() - offset);
+      if (n > 0) {
+        offset += static_cast<size_t>(n);
+        continue;
+      }
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        pollfd pfd{fd_, POLLOUT, 0};
+        ::poll(&pfd, 1, -1);
+        continue;
+      }
+      throw SlayerGitException(std::string("Writing to fast-import failed: ") +
+                               std::strerror(errno));
+    }
+    buffer_.clear();
+  }
+
+private:
+  static constexpr size_t capacity = 1 << 20;
+
+  int fd_;
+  std::string buffer_;
+};
+
+std::string file_path(const RepoShape &shape, size_t file) {
+  std::string path;
+  size_t dir = file;
+  for (size_t level = 0; level < shape.depth; ++level) {
+    path += "d" + std::to_string(dir % shape.fanout) + "/";
+    dir /= shape.fanout;
+  }
+  return path + "f" + std::to_string(file) + ".txt";
+}
+
+// A few lines so diffs have context; `revision` changes one of them
+std::string file_content(size_t file, size_t revision) {
+  std::string content;
+  for (size_t line = 0; line < 8; ++line) {
+    content += "file " + std::to_string(file) + " line " +
+               std::to_string(line);
+    if (line == revision % 8) {
+      content += " revision " + std::to_string(revision);
+    }
+    content += "\n";
+  }
+  return content;
+}
+
+void write_commit_header(StreamWriter &out, const std::string &ref,
+                         size_t mark, size_t index, const std::string &message) {
+  std::string ident = "Bench Author " + std::to_string(index % 50) +
+                      " <author" + std::to_string(index % 50) +
+                      "@example.com> " +
+                      std::to_string(base_time + static_cast<int64_t>(index) * 600) +
+                      " +0000";
+  out << "commit " << ref << "\nmark :" << mark << "\n";
+  out << "author " << ident << "\ncommitter " << ident << "\n";
+  out.data(message);
+}
+
+void modify_files(StreamWriter &out, const RepoShape &shape,
+                  std::mt19937_64 &rng, size_t revision) {
+  for (size_t i = 0; i < shape.files_per_commit; ++i) {
+    size_t file = static_cast<size_t>(rng() % shape.files);
+    out << "M 100644 inline " << file_path(shape, file) << "\n";
+    out.data(file_content(file, revision));
+  }
+}
+
+void fast_import(const std::string &path, const RepoShape &shape) {
+  infra::SpawnOptions options;
+  options.pipe_stdin = true;
+  options.pipe_stdout = false;
+  options.pipe_stderr = false;
+  auto child = infra::ChildProcess::spawn(
+      {"git", "-C", path, "fast-import", "--quiet", "--done"}, options);
+
+  StreamWriter out(child.stdin_fd());
+  std::mt19937_64 rng(shape.seed);
+  std::vector<uint32_t> main_marks;
+  main_marks.reserve(shape.commits);
+  size_t next_mark = 1;
+
+  // Root commit adds every file
+  write_commit_header(out, "refs/heads/main", next_mark, 0, "Initial commit\n");
+  for (size_t file = 0; file < shape.files; ++file) {
+    out << "M 100644 inline " << file_path(shape, file) << "\n";
+    out.data(file_content(file, 0));
+  }
+  main_marks.push_back(static_cast<uint32_t>(next_mark++));
+
+  for (size_t i = 1; i < shape.commits; ++i) {
+    size_t side_mark = 0;
+    if (shape.merge_every > 0 && i % shape.merge_every == 0 && i >= 2) {
+      // Fork from a few commits back so the merge is non-trivial
+      size_t base = i - 1 - static_cast<size_t>(rng() % std::min<size_t>(i - 1, 16));
+      side_mark = next_mark++;
+      write_commit_header(out, "refs/heads/side", side_mark, i,
+                          "Side change " + std::to_string(i) + "\n");
+      out << "from :" << main_marks[base] << "\n";
+      modify_files(out, shape, rng, i);
+    }
+
+    size_t mark = next_mark++;
+    std::string message = side_mark ? "Merge side change " : "Change ";
+    write_commit_header(out, "refs/heads/main", mark, i,
+                        message + std::to_string(i) + "\n\nBody of commit " +
+                            std::to_string(i) + ".\n");
+    out << "from :" << main_marks.back() << "\n";
+    if (side_mark) {
+      out << "merge :" << side_mark << "\n";
+    }
+    modify_files(out, shape, rng, i);
+    main_marks.push_back(static_cast<uint32_t>(mark));
+  }
+
+  for (size_t b = 0; b < shape.branches; ++b) {
+    size_t commit = static_cast<size_t>(rng() % main_marks.size());
+    out << "reset refs/heads/branch-" << b << "\nfrom :" << main_marks[commit]
+        << "\n\n";
+  }
+  out << "done\n";
+  out.flush();
+  child.close_stdin();
+
+  int exit_code = child.wait();
+  if (exit_code != 0) {
+    throw SlayerGitException("git fast-import failed with exit code " +
+                             std::to_string(exit_code));
+  }
+}
+
+void run_git(infra::GitProcessExecutor &executor,
+             const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    std::string command = "git";
+    for (const auto &arg : args) {
+      command += " " + arg;
+    }
+    throw GitCommandException(command, result.exit_code, result.stderr_output);
+  }
+}
+
+void dirty_worktree(const std::string &path, const RepoShape &shape) {
+  std::mt19937_64 rng(shape.seed ^ 0x5eedu);
+  for (size_t i = 0; i < shape.dirty_files && shape.files > 0; ++i) {
+    size_t file = static_cast<size_t>(rng() % shape.files);
+    std::ofstream(fs::path(path) / file_path(shape, file), std::ios::app)
+        << "uncommitted change " << i << "\n";
+  }
+  for (size_t i = 0; i < shape.untracked_files; ++i) {
+    fs::path untracked = fs::path(path) / "untracked" /
+                         ("u" + std::to_string(i) + ".txt");
+    fs::create_directories(untracked.parent_path());
+    std::ofstream(untracked) << "untracked " << i << "\n";
+  }
+}
+
+} // namespace
+
+RepoShape RepoShape::preset(const std::string &name) {
+  RepoShape shape;
+  if (name == "small") {
+    return shape;
+  }
+  if (name == "medium") {
+    shape.files = 50'000;
+    shape.commits = 100'000;
+    shape.branches = 5'000;
+    shape.depth = 5;
+    return shape;
+  }
+  if (name == "large") {
+    shape.files = 500'000;
+    shape.commits = 1'000'000;
+    shape.branches = 50'000;
+    shape.depth = 8;
+    return shape;
+  }
+  if (name == "merges") {
+    shape.files = 20'000;
+    shape.commits = 100'000;
+    shape.merge_every = 3;
+    shape.branches = 2'000;
+    shape.depth = 4;
+    return shape;
+  }
+  throw SlayerGitException("Unknown repository preset: " + name);
+}
+
+RepoShape RepoShape::parse(const std::string &spec) {
+  RepoShape shape;
+  std::istringstream stream(spec);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    auto eq = item.find('=');
+    if (eq == std::string::npos) {
+      // A bare name selects a preset to start from
+      shape = preset(item);
+      continue;
+    }
+    std::string key = item.substr(0, eq);
+    uint64_t value = 0;
+    try {
+      value = std::stoull(item.substr(eq + 1));
+    } catch (const std::exception &) {
+      throw SlayerGitException("Invalid value in repository shape: " + item);
+    }
+
+    if (key == "files") {
+      shape.files = value;
+    } else if (key == "commits") {
+      shape.commits = value;
+    } else if (key == "merge_every") {
+      shape.merge_every = value;
+    } else if (key == "files_per_commit") {
+      shape.files_per_commit = value;
+    } else if (key == "branches") {
+      shape.branches = value;
+    } else if (key == "depth") {
+      shape.depth = value;
+    } else if (key == "fanout") {
+      shape.fanout = value;
+    } else if (key == "dirty_files") {
+      shape.dirty_files = value;
+    } else if (key == "untracked_files") {
+      shape.untracked_files = value;
+    } else if (key == "pack_refs") {
+      shape.pack_refs = value != 0;
+    } else if (key == "seed") {
+      shape.seed = value;
+    } else {
+      throw SlayerGitException("Unknown repository shape key: " + key);
+    }
+  }
+  if (shape.files == 0 || shape.commits == 0 || shape.fanout == 0) {
+    throw SlayerGitException("files, commits and fanout must be positive");
+  }
+  return shape;
+}
+
+std::string RepoShape::key() const {
+  char buffer[160];
+  std::snprintf(buffer, sizeof(buffer),
+                "f%zu-c%zu-m%zu-p%zu-b%zu-d%zux%zu-w%zu-u%zu-%s-s%llu", files,
+                commits, merge_every, files_per_commit, branches, depth, fanout,
+                dirty_files, untracked_files, pack_refs ? "packed" : "loose",
+                static_cast<unsigned long long>(seed));
+  return buffer;
+}
+
+void generate_repo(const std::string &path, const RepoShape &shape) {
+  fs::path marker = fs::path(path) / ".git" / marker_name;
+  if (fs::exists(marker)) {
+    std::string existing;
+    std::getline(std::ifstream(marker), existing);
+    if (existing == shape.key()) {
+      return;
+    }
+    fs::remove_all(path);
+  } else if (fs::exists(path) && !fs::is_empty(path)) {
+    throw SlayerGitException("Refusing to overwrite " + path +
+                             ": not a generated benchmark repository");
+  }
+
+  fs::create_directories(path);
+  infra::GitProcessExecutor executor(path);
+  run_git(executor, {"init", "-q"});
+  run_git(executor, {"symbolic-ref", "HEAD", "refs/heads/main"});
+  // Claims the directory; replaced by the shape key once generation is done
+  std::ofstream(marker) << "incomplete\n";
+
+  fast_import(path, shape);
+
+  if (shape.pack_refs) {
+    run_git(executor, {"pack-refs", "--all"});
+  }
+  run_git(executor, {"reset", "-q", "--hard", "main"});
+  dirty_worktree(path, shape);
+
+  std::ofstream(marker) << shape.key() << "\n";
+}
+
+} // namespace slayergit::bench
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace slayergit::bench {
+
+// Shape of a synthetic repository. The same shape always produces the same
+// objects and commit ids: content, paths, authors and timestamps all derive
+// from `seed`.
+struct RepoShape {
+  // Tracked files in the tip commit
+  size_t files = 1000;
+  // Commits on main's first-parent chain
+  size_t commits = 1000;
+  // Every Nth commit merges a side-branch commit; 0 keeps history linear
+  size_t merge_every = 0;
+  size_t files_per_commit = 3;
+  size_t branches = 100;
+  // Files are spread over fanout^depth directories, `depth` levels deep
+  size_t depth = 3;
+  size_t fanout = 8;
+  // Worktree changes left behind for status benchmarks
+  size_t dirty_files = 10;
+  size_t untracked_files = 10;
+  bool pack_refs = true;
+  uint64_t seed = 1;
+
+  // Named presets: small, medium, large, merges. Throws on unknown names.
+  static RepoShape preset(const std::string &name);
+  // "files=500000,commits=1000000,merge_every=4,...", on top of defaults
+  static RepoShape parse(const std::string &spec);
+
+  // Stable identifier, used for directory names and result labels
+  [[nodiscard]] std::string key() const;
+};
+
+// Creates (or reuses) the repository for `shape` at `path`. A repository
+// generated earlier with the same shape is left untouched so setup is paid
+// once per machine. Throws SlayerGitException on failure, and refuses to
+// replace a directory it did not create.
+void generate_repo(const std::string &path, const RepoShape &shape);
+
+} // namespace slayergit::bench
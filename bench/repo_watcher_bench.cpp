@@ -0,0 +1,227 @@
+#include "bench.hpp"
+
+#include "core/repo_watcher.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <unistd.h>
+
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::time_us;
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr auto debounce = 50ms;
+constexpr auto max_delay = 500ms;
+constexpr auto first_change_timeout = 5s;
+constexpr size_t burst_files = 2000;
+
+struct Dispatched {
+  std::vector<core::RepoWatcher::Change> changes;
+  std::chrono::steady_clock::time_point first_at;
+};
+
+// Collects what the watcher dispatches
+class Recorder {
+public:
+  void add(const core::RepoWatcher::Change &change) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dispatched_.changes.empty()) {
+      dispatched_.first_at = std::chrono::steady_clock::now();
+    }
+    dispatched_.changes.push_back(change);
+    arrived_.notify_all();
+  }
+
+  // Changes until the watcher has been quiet for a while; the first must
+  // arrive within the timeout
+  Dispatched settle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!arrived_.wait_for(lock, first_change_timeout,
+                           [&] { return !dispatched_.changes.empty(); })) {
+      return {};
+    }
+    size_t seen = 0;
+    while (seen != dispatched_.changes.size()) {
+      seen = dispatched_.changes.size();
+      arrived_.wait_for(lock, max_delay + debounce * 2);
+    }
+    return std::exchange(dispatched_, {});
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable arrived_;
+  Dispatched dispatched_;
+};
+
+void run(infra::GitProcessExecutor &executor,
+         const std::vector<std::string> &args) {
+  std::vector<std::string> full{"-c", "user.name=bench", "-c",
+                                "user.email=bench@example"};
+  full.insert(full.end(), args.begin(), args.end());
+  auto result = executor.execute(full);
+  if (result.exit_code != 0) {
+    throw SlayerGitException("git " + args.front() +
+                             " failed: " + result.stderr_output);
+  }
+}
+
+} // namespace
+
+// Watch mode in a clone: each git operation must be dispatched as a single
+// refresh of the views it affects and nothing else, a burst of file
+// writes must collapse into a few refreshes, and ignored build output must
+// refresh nothing unless it is tracked. Reports the time to set up the
+// watches and the delay from an operation to its dispatch.
+SLAYERGIT_BENCH(repo_watcher) {
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-watch-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  std::string clone = (scratch / "work").string();
+  infra::GitProcessExecutor source(context.repo_path());
+  run(source, {"clone", "-q", "--shared", ".", clone});
+  infra::GitProcessExecutor executor(clone);
+  std::string tracked = executor.execute({"ls-files"}).stdout_output;
+  tracked = tracked.substr(0, tracked.find('\n'));
+  // Build output: one ignored directory holding a tracked file, and one
+  // created after the watches
+  std::ofstream(clone + "/.git/info/exclude", std::ios::app) << "/build-*/\n";
+  std::filesystem::create_directories(clone + "/build-kept");
+  std::ofstream(clone + "/build-kept/tracked") << "kept\n";
+  run(executor, {"add", "-f", "build-kept/tracked"});
+  run(executor, {"commit", "-q", "-m", "tracked in an ignored directory"});
+
+  core::RepoWatcher::Options options;
+  options.debounce = debounce;
+  options.max_delay = max_delay;
+  core::RepoWatcher watcher(clone, options);
+  Recorder recorder;
+  double setup = time_us([&] {
+    watcher.start([&](const auto &change) { recorder.add(change); });
+  });
+  context.report("watch_setup", setup / 1000.0, "ms");
+  context.report("watches", static_cast<double>(watcher.stats().watches),
+                 "count");
+  if (watcher.stats().watch_limit_reached) {
+    throw SlayerGitException("fs.inotify.max_user_watches is too low");
+  }
+
+  struct Step {
+    std::string name;
+    std::function<void()> action;
+    uint32_t required;
+    uint32_t forbidden;
+  };
+  auto edit = [&] { std::ofstream(clone + "/" + tracked, std::ios::app) << "x\n"; };
+  std::vector<Step> steps{
+      {"edit", edit, core::RefreshStatus,
+       core::RefreshBranches | core::RefreshTags | core::RefreshCommits},
+      {"add", [&] { run(executor, {"add", tracked}); }, core::RefreshStatus,
+       core::RefreshBranches | core::RefreshTags | core::RefreshCommits},
+      {"commit", [&] { run(executor, {"commit", "-q", "-m", "bench"}); },
+       core::RefreshCommits | core::RefreshBranches | core::RefreshReflog,
+       core::RefreshTags | core::RefreshStashes},
+      {"tag", [&] { run(executor, {"tag", "bench-tag"}); }, core::RefreshTags,
+       core::RefreshStatus | core::RefreshBranches | core::RefreshCommits},
+      {"branch", [&] { run(executor, {"branch", "bench-branch"}); },
+       core::RefreshBranches, core::RefreshStatus | core::RefreshTags},
+      {"stash",
+       [&] {
+         edit();
+         run(executor, {"stash", "-q"});
+       },
+       core::RefreshStashes | core::RefreshStatus, core::RefreshTags},
+  };
+  for (const auto &step : steps) {
+    step.action();
+    auto dispatched = recorder.settle();
+    if (dispatched.changes.empty()) {
+      throw SlayerGitException(step.name + " was not noticed");
+    }
+    uint32_t scopes = 0;
+    for (const auto &change : dispatched.changes) {
+      scopes |= change.scopes;
+    }
+    if ((scopes & step.required) != step.required ||
+        (scopes & step.forbidden) != 0) {
+      throw SlayerGitException(step.name + " refreshed " +
+                               core::describe_scopes(scopes));
+    }
+  }
+
+  // Latency: a plain edit to its dispatch, debounce included
+  edit();
+  auto edited = std::chrono::steady_clock::now();
+  auto dispatched = recorder.settle();
+  if (dispatched.changes.empty()) {
+    throw SlayerGitException("edit was not noticed");
+  }
+  context.report("edit_to_refresh",
+                 std::chrono::duration<double, std::milli>(
+                     dispatched.first_at - edited)
+                     .count(),
+                 "ms");
+
+  // A burst, such as a checkout or a build writing files
+  auto before = watcher.stats();
+  double burst = time_us([&] {
+    std::filesystem::create_directories(clone + "/burst");
+    for (size_t i = 0; i < burst_files; ++i) {
+      std::ofstream(clone + "/burst/" + std::to_string(i)) << i;
+    }
+  });
+  auto changes = recorder.settle().changes;
+  auto after = watcher.stats();
+  size_t allowed =
+      static_cast<size_t>(burst / 1000.0 / max_delay.count()) + 2;
+  if (changes.empty() || changes.size() > allowed) {
+    throw SlayerGitException("burst caused " + std::to_string(changes.size()) +
+                             " refreshes");
+  }
+  context.report("burst_events",
+                 static_cast<double>(after.events - before.events), "count");
+  context.report("burst_refreshes", static_cast<double>(changes.size()),
+                 "count");
+
+  before = watcher.stats();
+  for (const char *dir : {"/build-kept/", "/build-new/", "/build-new/obj/"}) {
+    std::filesystem::create_directories(clone + dir);
+    for (size_t i = 0; i < 100; ++i) {
+      std::ofstream(clone + dir + std::to_string(i) + ".o") << i;
+    }
+  }
+  changes = recorder.settle().changes;
+  if (!changes.empty()) {
+    throw SlayerGitException("ignored build output refreshed " +
+                             core::describe_scopes(changes.front().scopes));
+  }
+  context.report("ignored_events",
+                 static_cast<double>(watcher.stats().events - before.events),
+                 "count");
+  std::ofstream(clone + "/build-kept/tracked", std::ios::app) << "x\n";
+  changes = recorder.settle().changes;
+  if (changes.empty() || (changes.front().scopes & core::RefreshStatus) == 0) {
+    throw SlayerGitException(
+        "an edit to a tracked file in an ignored directory was not noticed");
+  }
+}
@@ -0,0 +1,236 @@
+#include "bench.hpp"
+
+#include "infra/diff/diff_engine.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+#include "ui/syntax/diff_highlighter.hpp"
+#include "ui/tabs/diff_tab.hpp"
+
+#include <ftxui/screen/screen.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr size_t target_lines = 50'000;
+constexpr size_t viewport_rows = 50;
+constexpr int runs = 9;
+
+// Stand-in for repositories without C-family code, such as the generated
+// bench fixtures. Covers comments, strings, numbers, keywords and braces.
+constexpr const char *synthetic_source = R"(// Generated sample for the highlighter
+#include <string>
+#include <vector>
+
+/* A block comment that spans
+   two lines */
+namespace sample {
+
+struct Entry {
+  std::string name;
+  int count = 0;
+};
+
+int total(const std::vector<Entry> &entries) {
+  int sum = 0x10;
+  for (const auto &entry : entries) {
+    if (entry.name == "skip \"quoted\"") {
+      continue;
+    }
+    sum += entry.count * 2.5e1;
+  }
+  return sum; // trailing comment
+}
+
+} // namespace sample
+)";
+
+// The repository's own C-family sources, concatenated and repeated until
+// the text has `target_lines` lines
+std::string source_text(const std::string &repo_path) {
+  infra::GitProcessExecutor executor(repo_path);
+  auto files = executor.execute({"ls-files", "*.cpp", "*.hpp", "*.c", "*.h",
+                                 "*.cc", "*.java", "*.go", "*.rs", "*.js"});
+  std::string sources;
+  std::istringstream paths(files.stdout_output);
+  std::string path;
+  while (std::getline(paths, path)) {
+    std::ifstream file(repo_path + "/" + path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    sources += content.str();
+    if (!sources.empty() && sources.back() != '\n') {
+      sources += '\n';
+    }
+  }
+  if (sources.empty()) {
+    sources = synthetic_source;
+  }
+
+  std::string text;
+  size_t lines = 0;
+  while (lines < target_lines) {
+    for (size_t pos = 0; pos < sources.size() && lines < target_lines;) {
+      size_t end = sources.find('\n', pos);
+      text.append(sources, pos, end + 1 - pos);
+      pos = end + 1;
+      ++lines;
+    }
+  }
+  return text;
+}
+
+// Changes roughly one line in `every`, so the diff has many hunks
+std::string mutate(const std::string &text, size_t every) {
+  std::mt19937 random(7);
+  std::string result;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find('\n', pos);
+    std::string line = text.substr(pos, end + 1 - pos);
+    if (random() % every == 0) {
+      line = "    int changed_" + std::to_string(pos) + " = 0; // edit\n";
+    }
+    result += line;
+    pos = end + 1;
+  }
+  return result;
+}
+
+std::vector<ui::DiffHighlighter::FileDiffPtr>
+make_diff(const std::string &old_text, const std::string &new_text) {
+  infra::DiffOptions options;
+  options.max_input_bytes = size_t{1} << 30;
+  auto file = infra::DiffEngine::diff(old_text, new_text, options);
+  file.old_path = file.new_path = "bench/generated.cpp";
+  return {std::make_shared<const core::FileDiff>(std::move(file))};
+}
+
+void touch_viewport(ui::DiffHighlighter &highlighter, size_t first) {
+  size_t last = std::min(first + viewport_rows, highlighter.row_count());
+  for (size_t row = first; row < last; ++row) {
+    highlighter.spans(row);
+  }
+}
+
+// Spans reached through checkpoints must equal a top-to-bottom pass
+void check_random_access(
+    const std::vector<ui::DiffHighlighter::FileDiffPtr> &files) {
+  ui::DiffHighlighter sequential(files);
+  std::vector<std::vector<ui::StyledSpan>> expected;
+  for (size_t row = 0; row < sequential.row_count(); ++row) {
+    expected.push_back(sequential.spans(row));
+  }
+
+  ui::DiffHighlighter jumping(files, {64, 8});
+  std::mt19937 random(11);
+  for (int i = 0; i < 2000; ++i) {
+    size_t row = random() % expected.size();
+    const auto &actual = jumping.spans(row);
+    bool same = actual.size() == expected[row].size();
+    for (size_t s = 0; same && s < actual.size(); ++s) {
+      same = actual[s].begin == expected[row][s].begin &&
+             actual[s].length == expected[row][s].length &&
+             actual[s].kind == expected[row][s].kind;
+    }
+    if (!same) {
+      throw SlayerGitException("highlight mismatch at row " +
+                               std::to_string(row));
+    }
+  }
+}
+
+void measure(bench::BenchContext &context, const std::string &prefix,
+             const std::vector<ui::DiffHighlighter::FileDiffPtr> &files) {
+  size_t rows = ui::DiffHighlighter(files).row_count();
+  context.report(prefix + ".rows", static_cast<double>(rows), "rows");
+
+  // What highlighting everything on each render would cost
+  context.report(prefix + ".full_pass", median_us(runs, [&] {
+                   ui::DiffHighlighter highlighter(files, {256, rows});
+                   for (size_t row = 0; row < rows; ++row) {
+                     highlighter.spans(row);
+                   }
+                 }) / 1000.0,
+                 "ms");
+
+  context.report(prefix + ".top_viewport", median_us(runs, [&] {
+                   ui::DiffHighlighter highlighter(files);
+                   touch_viewport(highlighter, 0);
+                 }),
+                 "us");
+
+  // A cold jump scans state-only from the hunk header; a second jump
+  // resumes from the checkpoints the first one left behind
+  size_t far = rows * 9 / 10;
+  size_t middle = rows / 2;
+  uint64_t scanned = 0;
+  std::vector<double> far_samples;
+  std::vector<double> back_samples;
+  for (int i = 0; i < runs; ++i) {
+    ui::DiffHighlighter highlighter(files);
+    far_samples.push_back(time_us([&] { touch_viewport(highlighter, far); }));
+    scanned = highlighter.stats().rows_scanned;
+    back_samples.push_back(
+        time_us([&] { touch_viewport(highlighter, middle); }));
+  }
+  std::sort(far_samples.begin(), far_samples.end());
+  std::sort(back_samples.begin(), back_samples.end());
+  context.report(prefix + ".far_jump", far_samples[runs / 2], "us");
+  context.report(prefix + ".far_jump.scanned", static_cast<double>(scanned),
+                 "rows");
+  context.report(prefix + ".jump_back", back_samples[runs / 2], "us");
+
+  // Scrolling one row at a time: each step lexes the one new row
+  ui::DiffHighlighter highlighter(files);
+  touch_viewport(highlighter, middle);
+  size_t steps = 1000;
+  double scroll = time_us([&] {
+    for (size_t step = 1; step <= steps; ++step) {
+      touch_viewport(highlighter, middle + step);
+    }
+  });
+  context.report(prefix + ".scroll_step", scroll / steps, "us");
+}
+
+// Laying out a DiffTab frame after moving the cursor deep into the diff
+double
+tab_frame_us(const std::vector<ui::DiffHighlighter::FileDiffPtr> &files) {
+  auto tab = std::make_shared<ui::DiffTab>();
+  tab->set_file_diff(files.front());
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(120),
+                                      ftxui::Dimension::Fixed(viewport_rows));
+  ftxui::Render(screen, tab->render());
+  size_t row = tab->row_count() / 2;
+  return median_us(101, [&] {
+    tab->list()->select(row++);
+    ftxui::Render(screen, tab->render());
+  });
+}
+
+} // namespace
+
+// Viewport-limited highlighting of a ~50k-line diff: cost of the first
+// screen, of a far jump, of scrolling, against highlighting all of it
+SLAYERGIT_BENCH(syntax_highlight) {
+  std::string text = source_text(context.repo_path());
+  auto new_file = make_diff("", text);
+  auto edited = make_diff(text, mutate(text, 40));
+
+  check_random_access(new_file);
+  check_random_access(edited);
+
+  measure(context, "new_file", new_file);
+  measure(context, "edited", edited);
+  context.report("tab_frame", tab_frame_us(new_file), "us");
+}
@@ -0,0 +1,263 @@
+#include "bench.hpp"
+
+#include "core/untracked.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace slayergit;
+using slayergit::bench::median_us;
+
+namespace {
+
+constexpr int runs = 5;
+constexpr size_t untracked_files = 5000;
+constexpr size_t expanded_dirs = 20;
+
+const infra::CancellationToken never;
+
+std::string run(infra::GitProcessExecutor &executor,
+                const std::vector<std::string> &args) {
+  auto result = executor.execute(args);
+  if (result.exit_code != 0) {
+    throw SlayerGitException("git " + args.front() +
+                             " failed: " + result.stderr_output);
+  }
+  return result.stdout_output;
+}
+
+void write(const std::filesystem::path &path, const std::string &text) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path, std::ios::binary) << text;
+}
+
+// Rules covering what gitignore allows: negation, directory-only,
+// anchored and "**" patterns, classes, escapes, nested files and
+// info/exclude
+void add_ignore_rules(const std::string &clone, const std::string &tracked_dir,
+                      const std::string &common_dir) {
+  write(clone + "/.gitignore", "# build output\n"
+                               "*.o\n"
+                               "/build/\n"
+                               "logs/\n"
+                               "!logs/keep.log\n"
+                               "*.tmp\n"
+                               "!important.tmp\n"
+                               "doc/**/*.pdf\n"
+                               "**/cache\n"
+                               "[Tt]emp[0-9]*\n"
+                               "\\#hash\n"
+                               "trailing\\ \n"
+                               "spaces   \n");
+  write(clone + "/" + tracked_dir + "/.gitignore", "*.c\n"
+                                                   "!u1*.c\n"
+                                                   "/local\n"
+                                                   "deep/**\n");
+  write(common_dir + "/info/exclude", "*.swp\n");
+}
+
+// Untracked files among the tracked ones and in new directories, some of
+// them shown and some ignored
+void add_untracked(const std::string &clone,
+                   const std::vector<std::string> &tracked_dirs) {
+  static const char *const names[] = {"u%.c",  "u%.o",    "u%.tmp",
+                                      "important.tmp", "Temp%", "temp%.x",
+                                      "#hash", "u%.swp", "trailing ",
+                                      "spaces", "u%.txt"};
+  constexpr size_t name_count = sizeof(names) / sizeof(names[0]);
+  for (size_t i = 0; i < untracked_files; ++i) {
+    std::string name = names[i % name_count];
+    size_t percent = name.find('%');
+    if (percent != std::string::npos) {
+      name.replace(percent, 1, std::to_string(i));
+    }
+    const std::string &dir = tracked_dirs[i % tracked_dirs.size()];
+    if (i % 7 == 0) {
+      write(clone + "/new" + std::to_string(i % 50) + "/a/b/" + name, "x");
+    } else {
+      write(clone + "/" + dir + "/" + name, "x");
+    }
+  }
+  const std::string &first = tracked_dirs.front();
+  for (const char *path :
+       {"build/out.bin", "logs/keep.log", "logs/a.log", "doc/x/y/z.pdf",
+        "doc/x/y/z.txt", "cache/c", "deeper/cache/c", "only_ignored/q.o",
+        "only_ignored/sub/r.tmp", "build2/build/x"}) {
+    write(clone + "/" + path, "x");
+  }
+  for (const char *path : {"local/x", "sub/local/y", "deep/z", "u1.c", "u2.c"}) {
+    write(clone + "/" + first + "/" + path, "x");
+  }
+  std::filesystem::create_directories(clone + "/empty/dir");
+}
+
+// "?? <path>" entries of `git status --porcelain -z`
+std::vector<std::string> git_untracked(infra::GitProcessExecutor &executor,
+                                       const std::string &mode) {
+  std::string output =
+      run(executor, {"status", "--porcelain", "-z", "--untracked-files=" + mode});
+  std::vector<std::string> paths;
+  size_t start = 0;
+  while (start < output.size()) {
+    size_t end = output.find('\0', start);
+    std::string entry = output.substr(start, end - start);
+    if (entry.compare(0, 3, "?? ") == 0) {
+      paths.push_back(entry.substr(3));
+    }
+    start = end + 1;
+  }
+  return paths;
+}
+
+void check(const std::vector<std::string> &ours,
+           const std::vector<std::string> &git, const std::string &what) {
+  if (ours == git) {
+    return;
+  }
+  std::set<std::string> a(ours.begin(), ours.end());
+  std::set<std::string> b(git.begin(), git.end());
+  for (const auto &path : a) {
+    if (b.count(path) == 0) {
+      throw SlayerGitException(what + ": git does not list " + path);
+    }
+  }
+  for (const auto &path : b) {
+    if (a.count(path) == 0) {
+      throw SlayerGitException(what + ": missing " + path);
+    }
+  }
+  throw SlayerGitException(what + ": order differs from git");
+}
+
+// Each collapsed directory opens into its files and collapsed children, as
+// the full listing has them
+void check_expand(core::UntrackedScanner &scanner,
+                  const std::vector<std::string> &collapsed,
+                  const std::vector<std::string> &all) {
+  size_t expanded = 0;
+  for (const auto &dir : collapsed) {
+    if (dir.back() != '/' || expanded == expanded_dirs) {
+      continue;
+    }
+    bool nested_repo = std::find(all.begin(), all.end(), dir) != all.end();
+    if (nested_repo) {
+      continue;
+    }
+    std::set<std::string> expected;
+    for (const auto &path : all) {
+      if (path.compare(0, dir.size(), dir) == 0) {
+        size_t slash = path.find('/', dir.size());
+        expected.insert(path.substr(0, slash == std::string::npos ? slash
+                                                                  : slash + 1));
+      }
+    }
+    auto children = scanner.expand(dir, never);
+    if (std::set<std::string>(children.begin(), children.end()) != expected) {
+      throw SlayerGitException("expanding " + dir + " differs from git");
+    }
+    ++expanded;
+  }
+}
+
+} // namespace
+
+// Untracked files of a clone with ignore rules of every kind, listed by
+// UntrackedScanner and by git. Fails if the collapsed listing differs from
+// `git status --untracked-files=normal`, the full one from `=all`, or an
+// expanded directory from the full listing.
+SLAYERGIT_BENCH(untracked) {
+  auto scratch = std::filesystem::temp_directory_path() /
+                 ("slayergit-untracked-bench-" + std::to_string(getpid()));
+  std::filesystem::create_directories(scratch);
+  struct Cleanup {
+    std::filesystem::path path;
+    ~Cleanup() {
+      std::error_code ignored;
+      std::filesystem::remove_all(path, ignored);
+    }
+  } cleanup{scratch};
+
+  std::string clone = (scratch / "work").string();
+  infra::GitProcessExecutor source(context.repo_path());
+  run(source, {"clone", "-q", "--shared", ".", clone});
+  infra::GitProcessExecutor executor(clone);
+
+  auto tracked = core::list_tracked_paths(executor, never);
+  std::set<std::string> dir_set;
+  for (const auto &path : tracked) {
+    size_t slash = path.rfind('/');
+    if (slash != std::string::npos && slash + 1 < path.size()) {
+      dir_set.insert(path.substr(0, slash));
+    }
+  }
+  if (dir_set.empty()) {
+    throw SlayerGitException("no tracked directories");
+  }
+  std::vector<std::string> tracked_dirs(dir_set.begin(), dir_set.end());
+  add_ignore_rules(clone, tracked_dirs.front(), clone + "/.git");
+  add_untracked(clone, tracked_dirs);
+  run(executor, {"init", "-q", "nested-repo"});
+
+  core::UntrackedScanner::Options options;
+  options.excludes_file = core::excludes_file_path(executor);
+  core::UntrackedScanner scanner(clone, options);
+
+  auto collapsed = scanner.scan(tracked, never);
+  auto all = scanner.scan_all(tracked, never);
+  check(collapsed, git_untracked(executor, "normal"), "normal");
+  check(all, git_untracked(executor, "all"), "all");
+  check_expand(scanner, collapsed, all);
+  context.report("untracked_entries", static_cast<double>(collapsed.size()),
+                 "count");
+  context.report("untracked_files", static_cast<double>(all.size()), "count");
+
+  context.report("list_tracked", median_us(runs, [&] {
+                   core::list_tracked_paths(executor, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("scan", median_us(runs, [&] {
+                   scanner.scan(tracked, never);
+                 }) / 1000.0,
+                 "ms");
+  context.report("scan_all", median_us(runs, [&] {
+                   scanner.scan_all(tracked, never);
+                 }) / 1000.0,
+                 "ms");
+
+  // Fixed thread counts, whatever the machine has; threads racing over
+  // the same tree must still agree with git
+  for (size_t threads : {size_t{1}, size_t{4}}) {
+    options.threads = threads;
+    core::UntrackedScanner fixed(clone, options);
+    check(fixed.scan_all(tracked, never), all,
+          std::to_string(threads) + " threads");
+    context.report("scan_all_threads_" + std::to_string(threads),
+                   median_us(runs, [&] {
+                     fixed.scan_all(tracked, never);
+                   }) / 1000.0,
+                   "ms");
+    if (threads > 1) {
+      context.report("steals_per_scan",
+                     static_cast<double>(fixed.stats().steals) / (runs + 1),
+                     "count");
+    }
+  }
+
+  context.report("git_ls_files_others", median_us(runs, [&] {
+                   run(executor, {"ls-files", "-z", "--others",
+                                  "--exclude-standard"});
+                 }) / 1000.0,
+                 "ms");
+  context.report("git_status_untracked_all", median_us(runs, [&] {
+                   git_untracked(executor, "all");
+                 }) / 1000.0,
+                 "ms");
+}
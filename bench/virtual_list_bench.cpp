@@ -0,0 +1,52 @@
+#include "bench.hpp"
+
+#include "ui/components/virtual_list.hpp"
+
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace slayergit;
+using slayergit::bench::time_us;
+
+namespace {
+
+constexpr int frames = 200;
+
+// Average time to lay out and draw one 120x40 frame of a list
+double frame_us(size_t row_count, bool select_last, size_t &rows_built) {
+  auto list = std::make_shared<ui::VirtualList>(
+      [row_count] { return row_count; },
+      [](size_t row, bool) {
+        return ftxui::text("row " + std::to_string(row));
+      });
+  if (select_last) {
+    list->select_last();
+  }
+
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(120),
+                                      ftxui::Dimension::Fixed(40));
+  double total = time_us([&] {
+    for (int i = 0; i < frames; ++i) {
+      ftxui::Render(screen, list->render());
+    }
+  });
+  rows_built = list->rows_built_last_frame();
+  return total / frames;
+}
+
+} // namespace
+
+// Frame cost must not depend on the number of rows in the list
+SLAYERGIT_BENCH(virtual_list_render) {
+  size_t rows_built = 0;
+  context.report("rows_10", frame_us(10, false, rows_built), "us/frame");
+  context.report("rows_10.built", static_cast<double>(rows_built), "rows");
+  context.report("rows_10M", frame_us(10'000'000, false, rows_built),
+                 "us/frame");
+  context.report("rows_10M.built", static_cast<double>(rows_built), "rows");
+  context.report("rows_10M_at_end", frame_us(10'000'000, true, rows_built),
+                 "us/frame");
+}
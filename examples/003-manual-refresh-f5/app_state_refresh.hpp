@@ -3,12 +3,17 @@
 
 #pragma once
 
+#include "core/diff_cache.hpp"
 #include "core/git_repository.hpp"
 #include "core/models/branch.hpp"
 #include "core/models/commit.hpp"
 #include "core/models/repository_status.hpp"
+#include "core/refresh_slot.hpp"
+#include "infra/cat_file_pool.hpp"
+#include "infra/task_executor.hpp"
 #include <future>
 #include <memory>
+#include <utility>
 #include <vector>
 
 
@@ -16,6 +21,15 @@ namespace slayergit::app {
 
 class AppState {
 public:
+  // The slot and the cache use `tasks` and `objects`, so those are
+  // members declared (and initialized) before them
+  AppState(std::shared_ptr<core::GitRepository> repo,
+           std::shared_ptr<infra::TaskExecutor> tasks,
+           std::shared_ptr<infra::CatFilePool> objects)
+      : _repo(std::move(repo)), _tasks(std::move(tasks)),
+        _objects(std::move(objects)), _diff_slot(*_tasks),
+        _diff_cache(*_tasks, core::DiffCache::blob_loader(*_objects)) {}
+
   // Full refresh triggered by F5 - refreshes ALL repository data
   void refresh_all() {
     // Launch async operations for all Git data
@@ -42,9 +56,17 @@ public:
   void refresh_stashes();  // After stash operations
   void refresh_tags();     // After tag operations
   void refresh_diff();     // When selection changes
+  void refresh_file_diff(); // When the cursor moves in a file list
 
 private:
   std::shared_ptr<core::GitRepository> _repo;
+  // Shared background pool; see async_refresh_pattern.cpp
+  std::shared_ptr<infra::TaskExecutor> _tasks;
+  std::shared_ptr<infra::CatFilePool> _objects;
+  // Newer diff requests supersede older ones (core::RefreshSlot)
+  core::RefreshSlot _diff_slot;
+  // Per-file diffs by blob pair, with the cursor's neighbours prefetched
+  core::DiffCache _diff_cache;
 
   // Cached repository data
   core::RepositoryStatus _status;
@@ -55,6 +77,10 @@ private:
   std::vector<core::Stash> _stashes;
   std::vector<core::Tag> _tags;
   core::Diff _current_diff;
+  // Rows of the focused file list (Unstaged, Staged or a commit's files)
+  std::vector<core::DiffKey> _file_rows;
+  size_t _selected_file_row = 0;
+  core::DiffCache::DiffPtr _current_file_diff;
 
   // Observer management
   std::vector<Observer *> _observers;
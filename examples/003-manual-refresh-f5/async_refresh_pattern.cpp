@@ -2,7 +2,9 @@
 // Reference: Async refresh implementation with thread safety
 
 #include "app/app_state.hpp"
-#include <future>
+#include "core/diff_cache.hpp"
+#include "core/refresh_slot.hpp"
+#include "infra/task_executor.hpp"
 #include <mutex>
 #include <vector>
 
@@ -13,49 +15,59 @@ void AppState::refresh_all() {
   _is_loading = true;
   notify_loading_state_changed();
 
-  // Launch all async operations in parallel
-  std::vector<std::future<void>> futures;
+  // Each source is a task on the shared pool (infra::TaskExecutor). The
+  // focused window's data gets the Focused priority so it loads first;
+  // concurrency is bounded by the pool size, not by the number of sources.
+  auto priority_for = [this](WindowKind kind) {
+    return kind == _focused_window_kind ? infra::TaskPriority::Focused
+                                        : infra::TaskPriority::Visible;
+  };
+
+  std::vector<infra::TaskHandle> loads;
 
   // Each lambda captures 'this' and updates state with proper locking
-  futures.push_back(std::async(std::launch::async, [this]() {
-    auto status = _repo->get_status();
-    std::lock_guard<std::mutex> lock(_state_mutex);
-    _status = std::move(status);
-    _status_dirty = true;
-  }));
+  loads.push_back(_tasks->post(
+      [this]() {
+        auto status = _repo->get_status();
+        std::lock_guard<std::mutex> lock(_state_mutex);
+        _status = std::move(status);
+        _status_dirty = true;
+      },
+      priority_for(WindowKind::Status)));
 
-  futures.push_back(std::async(std::launch::async, [this]() {
-    auto branches = _repo->get_local_branches();
-    std::lock_guard<std::mutex> lock(_state_mutex);
-    _local_branches = std::move(branches);
-    _branches_dirty = true;
-  }));
+  loads.push_back(_tasks->post(
+      [this]() {
+        auto branches = _repo->get_local_branches();
+        std::lock_guard<std::mutex> lock(_state_mutex);
+        _local_branches = std::move(branches);
+        _branches_dirty = true;
+      },
+      priority_for(WindowKind::Branches)));
 
-  futures.push_back(std::async(std::launch::async, [this]() {
-    auto commits = _repo->get_log();
-    std::lock_guard<std::mutex> lock(_state_mutex);
-    _commits = std::move(commits);
-    _commits_dirty = true;
-  }));
-
-  // ... more futures for reflog, stashes, tags, etc.
-
-  // Wait for all to complete (in another background thread to not block UI)
-  std::async(std::launch::async,
-             [this, futures = std::move(futures)]() mutable {
-               // Wait for all futures
-               for (auto &future : futures) {
-                 future.get();
-               }
-
-               // All done - notify observers on main thread
-               // (In real implementation, use FTXUI's post_to_main_thread or
-               // similar)
-               post_to_main_thread([this]() {
-                 _is_loading = false;
-                 notify_all_observers();
-               });
-             });
+  loads.push_back(_tasks->post(
+      [this]() {
+        auto commits = _repo->get_log();
+        std::lock_guard<std::mutex> lock(_state_mutex);
+        _commits = std::move(commits);
+        _commits_dirty = true;
+      },
+      priority_for(WindowKind::Log)));
+
+  // ... more tasks for reflog, stashes, tags, etc.
+
+  // Continuation: runs once every load has finished. No thread sits
+  // blocked on futures while the loads are in flight.
+  _tasks->post(
+      [this]() {
+        // All done - notify observers on main thread
+        // (In real implementation, use FTXUI's post_to_main_thread or
+        // similar)
+        post_to_main_thread([this]() {
+          _is_loading = false;
+          notify_all_observers();
+        });
+      },
+      infra::TaskPriority::Focused, loads);
 }
 
 // Targeted refresh - simpler, just one async operation
@@ -77,4 +89,52 @@ void AppState::refresh_status() {
   }
 }
 
+// Selection-driven refresh - every cursor move requests a new diff. The
+// slot (core::RefreshSlot) cancels the previous request, which sends
+// SIGTERM to its `git diff`, and drops its result if it still finishes.
+// Only the row the cursor rests on is published.
+void AppState::refresh_diff() {
+  auto commit = _selected_commit;
+  _diff_slot.request(
+      [this, commit](const infra::CancellationToken &token) {
+        // The token reaches GitProcessExecutor, which kills git on cancel
+        return _repo->get_diff_commit(commit, token);
+      },
+      [this](core::Diff diff) {
+        {
+          std::lock_guard<std::mutex> lock(_state_mutex);
+          _current_diff = std::move(diff);
+        }
+        post_to_main_thread([this]() { notify_diff_observers(); });
+      });
+}
+
+// File-list cursor moves go through core::DiffCache: a hit is published
+// straight away, a miss loads in the slot as above. Either way the rows
+// around the cursor are then prefetched at Background priority, so holding
+// an arrow key mostly lands on diffs that are already cached.
+void AppState::refresh_file_diff() {
+  if (_selected_file_row >= _file_rows.size()) {
+    return;
+  }
+  auto key = _file_rows[_selected_file_row];
+  _diff_slot.request(
+      [this, key](const infra::CancellationToken &token) {
+        return _diff_cache.get(key, token);
+      },
+      [this](core::DiffCache::DiffPtr diff) {
+        {
+          std::lock_guard<std::mutex> lock(_state_mutex);
+          _current_file_diff = std::move(diff);
+        }
+        post_to_main_thread([this]() { notify_diff_observers(); });
+      });
+
+  std::vector<core::DiffKey> neighbours;
+  for (size_t row : core::rows_around(_selected_file_row, _file_rows.size())) {
+    neighbours.push_back(_file_rows[row]);
+  }
+  _diff_cache.prefetch(neighbours);
+}
+
 } // namespace slayergit::app
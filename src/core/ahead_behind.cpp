@@ -0,0 +1,434 @@
+#include "ahead_behind.hpp"
+
+#include "core/commit_graph.hpp"
+#include "infra/exceptions.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <string_view>
+#include <utility>
+
+namespace slayergit::core {
+
+namespace {
+
+constexpr uint32_t no_node = 0xffffffff;
+constexpr uint32_t no_pair = 0xffffffff;
+// Pops between cancellation checks
+constexpr uint64_t cancel_check_interval = 1024;
+
+// The commits a walk can reach: positions in the commit-graph, then the
+// commits loaded from git, numbered after them
+class History {
+public:
+  explicit History(std::unique_ptr<CommitGraph> graph)
+      : graph_(std::move(graph)), base_(graph_ ? graph_->size() : 0) {}
+
+  [[nodiscard]] uint32_t find(const std::string &hex) const {
+    auto loaded = loaded_ids_.find(hex);
+    if (loaded != loaded_ids_.end()) {
+      return base_ + loaded->second;
+    }
+    if (graph_) {
+      uint32_t position = graph_->find_hex(hex);
+      if (position != CommitGraph::no_position) {
+        return position;
+      }
+    }
+    return no_node;
+  }
+
+  // Loads the commits reachable from `missing` but not from `known`. A
+  // commit-graph is closed under parents, so with `known` being the tips
+  // found in it, every parent is either loaded here or in the graph.
+  void load(infra::GitProcessExecutor &executor,
+            const std::vector<std::string> &missing,
+            const std::vector<std::string> &known,
+            const infra::CancellationToken &token) {
+    // Topological order lists children first, so generations can be
+    // assigned in one backwards pass
+    std::vector<std::string> args{"rev-list", "--topo-order", "--parents"};
+    args.insert(args.end(), missing.begin(), missing.end());
+    if (!known.empty()) {
+      args.push_back("--not");
+      args.insert(args.end(), known.begin(), known.end());
+    }
+    auto result = executor.execute(args, token);
+    if (result.exit_code != 0) {
+      throw GitCommandException("git rev-list", result.exit_code,
+                                result.stderr_output);
+    }
+
+    std::vector<std::string_view> lines;
+    std::string_view output = result.stdout_output;
+    while (!output.empty()) {
+      size_t end = output.find('\n');
+      std::string_view line = output.substr(0, end);
+      output.remove_prefix(end == std::string_view::npos ? output.size()
+                                                         : end + 1);
+      if (!line.empty()) {
+        lines.push_back(line);
+      }
+    }
+    for (size_t i = 0; i < lines.size(); ++i) {
+      loaded_ids_.emplace(std::string(lines[i].substr(0, lines[i].find(' '))),
+                          static_cast<uint32_t>(i));
+    }
+
+    parent_begin_.assign(1, 0);
+    std::string parent;
+    for (std::string_view line : lines) {
+      size_t space = line.find(' ');
+      while (space != std::string_view::npos) {
+        size_t next = line.find(' ', space + 1);
+        parent.assign(line.substr(space + 1, next - space - 1));
+        // Missing parents (shallow clones) simply end the history
+        uint32_t node = find(parent);
+        if (node != no_node) {
+          parent_nodes_.push_back(node);
+        }
+        space = next;
+      }
+      parent_begin_.push_back(static_cast<uint32_t>(parent_nodes_.size()));
+    }
+
+    generations_.assign(lines.size(), 0);
+    for (size_t i = lines.size(); i-- > 0;) {
+      uint64_t generation = 0;
+      for (uint32_t p = parent_begin_[i]; p < parent_begin_[i + 1]; ++p) {
+        generation = std::max(generation, this->generation(parent_nodes_[p]));
+      }
+      generations_[i] = generation + 1;
+    }
+  }
+
+  [[nodiscard]] uint64_t generation(uint32_t node) const {
+    return node < base_ ? graph_->generation(node) : generations_[node - base_];
+  }
+
+  void parents(uint32_t node, std::vector<uint32_t> &out) const {
+    if (node < base_) {
+      graph_->parents(node, out);
+      return;
+    }
+    uint32_t index = node - base_;
+    out.assign(parent_nodes_.begin() + parent_begin_[index],
+               parent_nodes_.begin() + parent_begin_[index + 1]);
+  }
+
+  [[nodiscard]] size_t loaded() const { return generations_.size(); }
+
+private:
+  std::unique_ptr<CommitGraph> graph_;
+  uint32_t base_;
+  std::unordered_map<std::string, uint32_t> loaded_ids_;
+  std::vector<uint64_t> generations_;
+  std::vector<uint32_t> parent_begin_;
+  std::vector<uint32_t> parent_nodes_;
+};
+
+// The pairs sharing one upstream. Most branches track the same few
+// upstreams, so a commit's counts come from a few word operations per
+// group instead of a test per pair.
+struct Group {
+  uint32_t upstream_bit = 0;
+  size_t first_word = 0;
+  std::vector<uint64_t> mask;    // Tip bits, from first_word on
+  std::vector<uint32_t> pair_at; // Pair of each tip bit in the mask
+};
+
+bool test_bit(const uint64_t *bits, uint32_t bit) {
+  return (bits[bit / 64] >> (bit % 64)) & 1;
+}
+
+// Tips in the group whose reachability of this commit differs from the
+// upstream's, for one word
+uint64_t differing(const Group &group, const uint64_t *bits, size_t word,
+                   bool upstream_reaches) {
+  uint64_t mask = group.mask[word];
+  uint64_t tips = bits[group.first_word + word];
+  return upstream_reaches ? mask & ~tips : mask & tips;
+}
+
+// A commit matters to a pair only if exactly one side reaches it. Its
+// ancestors inherit its set, so once every queued commit is balanced for
+// every pair, no count can change.
+bool unbalanced(const std::vector<Group> &groups, const uint64_t *bits) {
+  for (const auto &group : groups) {
+    bool upstream_reaches = test_bit(bits, group.upstream_bit);
+    for (size_t word = 0; word < group.mask.size(); ++word) {
+      if (differing(group, bits, word, upstream_reaches) != 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void accumulate(const std::vector<Group> &groups, const uint64_t *bits,
+                std::vector<AheadBehind> &results) {
+  for (const auto &group : groups) {
+    bool upstream_reaches = test_bit(bits, group.upstream_bit);
+    for (size_t word = 0; word < group.mask.size(); ++word) {
+      uint64_t pending = differing(group, bits, word, upstream_reaches);
+      while (pending != 0) {
+        int bit = __builtin_ctzll(pending);
+        AheadBehind &result = results[group.pair_at[word * 64 + bit]];
+        if (upstream_reaches) {
+          ++result.behind;
+        } else {
+          ++result.ahead;
+        }
+        pending &= pending - 1;
+      }
+    }
+  }
+}
+
+} // namespace
+
+AheadBehindCounter::AheadBehindCounter(infra::GitProcessExecutor &executor)
+    : executor_(executor) {}
+
+std::vector<AheadBehind>
+AheadBehindCounter::count(const std::vector<TrackingPair> &pairs,
+                          const infra::CancellationToken &token) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<AheadBehind> results(pairs.size());
+  std::vector<TrackingPair> missing;
+  std::unordered_map<std::string, size_t> missing_index;
+  std::vector<size_t> result_source(pairs.size(), no_pair);
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    std::string key = pairs[i].tip + pairs[i].upstream;
+    auto cached = cache_.find(key);
+    if (cached != cache_.end()) {
+      results[i] = cached->second;
+      ++stats_.cache_hits;
+      continue;
+    }
+    auto [slot, inserted] = missing_index.emplace(key, missing.size());
+    if (inserted) {
+      missing.push_back(pairs[i]);
+    }
+    result_source[i] = slot->second;
+  }
+
+  std::vector<AheadBehind> computed(missing.size());
+  if (!missing.empty()) {
+    walk(missing, computed, token);
+    stats_.computed += missing.size();
+  }
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    if (result_source[i] != no_pair) {
+      results[i] = computed[result_source[i]];
+    }
+  }
+
+  // Keep only the current pairs; ids a fetch moved away from are dropped
+  std::unordered_map<std::string, AheadBehind> cache;
+  cache.reserve(pairs.size());
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    cache.emplace(pairs[i].tip + pairs[i].upstream, results[i]);
+  }
+  cache_ = std::move(cache);
+  return results;
+}
+
+void AheadBehindCounter::fill(std::vector<Branch> &branches,
+                              const infra::CancellationToken &token) {
+  std::vector<TrackingPair> pairs;
+  std::vector<Branch *> tracking;
+  for (auto &branch : branches) {
+    if (!branch.upstream_hash.empty()) {
+      pairs.push_back({branch.hash, branch.upstream_hash});
+      tracking.push_back(&branch);
+    }
+  }
+  auto counts = count(pairs, token);
+  for (size_t i = 0; i < tracking.size(); ++i) {
+    tracking[i]->ahead = counts[i].ahead;
+    tracking[i]->behind = counts[i].behind;
+    tracking[i]->has_counts = true;
+  }
+}
+
+void AheadBehindCounter::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_.clear();
+}
+
+AheadBehindCounter::Stats AheadBehindCounter::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void AheadBehindCounter::walk(const std::vector<TrackingPair> &pairs,
+                              std::vector<AheadBehind> &results,
+                              const infra::CancellationToken &token) {
+  // A malformed or unreadable graph only costs speed: git loads it all
+  std::unique_ptr<CommitGraph> graph;
+  try {
+    graph = CommitGraph::open_repository(executor_.repo_path());
+  } catch (const SlayerGitException &) {
+  }
+  History history(std::move(graph));
+
+  // One bit per distinct commit among tips and upstreams
+  std::vector<std::string> tips;
+  std::unordered_map<std::string, uint32_t> bit_of;
+  std::vector<std::pair<uint32_t, uint32_t>> pair_bits;
+  for (const auto &pair : pairs) {
+    uint32_t bits[2];
+    const std::string *ids[2] = {&pair.tip, &pair.upstream};
+    for (int side = 0; side < 2; ++side) {
+      auto [slot, inserted] =
+          bit_of.emplace(*ids[side], static_cast<uint32_t>(tips.size()));
+      if (inserted) {
+        tips.push_back(*ids[side]);
+      }
+      bits[side] = slot->second;
+    }
+    pair_bits.emplace_back(bits[0], bits[1]);
+  }
+
+  std::vector<std::string> missing;
+  std::vector<std::string> known;
+  for (const auto &tip : tips) {
+    (history.find(tip) == no_node ? missing : known).push_back(tip);
+  }
+  if (!missing.empty()) {
+    history.load(executor_, missing, known, token);
+    stats_.commits_loaded += history.loaded();
+  }
+  std::vector<uint32_t> tip_nodes;
+  for (const auto &tip : tips) {
+    uint32_t node = history.find(tip);
+    if (node == no_node) {
+      throw SlayerGitException("commit not found: " + tip);
+    }
+    tip_nodes.push_back(node);
+  }
+
+  const size_t width = (tips.size() + 63) / 64;
+  std::vector<Group> groups;
+  std::unordered_map<uint32_t, size_t> group_of;
+  for (size_t i = 0; i < pair_bits.size(); ++i) {
+    auto [tip, upstream] = pair_bits[i];
+    if (tip == upstream) {
+      continue; // Same commit: 0 and 0
+    }
+    auto [slot, inserted] = group_of.emplace(upstream, groups.size());
+    if (inserted) {
+      Group group;
+      group.upstream_bit = upstream;
+      groups.push_back(std::move(group));
+    }
+    Group &group = groups[slot->second];
+    // Masks span only the words their tips use; grow to cover this one
+    size_t word = tip / 64;
+    if (group.mask.empty()) {
+      group.first_word = word;
+    } else if (word < group.first_word) {
+      size_t shift = group.first_word - word;
+      group.mask.insert(group.mask.begin(), shift, 0);
+      group.pair_at.insert(group.pair_at.begin(), shift * 64, no_pair);
+      group.first_word = word;
+    }
+    if (word - group.first_word >= group.mask.size()) {
+      group.mask.resize(word - group.first_word + 1, 0);
+      group.pair_at.resize(group.mask.size() * 64, no_pair);
+    }
+    group.mask[word - group.first_word] |= uint64_t{1} << (tip % 64);
+    group.pair_at[(word - group.first_word) * 64 + tip % 64] =
+        static_cast<uint32_t>(i);
+  }
+  if (groups.empty()) {
+    return;
+  }
+
+  // Bitsets of the queued commits live in a pool of reusable slots
+  struct Entry {
+    size_t slot;
+    bool unbalanced;
+  };
+  std::vector<uint64_t> pool;
+  std::vector<size_t> free_slots;
+  std::unordered_map<uint32_t, Entry> entries;
+  std::priority_queue<std::pair<uint64_t, uint32_t>> queue;
+  size_t active = 0; // Queued commits that are unbalanced
+
+  auto entry_for = [&](uint32_t node) -> Entry & {
+    auto [it, inserted] = entries.try_emplace(node, Entry{0, false});
+    if (inserted) {
+      if (free_slots.empty()) {
+        it->second.slot = pool.size() / width;
+        pool.resize(pool.size() + width, 0);
+      } else {
+        it->second.slot = free_slots.back();
+        free_slots.pop_back();
+        std::fill_n(pool.begin() + it->second.slot * width, width, 0);
+      }
+      queue.emplace(history.generation(node), node);
+    }
+    return it->second;
+  };
+  auto update = [&](Entry &entry) {
+    bool now = unbalanced(groups, pool.data() + entry.slot * width);
+    if (now && !entry.unbalanced) {
+      ++active;
+    } else if (!now && entry.unbalanced) {
+      --active;
+    }
+    entry.unbalanced = now;
+  };
+
+  for (uint32_t bit = 0; bit < tip_nodes.size(); ++bit) {
+    Entry &entry = entry_for(tip_nodes[bit]);
+    pool[entry.slot * width + bit / 64] |= uint64_t{1} << (bit % 64);
+  }
+  for (auto &[node, entry] : entries) {
+    update(entry);
+  }
+
+  std::vector<uint32_t> parents;
+  std::vector<uint64_t> bits(width);
+  uint64_t popped = 0;
+  while (active > 0 && !queue.empty()) {
+    if (++popped % cancel_check_interval == 0) {
+      token.throw_if_cancelled();
+    }
+    uint32_t node = queue.top().second;
+    queue.pop();
+    auto found = entries.find(node);
+    Entry entry = found->second;
+    entries.erase(found);
+    // Copied out: creating a parent's entry may grow the pool
+    std::copy_n(pool.begin() + entry.slot * width, width, bits.begin());
+    free_slots.push_back(entry.slot);
+
+    if (entry.unbalanced) {
+      --active;
+      accumulate(groups, bits.data(), results);
+    }
+    history.parents(node, parents);
+    for (uint32_t parent : parents) {
+      Entry &target = entry_for(parent);
+      uint64_t *target_bits = pool.data() + target.slot * width;
+      bool changed = false;
+      for (size_t word = 0; word < width; ++word) {
+        uint64_t merged = target_bits[word] | bits[word];
+        changed = changed || merged != target_bits[word];
+        target_bits[word] = merged;
+      }
+      if (changed) {
+        update(target);
+      }
+    }
+  }
+  ++stats_.walks;
+  stats_.commits_walked += popped;
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "core/models/branch.hpp"
+#include "infra/cancellation.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace slayergit::core {
+
+struct AheadBehind {
+  uint32_t ahead = 0;  // Commits in the tip but not in the upstream
+  uint32_t behind = 0; // Commits in the upstream but not in the tip
+
+  bool operator==(const AheadBehind &other) const {
+    return ahead == other.ahead && behind == other.behind;
+  }
+};
+
+// Tip and upstream commit ids (hex)
+struct TrackingPair {
+  std::string tip;
+  std::string upstream;
+};
+
+// Ahead/behind counts for many branch/upstream pairs in one history walk,
+// instead of one `git rev-list --left-right --count` per branch.
+//
+// Each visited commit carries a bitset of the tips that reach it, and
+// commits are visited in decreasing generation order, so a commit's set is
+// complete when it is popped. The walk stops once no queued commit can
+// change any count. Parents and generations come from the commit-graph;
+// commits newer than the graph (or all of them, without one) are loaded
+// with a single `git rev-list`.
+//
+// Results are cached per (tip, upstream) pair. Commit ids never change
+// meaning, so after a fetch only the pairs whose ids moved are walked.
+// Thread-safe; count() calls are serialised.
+class AheadBehindCounter {
+public:
+  struct Stats {
+    uint64_t cache_hits = 0;
+    uint64_t computed = 0;      // Pairs that needed a walk
+    uint64_t walks = 0;
+    uint64_t commits_walked = 0;
+    uint64_t commits_loaded = 0; // Read from `git rev-list`, not the graph
+  };
+
+  explicit AheadBehindCounter(infra::GitProcessExecutor &executor);
+
+  AheadBehindCounter(const AheadBehindCounter &) = delete;
+  AheadBehindCounter &operator=(const AheadBehindCounter &) = delete;
+
+  // One result per pair, in order. Cache entries for pairs not asked for
+  // are dropped, so the cache tracks the current branch list.
+  std::vector<AheadBehind> count(const std::vector<TrackingPair> &pairs,
+                                 const infra::CancellationToken &token = {});
+  // Sets the counts of every branch that has an existing upstream
+  void fill(std::vector<Branch> &branches,
+            const infra::CancellationToken &token = {});
+
+  void clear();
+  [[nodiscard]] Stats stats() const;
+
+private:
+  void walk(const std::vector<TrackingPair> &pairs,
+            std::vector<AheadBehind> &results,
+            const infra::CancellationToken &token);
+
+  infra::GitProcessExecutor &executor_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, AheadBehind> cache_; // tip + upstream
+  Stats stats_;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,104 @@
+#include "branches.hpp"
+
+#include "infra/exceptions.hpp"
+
+#include <string_view>
+#include <unordered_map>
+
+namespace slayergit::core {
+
+namespace {
+
+constexpr std::string_view heads_prefix = "refs/heads/";
+constexpr std::string_view remotes_prefix = "refs/remotes/";
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string short_name(std::string_view ref) {
+  if (starts_with(ref, heads_prefix)) {
+    ref.remove_prefix(heads_prefix.size());
+  } else if (starts_with(ref, remotes_prefix)) {
+    ref.remove_prefix(remotes_prefix.size());
+  }
+  return std::string(ref);
+}
+
+} // namespace
+
+std::vector<Branch> list_branches(infra::GitProcessExecutor &executor,
+                                  const RefSnapshot &refs,
+                                  const infra::CancellationToken &token) {
+  std::vector<std::string> args{"for-each-ref",
+                                "--format=%(refname)%00%(upstream)",
+                                "refs/heads"};
+  auto result = executor.execute(args, token);
+  if (result.exit_code != 0) {
+    throw GitCommandException("git for-each-ref", result.exit_code,
+                              result.stderr_output);
+  }
+  std::unordered_map<std::string_view, std::string_view> upstreams;
+  std::string_view output = result.stdout_output;
+  while (!output.empty()) {
+    size_t end = output.find('\n');
+    std::string_view line = output.substr(0, end);
+    output.remove_prefix(end == std::string_view::npos ? output.size()
+                                                       : end + 1);
+    size_t nul = line.find('\0');
+    if (nul == std::string_view::npos) {
+      throw ParseException("unexpected for-each-ref line");
+    }
+    upstreams.emplace(line.substr(0, nul), line.substr(nul + 1));
+  }
+
+  std::vector<Branch> branches;
+  auto [first, last] = refs.range(heads_prefix);
+  branches.reserve(last - first);
+  for (size_t i = first; i < last; ++i) {
+    std::string_view name = refs.name(i);
+    Branch branch;
+    branch.name = short_name(name);
+    branch.hash = std::string(refs.oid(i));
+    branch.is_head = refs.head().symref == name;
+    auto upstream = upstreams.find(name);
+    if (upstream != upstreams.end() && !upstream->second.empty()) {
+      branch.upstream = short_name(upstream->second);
+      size_t index = refs.find(upstream->second);
+      if (index != RefSnapshot::npos) {
+        branch.upstream_hash = std::string(refs.oid(index));
+      }
+    }
+    branches.push_back(std::move(branch));
+  }
+  return branches;
+}
+
+std::vector<Branch> list_branches(infra::GitProcessExecutor &executor,
+                                  const infra::CancellationToken &token) {
+  return list_branches(executor, *RefSnapshot::read(executor.repo_path()),
+                       token);
+}
+
+std::string tracking_label(const Branch &branch) {
+  if (branch.upstream.empty()) {
+    return "";
+  }
+  if (branch.upstream_hash.empty()) {
+    return "[" + branch.upstream + ": gone]";
+  }
+  if (!branch.has_counts || (branch.ahead == 0 && branch.behind == 0)) {
+    return "[" + branch.upstream + "]";
+  }
+  std::string label = "[" + branch.upstream + ":";
+  if (branch.ahead > 0) {
+    label += " ahead " + std::to_string(branch.ahead);
+  }
+  if (branch.behind > 0) {
+    label += std::string(branch.ahead > 0 ? "," : "") + " behind " +
+             std::to_string(branch.behind);
+  }
+  return label + "]";
+}
+
+} // namespace slayergit::core
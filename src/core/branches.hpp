@@ -0,0 +1,27 @@
+#pragma once
+
+#include "core/models/branch.hpp"
+#include "core/ref_snapshot.hpp"
+#include "infra/cancellation.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <string>
+#include <vector>
+
+namespace slayergit::core {
+
+// Local branches with their upstreams. Tips come from `refs`; only the
+// upstream names need git (one `for-each-ref` over refs/heads, which
+// applies the remotes' fetch refspecs). Counts are left unset;
+// AheadBehindCounter::fill() adds them.
+std::vector<Branch> list_branches(infra::GitProcessExecutor &executor,
+                                  const RefSnapshot &refs,
+                                  const infra::CancellationToken &token = {});
+// Reads a RefSnapshot of the executor's repository first
+std::vector<Branch> list_branches(infra::GitProcessExecutor &executor,
+                                  const infra::CancellationToken &token = {});
+
+// "[origin/main: ahead 2, behind 1]", "[origin/main: gone]", or empty
+std::string tracking_label(const Branch &branch);
+
+} // namespace slayergit::core
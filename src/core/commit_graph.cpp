@@ -0,0 +1,388 @@
+#include "commit_graph.hpp"
+
+#include "infra/exceptions.hpp"
+#include "infra/git_dir.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace slayergit::core {
+
+namespace {
+
+using infra::read_be32;
+using infra::read_be64;
+
+constexpr uint32_t signature = 0x43475048; // "CGPH"
+constexpr size_t header_size = 8;
+constexpr size_t lookup_entry_size = 12;
+constexpr size_t fanout_size = 256 * 4;
+
+constexpr uint32_t chunk_oid_fanout = 0x4f494446;  // "OIDF"
+constexpr uint32_t chunk_oid_lookup = 0x4f49444c;  // "OIDL"
+constexpr uint32_t chunk_commit_data = 0x43444154; // "CDAT"
+constexpr uint32_t chunk_generation_data = 0x47444132;     // "GDA2"
+constexpr uint32_t chunk_generation_overflow = 0x47444f32; // "GDO2"
+constexpr uint32_t chunk_extra_edges = 0x45444745;         // "EDGE"
+constexpr uint32_t chunk_base_graphs = 0x42415345;         // "BASE"
+
+constexpr uint32_t parent_none = 0x70000000;
+constexpr uint32_t parent_extra_edges = 0x80000000;
+constexpr uint32_t edge_last = 0x80000000;
+constexpr uint32_t generation_overflow_flag = 0x80000000;
+
+std::vector<std::string> read_chain(const std::string &path) {
+  std::vector<std::string> hashes;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      hashes.push_back(line);
+    }
+  }
+  return hashes;
+}
+
+int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+} // namespace
+
+std::unique_ptr<CommitGraph>
+CommitGraph::open(const std::string &objects_dir) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  std::unique_ptr<CommitGraph> graph(new CommitGraph());
+
+  // Same preference as git: the single file, then the split chain
+  std::string single = objects_dir + "/info/commit-graph";
+  if (fs::is_regular_file(single, error)) {
+    graph->add_layer(single, 0, {});
+    return graph;
+  }
+
+  std::string chain_dir = objects_dir + "/info/commit-graphs";
+  std::string chain_file = chain_dir + "/commit-graph-chain";
+  if (!fs::is_regular_file(chain_file, error)) {
+    return nullptr;
+  }
+  auto chain = read_chain(chain_file);
+  if (chain.empty()) {
+    return nullptr;
+  }
+  for (size_t layer = 0; layer < chain.size(); ++layer) {
+    graph->add_layer(chain_dir + "/graph-" + chain[layer] + ".graph", layer,
+                     chain);
+  }
+  return graph;
+}
+
+std::unique_ptr<CommitGraph>
+CommitGraph::open_repository(const std::string &repo_path) {
+  return open(infra::resolve_git_dirs(repo_path).objects_dir);
+}
+
+void CommitGraph::add_layer(const std::string &path, size_t expected_bases,
+                            const std::vector<std::string> &chain) {
+  Layer layer;
+  layer.file = infra::MappedFile(path);
+  const uint8_t *data = layer.file.data();
+  size_t size = layer.file.size();
+  auto fail = [&path](const std::string &what) {
+    throw ParseException("commit-graph " + path + ": " + what);
+  };
+
+  if (size < header_size || read_be32(data) != signature) {
+    fail("bad signature");
+  }
+  if (data[4] != 1) {
+    fail("unsupported version " + std::to_string(data[4]));
+  }
+  size_t hash_size = data[5] == 1 ? 20 : data[5] == 2 ? 32 : 0;
+  if (hash_size == 0) {
+    fail("unknown hash version " + std::to_string(data[5]));
+  }
+  if (!layers_.empty() && hash_size != hash_size_) {
+    fail("hash version differs from the base graph");
+  }
+  hash_size_ = hash_size;
+  size_t chunk_count = data[6];
+  size_t base_count = data[7];
+  if (base_count != expected_bases) {
+    fail("expected " + std::to_string(expected_bases) + " base graphs");
+  }
+
+  // Chunk table: id and offset per chunk, then a terminating entry whose
+  // offset is where the last chunk ends
+  size_t table_end = header_size + (chunk_count + 1) * lookup_entry_size;
+  if (table_end > size) {
+    fail("truncated chunk table");
+  }
+  for (size_t i = 0; i < chunk_count; ++i) {
+    const uint8_t *entry = data + header_size + i * lookup_entry_size;
+    uint64_t offset = read_be64(entry + 4);
+    uint64_t end = read_be64(entry + lookup_entry_size + 4);
+    if (offset < table_end || end < offset || end > size) {
+      fail("chunk out of bounds");
+    }
+    layer.chunks.push_back({read_be32(entry), data + offset,
+                            static_cast<size_t>(end - offset)});
+  }
+  auto find_chunk = [&layer](uint32_t id) -> const Chunk * {
+    for (const auto &chunk : layer.chunks) {
+      if (chunk.id == id) {
+        return &chunk;
+      }
+    }
+    return nullptr;
+  };
+
+  const Chunk *fanout = find_chunk(chunk_oid_fanout);
+  const Chunk *oids = find_chunk(chunk_oid_lookup);
+  const Chunk *commits = find_chunk(chunk_commit_data);
+  if (fanout == nullptr || oids == nullptr || commits == nullptr) {
+    fail("missing a required chunk");
+  }
+  if (fanout->size != fanout_size) {
+    fail("bad fanout size");
+  }
+  uint32_t previous = 0;
+  for (size_t i = 0; i < 256; ++i) {
+    uint32_t value = read_be32(fanout->data + 4 * i);
+    if (value < previous) {
+      fail("fanout is not monotonic");
+    }
+    previous = value;
+  }
+  layer.count = previous;
+  if (oids->size != size_t{layer.count} * hash_size ||
+      commits->size != size_t{layer.count} * (hash_size + 16)) {
+    fail("chunk sizes do not match the commit count");
+  }
+  layer.fanout = fanout->data;
+  layer.oids = oids->data;
+  layer.data = commits->data;
+
+  if (const Chunk *generations = find_chunk(chunk_generation_data)) {
+    if (generations->size != size_t{layer.count} * 4) {
+      fail("bad GDA2 size");
+    }
+    layer.generation_data = generations->data;
+  }
+  if (const Chunk *overflow = find_chunk(chunk_generation_overflow)) {
+    layer.generation_overflow = overflow->data;
+    layer.generation_overflow_count = overflow->size / 8;
+  }
+  if (const Chunk *edges = find_chunk(chunk_extra_edges)) {
+    layer.extra_edges = edges->data;
+    layer.extra_edge_count = edges->size / 4;
+  }
+
+  // A split layer names the files below it; they must be the chain's
+  if (base_count > 0) {
+    const Chunk *bases = find_chunk(chunk_base_graphs);
+    if (bases == nullptr || bases->size != base_count * hash_size) {
+      fail("missing or bad BASE chunk");
+    }
+    for (size_t i = 0; i < base_count; ++i) {
+      std::string_view base(reinterpret_cast<const char *>(bases->data) +
+                                i * hash_size,
+                            hash_size);
+      if (base != from_hex(chain[i])) {
+        fail("base graph " + std::to_string(i) + " does not match the chain");
+      }
+    }
+  }
+
+  if (uint64_t{size_} + layer.count > no_position) {
+    fail("too many commits");
+  }
+  // Git only trusts corrected dates when every layer carries them
+  corrected_dates_ = corrected_dates_ && layer.generation_data != nullptr;
+  layer.base = size_;
+  size_ += layer.count;
+  layers_.push_back(std::move(layer));
+}
+
+const CommitGraph::Layer &CommitGraph::layer_of(uint32_t position) const {
+  if (position >= size_) {
+    throw ParseException("commit-graph position " + std::to_string(position) +
+                         " out of range");
+  }
+  for (size_t i = layers_.size(); i-- > 1;) {
+    if (position >= layers_[i].base) {
+      return layers_[i];
+    }
+  }
+  return layers_.front();
+}
+
+const uint8_t *CommitGraph::commit_data(uint32_t position) const {
+  const Layer &layer = layer_of(position);
+  return layer.data + size_t{position - layer.base} * (hash_size_ + 16);
+}
+
+std::string_view CommitGraph::oid(uint32_t position) const {
+  const Layer &layer = layer_of(position);
+  return {reinterpret_cast<const char *>(layer.oids) +
+              size_t{position - layer.base} * hash_size_,
+          hash_size_};
+}
+
+std::string_view CommitGraph::tree(uint32_t position) const {
+  return {reinterpret_cast<const char *>(commit_data(position)), hash_size_};
+}
+
+uint32_t CommitGraph::find(std::string_view oid) const {
+  if (oid.size() != hash_size_) {
+    return no_position;
+  }
+  auto first_byte = static_cast<uint8_t>(oid[0]);
+  for (const auto &layer : layers_) {
+    uint32_t lo = first_byte == 0 ? 0
+                                  : read_be32(layer.fanout + 4 * (first_byte - 1));
+    uint32_t hi = read_be32(layer.fanout + 4 * first_byte);
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      int order = std::memcmp(layer.oids + size_t{mid} * hash_size_,
+                              oid.data(), hash_size_);
+      if (order == 0) {
+        return layer.base + mid;
+      }
+      if (order < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+  }
+  return no_position;
+}
+
+uint32_t CommitGraph::find_hex(std::string_view hex) const {
+  if (hex.size() != 2 * hash_size_) {
+    return no_position;
+  }
+  return find(from_hex(hex));
+}
+
+void CommitGraph::parents(uint32_t position,
+                          std::vector<uint32_t> &out) const {
+  out.clear();
+  const Layer &layer = layer_of(position);
+  const uint8_t *data =
+      layer.data + size_t{position - layer.base} * (hash_size_ + 16);
+  uint32_t first = read_be32(data + hash_size_);
+  uint32_t second = read_be32(data + hash_size_ + 4);
+  if (first == parent_none) {
+    return;
+  }
+  out.push_back(first);
+  if (second == parent_none) {
+    return;
+  }
+  if ((second & parent_extra_edges) == 0) {
+    out.push_back(second);
+    return;
+  }
+
+  // Octopus: the second and later parents are listed in EDGE, the last
+  // one flagged
+  for (size_t index = second & ~parent_extra_edges;; ++index) {
+    if (index >= layer.extra_edge_count) {
+      throw ParseException("commit-graph: EDGE index out of range");
+    }
+    uint32_t edge = read_be32(layer.extra_edges + 4 * index);
+    out.push_back(edge & ~edge_last);
+    if ((edge & edge_last) != 0) {
+      break;
+    }
+  }
+}
+
+uint32_t CommitGraph::first_parent(uint32_t position) const {
+  uint32_t first = read_be32(commit_data(position) + hash_size_);
+  return first == parent_none ? no_position : first;
+}
+
+int64_t CommitGraph::commit_time(uint32_t position) const {
+  const uint8_t *data = commit_data(position) + hash_size_ + 8;
+  return static_cast<int64_t>((uint64_t{read_be32(data) & 0x3} << 32) |
+                              read_be32(data + 4));
+}
+
+uint32_t CommitGraph::topological_level(uint32_t position) const {
+  return read_be32(commit_data(position) + hash_size_ + 8) >> 2;
+}
+
+uint64_t CommitGraph::generation(uint32_t position) const {
+  if (!corrected_dates_) {
+    return topological_level(position);
+  }
+  const Layer &layer = layer_of(position);
+  uint32_t offset = read_be32(layer.generation_data +
+                              4 * size_t{position - layer.base});
+  uint64_t delta = offset;
+  if ((offset & generation_overflow_flag) != 0) {
+    size_t index = offset & ~generation_overflow_flag;
+    if (index >= layer.generation_overflow_count) {
+      throw ParseException("commit-graph: GDO2 index out of range");
+    }
+    delta = read_be64(layer.generation_overflow + 8 * index);
+  }
+  return static_cast<uint64_t>(commit_time(position)) + delta;
+}
+
+std::string_view CommitGraph::chunk(size_t layer, uint32_t id) const {
+  for (const auto &chunk : layers_[layer].chunks) {
+    if (chunk.id == id) {
+      return {reinterpret_cast<const char *>(chunk.data), chunk.size};
+    }
+  }
+  return {};
+}
+
+std::string CommitGraph::to_hex(std::string_view oid) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex;
+  hex.reserve(oid.size() * 2);
+  for (char c : oid) {
+    auto byte = static_cast<uint8_t>(c);
+    hex += digits[byte >> 4];
+    hex += digits[byte & 0xf];
+  }
+  return hex;
+}
+
+std::string CommitGraph::from_hex(std::string_view hex) {
+  if (hex.size() % 2 != 0) {
+    throw ParseException("odd-length object id: " + std::string(hex));
+  }
+  std::string oid(hex.size() / 2, '\0');
+  for (size_t i = 0; i < oid.size(); ++i) {
+    int high = hex_value(hex[2 * i]);
+    int low = hex_value(hex[2 * i + 1]);
+    if (high < 0 || low < 0) {
+      throw ParseException("invalid object id: " + std::string(hex));
+    }
+    oid[i] = static_cast<char>((high << 4) | low);
+  }
+  return oid;
+}
+
+} // namespace slayergit::core
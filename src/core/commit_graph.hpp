@@ -0,0 +1,105 @@
+#pragma once
+
+#include "infra/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::core {
+
+// Reads git's commit-graph (objects/info/commit-graph, or the split chain
+// in objects/info/commit-graphs/) in place through mmap. Gives parents,
+// commit dates and generation numbers for every commit in the graph
+// without running git or reading commit objects.
+//
+// Commits are addressed by position: 0 .. size()-1 across all layers of a
+// chain, base layer first, as git numbers them. Object ids are raw bytes
+// (20 for SHA-1, 32 for SHA-256); see to_hex()/from_hex().
+//
+// Immutable once opened, so safe to share between threads.
+class CommitGraph {
+public:
+  static constexpr uint32_t no_position = 0xffffffff;
+
+  // nullptr when the repository has no commit-graph, so callers fall back
+  // to git. Throws ParseException if a file exists but is malformed.
+  static std::unique_ptr<CommitGraph> open(const std::string &objects_dir);
+  // Resolves the objects directory of `repo_path` first
+  static std::unique_ptr<CommitGraph>
+  open_repository(const std::string &repo_path);
+
+  [[nodiscard]] uint32_t size() const { return size_; }
+  [[nodiscard]] size_t hash_size() const { return hash_size_; }
+  [[nodiscard]] size_t layer_count() const { return layers_.size(); }
+
+  [[nodiscard]] std::string_view oid(uint32_t position) const;
+  [[nodiscard]] std::string_view tree(uint32_t position) const;
+  // Binary search through the fanout of each layer; no_position if absent
+  [[nodiscard]] uint32_t find(std::string_view oid) const;
+  [[nodiscard]] uint32_t find_hex(std::string_view hex) const;
+
+  // Parent positions in order; octopus merges read the EDGE chunk
+  void parents(uint32_t position, std::vector<uint32_t> &out) const;
+  [[nodiscard]] uint32_t first_parent(uint32_t position) const;
+
+  // Committer date, seconds since the epoch
+  [[nodiscard]] int64_t commit_time(uint32_t position) const;
+  // Generation number v1: 1 + the highest topological level of a parent
+  [[nodiscard]] uint32_t topological_level(uint32_t position) const;
+  // Corrected commit date (v2) when every layer has GDA2, else the
+  // topological level. Either way a commit's generation is greater than
+  // each of its parents', which is what walks rely on to stop early.
+  [[nodiscard]] uint64_t generation(uint32_t position) const;
+  [[nodiscard]] bool has_corrected_dates() const { return corrected_dates_; }
+
+  // Chunks a layer carries beyond the required ones, for later readers
+  // (e.g. Bloom filters); empty if that layer has none
+  [[nodiscard]] std::string_view chunk(size_t layer, uint32_t id) const;
+  // First position of a layer
+  [[nodiscard]] uint32_t layer_base(size_t layer) const {
+    return layers_[layer].base;
+  }
+
+  static std::string to_hex(std::string_view oid);
+  static std::string from_hex(std::string_view hex);
+
+private:
+  struct Chunk {
+    uint32_t id;
+    const uint8_t *data;
+    size_t size;
+  };
+
+  struct Layer {
+    infra::MappedFile file;
+    uint32_t base = 0;  // Commits in the layers below
+    uint32_t count = 0;
+    const uint8_t *fanout = nullptr;
+    const uint8_t *oids = nullptr;
+    const uint8_t *data = nullptr; // CDAT
+    const uint8_t *generation_data = nullptr;          // GDA2
+    const uint8_t *generation_overflow = nullptr;      // GDO2
+    size_t generation_overflow_count = 0;
+    const uint8_t *extra_edges = nullptr;              // EDGE
+    size_t extra_edge_count = 0;
+    std::vector<Chunk> chunks;
+  };
+
+  CommitGraph() = default;
+
+  void add_layer(const std::string &path, size_t expected_bases,
+                 const std::vector<std::string> &chain);
+  [[nodiscard]] const Layer &layer_of(uint32_t position) const;
+  [[nodiscard]] const uint8_t *commit_data(uint32_t position) const;
+
+  std::vector<Layer> layers_;
+  uint32_t size_ = 0;
+  size_t hash_size_ = 20;
+  bool corrected_dates_ = true;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,449 @@
+#include "diff_cache.hpp"
+
+#include "core/commit_graph.hpp"
+#include "infra/cat_file_pool.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace slayergit::core {
+
+namespace {
+
+// libstdc++ and libc++ keep strings this short inside the object
+constexpr size_t small_string_capacity = 15;
+
+size_t heap_bytes(const std::string &value) {
+  return value.capacity() > small_string_capacity ? value.capacity() + 1 : 0;
+}
+
+void hash_combine(size_t &seed, size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+// A work tree file as git stores it: a link's blob is its target. nullopt
+// if it is gone.
+std::optional<std::string> read_work_tree_file(const std::string &path) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  if (fs::is_symlink(fs::symlink_status(path, error))) {
+    fs::path target = fs::read_symlink(path, error);
+    return error ? std::nullopt : std::optional(target.string());
+  }
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+  return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+// Hex id of `spec` through the pool; empty if there is no such object
+std::string object_id(infra::CatFilePool &pool, const std::string &spec) {
+  auto info = pool.object_info(spec).get();
+  return info.status == infra::ObjectStatus::Found ? info.oid : std::string();
+}
+
+} // namespace
+
+bool DiffKey::operator==(const DiffKey &other) const {
+  return old_blob == other.old_blob && new_blob == other.new_blob &&
+         options.algorithm == other.options.algorithm &&
+         options.context_lines == other.options.context_lines &&
+         options.indent_heuristic == other.options.indent_heuristic &&
+         options.minimal == other.options.minimal &&
+         options.max_input_bytes == other.options.max_input_bytes;
+}
+
+size_t DiffKeyHash::operator()(const DiffKey &key) const {
+  size_t seed = std::hash<std::string>{}(key.old_blob);
+  hash_combine(seed, std::hash<std::string>{}(key.new_blob));
+  hash_combine(seed, static_cast<size_t>(key.options.algorithm));
+  hash_combine(seed, static_cast<size_t>(key.options.context_lines));
+  hash_combine(seed, (key.options.indent_heuristic ? 1u : 0u) |
+                         (key.options.minimal ? 2u : 0u));
+  hash_combine(seed, key.options.max_input_bytes);
+  return seed;
+}
+
+struct DiffCache::State {
+  struct Entry {
+    DiffKey key;
+    DiffPtr diff;
+    size_t bytes;
+  };
+
+  State(Loader loader, size_t byte_budget)
+      : loader(std::move(loader)), byte_budget(byte_budget) {}
+
+  // Caller holds the lock. Marks the entry most recently used.
+  DiffPtr lookup(const DiffKey &key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+      return nullptr;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->diff;
+  }
+
+  // Caller holds the lock. Diffs larger than the whole budget are handed
+  // out but not kept.
+  void insert(const DiffKey &key, const DiffPtr &diff) {
+    size_t size = estimated_bytes(*diff);
+    if (auto it = index.find(key); it != index.end()) {
+      bytes -= it->second->bytes;
+      lru.erase(it->second);
+      index.erase(it);
+    }
+    if (size > byte_budget) {
+      return;
+    }
+    lru.push_front({key, diff, size});
+    index.emplace(key, lru.begin());
+    bytes += size;
+    evict();
+  }
+
+  // Caller holds the lock
+  void evict() {
+    while (bytes > byte_budget && !lru.empty()) {
+      bytes -= lru.back().bytes;
+      index.erase(lru.back().key);
+      lru.pop_back();
+      ++stats.evictions;
+    }
+  }
+
+  mutable std::mutex mutex;
+  std::condition_variable idle;
+  std::condition_variable loaded; // A load finished, one way or another
+  Loader loader;
+  size_t byte_budget;
+  size_t bytes = 0;
+  std::list<Entry> lru; // Most recently used first
+  std::unordered_map<DiffKey, std::list<Entry>::iterator, DiffKeyHash> index;
+  std::unordered_map<DiffKey, std::shared_future<DiffPtr>, DiffKeyHash>
+      loading;
+  uint64_t prefetch_generation = 0;
+  size_t running_prefetches = 0;
+  bool closed = false;
+  Stats stats;
+};
+
+DiffCache::DiffCache(infra::TaskExecutor &tasks, Loader loader)
+    : DiffCache(tasks, std::move(loader), Options{}) {}
+
+DiffCache::DiffCache(infra::TaskExecutor &tasks, Loader loader,
+                     Options options)
+    : tasks_(tasks),
+      state_(std::make_shared<State>(std::move(loader), options.byte_budget)) {}
+
+DiffCache::~DiffCache() {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  state_->closed = true;
+  // Running loads may use whatever the loader captured (e.g. the pool)
+  state_->idle.wait(lock, [this] { return state_->running_prefetches == 0; });
+}
+
+DiffCache::Loader DiffCache::blob_loader(infra::CatFilePool &pool) {
+  return [&pool](const DiffKey &key, const infra::CancellationToken &token) {
+    // Both reads are pipelined before waiting on either
+    std::future<infra::GitObject> old_object;
+    std::future<infra::GitObject> new_object;
+    if (!key.old_blob.empty()) {
+      old_object = pool.read_object(key.old_blob);
+    }
+    if (!key.new_blob.empty() && key.new_file.empty()) {
+      new_object = pool.read_object(key.new_blob);
+    }
+    std::string old_text = old_object.valid() ? old_object.get().data : "";
+    std::string new_text = new_object.valid() ? new_object.get().data : "";
+    if (!key.new_file.empty()) {
+      new_text = read_work_tree_file(key.new_file).value_or("");
+    }
+    token.throw_if_cancelled();
+
+    FileDiff diff =
+        infra::DiffEngine::diff(old_text, new_text, key.options, token);
+    diff.is_new_file = key.old_blob.empty();
+    diff.is_deleted = key.new_blob.empty();
+    return diff;
+  };
+}
+
+DiffCache::DiffPtr DiffCache::get(const DiffKey &key,
+                                  const infra::CancellationToken &token) {
+  // Wakes this caller if it gives up while waiting for another's load.
+  // Registered (and destroyed) outside the lock the callback takes.
+  auto state = state_;
+  auto wake = token.on_cancel([state] {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->loaded.notify_all();
+  });
+  std::promise<DiffPtr> promise;
+  {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    if (auto hit = state_->lookup(key)) {
+      ++state_->stats.hits;
+      return hit;
+    }
+    ++state_->stats.misses;
+    while (true) {
+      auto it = state_->loading.find(key);
+      if (it == state_->loading.end()) {
+        state_->loading.emplace(key, promise.get_future().share());
+        break;
+      }
+      // Another caller's load, waited for only as long as this caller
+      // wants the diff. If that caller was cancelled, this one loads it.
+      std::shared_future<DiffPtr> pending = it->second;
+      state_->loaded.wait(lock, [&] {
+        return token.cancelled() ||
+               pending.wait_for(std::chrono::seconds(0)) ==
+                   std::future_status::ready;
+      });
+      token.throw_if_cancelled();
+      try {
+        return pending.get();
+      } catch (const CancelledException &) {
+      }
+    }
+  }
+
+  try {
+    auto diff = std::make_shared<const FileDiff>(state_->loader(key, token));
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->insert(key, diff);
+    state_->loading.erase(key);
+    promise.set_value(diff);
+    state_->loaded.notify_all();
+    return diff;
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->loading.erase(key);
+    promise.set_exception(std::current_exception());
+    state_->loaded.notify_all();
+    throw;
+  }
+}
+
+DiffCache::DiffPtr DiffCache::find(const DiffKey &key) const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  auto it = state_->index.find(key);
+  return it == state_->index.end() ? nullptr : it->second->diff;
+}
+
+void DiffCache::prefetch(const std::vector<DiffKey> &keys) {
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    generation = ++state_->prefetch_generation;
+  }
+
+  for (const auto &key : keys) {
+    auto state = state_;
+    tasks_.post(
+        [state, key, generation] {
+          std::promise<DiffPtr> promise;
+          {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->closed || generation != state->prefetch_generation) {
+              ++state->stats.prefetch_skipped;
+              return;
+            }
+            if (state->index.count(key) != 0 ||
+                state->loading.count(key) != 0) {
+              return;
+            }
+            state->loading.emplace(key, promise.get_future().share());
+            ++state->running_prefetches;
+          }
+
+          DiffPtr diff;
+          std::exception_ptr error;
+          try {
+            diff = std::make_shared<const FileDiff>(
+                state->loader(key, infra::CancellationToken()));
+          } catch (...) {
+            error = std::current_exception();
+          }
+
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->loading.erase(key);
+          if (diff) {
+            state->insert(key, diff);
+            ++state->stats.prefetched;
+            promise.set_value(diff);
+          } else {
+            promise.set_exception(error);
+          }
+          state->loaded.notify_all();
+          if (--state->running_prefetches == 0) {
+            state->idle.notify_all();
+          }
+        },
+        infra::TaskPriority::Background);
+  }
+}
+
+void DiffCache::set_byte_budget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->byte_budget = bytes;
+  state_->evict();
+}
+
+void DiffCache::clear() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->lru.clear();
+  state_->index.clear();
+  state_->bytes = 0;
+}
+
+DiffCache::Stats DiffCache::stats() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  Stats stats = state_->stats;
+  stats.entries = state_->lru.size();
+  stats.bytes = state_->bytes;
+  stats.byte_budget = state_->byte_budget;
+  return stats;
+}
+
+size_t DiffCache::estimated_bytes(const FileDiff &diff) {
+  size_t bytes = sizeof(FileDiff) + heap_bytes(diff.old_path) +
+                 heap_bytes(diff.new_path) +
+                 diff.hunks.capacity() * sizeof(DiffHunk);
+  for (const auto &hunk : diff.hunks) {
+    bytes += heap_bytes(hunk.header) + hunk.lines.capacity() * sizeof(DiffLine);
+    for (const auto &line : hunk.lines) {
+      bytes += heap_bytes(line.content);
+    }
+  }
+  return bytes;
+}
+
+FileDiff with_paths(const DiffEntry &entry, const FileDiff &diff) {
+  FileDiff copy = diff;
+  copy.old_path = entry.old_path;
+  copy.new_path = entry.new_path;
+  copy.is_renamed = entry.is_renamed;
+  return copy;
+}
+
+std::vector<DiffEntry> commit_changes(infra::GitProcessExecutor &executor,
+                                      const std::string &commit,
+                                      const infra::CancellationToken &token) {
+  // Raw pairs of blob ids, no content: the hunks come from the cache
+  std::vector<std::string> args{"diff-tree", "-r", "-z", "-M", "--root",
+                                "--no-commit-id",
+                                "--diff-merges=first-parent", commit};
+  auto result = executor.execute(args, token);
+  if (result.exit_code != 0) {
+    throw GitCommandException("git diff-tree", result.exit_code,
+                              result.stderr_output);
+  }
+
+  // ":<old mode> <new mode> <old id> <new id> <status>\0<path>\0", with a
+  // second path for renames and copies
+  std::vector<DiffEntry> entries;
+  std::string_view output = result.stdout_output;
+  auto next_field = [&output]() {
+    size_t end = output.find('\0');
+    std::string_view field = output.substr(0, end);
+    output.remove_prefix(end == std::string_view::npos ? output.size()
+                                                       : end + 1);
+    return field;
+  };
+  constexpr std::string_view gitlink = "160000";
+  while (!output.empty()) {
+    std::string_view meta = next_field();
+    if (meta.size() < 2 || meta.front() != ':') {
+      throw ParseException("unexpected diff-tree line: " + std::string(meta));
+    }
+    std::vector<std::string_view> fields;
+    for (size_t start = 1; start <= meta.size();) {
+      size_t space = std::min(meta.find(' ', start), meta.size());
+      fields.push_back(meta.substr(start, space - start));
+      start = space + 1;
+    }
+    if (fields.size() != 5 || fields[4].empty()) {
+      throw ParseException("unexpected diff-tree line: " + std::string(meta));
+    }
+    char status = fields[4].front();
+    DiffEntry entry;
+    entry.old_path = next_field();
+    entry.new_path =
+        status == 'R' || status == 'C' ? std::string(next_field())
+                                       : entry.old_path;
+    entry.is_renamed = status == 'R';
+    if (fields[0] == gitlink || fields[1] == gitlink) {
+      continue; // Ids of commits in another repository
+    }
+    // All zeros for the side that does not exist
+    if (fields[2].find_first_not_of('0') != std::string_view::npos) {
+      entry.key.old_blob = fields[2];
+    }
+    if (fields[3].find_first_not_of('0') != std::string_view::npos) {
+      entry.key.new_blob = fields[3];
+    }
+    entries.push_back(std::move(entry));
+  }
+  return entries;
+}
+
+DiffEntry status_change(infra::CatFilePool &pool, const std::string &work_tree,
+                        const FileStatus &file, bool staged,
+                        HashAlgorithm algorithm) {
+  DiffEntry entry;
+  entry.old_path = file.path;
+  entry.new_path = file.path;
+  if (staged) {
+    if (!file.old_path.empty()) {
+      entry.old_path = file.old_path;
+    }
+    entry.is_renamed = file.staged_status == FileStatusType::Renamed;
+    entry.key.old_blob = object_id(pool, "HEAD:" + entry.old_path);
+    entry.key.new_blob = object_id(pool, ":" + file.path);
+    return entry;
+  }
+  if (work_tree.empty()) {
+    throw SlayerGitException("unstaged changes need a work tree");
+  }
+  // An unmerged path is shown against our side
+  entry.key.old_blob =
+      object_id(pool, (file.unstaged_status == FileStatusType::Unmerged
+                           ? ":2:"
+                           : ":") +
+                          file.path);
+  std::string path = work_tree + "/" + file.path;
+  if (auto contents = read_work_tree_file(path)) {
+    entry.key.new_blob =
+        CommitGraph::to_hex(hash_object(algorithm, "blob", *contents));
+    entry.key.new_file = std::move(path);
+  }
+  return entry;
+}
+
+std::vector<size_t> rows_around(size_t row, size_t row_count, size_t radius) {
+  std::vector<size_t> rows;
+  for (size_t distance = 1; distance <= radius; ++distance) {
+    if (row + distance < row_count) {
+      rows.push_back(row + distance);
+    }
+    if (row >= distance && row - distance < row_count) {
+      rows.push_back(row - distance);
+    }
+  }
+  return rows;
+}
+
+} // namespace slayergit::core
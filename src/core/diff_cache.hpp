@@ -0,0 +1,149 @@
+#pragma once
+
+#include "core/models/diff.hpp"
+#include "core/models/file_status.hpp"
+#include "core/object_hash.hpp"
+#include "infra/cancellation.hpp"
+#include "infra/diff/diff_engine.hpp"
+#include "infra/task_executor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace slayergit::infra {
+class CatFilePool;
+class GitProcessExecutor;
+} // namespace slayergit::infra
+
+namespace slayergit::core {
+
+// Identifies a diff by content: blob ids never change meaning, so a cached
+// diff stays valid across refreshes
+struct DiffKey {
+  std::string old_blob; // Empty for an added file
+  std::string new_blob; // Empty for a deleted file
+  infra::DiffOptions options;
+  // Work tree file (absolute) the new side is read from, new_blob being
+  // the id its content hashed to; not part of the key
+  std::string new_file;
+
+  bool operator==(const DiffKey &other) const;
+};
+
+struct DiffKeyHash {
+  size_t operator()(const DiffKey &key) const;
+};
+
+// LRU cache of computed diffs with a byte budget. get() loads on a miss;
+// prefetch() loads the rows around the cursor on Background tasks so the
+// next cursor move finds its diff ready. Concurrent requests for the same
+// key share one load.
+//
+// Thread-safe. Results are shared_ptrs, so an evicted diff stays alive for
+// whoever is still showing it.
+class DiffCache {
+public:
+  using DiffPtr = std::shared_ptr<const FileDiff>;
+  using Loader =
+      std::function<FileDiff(const DiffKey &, const infra::CancellationToken &)>;
+
+  struct Options {
+    size_t byte_budget = size_t{64} << 20;
+  };
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t prefetched = 0; // Loads done by prefetch tasks
+    uint64_t prefetch_skipped = 0; // Queued prefetches the cursor moved past
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t byte_budget = 0;
+
+    [[nodiscard]] double hit_ratio() const {
+      uint64_t lookups = hits + misses;
+      return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+  };
+
+  DiffCache(infra::TaskExecutor &tasks, Loader loader);
+  DiffCache(infra::TaskExecutor &tasks, Loader loader, Options options);
+  // Queued prefetches still run after destruction but do nothing
+  ~DiffCache();
+
+  DiffCache(const DiffCache &) = delete;
+  DiffCache &operator=(const DiffCache &) = delete;
+
+  // Reads both blobs through `pool` (or new_file from disk) and diffs them
+  // in-process
+  static Loader blob_loader(infra::CatFilePool &pool);
+
+  // Cached diff for `key`, loading it on a miss. Waits for a prefetch or
+  // another get() of the same key instead of starting a second load; only
+  // `token` stops the wait, and if the other load was cancelled this call
+  // loads the diff itself.
+  DiffPtr get(const DiffKey &key, const infra::CancellationToken &token = {});
+
+  // Cached diff or nullptr; never loads
+  [[nodiscard]] DiffPtr find(const DiffKey &key) const;
+
+  // Loads `keys` (nearest first) at Background priority. A newer call makes
+  // the still-queued part of older batches a no-op.
+  void prefetch(const std::vector<DiffKey> &keys);
+
+  void set_byte_budget(size_t bytes);
+  void clear();
+
+  [[nodiscard]] Stats stats() const;
+
+  // Approximate heap footprint of a diff, as charged against the budget
+  static size_t estimated_bytes(const FileDiff &diff);
+
+private:
+  struct State;
+
+  infra::TaskExecutor &tasks_;
+  // Shared with queued prefetch tasks, which may outlive the cache
+  std::shared_ptr<State> state_;
+};
+
+// One file of a commit or of the status lists, with the key its hunks are
+// cached under
+struct DiffEntry {
+  std::string old_path;
+  std::string new_path;
+  bool is_renamed = false;
+  DiffKey key;
+};
+
+// A copy of `diff`, loaded for `entry`, with the paths filled in: cached
+// diffs are shared by every path with the same content
+FileDiff with_paths(const DiffEntry &entry, const FileDiff &diff);
+
+// The files `commit` (hex) changed against its first parent, or all of
+// them for a root, paired into renames as `git show` pairs them.
+// Submodules are left out. Throws GitCommandException.
+std::vector<DiffEntry> commit_changes(infra::GitProcessExecutor &executor,
+                                      const std::string &commit,
+                                      const infra::CancellationToken &token = {});
+
+// The staged (HEAD to index) or unstaged (index to work tree) change of one
+// file of the status lists. Blob ids are looked up through `pool`; a work
+// tree file is hashed here and read again when its diff is loaded. Throws
+// SlayerGitException for an unstaged change when `work_tree` is empty (a
+// bare repository).
+DiffEntry status_change(infra::CatFilePool &pool, const std::string &work_tree,
+                        const FileStatus &file, bool staged,
+                        HashAlgorithm algorithm);
+
+// Rows to prefetch around `row`, nearest first and below before above:
+// row+1, row-1, row+2, row-2, ...
+std::vector<size_t> rows_around(size_t row, size_t row_count,
+                                size_t radius = 2);
+
+} // namespace slayergit::core
@@ -0,0 +1,718 @@
+#include "file_history.hpp"
+
+#include "core/commit_graph.hpp"
+#include "core/object_database.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/mapped_file.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace slayergit::core {
+
+namespace {
+
+using infra::read_be32;
+
+constexpr uint32_t chunk_bloom_indexes = 0x42494458; // "BIDX"
+constexpr uint32_t chunk_bloom_data = 0x42444154;    // "BDAT"
+constexpr size_t bloom_header_size = 12;
+constexpr uint32_t bloom_seed0 = 0x293ae76f;
+constexpr uint32_t bloom_seed1 = 0x7e646e2c;
+constexpr uint32_t tree_mode = 040000;
+
+constexpr uint32_t no_node = 0xffffffff;
+constexpr uint32_t unresolved = 0xfffffffe;
+// Evaluations between cancellation and batch-delay checks
+constexpr uint64_t check_interval = 256;
+// Parsed trees kept between comparisons; a commit's trees are usually its
+// parent's too
+constexpr size_t tree_cache_entries = 1024;
+
+enum NodeFlags : uint8_t {
+  Queued = 1 << 0,
+  Evaluated = 1 << 1,
+  Shown = 1 << 2,
+};
+
+enum class BloomAnswer { DefinitelyNot, Maybe, Missing };
+
+uint32_t rotate_left(uint32_t value, int count) {
+  return (value << count) | (value >> (32 - count));
+}
+
+// MurmurHash3 (x86, 32-bit) as git's bloom.c computes it for version 2
+// filters. Version 1 sign-extends bytes above 0x7f on most platforms;
+// such paths skip version 1 filters, as in git.
+uint32_t murmur3(uint32_t seed, std::string_view data) {
+  const uint32_t c1 = 0xcc9e2d51;
+  const uint32_t c2 = 0x1b873593;
+  auto byte = [&data](size_t i) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(data[i]));
+  };
+  size_t blocks = data.size() / 4;
+  for (size_t i = 0; i < blocks; ++i) {
+    uint32_t k = byte(4 * i) | byte(4 * i + 1) << 8 | byte(4 * i + 2) << 16 |
+                 byte(4 * i + 3) << 24;
+    k *= c1;
+    k = rotate_left(k, 15);
+    k *= c2;
+    seed ^= k;
+    seed = rotate_left(seed, 13) * 5 + 0xe6546b64;
+  }
+  uint32_t k = 0;
+  size_t tail = 4 * blocks;
+  switch (data.size() & 3) {
+  case 3:
+    k ^= byte(tail + 2) << 16;
+    [[fallthrough]];
+  case 2:
+    k ^= byte(tail + 1) << 8;
+    [[fallthrough]];
+  case 1:
+    k ^= byte(tail);
+    k *= c1;
+    k = rotate_left(k, 15);
+    k *= c2;
+    seed ^= k;
+    break;
+  default:
+    break;
+  }
+  seed ^= static_cast<uint32_t>(data.size());
+  seed ^= seed >> 16;
+  seed *= 0x85ebca6b;
+  seed ^= seed >> 13;
+  seed *= 0xc2b2ae35;
+  seed ^= seed >> 16;
+  return seed;
+}
+
+bool is_ascii(std::string_view text) {
+  return std::all_of(text.begin(), text.end(), [](char c) {
+    return static_cast<uint8_t>(c) < 0x80;
+  });
+}
+
+// "a/b/c" -> "a", "b", "c"; "./" prefixes and trailing or doubled slashes
+// are dropped
+std::vector<std::string> split_path(const std::string &path) {
+  std::vector<std::string> components;
+  std::string_view rest = path;
+  while (!rest.empty()) {
+    size_t slash = rest.find('/');
+    std::string_view component = rest.substr(0, slash);
+    if (!component.empty() && component != ".") {
+      components.emplace_back(component);
+    }
+    rest.remove_prefix(slash == std::string_view::npos ? rest.size()
+                                                       : slash + 1);
+  }
+  return components;
+}
+
+// The fields of a commit object the log shows
+struct CommitFields {
+  std::string_view tree;              // Hex
+  std::vector<std::string_view> parents; // Hex
+  std::string_view author;            // "Name <email> time zone"
+  std::string_view message;
+};
+
+CommitFields parse_commit(std::string_view data) {
+  CommitFields fields;
+  while (!data.empty()) {
+    size_t end = data.find('\n');
+    std::string_view line = data.substr(0, end);
+    data.remove_prefix(end == std::string_view::npos ? data.size() : end + 1);
+    if (line.empty()) {
+      fields.message = data;
+      break;
+    }
+    if (line.compare(0, 5, "tree ") == 0) {
+      fields.tree = line.substr(5);
+    } else if (line.compare(0, 7, "parent ") == 0) {
+      fields.parents.push_back(line.substr(7));
+    } else if (line.compare(0, 7, "author ") == 0) {
+      fields.author = line.substr(7);
+    }
+  }
+  if (fields.tree.empty()) {
+    throw ParseException("commit object without a tree");
+  }
+  return fields;
+}
+
+// What `%an %ae %at %s %b` would print
+void fill_details(Commit &commit, const CommitFields &fields) {
+  std::string_view author = fields.author;
+  size_t open = author.find('<');
+  size_t close = author.find('>', open);
+  if (open != std::string_view::npos && close != std::string_view::npos) {
+    std::string_view name = author.substr(0, open);
+    while (!name.empty() && name.back() == ' ') {
+      name.remove_suffix(1);
+    }
+    commit.author_name = std::string(name);
+    commit.author_email = std::string(author.substr(open + 1, close - open - 1));
+    std::time_t date = 0;
+    for (size_t i = close + 2; i < author.size() && author[i] >= '0' &&
+                               author[i] <= '9';
+         ++i) {
+      date = date * 10 + (author[i] - '0');
+    }
+    commit.author_date = date;
+  }
+
+  // The subject is the first paragraph on one line, the body the rest
+  std::string_view message = fields.message;
+  while (!message.empty() && message.front() == '\n') {
+    message.remove_prefix(1);
+  }
+  while (!message.empty()) {
+    size_t end = message.find('\n');
+    std::string_view line = message.substr(0, end);
+    message.remove_prefix(end == std::string_view::npos ? message.size()
+                                                        : end + 1);
+    if (line.empty()) {
+      break;
+    }
+    if (!commit.subject.empty()) {
+      commit.subject += ' ';
+    }
+    commit.subject += line;
+  }
+  while (!message.empty() && message.front() == '\n') {
+    message.remove_prefix(1);
+  }
+  while (!message.empty() && message.back() == '\n') {
+    message.remove_suffix(1);
+  }
+  commit.body = std::string(message);
+}
+
+// One commit-graph layer's filters, with the path's keys hashed for its
+// settings
+struct BloomLayer {
+  uint32_t base = 0;
+  uint32_t count = 0;
+  const uint8_t *indexes = nullptr; // BIDX: end offset of each filter
+  const uint8_t *filters = nullptr; // BDAT after its header
+  size_t filters_size = 0;
+  // One key per leading directory of the path and the path itself; every
+  // one must be in a filter for the path to maybe have changed
+  std::vector<std::vector<uint32_t>> keys;
+};
+
+struct TreeEntryCopy {
+  uint32_t mode = 0;
+  std::string oid;
+};
+
+// Parsed once, then kept while the walk moves through nearby commits
+struct CachedTree {
+  Object object;
+  std::vector<TreeEntry> entries;
+};
+
+// A commit newer than the commit-graph, read from the object database
+struct LoadedCommit {
+  std::string oid;
+  std::string tree;
+  std::vector<std::string> parent_oids;
+  std::vector<uint32_t> parents;
+  uint64_t generation = 0;
+};
+
+// The state of one run(). Commits are numbered by commit-graph position,
+// then the loaded ones after them.
+class Walk {
+public:
+  Walk(const CommitGraph &graph, const ObjectDatabase &objects,
+       const std::string &path, FileHistory::Stats &stats,
+       const infra::CancellationToken &token)
+      : graph_(graph), objects_(objects), graph_size_(graph.size()),
+        path_(split_path(path)), stats_(stats), token_(token) {
+    read_filters();
+  }
+
+  // Id of `tip`, loading it and its ancestors outside the commit-graph
+  uint32_t load(const std::string &tip) {
+    uint32_t position = graph_.find(tip);
+    if (position != CommitGraph::no_position) {
+      return position;
+    }
+    std::vector<std::string> queue{tip};
+    while (!queue.empty()) {
+      std::string oid = std::move(queue.back());
+      queue.pop_back();
+      if (graph_.find(oid) != CommitGraph::no_position ||
+          loaded_ids_.count(oid) != 0) {
+        continue;
+      }
+      token_.throw_if_cancelled();
+      auto object = read(oid, ObjectType::Commit);
+      auto fields = parse_commit(object.data);
+      LoadedCommit commit;
+      commit.oid = oid;
+      commit.tree = CommitGraph::from_hex(fields.tree);
+      for (auto parent : fields.parents) {
+        commit.parent_oids.push_back(CommitGraph::from_hex(parent));
+        queue.push_back(commit.parent_oids.back());
+      }
+      loaded_ids_.emplace(oid, static_cast<uint32_t>(loaded_.size()));
+      loaded_.push_back(std::move(commit));
+    }
+    for (auto &commit : loaded_) {
+      for (const auto &parent : commit.parent_oids) {
+        commit.parents.push_back(id_of(parent));
+      }
+    }
+    // Above every parent, so generation order stays topological
+    for (size_t i = 0; i < loaded_.size(); ++i) {
+      std::vector<size_t> stack{i};
+      while (!stack.empty()) {
+        LoadedCommit &commit = loaded_[stack.back()];
+        if (commit.generation != 0) {
+          stack.pop_back();
+          continue;
+        }
+        uint64_t highest = 0;
+        bool ready = true;
+        for (uint32_t parent : commit.parents) {
+          if (parent < graph_size_) {
+            highest = std::max(highest, graph_.generation(parent));
+          } else if (loaded_[parent - graph_size_].generation == 0) {
+            stack.push_back(parent - graph_size_);
+            ready = false;
+          } else {
+            highest = std::max(highest, loaded_[parent - graph_size_].generation);
+          }
+        }
+        if (ready) {
+          commit.generation = highest + 1;
+          stack.pop_back();
+        }
+      }
+    }
+    stats_.commits_loaded = loaded_.size();
+    return graph_size_ + loaded_ids_.at(tip);
+  }
+
+  void start() {
+    size_t total = graph_size_ + loaded_.size();
+    flags_.assign(total, 0);
+    kept_parent_.assign(total, no_node);
+    rewritten_.assign(total, unresolved);
+  }
+
+  [[nodiscard]] uint64_t generation(uint32_t id) const {
+    return id < graph_size_ ? graph_.generation(id)
+                            : loaded_[id - graph_size_].generation;
+  }
+
+  void parents(uint32_t id, std::vector<uint32_t> &out) const {
+    if (id < graph_size_) {
+      graph_.parents(id, out);
+    } else {
+      out = loaded_[id - graph_size_].parents;
+    }
+  }
+
+  [[nodiscard]] bool queue(uint32_t id) {
+    if ((flags_[id] & Queued) != 0) {
+      return false;
+    }
+    flags_[id] |= Queued;
+    return true;
+  }
+
+  [[nodiscard]] bool shown(uint32_t id) {
+    evaluate(id);
+    return (flags_[id] & Shown) != 0;
+  }
+
+  [[nodiscard]] uint32_t kept_parent(uint32_t id) const {
+    return kept_parent_[id];
+  }
+
+  // The nearest commit at or below `id` that is shown, following the one
+  // parent each skipped commit keeps; no_node if the chain ends first
+  uint32_t resolve(uint32_t id) {
+    std::vector<uint32_t> chain;
+    uint32_t result = no_node;
+    while (true) {
+      if (rewritten_[id] != unresolved) {
+        result = rewritten_[id];
+        break;
+      }
+      if (shown(id)) {
+        result = id;
+        break;
+      }
+      chain.push_back(id);
+      if (kept_parent_[id] == no_node) {
+        break;
+      }
+      id = kept_parent_[id];
+    }
+    for (uint32_t skipped : chain) {
+      rewritten_[skipped] = result;
+    }
+    return result;
+  }
+
+  Commit details(uint32_t id, const std::vector<uint32_t> &parents) {
+    std::string raw(oid(id));
+    auto object = read(raw, ObjectType::Commit);
+    Commit commit;
+    commit.hash = CommitGraph::to_hex(raw);
+    commit.short_hash = commit.hash.substr(0, 7);
+    fill_details(commit, parse_commit(object.data));
+    for (uint32_t parent : parents) {
+      commit.parent_hashes.push_back(CommitGraph::to_hex(oid(parent)));
+    }
+    return commit;
+  }
+
+  // Called every check_interval evaluations
+  std::function<void()> on_check;
+
+private:
+  [[nodiscard]] std::string_view oid(uint32_t id) const {
+    return id < graph_size_ ? graph_.oid(id) : loaded_[id - graph_size_].oid;
+  }
+
+  [[nodiscard]] std::string_view tree(uint32_t id) const {
+    return id < graph_size_ ? graph_.tree(id) : loaded_[id - graph_size_].tree;
+  }
+
+  [[nodiscard]] uint32_t id_of(const std::string &oid) const {
+    uint32_t position = graph_.find(oid);
+    if (position != CommitGraph::no_position) {
+      return position;
+    }
+    return graph_size_ + loaded_ids_.at(oid);
+  }
+
+  Object read(std::string_view oid, ObjectType type) const {
+    auto object = objects_.read(oid);
+    if (!object || object->type != type) {
+      throw ParseException(std::string(object_type_name(type)) + " " +
+                           CommitGraph::to_hex(oid) + " is missing");
+    }
+    return std::move(*object);
+  }
+
+  void read_filters() {
+    if (path_.empty()) {
+      return;
+    }
+    std::vector<std::string> prefixes;
+    std::string prefix;
+    for (const auto &component : path_) {
+      prefix += prefix.empty() ? component : "/" + component;
+      prefixes.push_back(prefix);
+    }
+    for (size_t layer = 0; layer < graph_.layer_count(); ++layer) {
+      BloomLayer bloom;
+      bloom.base = graph_.layer_base(layer);
+      bloom.count = (layer + 1 < graph_.layer_count()
+                         ? graph_.layer_base(layer + 1)
+                         : graph_.size()) -
+                    bloom.base;
+      std::string_view indexes = graph_.chunk(layer, chunk_bloom_indexes);
+      std::string_view data = graph_.chunk(layer, chunk_bloom_data);
+      if (indexes.size() != size_t{bloom.count} * 4 ||
+          data.size() < bloom_header_size) {
+        bloom_.push_back(std::move(bloom));
+        continue;
+      }
+      auto header = reinterpret_cast<const uint8_t *>(data.data());
+      uint32_t version = read_be32(header);
+      uint32_t hashes = read_be32(header + 4);
+      bool usable = (version == 2 || (version == 1 && is_ascii(prefix))) &&
+                    hashes > 0 && hashes <= 32;
+      if (usable) {
+        bloom.indexes = reinterpret_cast<const uint8_t *>(indexes.data());
+        bloom.filters = header + bloom_header_size;
+        bloom.filters_size = data.size() - bloom_header_size;
+        for (const auto &key : prefixes) {
+          uint32_t hash0 = murmur3(bloom_seed0, key);
+          uint32_t hash1 = murmur3(bloom_seed1, key);
+          auto &hashed = bloom.keys.emplace_back();
+          for (uint32_t i = 0; i < hashes; ++i) {
+            hashed.push_back(hash0 + i * hash1);
+          }
+        }
+      }
+      bloom_.push_back(std::move(bloom));
+    }
+  }
+
+  // Whether the path may differ between `id` and its first parent
+  [[nodiscard]] BloomAnswer ask_filter(uint32_t id) const {
+    if (id >= graph_size_) {
+      return BloomAnswer::Missing;
+    }
+    const BloomLayer *layer = nullptr;
+    for (size_t i = bloom_.size(); i-- > 0;) {
+      if (id >= bloom_[i].base) {
+        layer = &bloom_[i];
+        break;
+      }
+    }
+    if (layer == nullptr || layer->indexes == nullptr) {
+      return BloomAnswer::Missing;
+    }
+    uint32_t index = id - layer->base;
+    uint32_t begin = index == 0 ? 0 : read_be32(layer->indexes + 4 * (index - 1));
+    uint32_t end = read_be32(layer->indexes + 4 * index);
+    // An empty filter was not computed
+    if (end <= begin || end > layer->filters_size) {
+      return BloomAnswer::Missing;
+    }
+    const uint8_t *filter = layer->filters + begin;
+    uint64_t bits = uint64_t{end - begin} * 8;
+    for (const auto &key : layer->keys) {
+      for (uint32_t hash : key) {
+        uint64_t bit = hash % bits;
+        if ((filter[bit / 8] & (1u << (bit % 8))) == 0) {
+          return BloomAnswer::DefinitelyNot;
+        }
+      }
+    }
+    return BloomAnswer::Maybe;
+  }
+
+  const CachedTree &tree_object(const std::string &oid) {
+    auto found = trees_.find(oid);
+    if (found != trees_.end()) {
+      return *found->second;
+    }
+    if (trees_.size() >= tree_cache_entries) {
+      trees_.clear();
+    }
+    auto cached = std::make_unique<CachedTree>();
+    cached->object = read(oid, ObjectType::Tree);
+    cached->entries = parse_tree(cached->object.data, objects_.hash_size());
+    ++stats_.trees_read;
+    return *trees_.emplace(oid, std::move(cached)).first->second;
+  }
+
+  std::optional<TreeEntryCopy> lookup(const std::string &tree,
+                                      const std::string &name) {
+    if (tree.empty()) {
+      return std::nullopt;
+    }
+    for (const auto &entry : tree_object(tree).entries) {
+      if (entry.name == name) {
+        return TreeEntryCopy{entry.mode, std::string(entry.oid)};
+      }
+    }
+    return std::nullopt;
+  }
+
+  // The path's entry under `tree`, or nullopt where it is absent: a
+  // component is missing, or a leading one is not a tree
+  std::optional<TreeEntryCopy> resolve_step(std::optional<TreeEntryCopy> tree,
+                                            size_t component) {
+    if (!tree) {
+      return std::nullopt;
+    }
+    auto entry = lookup(tree->oid, path_[component]);
+    if (entry && component + 1 < path_.size() && entry->mode != tree_mode) {
+      return std::nullopt;
+    }
+    return entry;
+  }
+
+  // Whether the path resolves to the same mode and id in both trees, or is
+  // absent from both; an empty id is a tree without it. Equal subtrees on
+  // the way end the comparison early.
+  bool same_path(const std::string &a, const std::string &b) {
+    auto root = [](const std::string &oid) -> std::optional<TreeEntryCopy> {
+      if (oid.empty()) {
+        return std::nullopt;
+      }
+      return TreeEntryCopy{tree_mode, oid};
+    };
+    auto side_a = root(a);
+    auto side_b = root(b);
+    for (size_t i = 0; i < path_.size(); ++i) {
+      if (!side_a && !side_b) {
+        return true;
+      }
+      if (side_a && side_b && side_a->oid == side_b->oid) {
+        return true;
+      }
+      side_a = resolve_step(std::move(side_a), i);
+      side_b = resolve_step(std::move(side_b), i);
+    }
+    if (!side_a || !side_b) {
+      return !side_a && !side_b;
+    }
+    return side_a->oid == side_b->oid && side_a->mode == side_b->mode;
+  }
+
+  // git's try_to_simplify_commit: a commit whose path matches a parent's
+  // is not shown and keeps only that parent; a root is shown if it has
+  // the path
+  void evaluate(uint32_t id) {
+    if ((flags_[id] & Evaluated) != 0) {
+      return;
+    }
+    flags_[id] |= Evaluated;
+    if (++stats_.commits_walked % check_interval == 0) {
+      token_.throw_if_cancelled();
+      if (on_check) {
+        on_check();
+      }
+    }
+    parents(id, scratch_);
+    if (scratch_.empty()) {
+      if (!same_path(std::string(tree(id)), {})) {
+        flags_[id] |= Shown;
+      }
+      return;
+    }
+    std::vector<uint32_t> candidates = scratch_;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      bool same = false;
+      if (i == 0) {
+        switch (ask_filter(id)) {
+        case BloomAnswer::DefinitelyNot:
+          ++stats_.bloom_definitely_not;
+          same = true;
+          break;
+        case BloomAnswer::Maybe:
+          ++stats_.bloom_maybe;
+          same = same_path(std::string(tree(id)), std::string(tree(candidates[0])));
+          stats_.bloom_false_positives += same ? 1 : 0;
+          break;
+        case BloomAnswer::Missing:
+          ++stats_.bloom_missing;
+          same = same_path(std::string(tree(id)), std::string(tree(candidates[0])));
+          break;
+        }
+      } else {
+        same = same_path(std::string(tree(id)), std::string(tree(candidates[i])));
+      }
+      if (same) {
+        kept_parent_[id] = candidates[i];
+        return;
+      }
+    }
+    flags_[id] |= Shown;
+  }
+
+  const CommitGraph &graph_;
+  const ObjectDatabase &objects_;
+  uint32_t graph_size_;
+  std::vector<std::string> path_;
+  FileHistory::Stats &stats_;
+  const infra::CancellationToken &token_;
+
+  std::vector<BloomLayer> bloom_;
+  std::vector<LoadedCommit> loaded_;
+  std::unordered_map<std::string, uint32_t> loaded_ids_;
+  std::unordered_map<std::string, std::unique_ptr<CachedTree>> trees_;
+
+  std::vector<uint8_t> flags_;
+  std::vector<uint32_t> kept_parent_; // The one parent a skipped commit follows
+  std::vector<uint32_t> rewritten_;   // resolve() results
+  std::vector<uint32_t> scratch_;
+};
+
+} // namespace
+
+double FileHistory::Stats::false_positive_rate() const {
+  uint64_t unchanged = bloom_definitely_not + bloom_false_positives;
+  return unchanged == 0 ? 0.0
+                        : static_cast<double>(bloom_false_positives) /
+                              static_cast<double>(unchanged);
+}
+
+FileHistory::FileHistory(const CommitGraph &graph,
+                         const ObjectDatabase &objects)
+    : FileHistory(graph, objects, Options{}) {}
+
+FileHistory::FileHistory(const CommitGraph &graph,
+                         const ObjectDatabase &objects, Options options)
+    : graph_(graph), objects_(objects), options_(options) {}
+
+FileHistory::Stats FileHistory::run(const std::string &tip,
+                                    const std::string &path,
+                                    const BatchCallback &on_batch,
+                                    const infra::CancellationToken &token) const {
+  if (graph_.hash_size() != objects_.hash_size()) {
+    throw ParseException("commit-graph and object database hash differ");
+  }
+  Stats stats;
+  Walk walk(graph_, objects_, path, stats, token);
+  uint32_t start = walk.load(CommitGraph::from_hex(tip));
+  walk.start();
+
+  std::vector<Commit> pending;
+  auto last_publish = std::chrono::steady_clock::now();
+  auto publish = [&] {
+    if (!pending.empty()) {
+      on_batch(std::move(pending));
+      pending.clear();
+    }
+    last_publish = std::chrono::steady_clock::now();
+  };
+  walk.on_check = [&] {
+    if (!pending.empty() && std::chrono::steady_clock::now() - last_publish >=
+                                options_.max_batch_delay) {
+      publish();
+    }
+  };
+
+  using Queued = std::pair<uint64_t, uint32_t>; // Generation, id
+  std::priority_queue<Queued> queue;
+  (void)walk.queue(start);
+  queue.emplace(walk.generation(start), start);
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> rewritten;
+  while (!queue.empty()) {
+    uint32_t id = queue.top().second;
+    queue.pop();
+    if (!walk.shown(id)) {
+      uint32_t parent = walk.kept_parent(id);
+      if (parent != no_node && walk.queue(parent)) {
+        queue.emplace(walk.generation(parent), parent);
+      }
+      continue;
+    }
+    walk.parents(id, parents);
+    rewritten.clear();
+    for (uint32_t parent : parents) {
+      if (walk.queue(parent)) {
+        queue.emplace(walk.generation(parent), parent);
+      }
+      uint32_t shown = walk.resolve(parent);
+      if (shown != no_node &&
+          std::find(rewritten.begin(), rewritten.end(), shown) ==
+              rewritten.end()) {
+        rewritten.push_back(shown);
+      }
+    }
+    pending.push_back(walk.details(id, rewritten));
+    ++stats.matches;
+    if (pending.size() >= options_.batch_rows ||
+        std::chrono::steady_clock::now() - last_publish >=
+            options_.max_batch_delay) {
+      publish();
+    }
+  }
+  publish();
+  return stats;
+}
+
+} // namespace slayergit::core
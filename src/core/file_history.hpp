@@ -0,0 +1,83 @@
+#pragma once
+
+#include "core/models/commit.hpp"
+#include "infra/cancellation.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace slayergit::core {
+
+class CommitGraph;
+class ObjectDatabase;
+
+// The commits that changed one path, the ones `git log -- <path>` lists
+// (default history simplification), found without running git.
+//
+// Commits are walked from the tip in decreasing generation order, so
+// children come before parents. A commit is first compared with its first
+// parent through the changed-path Bloom filter in the commit-graph (BIDX
+// and BDAT chunks): if the filter rules the path out, no tree is read.
+// Otherwise the path is looked up in both trees, reading only the
+// subtrees on the way to it. As in git, a commit whose path matches a
+// parent's follows only that parent. Commits newer than the commit-graph
+// are read from the object database.
+//
+// Matches stream out in batches. Their parents are rewritten to the
+// nearest matching ancestors, as `git log --graph -- <path>` does, so the
+// commits tab can draw lanes between them.
+class FileHistory {
+public:
+  struct Options {
+    size_t batch_rows = 200;
+    // A partial batch is published once this much time has passed since
+    // the last one, so sparse matches still show up while the walk runs
+    std::chrono::milliseconds max_batch_delay{50};
+  };
+
+  struct Stats {
+    uint64_t commits_walked = 0;
+    uint64_t commits_loaded = 0; // Newer than the commit-graph
+    uint64_t matches = 0;
+    // First-parent comparisons the Bloom filter answered
+    uint64_t bloom_definitely_not = 0;
+    uint64_t bloom_maybe = 0;
+    // The filter said maybe, but the path was the same as the parent's
+    uint64_t bloom_false_positives = 0;
+    // No usable filter: not computed, or the commit is not in the graph
+    uint64_t bloom_missing = 0;
+    uint64_t trees_read = 0;
+
+    // Of the commits that did not change the path (and had a filter),
+    // the share the filter failed to rule out
+    [[nodiscard]] double false_positive_rate() const;
+  };
+
+  // Called on the walking thread
+  using BatchCallback = std::function<void(std::vector<Commit> batch)>;
+
+  // `graph` and `objects` must outlive this; both are only read
+  FileHistory(const CommitGraph &graph, const ObjectDatabase &objects);
+  FileHistory(const CommitGraph &graph, const ObjectDatabase &objects,
+              Options options);
+
+  // Walks from `tip` (a commit id, hex). `path` is relative to the top of
+  // the work tree with '/' separators; a directory matches the commits
+  // that changed anything under it. Returns when the walk is done. Throws
+  // CancelledException, and ParseException for a missing or corrupt
+  // object.
+  Stats run(const std::string &tip, const std::string &path,
+            const BatchCallback &on_batch,
+            const infra::CancellationToken &token = {}) const;
+
+private:
+  const CommitGraph &graph_;
+  const ObjectDatabase &objects_;
+  Options options_;
+};
+
+} // namespace slayergit::core
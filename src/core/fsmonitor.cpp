@@ -0,0 +1,422 @@
+#include "fsmonitor.hpp"
+
+#include "infra/exceptions.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <unordered_set>
+
+namespace slayergit::core {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr std::string_view cookie_prefix = "slayergit-fsmonitor-cookie-";
+constexpr std::string_view token_prefix = "slayergit:";
+// How long a query waits for the watcher to catch up before giving up
+// and answering "/"
+constexpr auto cookie_timeout = 1s;
+constexpr auto client_timeout = 10s;
+// Past this, the older half of the journal is dropped; tokens from before
+// it get "/"
+constexpr size_t max_journal_paths = size_t{1} << 20;
+constexpr size_t max_token_size = 4096;
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// `path` relative to `dir`, if it is inside it
+bool relative_to(std::string_view path, std::string_view dir,
+                 std::string_view &rel) {
+  if (dir.empty() || !starts_with(path, dir) || path.size() <= dir.size() ||
+      path[dir.size()] != '/') {
+    return false;
+  }
+  rel = path.substr(dir.size() + 1);
+  return true;
+}
+
+bool parse_number(std::string_view text, uint64_t &sequence) {
+  if (text.empty() || text.size() > 19) {
+    return false;
+  }
+  sequence = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    sequence = sequence * 10 + static_cast<uint64_t>(c - '0');
+  }
+  return true;
+}
+
+void set_timeouts(int fd, std::chrono::seconds timeout) {
+  timeval value{};
+  value.tv_sec = static_cast<time_t>(timeout.count());
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value));
+}
+
+bool send_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(sent));
+  }
+  return true;
+}
+
+sockaddr_un socket_address(const std::string &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+// Connected socket to `path`, or an invalid one
+infra::UniqueFd connect_to(const std::string &path) {
+  infra::UniqueFd fd(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+  if (!fd.valid()) {
+    return fd;
+  }
+  sockaddr_un address = socket_address(path);
+  if (::connect(fd.get(), reinterpret_cast<const sockaddr *>(&address),
+                sizeof(address)) != 0) {
+    fd.reset();
+  }
+  return fd;
+}
+
+} // namespace
+
+std::string fsmonitor_socket_path(const infra::GitDirs &dirs) {
+  std::string path = dirs.git_dir + "/slayergit-fsmonitor.sock";
+  if (path.size() < sizeof(sockaddr_un::sun_path)) {
+    return path;
+  }
+  std::ostringstream name;
+  name << "slayergit-fsmonitor-" << std::hex
+       << std::hash<std::string>()(dirs.git_dir) << ".sock";
+  return (std::filesystem::temp_directory_path() / name.str()).string();
+}
+
+FsMonitorDaemon::FsMonitorDaemon(const std::string &repo_path)
+    : dirs_(infra::resolve_git_dirs(repo_path)),
+      socket_path_(fsmonitor_socket_path(dirs_)),
+      // git trusts "unchanged" answers, so writes through descriptors
+      // that stay open, and truncate(2), must be journaled too
+      watcher_(true) {
+  std::ostringstream instance;
+  instance << ::getpid() << '-' << std::hex
+           << std::chrono::steady_clock::now().time_since_epoch().count();
+  instance_ = instance.str();
+}
+
+FsMonitorDaemon::~FsMonitorDaemon() { stop(); }
+
+void FsMonitorDaemon::start() {
+  stop();
+  if (dirs_.work_tree.empty()) {
+    throw SlayerGitException("fsmonitor needs a work tree");
+  }
+
+  // The git dir is watched on its own, for the cookies queries write
+  watcher_.add(dirs_.work_tree, true, [this](const std::string &dir) {
+    return dir == dirs_.git_dir ||
+           std::filesystem::path(dir).filename() == ".git";
+  });
+  watcher_.add(dirs_.git_dir, false);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Nothing before this point is known
+    valid_from_ = journal_base_ + journal_.size();
+    cookies_seen_ = cookies_made_;
+  }
+  watcher_.start(
+      [this](const std::vector<std::string> &paths) { on_paths(paths); });
+
+  // A socket left by a daemon that died is replaced; a live one is not
+  if (connect_to(socket_path_).valid()) {
+    watcher_.stop();
+    throw SlayerGitException("an fsmonitor daemon already serves " +
+                             dirs_.work_tree);
+  }
+  ::unlink(socket_path_.c_str());
+  listener_.reset(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+  sockaddr_un address = socket_address(socket_path_);
+  if (!listener_.valid() ||
+      ::bind(listener_.get(), reinterpret_cast<const sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(listener_.get(), 16) != 0) {
+    std::string error = std::strerror(errno);
+    listener_.reset();
+    ::unlink(socket_path_.c_str());
+    watcher_.stop();
+    throw SlayerGitException("cannot listen on " + socket_path_ + ": " +
+                             error);
+  }
+  int fds[2];
+  if (::pipe2(fds, O_CLOEXEC) != 0) {
+    std::string error = std::strerror(errno);
+    listener_.reset();
+    ::unlink(socket_path_.c_str());
+    watcher_.stop();
+    throw SlayerGitException("cannot create pipe: " + error);
+  }
+  wake_read_.reset(fds[0]);
+  wake_write_.reset(fds[1]);
+  server_ = std::thread([this] { serve(); });
+}
+
+void FsMonitorDaemon::stop() {
+  watcher_.stop();
+  if (!server_.joinable()) {
+    return;
+  }
+  char byte = 0;
+  [[maybe_unused]] ssize_t written = ::write(wake_write_.get(), &byte, 1);
+  server_.join();
+  wake_read_.reset();
+  wake_write_.reset();
+  listener_.reset();
+  ::unlink(socket_path_.c_str());
+}
+
+FsMonitorDaemon::Stats FsMonitorDaemon::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.journal = journal_.size();
+  stats.watches = watcher_.watch_count();
+  stats.watch_limit_reached = watcher_.limit_reached();
+  return stats;
+}
+
+void FsMonitorDaemon::on_paths(const std::vector<std::string> &paths) {
+  bool cookie = false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &path : paths) {
+    ++stats_.events;
+    if (path.empty()) {
+      // Lost events: every token so far is stale, and so is any cookie
+      valid_from_ = journal_base_ + journal_.size();
+      cookies_seen_ = cookies_made_;
+      cookie = true;
+      continue;
+    }
+    // The git dir usually sits inside the work tree, so it is checked first
+    std::string_view rel;
+    if (relative_to(path, dirs_.git_dir, rel)) {
+      uint64_t number = 0;
+      if (starts_with(rel, cookie_prefix) &&
+          parse_number(rel.substr(cookie_prefix.size()), number)) {
+        cookies_seen_ = std::max(cookies_seen_, number);
+        cookie = true;
+      }
+      continue;
+    }
+    if (relative_to(path, dirs_.work_tree, rel) && rel != ".git" &&
+        !starts_with(rel, ".git/")) {
+      // Every write() of one file arrives as its own event. Repeats are
+      // dropped unless a token handed out since needs the newer entry.
+      uint64_t next = journal_base_ + journal_.size();
+      if (journal_.empty() || issued_ >= next || journal_.back() != rel) {
+        journal_.emplace_back(rel);
+      }
+    }
+  }
+  trim_journal();
+  if (cookie) {
+    cookie_seen_.notify_all();
+  }
+}
+
+void FsMonitorDaemon::trim_journal() {
+  if (journal_.size() <= max_journal_paths) {
+    return;
+  }
+  size_t dropped = journal_.size() / 2;
+  journal_.erase(journal_.begin(),
+                 journal_.begin() + static_cast<ptrdiff_t>(dropped));
+  journal_base_ += dropped;
+  valid_from_ = std::max(valid_from_, journal_base_);
+}
+
+bool FsMonitorDaemon::sync_with_watcher() {
+  // Events reach inotify in order, so once the cookie written now has been
+  // seen, so has every change made before the query
+  uint64_t number;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    number = ++cookies_made_;
+  }
+  std::string path =
+      dirs_.git_dir + "/" + std::string(cookie_prefix) + std::to_string(number);
+  int fd = ::open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  ::close(fd);
+  bool seen;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    seen = cookie_seen_.wait_for(lock, cookie_timeout,
+                                 [&] { return cookies_seen_ >= number; });
+  }
+  ::unlink(path.c_str());
+  return seen;
+}
+
+std::string FsMonitorDaemon::token(uint64_t sequence) const {
+  return std::string(token_prefix) + instance_ + ":" + std::to_string(sequence);
+}
+
+std::string FsMonitorDaemon::answer(std::string_view token) {
+  std::lock_guard<std::mutex> query_lock(query_mutex_);
+  bool synced = sync_with_watcher();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.queries;
+  uint64_t next = journal_base_ + journal_.size();
+  issued_ = next;
+  std::string reply = this->token(next);
+  reply += '\0';
+
+  std::string own_prefix = std::string(token_prefix) + instance_ + ":";
+  uint64_t since = 0;
+  bool known = synced && starts_with(token, own_prefix) &&
+               parse_number(token.substr(own_prefix.size()), since) &&
+               since >= valid_from_ && since >= journal_base_ && since <= next;
+  if (!known) {
+    ++stats_.full_rescans;
+    reply += "/";
+    reply += '\0';
+    return reply;
+  }
+  // A file written many times is reported once
+  std::unordered_set<std::string_view> reported;
+  for (size_t i = since - journal_base_; i < journal_.size(); ++i) {
+    if (reported.insert(journal_[i]).second) {
+      reply += journal_[i];
+      reply += '\0';
+    }
+  }
+  return reply;
+}
+
+void FsMonitorDaemon::serve() {
+  while (true) {
+    pollfd fds[2] = {{listener_.get(), POLLIN, 0},
+                     {wake_read_.get(), POLLIN, 0}};
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    if ((fds[1].revents & POLLIN) != 0) {
+      return;
+    }
+    if ((fds[0].revents & POLLIN) != 0) {
+      infra::UniqueFd client(::accept4(listener_.get(), nullptr, nullptr,
+                                       SOCK_CLOEXEC));
+      if (client.valid()) {
+        serve_client(client.get());
+      }
+    }
+  }
+}
+
+// One query per connection: the token on a line, then the answer's size
+// on a line and the answer
+void FsMonitorDaemon::serve_client(int fd) {
+  set_timeouts(fd, std::chrono::duration_cast<std::chrono::seconds>(
+                       client_timeout));
+  std::string request;
+  char buffer[512];
+  while (request.find('\n') == std::string::npos &&
+         request.size() < max_token_size) {
+    ssize_t length = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length <= 0) {
+      break;
+    }
+    request.append(buffer, static_cast<size_t>(length));
+  }
+  size_t end = request.find('\n');
+  if (end == std::string::npos) {
+    return;
+  }
+  // Sized, so the hook can tell a whole answer from a cut one
+  std::string reply = answer(std::string_view(request).substr(0, end));
+  send_all(fd, std::to_string(reply.size()) + "\n" + reply);
+}
+
+int run_fsmonitor_hook(const std::string &repo_path, const std::string &version,
+                       const std::string &token, std::ostream &out) {
+  if (version != "2") {
+    return 1;
+  }
+  std::string socket_path;
+  try {
+    socket_path = fsmonitor_socket_path(infra::resolve_git_dirs(repo_path));
+  } catch (const SlayerGitException &) {
+    return 1;
+  }
+  infra::UniqueFd fd = connect_to(socket_path);
+  if (!fd.valid()) {
+    return 1;
+  }
+  set_timeouts(fd.get(),
+               std::chrono::duration_cast<std::chrono::seconds>(client_timeout));
+  if (!send_all(fd.get(), token + "\n")) {
+    return 1;
+  }
+  std::string reply;
+  char buffer[64 * 1024];
+  while (true) {
+    ssize_t length = ::recv(fd.get(), buffer, sizeof(buffer), 0);
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length < 0) {
+      return 1;
+    }
+    if (length == 0) {
+      break;
+    }
+    reply.append(buffer, static_cast<size_t>(length));
+  }
+  // A missing path would leave git trusting a stale entry, so an answer
+  // cut short by a daemon that stopped is not passed on
+  size_t header = reply.find('\n');
+  uint64_t size = 0;
+  if (header == std::string::npos ||
+      !parse_number(std::string_view(reply).substr(0, header), size) ||
+      reply.size() - header - 1 != size) {
+    return 1;
+  }
+  out.write(reply.data() + header + 1, static_cast<std::streamsize>(size));
+  out.flush();
+  return out ? 0 : 1;
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "infra/fs_watcher.hpp"
+#include "infra/git_dir.hpp"
+#include "infra/process.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace slayergit::core {
+
+// Unix socket the repository's fsmonitor daemon listens on: in the git dir,
+// or under the temp dir when that path is too long for a socket address
+std::string fsmonitor_socket_path(const infra::GitDirs &dirs);
+
+// Provider for git's fsmonitor hook, protocol v2. Keeps an inotify watch on
+// the work tree and a journal of the paths that changed, so `git status`
+// only looks at those instead of every file:
+//
+//   git config core.fsmonitor "slayergit fsmonitor"
+//   git config core.fsmonitorHookVersion 2
+//
+// git runs the hook with the token of its last query; the hook asks this
+// daemon over the socket, which replies with a new token and the paths
+// changed since the old one. A token from another daemon, or one older
+// than lost events, gets "/": git then checks everything, as it would
+// without a hook.
+class FsMonitorDaemon {
+public:
+  struct Stats {
+    uint64_t events = 0;
+    uint64_t queries = 0;
+    uint64_t full_rescans = 0; // Queries answered with "/"
+    size_t journal = 0;        // Paths kept for tokens still answerable
+    size_t watches = 0;
+    bool watch_limit_reached = false;
+  };
+
+  explicit FsMonitorDaemon(const std::string &repo_path);
+  ~FsMonitorDaemon();
+
+  FsMonitorDaemon(const FsMonitorDaemon &) = delete;
+  FsMonitorDaemon &operator=(const FsMonitorDaemon &) = delete;
+
+  // Adds the watches and listens on socket_path(). Throws SlayerGitException
+  // for a bare repository, without inotify, or if the socket cannot be
+  // bound.
+  void start();
+  void stop();
+
+  // What the hook prints for `token`: "<new token>\0" followed by the
+  // changed paths relative to the work tree, each ending in "\0".
+  // Directories end with '/'.
+  std::string answer(std::string_view token);
+
+  [[nodiscard]] const std::string &socket_path() const { return socket_path_; }
+  [[nodiscard]] Stats stats() const;
+
+private:
+  void on_paths(const std::vector<std::string> &paths);
+  // Waits until the watcher has read every event from before the call
+  bool sync_with_watcher();
+  void trim_journal();
+  std::string token(uint64_t sequence) const;
+  void serve();
+  void serve_client(int fd);
+
+  infra::GitDirs dirs_;
+  std::string socket_path_;
+  std::string instance_; // Tells this daemon's tokens from older ones
+  infra::FsWatcher watcher_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cookie_seen_;
+  std::vector<std::string> journal_;
+  uint64_t journal_base_ = 0; // Sequence number of journal_[0]
+  uint64_t valid_from_ = 0;   // Older tokens missed events
+  uint64_t issued_ = 0;       // Sequence in the newest token answered
+  uint64_t cookies_made_ = 0;
+  uint64_t cookies_seen_ = 0;
+  Stats stats_;
+
+  // Queries are answered one at a time
+  std::mutex query_mutex_;
+  infra::UniqueFd listener_;
+  infra::UniqueFd wake_read_;
+  infra::UniqueFd wake_write_;
+  std::thread server_;
+};
+
+// The hook side, run by git from the work tree as
+// `slayergit fsmonitor <version> <token>`: writes the daemon's answer to
+// `out`. Returns non-zero, so git checks the whole tree, when the version
+// is not 2 or no daemon is running.
+int run_fsmonitor_hook(const std::string &repo_path, const std::string &version,
+                       const std::string &token, std::ostream &out);
+
+} // namespace slayergit::core
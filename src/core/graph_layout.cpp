@@ -0,0 +1,191 @@
+#include "graph_layout.hpp"
+
+#include <algorithm>
+
+namespace slayergit::core {
+
+GraphLayout::GraphLayout(size_t checkpoint_interval, size_t cache_rows)
+    : checkpoint_interval_(std::max<size_t>(checkpoint_interval, 1)),
+      cache_(std::max<size_t>(cache_rows, 1)) {}
+
+void GraphLayout::append(const std::vector<Commit> &batch) {
+  for (const auto &commit : batch) {
+    if (rows_ % checkpoint_interval_ == 0) {
+      checkpoints_.push_back(lanes_);
+    }
+    advance(lanes_, rows_, commit, nullptr);
+    max_lanes_ = std::max(max_lanes_, lanes_.size());
+    if (!topological_) {
+      listed_.emplace(std::hash<std::string>{}(commit.hash), rows_);
+    }
+    ++rows_;
+  }
+}
+
+void GraphLayout::clear() {
+  rows_ = 0;
+  lanes_.clear();
+  checkpoints_.clear();
+  max_lanes_ = 0;
+  listed_.clear();
+  replay_row_ = 0;
+  replay_lanes_.clear();
+  for (auto &slot : cache_) {
+    slot.row = static_cast<size_t>(-1);
+  }
+  rows_replayed_ = 0;
+  cache_hits_ = 0;
+}
+
+const GraphRow &GraphLayout::row(size_t row, const CommitAt &commit_at) {
+  CachedRow &slot = cache_[row % cache_.size()];
+  if (slot.row == row) {
+    ++cache_hits_;
+    return slot.layout;
+  }
+
+  // Continue from where the last call stopped when that is closer than the
+  // checkpoint, e.g. while a viewport is laid out top to bottom
+  size_t base = row - row % checkpoint_interval_;
+  if (replay_row_ > row || replay_row_ < base) {
+    replay_row_ = base;
+    replay_lanes_ = checkpoints_[base / checkpoint_interval_];
+  }
+  for (; replay_row_ < row; ++replay_row_) {
+    advance(replay_lanes_, replay_row_, commit_at(replay_row_), nullptr);
+    ++rows_replayed_;
+  }
+
+  advance(replay_lanes_, row, commit_at(row), &slot.layout);
+  replay_row_ = row + 1;
+  slot.row = row;
+  return slot.layout;
+}
+
+GraphLayout::Stats GraphLayout::stats() const {
+  Stats stats;
+  stats.rows = rows_;
+  stats.active_lanes = lanes_.size();
+  stats.max_lanes = max_lanes_;
+  stats.checkpoints = checkpoints_.size();
+  stats.rows_replayed = rows_replayed_;
+  stats.cache_hits = cache_hits_;
+  return stats;
+}
+
+bool GraphLayout::listed_above(const std::string &hash, size_t row) const {
+  if (topological_) {
+    return false;
+  }
+  auto found = listed_.find(std::hash<std::string>{}(hash));
+  return found != listed_.end() && found->second < row;
+}
+
+void GraphLayout::advance(Lanes &lanes, size_t row, const Commit &commit,
+                          GraphRow *out) {
+  size_t before = lanes.size();
+  freed_.assign(before, false);
+  if (out != nullptr) {
+    out->cells.assign(before, GraphNone);
+    out->merge = commit.parent_hashes.size() > 1;
+  }
+  auto mark = [out](size_t column, uint8_t flags) {
+    if (out != nullptr) {
+      if (column >= out->cells.size()) {
+        out->cells.resize(column + 1, GraphNone);
+      }
+      out->cells[column] |= flags;
+    }
+  };
+  auto edge = [&mark](size_t a, size_t b) {
+    size_t lo = std::min(a, b);
+    size_t hi = std::max(a, b);
+    mark(lo, GraphRight);
+    for (size_t column = lo + 1; column < hi; ++column) {
+      mark(column, GraphLeft | GraphRight);
+    }
+    mark(hi, GraphLeft);
+  };
+
+  // The leftmost lane waiting for this commit takes it; the others end
+  // here, bending into it
+  size_t column = before;
+  for (size_t lane = 0; lane < before; ++lane) {
+    if (lanes[lane].empty()) {
+      continue;
+    }
+    if (lanes[lane] != commit.hash) {
+      mark(lane, GraphUp | GraphDown);
+    } else if (column == before) {
+      column = lane;
+      mark(lane, GraphUp);
+    } else {
+      lanes[lane].clear();
+      freed_[lane] = true;
+      mark(lane, GraphUp);
+      edge(column, lane);
+    }
+  }
+
+  // A branch tip: nothing was waiting for it, so it opens a lane
+  if (column == before) {
+    auto free = std::find_if(lanes.begin(), lanes.end(),
+                             [](const std::string &lane) { return lane.empty(); });
+    column = free - lanes.begin();
+    if (column == lanes.size()) {
+      lanes.emplace_back();
+      freed_.push_back(false);
+    }
+  }
+  mark(column, GraphNode);
+
+  // The first parent continues straight down, even if another lane waits
+  // for it too; those lanes meet at the parent's row. A parent listed
+  // above would never arrive, so its lane is not opened.
+  if (commit.parent_hashes.empty() ||
+      listed_above(commit.parent_hashes.front(), row)) {
+    lanes[column].clear();
+  } else {
+    lanes[column] = commit.parent_hashes.front();
+    mark(column, GraphDown);
+  }
+  for (size_t i = 1; i < commit.parent_hashes.size(); ++i) {
+    const std::string &parent = commit.parent_hashes[i];
+    if (listed_above(parent, row)) {
+      continue;
+    }
+    size_t existing = std::find(lanes.begin(), lanes.end(), parent) -
+                      lanes.begin();
+    if (existing < lanes.size()) {
+      // Another child already leads to this parent; join its lane
+      if (existing != column) {
+        edge(column, existing);
+      }
+      continue;
+    }
+    // A new lane, in a slot that was free above this row
+    size_t slot = 0;
+    while (slot < lanes.size() && (!lanes[slot].empty() || freed_[slot])) {
+      ++slot;
+    }
+    if (slot == lanes.size()) {
+      lanes.emplace_back();
+      freed_.push_back(false);
+    }
+    lanes[slot] = parent;
+    mark(slot, GraphDown);
+    edge(column, slot);
+  }
+
+  while (!lanes.empty() && lanes.back().empty()) {
+    lanes.pop_back();
+  }
+  if (out != nullptr) {
+    out->commit_column = column;
+    while (!out->cells.empty() && out->cells.back() == GraphNone) {
+      out->cells.pop_back();
+    }
+  }
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "core/models/commit.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace slayergit::core {
+
+// Edges touching one lane column in one graph row. The UI maps each
+// combination to a glyph (up|down = "│", up|left = "╯", ...).
+enum GraphCell : uint8_t {
+  GraphNone = 0,
+  GraphUp = 1 << 0,    // A line comes in from the row above
+  GraphDown = 1 << 1,  // A line continues to the row below
+  GraphLeft = 1 << 2,  // A horizontal edge leaves to the left
+  GraphRight = 1 << 3, // A horizontal edge leaves to the right
+  GraphNode = 1 << 4,  // The row's commit sits in this column
+};
+
+struct GraphRow {
+  size_t commit_column = 0;
+  bool merge = false;         // The commit has more than one parent
+  std::vector<uint8_t> cells; // GraphCell flags, one per lane column
+};
+
+// Assigns commits to lanes as the log streams in, in topological order
+// (children before parents, e.g. `git log --topo-order`).
+//
+// Only the active lanes, the commit each is waiting for, are kept, plus a
+// copy of them every `checkpoint_interval` rows. A row's glyphs are rebuilt
+// on demand by replaying the commits from the nearest checkpoint, so only
+// visible rows cost anything and jumping to row 1,500,000 replays at most
+// one interval. The commits themselves stay with the caller (the commits
+// tab), which hands them back through a CommitAt callback.
+//
+// A log that is not in topological order (plain date order, streamed
+// while git has no commit-graph) may list a parent before one of its
+// children when commit clocks are skewed. With set_topological(false),
+// the rows of listed commits are remembered, and no lane is opened for a
+// parent that was already listed.
+//
+// Not thread-safe; callers serialize append() and row().
+class GraphLayout {
+public:
+  using CommitAt = std::function<const Commit &(size_t row)>;
+
+  struct Stats {
+    size_t rows = 0;
+    size_t active_lanes = 0;
+    size_t max_lanes = 0;
+    size_t checkpoints = 0;
+    uint64_t rows_replayed = 0; // Advanced to reach requested rows
+    uint64_t cache_hits = 0;
+  };
+
+  explicit GraphLayout(size_t checkpoint_interval = 512,
+                       size_t cache_rows = 256);
+
+  // Commits that follow the ones appended so far
+  void append(const std::vector<Commit> &batch);
+  void clear();
+
+  // True by default. Set before the first append().
+  void set_topological(bool topological) { topological_ = topological; }
+
+  [[nodiscard]] size_t row_count() const { return rows_; }
+
+  // Layout of `row`. The reference stays valid until the next call.
+  // Recently laid-out rows are cached, and the row below the last one
+  // computed continues from it without replaying.
+  const GraphRow &row(size_t row, const CommitAt &commit_at);
+
+  [[nodiscard]] Stats stats() const;
+
+private:
+  using Lanes = std::vector<std::string>;
+
+  struct CachedRow {
+    size_t row = static_cast<size_t>(-1);
+    GraphRow layout;
+  };
+
+  // Moves `lanes` past `commit` on `row`, filling `out` with the row if
+  // non-null
+  void advance(Lanes &lanes, size_t row, const Commit &commit, GraphRow *out);
+  // Whether `hash` was listed above `row`; always false in topological
+  // order
+  [[nodiscard]] bool listed_above(const std::string &hash, size_t row) const;
+
+  size_t checkpoint_interval_;
+  size_t rows_ = 0;
+  Lanes lanes_; // After the last appended commit
+  // checkpoints_[k] is the lanes before row k * checkpoint_interval_
+  std::vector<Lanes> checkpoints_;
+  size_t max_lanes_ = 0;
+  bool topological_ = true;
+  // Row of each listed commit by a hash of its id, when not topological
+  std::unordered_map<size_t, size_t> listed_;
+
+  // Where row() left off, so a viewport is laid out in one pass
+  size_t replay_row_ = 0;
+  Lanes replay_lanes_;
+  std::vector<CachedRow> cache_; // Slot = row % size
+  uint64_t rows_replayed_ = 0;
+  uint64_t cache_hits_ = 0;
+  std::vector<bool> freed_; // Scratch: lanes that ended in this row
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,391 @@
+#include "ignore_rules.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+
+namespace slayergit::core {
+
+namespace {
+
+enum GlobResult { GlobMatch, GlobNoMatch, GlobAbortAll, GlobAbortToStarStar };
+
+constexpr std::string_view glob_special = "*?[\\";
+
+bool is_glob_special(char c) {
+  return glob_special.find(c) != std::string_view::npos;
+}
+
+// "[:alpha:]" and friends; `name` is what sits between the colons
+bool in_class(std::string_view name, unsigned char c, bool &known) {
+  known = true;
+  if (name == "alnum") {
+    return std::isalnum(c) != 0;
+  }
+  if (name == "alpha") {
+    return std::isalpha(c) != 0;
+  }
+  if (name == "blank") {
+    return c == ' ' || c == '\t';
+  }
+  if (name == "cntrl") {
+    return std::iscntrl(c) != 0;
+  }
+  if (name == "digit") {
+    return std::isdigit(c) != 0;
+  }
+  if (name == "graph") {
+    return std::isgraph(c) != 0;
+  }
+  if (name == "lower") {
+    return std::islower(c) != 0;
+  }
+  if (name == "print") {
+    return std::isprint(c) != 0;
+  }
+  if (name == "punct") {
+    return std::ispunct(c) != 0;
+  }
+  if (name == "space") {
+    return std::isspace(c) != 0;
+  }
+  if (name == "upper") {
+    return std::isupper(c) != 0;
+  }
+  if (name == "xdigit") {
+    return std::isxdigit(c) != 0;
+  }
+  known = false;
+  return false;
+}
+
+// git's dowild() with WM_PATHNAME, over views instead of C strings. The
+// abort results stop retries that can no longer succeed, which keeps
+// patterns with many stars from going exponential.
+GlobResult match_glob(std::string_view pattern, size_t p, std::string_view text,
+                      size_t t) {
+  auto at = [&](size_t i) { return i < pattern.size() ? pattern[i] : '\0'; };
+  for (; p < pattern.size(); ++p, ++t) {
+    char p_ch = pattern[p];
+    char t_ch = t < text.size() ? text[t] : '\0';
+    if (t >= text.size() && p_ch != '*') {
+      return GlobAbortAll;
+    }
+    switch (p_ch) {
+    case '\\':
+      p_ch = at(++p);
+      if (t_ch != p_ch) {
+        return GlobNoMatch;
+      }
+      continue;
+    default:
+      if (t_ch != p_ch) {
+        return GlobNoMatch;
+      }
+      continue;
+    case '?':
+      if (t_ch == '/') {
+        return GlobNoMatch;
+      }
+      continue;
+    case '*': {
+      bool match_slash = false;
+      if (at(++p) == '*') {
+        size_t first = p - 1;
+        while (at(++p) == '*') {
+        }
+        // Only "**" standing for whole path components spans directories
+        if ((first == 0 || pattern[first - 1] == '/') &&
+            (p == pattern.size() || at(p) == '/' ||
+             (at(p) == '\\' && at(p + 1) == '/'))) {
+          if (at(p) == '/' && match_glob(pattern, p + 1, text, t) == GlobMatch) {
+            return GlobMatch;
+          }
+          match_slash = true;
+        }
+      }
+      if (p == pattern.size()) {
+        // A trailing "**" matches everything; a trailing "*" the rest of
+        // this component
+        if (!match_slash && text.find('/', t) != std::string_view::npos) {
+          return GlobNoMatch;
+        }
+        return GlobMatch;
+      }
+      if (!match_slash && at(p) == '/') {
+        // One star and a slash: the rest of this component
+        size_t slash = text.find('/', t);
+        if (slash == std::string_view::npos) {
+          return GlobNoMatch;
+        }
+        t = slash;
+        break; // The loop consumes the slash
+      }
+      while (t < text.size()) {
+        t_ch = text[t];
+        // Skip ahead to the literal that follows the star
+        if (!is_glob_special(at(p))) {
+          char literal = at(p);
+          while (t < text.size() && (match_slash || text[t] != '/') &&
+                 text[t] != literal) {
+            ++t;
+          }
+          if (t == text.size() || text[t] != literal) {
+            return GlobNoMatch;
+          }
+          t_ch = text[t];
+        }
+        GlobResult result = match_glob(pattern, p, text, t);
+        if (result != GlobNoMatch) {
+          if (!match_slash || result != GlobAbortToStarStar) {
+            return result;
+          }
+        } else if (!match_slash && t_ch == '/') {
+          return GlobAbortToStarStar;
+        }
+        ++t;
+      }
+      return GlobAbortAll;
+    }
+    case '[': {
+      p_ch = at(++p);
+      if (p_ch == '^') {
+        p_ch = '!';
+      }
+      bool negated = p_ch == '!';
+      if (negated) {
+        p_ch = at(++p);
+      }
+      char prev_ch = 0;
+      bool matched = false;
+      do {
+        if (p_ch == '\0') {
+          return GlobAbortAll;
+        }
+        if (p_ch == '\\') {
+          p_ch = at(++p);
+          if (p_ch == '\0') {
+            return GlobAbortAll;
+          }
+          matched = matched || t_ch == p_ch;
+        } else if (p_ch == '-' && prev_ch != 0 && at(p + 1) != '\0' &&
+                   at(p + 1) != ']') {
+          p_ch = at(++p);
+          if (p_ch == '\\') {
+            p_ch = at(++p);
+            if (p_ch == '\0') {
+              return GlobAbortAll;
+            }
+          }
+          matched = matched || (t_ch <= p_ch && t_ch >= prev_ch);
+          p_ch = 0; // No range may start here
+        } else if (p_ch == '[' && at(p + 1) == ':') {
+          size_t name_start = p + 2;
+          size_t close = pattern.find(']', name_start);
+          if (close == std::string_view::npos) {
+            return GlobAbortAll;
+          }
+          if (close - name_start < 1 || pattern[close - 1] != ':') {
+            // "[:" without ":]" is a plain '['
+            matched = matched || t_ch == '[';
+          } else {
+            bool known = false;
+            std::string_view name =
+                pattern.substr(name_start, close - 1 - name_start);
+            bool in = in_class(name, static_cast<unsigned char>(t_ch), known);
+            if (!known) {
+              return GlobAbortAll;
+            }
+            matched = matched || in;
+            p = close;
+            p_ch = 0; // No range may start here
+          }
+        } else {
+          matched = matched || t_ch == p_ch;
+        }
+        prev_ch = p_ch;
+        p_ch = at(++p);
+      } while (p_ch != ']');
+      if (matched == negated || t_ch == '/') {
+        return GlobNoMatch;
+      }
+      continue;
+    }
+    }
+  }
+  return t < text.size() ? GlobNoMatch : GlobMatch;
+}
+
+bool has_wildcard(std::string_view text) {
+  return std::any_of(text.begin(), text.end(), is_glob_special);
+}
+
+// Trailing spaces go unless escaped with a backslash
+std::string_view trim_trailing_spaces(std::string_view line) {
+  size_t end = line.size();
+  while (end > 0 && line[end - 1] == ' ') {
+    size_t backslashes = 0;
+    while (backslashes < end - 1 && line[end - 2 - backslashes] == '\\') {
+      ++backslashes;
+    }
+    if (backslashes % 2 == 1) {
+      break;
+    }
+    --end;
+  }
+  return line.substr(0, end);
+}
+
+std::string literal_key(std::string_view text, bool dir_only) {
+  std::string key(text);
+  if (dir_only) {
+    key += '/';
+  }
+  return key;
+}
+
+} // namespace
+
+bool glob_match(std::string_view pattern, std::string_view text) {
+  return match_glob(pattern, 0, text, 0) == GlobMatch;
+}
+
+IgnoreRules::IgnoreRules(std::string_view text, std::string base)
+    : base_(std::move(base)) {
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    add(text.substr(0, end));
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+  }
+}
+
+IgnoreRules IgnoreRules::read(const std::string &path, std::string base) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return IgnoreRules({}, std::move(base));
+  }
+  std::string text(std::istreambuf_iterator<char>(file), {});
+  return IgnoreRules(text, std::move(base));
+}
+
+void IgnoreRules::add(std::string_view line) {
+  if (line.empty() || line[0] == '#') {
+    return;
+  }
+  line = trim_trailing_spaces(line);
+  Pattern pattern;
+  if (!line.empty() && line[0] == '!') {
+    pattern.negated = true;
+    line.remove_prefix(1);
+  }
+  if (!line.empty() && line.back() == '/') {
+    pattern.dir_only = true;
+    line.remove_suffix(1);
+  }
+  if (line.empty()) {
+    return;
+  }
+  pattern.basename = line.find('/') == std::string_view::npos;
+  if (!pattern.basename && line[0] == '/') {
+    line.remove_prefix(1);
+  }
+  size_t index = patterns_.size();
+  pattern.literal_prefix = std::min(line.find_first_of(glob_special), line.size());
+  if (pattern.literal_prefix == line.size()) {
+    pattern.kind = Kind::Literal;
+    auto &map = pattern.basename ? literal_names_ : literal_paths_;
+    map[literal_key(line, pattern.dir_only)] = index;
+  } else if (pattern.basename && line[0] == '*' && !has_wildcard(line.substr(1))) {
+    pattern.kind = Kind::Suffix;
+    line.remove_prefix(1);
+    wildcards_.push_back(index);
+  } else {
+    wildcards_.push_back(index);
+  }
+  pattern.text = std::string(line);
+  patterns_.push_back(std::move(pattern));
+}
+
+bool IgnoreRules::matches(const Pattern &pattern, std::string_view path,
+                          std::string_view name, bool is_dir) const {
+  if (pattern.dir_only && !is_dir) {
+    return false;
+  }
+  std::string_view text = pattern.basename ? name : path;
+  std::string_view literal(pattern.text.data(), pattern.literal_prefix);
+  switch (pattern.kind) {
+  case Kind::Literal:
+    return text == pattern.text;
+  case Kind::Suffix:
+    return text.size() >= pattern.text.size() &&
+           text.compare(text.size() - pattern.text.size(), pattern.text.size(),
+                        pattern.text) == 0;
+  case Kind::Glob:
+    break;
+  }
+  if (text.compare(0, literal.size(), literal) != 0) {
+    return false;
+  }
+  return match_glob(pattern.text, literal.size(), text, literal.size()) ==
+         GlobMatch;
+}
+
+IgnoreRules::Match IgnoreRules::match(std::string_view path,
+                                      bool is_dir) const {
+  if (patterns_.empty() || path.compare(0, base_.size(), base_) != 0) {
+    return Match::None;
+  }
+  std::string_view below = path.substr(base_.size());
+  size_t slash = below.rfind('/');
+  std::string_view name =
+      slash == std::string_view::npos ? below : below.substr(slash + 1);
+
+  // The highest matching index wins; literals are looked up directly
+  bool found = false;
+  size_t best = 0;
+  auto consider = [&](const std::unordered_map<std::string, size_t> &map,
+                      std::string_view key, bool dir_only) {
+    if (map.empty()) {
+      return;
+    }
+    auto it = map.find(literal_key(key, dir_only));
+    if (it != map.end() && (!found || it->second > best)) {
+      found = true;
+      best = it->second;
+    }
+  };
+  consider(literal_names_, name, false);
+  consider(literal_paths_, below, false);
+  if (is_dir) {
+    consider(literal_names_, name, true);
+    consider(literal_paths_, below, true);
+  }
+  for (auto it = wildcards_.rbegin(); it != wildcards_.rend(); ++it) {
+    if (found && *it < best) {
+      break;
+    }
+    if (matches(patterns_[*it], below, name, is_dir)) {
+      found = true;
+      best = *it;
+      break;
+    }
+  }
+  if (!found) {
+    return Match::None;
+  }
+  return patterns_[best].negated ? Match::Included : Match::Ignored;
+}
+
+bool IgnoreStack::ignored(std::string_view path, bool is_dir) const {
+  for (const IgnoreStack *layer = this; layer != nullptr;
+       layer = layer->parent_.get()) {
+    auto match = layer->rules_.match(path, is_dir);
+    if (match != IgnoreRules::Match::None) {
+      return match == IgnoreRules::Match::Ignored;
+    }
+  }
+  return false;
+}
+
+} // namespace slayergit::core
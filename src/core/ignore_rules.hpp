@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace slayergit::core {
+
+// Whether `text` matches the gitignore glob `pattern`, as git's wildmatch
+// does with WM_PATHNAME: `*`, `?` and `[...]` stop at '/', and `**`
+// between slashes spans any number of directories
+bool glob_match(std::string_view pattern, std::string_view text);
+
+// The patterns of one .gitignore, info/exclude or core.excludesFile,
+// compiled once. Patterns without wildcards go into hash maps; the rest
+// keep their literal prefix so most of them are rejected by a compare
+// before the glob runs.
+class IgnoreRules {
+public:
+  enum class Match { None, Ignored, Included };
+
+  IgnoreRules() = default;
+  // `base` is the directory the file applies to, relative to the work tree:
+  // "" for the root, otherwise ending with '/'
+  IgnoreRules(std::string_view text, std::string base);
+
+  // Empty rules when the file does not exist
+  static IgnoreRules read(const std::string &path, std::string base);
+
+  // The last pattern matching `path` (relative to the work tree, below
+  // base, without a trailing '/') decides; None if no pattern matches
+  [[nodiscard]] Match match(std::string_view path, bool is_dir) const;
+
+  [[nodiscard]] bool empty() const { return patterns_.empty(); }
+  [[nodiscard]] size_t size() const { return patterns_.size(); }
+
+private:
+  enum class Kind {
+    Literal, // No wildcards
+    Suffix,  // "*" then no wildcards: "*.o"
+    Glob,
+  };
+
+  struct Pattern {
+    std::string text; // For Suffix, without the leading '*'
+    Kind kind = Kind::Glob;
+    size_t literal_prefix = 0; // Bytes before the first wildcard
+    bool negated = false;
+    bool dir_only = false;
+    bool basename = false; // No '/': matches the name at any depth
+  };
+
+  void add(std::string_view line);
+  [[nodiscard]] bool matches(const Pattern &pattern, std::string_view path,
+                             std::string_view name, bool is_dir) const;
+
+  std::string base_;
+  std::vector<Pattern> patterns_; // In file order; later ones win
+  // Highest index of each literal pattern, by name or by path below base
+  std::unordered_map<std::string, size_t> literal_names_;
+  std::unordered_map<std::string, size_t> literal_paths_;
+  std::vector<size_t> wildcards_; // Indices of the other patterns
+};
+
+// The rules in effect in one directory: its own file over those of its
+// parents, which are shared between siblings
+class IgnoreStack {
+public:
+  IgnoreStack(IgnoreRules rules, std::shared_ptr<const IgnoreStack> parent)
+      : rules_(std::move(rules)), parent_(std::move(parent)) {}
+
+  [[nodiscard]] bool ignored(std::string_view path, bool is_dir) const;
+
+private:
+  IgnoreRules rules_;
+  std::shared_ptr<const IgnoreStack> parent_;
+};
+
+} // namespace slayergit::core
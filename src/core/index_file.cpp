@@ -0,0 +1,281 @@
+#include "index_file.hpp"
+
+#include "infra/exceptions.hpp"
+#include "infra/git_dir.hpp"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace slayergit::core {
+
+namespace {
+
+using infra::read_be16;
+using infra::read_be32;
+
+constexpr uint32_t signature = 0x44495243; // "DIRC"
+constexpr size_t header_size = 12;
+constexpr size_t stat_size = 40; // Ten 32-bit fields, mode included
+
+constexpr uint32_t extension_cache_tree = 0x54524545;   // "TREE"
+constexpr uint32_t extension_split_index = 0x6c696e6b;  // "link"
+constexpr uint32_t extension_sparse = 0x73646972;       // "sdir"
+
+constexpr uint16_t flag_extended = 0x4000;
+constexpr uint16_t name_mask = 0x0fff;
+
+// git's varint: seven bits per byte, most significant first, with each
+// continuation adding one so that no value has two encodings
+bool decode_varint(const uint8_t *&p, const uint8_t *end, uint64_t &value) {
+  if (p == end) {
+    return false;
+  }
+  uint8_t c = *p++;
+  value = c & 0x7f;
+  while ((c & 0x80) != 0) {
+    if (p == end || value >= (uint64_t{1} << 56)) {
+      return false;
+    }
+    c = *p++;
+    value = ((value + 1) << 7) | (c & 0x7f);
+  }
+  return true;
+}
+
+} // namespace
+
+std::shared_ptr<const IndexFile> IndexFile::read(const std::string &path,
+                                                 HashAlgorithm algorithm) {
+  std::shared_ptr<IndexFile> index(new IndexFile());
+  index->path_ = path;
+  index->hash_size_ = core::hash_size(algorithm);
+
+  // Stat before mapping: if git replaces the index in between, the older
+  // time only makes more entries count as racy
+  struct stat info {};
+  if (::stat(path.c_str(), &info) != 0) {
+    if (errno == ENOENT) {
+      return index;
+    }
+    throw SlayerGitException("cannot stat " + path + ": " +
+                             std::strerror(errno));
+  }
+  index->mtime_sec_ = static_cast<uint32_t>(info.st_mtim.tv_sec);
+  index->mtime_nsec_ = static_cast<uint32_t>(info.st_mtim.tv_nsec);
+  index->file_ = infra::MappedFile(path);
+  index->parse();
+  return index;
+}
+
+std::shared_ptr<const IndexFile>
+IndexFile::read_repository(const std::string &repo_path,
+                           HashAlgorithm algorithm) {
+  return read(infra::resolve_git_dirs(repo_path).git_dir + "/index",
+              algorithm);
+}
+
+void IndexFile::parse() {
+  const uint8_t *data = file_.data();
+  size_t size = file_.size();
+  auto fail = [this](const std::string &what) {
+    throw ParseException("index " + path_ + ": " + what);
+  };
+
+  if (size < header_size + hash_size_ || read_be32(data) != signature) {
+    fail("bad signature");
+  }
+  version_ = read_be32(data + 4);
+  if (version_ < 2 || version_ > 4) {
+    fail("unsupported version " + std::to_string(version_));
+  }
+  // The trailing checksum is not verified: git renames a complete
+  // index.lock over the index, so a reader never sees a torn file
+  size_t end = size - hash_size_;
+  size_t offset = parse_entries(data, end, read_be32(data + 8));
+
+  while (offset < end) {
+    if (end - offset < 8) {
+      fail("truncated extension header");
+    }
+    uint32_t id = read_be32(data + offset);
+    size_t length = read_be32(data + offset + 4);
+    offset += 8;
+    if (length > end - offset) {
+      fail("truncated extension");
+    }
+    if (id == extension_cache_tree) {
+      parse_cache_tree(data + offset, length);
+    } else if (id == extension_sparse) {
+      sparse_ = true;
+    } else if (id == extension_split_index) {
+      throw SlayerGitException("index " + path_ +
+                               ": split index is not supported");
+    } else if (data[offset - 8] < 'A' || data[offset - 8] > 'Z') {
+      // Lower case: a reader that does not know it must not go on
+      fail("unknown extension " +
+           std::string(reinterpret_cast<const char *>(data + offset - 8), 4));
+    }
+    offset += length;
+  }
+}
+
+size_t IndexFile::parse_entries(const uint8_t *data, size_t end,
+                                size_t count) {
+  auto fail = [this](const std::string &what) {
+    throw ParseException("index " + path_ + ": " + what);
+  };
+  const size_t fixed = stat_size + hash_size_ + 2;
+  entries_.reserve(count);
+  // Version 4 paths go to paths_, which grows while parsing; views into it
+  // are made once it is complete
+  std::vector<std::pair<size_t, size_t>> v4_paths; // Offset, length
+  std::string previous;
+
+  size_t offset = header_size;
+  for (size_t i = 0; i < count; ++i) {
+    if (end - offset < fixed) {
+      fail("truncated entry " + std::to_string(i));
+    }
+    const uint8_t *p = data + offset;
+    Entry entry;
+    entry.stat.ctime_sec = read_be32(p);
+    entry.stat.ctime_nsec = read_be32(p + 4);
+    entry.stat.mtime_sec = read_be32(p + 8);
+    entry.stat.mtime_nsec = read_be32(p + 12);
+    entry.stat.dev = read_be32(p + 16);
+    entry.stat.ino = read_be32(p + 20);
+    entry.mode = read_be32(p + 24);
+    entry.stat.uid = read_be32(p + 28);
+    entry.stat.gid = read_be32(p + 32);
+    entry.stat.size = read_be32(p + 36);
+    entry.oid = {reinterpret_cast<const char *>(p + stat_size), hash_size_};
+    entry.flags = read_be16(p + stat_size + hash_size_);
+    const uint8_t *name = p + fixed;
+    if ((entry.flags & flag_extended) != 0) {
+      if (version_ < 3 || static_cast<size_t>(data + end - name) < 2) {
+        fail("bad extended flags in entry " + std::to_string(i));
+      }
+      entry.extended_flags = read_be16(name);
+      name += 2;
+    }
+
+    const uint8_t *limit = data + end;
+    if (version_ == 4) {
+      uint64_t strip = 0;
+      if (!decode_varint(name, limit, strip) || strip > previous.size()) {
+        fail("bad path prefix in entry " + std::to_string(i));
+      }
+      const void *nul = std::memchr(name, 0, static_cast<size_t>(limit - name));
+      if (nul == nullptr) {
+        fail("unterminated path in entry " + std::to_string(i));
+      }
+      const auto *suffix_end = static_cast<const uint8_t *>(nul);
+      previous.resize(previous.size() - strip);
+      previous.append(reinterpret_cast<const char *>(name),
+                      static_cast<size_t>(suffix_end - name));
+      v4_paths.emplace_back(paths_.size(), previous.size());
+      paths_ += previous;
+      offset = static_cast<size_t>(suffix_end + 1 - data);
+    } else {
+      // The length field saturates at 0xfff; longer names run to the NUL
+      size_t length = entry.flags & name_mask;
+      if (length == name_mask || length >= static_cast<size_t>(limit - name)) {
+        const void *nul =
+            std::memchr(name, 0, static_cast<size_t>(limit - name));
+        if (nul == nullptr) {
+          fail("unterminated path in entry " + std::to_string(i));
+        }
+        length = static_cast<size_t>(static_cast<const uint8_t *>(nul) - name);
+      } else if (name[length] != 0) {
+        fail("bad path length in entry " + std::to_string(i));
+      }
+      entry.path = {reinterpret_cast<const char *>(name), length};
+      // Padded with one to eight NULs to a multiple of eight bytes
+      size_t entry_size =
+          (static_cast<size_t>(name - p) + length + 8) & ~size_t{7};
+      if (entry_size > end - offset) {
+        fail("truncated entry " + std::to_string(i));
+      }
+      offset += entry_size;
+    }
+    entries_.push_back(entry);
+  }
+
+  for (size_t i = 0; i < v4_paths.size(); ++i) {
+    entries_[i].path =
+        std::string_view(paths_).substr(v4_paths[i].first, v4_paths[i].second);
+  }
+  return offset;
+}
+
+void IndexFile::parse_cache_tree(const uint8_t *data, size_t size) {
+  // Pre-order: "<name>\0<entries> <subtrees>\n<oid>", where entries is -1
+  // and the oid absent for an invalidated directory
+  const char *p = reinterpret_cast<const char *>(data);
+  const char *end = p + size;
+  auto fail = [this] {
+    throw ParseException("index " + path_ + ": bad cache tree");
+  };
+  auto read_number = [&](char terminator) {
+    const char *stop = static_cast<const char *>(
+        std::memchr(p, terminator, static_cast<size_t>(end - p)));
+    if (stop == nullptr || stop == p) {
+      fail();
+    }
+    std::string text(p, stop);
+    p = stop + 1;
+    try {
+      return std::stol(text);
+    } catch (const std::exception &) {
+      fail();
+    }
+    return 0L;
+  };
+
+  // Subtrees still to read below each open directory
+  std::vector<std::pair<std::string, uint32_t>> open;
+  while (p < end) {
+    const char *nul =
+        static_cast<const char *>(std::memchr(p, 0, static_cast<size_t>(end - p)));
+    if (nul == nullptr) {
+      fail();
+    }
+    std::string_view name(p, static_cast<size_t>(nul - p));
+    p = nul + 1;
+    CacheTree node;
+    long entries = read_number(' ');
+    long subtrees = read_number('\n');
+    if (entries < -1 || subtrees < 0) {
+      fail();
+    }
+    node.entry_count = static_cast<int32_t>(entries);
+    node.subtree_count = static_cast<uint32_t>(subtrees);
+    if (node.entry_count >= 0) {
+      if (static_cast<size_t>(end - p) < hash_size_) {
+        fail();
+      }
+      node.oid.assign(p, hash_size_);
+      p += hash_size_;
+    }
+    while (!open.empty() && open.back().second == 0) {
+      open.pop_back();
+    }
+    if (open.empty()) {
+      if (!cache_tree_.empty()) {
+        fail(); // A second root
+      }
+      node.path = std::string(name);
+    } else {
+      --open.back().second;
+      node.path = open.back().first.empty()
+                      ? std::string(name)
+                      : open.back().first + "/" + std::string(name);
+    }
+    open.emplace_back(node.path, node.subtree_count);
+    cache_tree_.push_back(std::move(node));
+  }
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "core/object_hash.hpp"
+#include "infra/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::core {
+
+// Reads .git/index in place through mmap: versions 2, 3 and 4 (whose paths
+// are prefix-compressed against the previous entry), the cache tree (TREE)
+// and sparse directory entries (sdir). Other optional extensions (EOIE,
+// IEOT, UNTR, FSMN, REUC, ...) are skipped. A split index ("link") is not
+// supported and throws.
+//
+// Entries keep their paths and object ids as views into the mapping, or
+// into one buffer for version 4, so 500k entries are read without a string
+// copy each. Immutable once read, so safe to share between threads.
+class IndexFile {
+public:
+  // Flags of an entry
+  static constexpr uint16_t assume_valid = 0x8000;
+  static constexpr uint16_t skip_worktree = 0x4000;  // Extended flags
+  static constexpr uint16_t intent_to_add = 0x2000;  // Extended flags
+
+  // As git records them from lstat(); all truncated to 32 bits
+  struct StatData {
+    uint32_t ctime_sec = 0;
+    uint32_t ctime_nsec = 0;
+    uint32_t mtime_sec = 0;
+    uint32_t mtime_nsec = 0;
+    uint32_t dev = 0;
+    uint32_t ino = 0;
+    uint32_t uid = 0;
+    uint32_t gid = 0;
+    uint32_t size = 0;
+  };
+
+  struct Entry {
+    std::string_view path; // Sparse directories end with '/'
+    std::string_view oid;  // Raw, hash_size() bytes
+    StatData stat;
+    uint32_t mode = 0; // 0100644, 0100755, 0120000, 0160000 or 040000
+    uint16_t flags = 0;
+    uint16_t extended_flags = 0;
+
+    [[nodiscard]] int stage() const { return (flags >> 12) & 3; }
+    [[nodiscard]] bool assumed_valid() const {
+      return (flags & assume_valid) != 0;
+    }
+    [[nodiscard]] bool skipped_worktree() const {
+      return (extended_flags & skip_worktree) != 0;
+    }
+    [[nodiscard]] bool intended_to_add() const {
+      return (extended_flags & intent_to_add) != 0;
+    }
+    [[nodiscard]] bool sparse_directory() const {
+      return (mode & 0170000) == 0040000;
+    }
+  };
+
+  // One directory of the cache tree, in the pre-order git writes them
+  struct CacheTree {
+    std::string path; // Empty for the root, else "dir" or "dir/sub"
+    int32_t entry_count = -1; // -1: invalidated, no oid
+    uint32_t subtree_count = 0;
+    std::string oid; // Raw tree id when valid
+  };
+
+  // An empty index when the file does not exist. Throws ParseException
+  // for a malformed index and SlayerGitException for a split index.
+  static std::shared_ptr<const IndexFile> read(const std::string &path,
+                                               HashAlgorithm algorithm);
+  // The index of `repo_path`, resolving its git dir first
+  static std::shared_ptr<const IndexFile>
+  read_repository(const std::string &repo_path, HashAlgorithm algorithm);
+
+  [[nodiscard]] uint32_t version() const { return version_; }
+  [[nodiscard]] size_t size() const { return entries_.size(); }
+  [[nodiscard]] const Entry &entry(size_t index) const {
+    return entries_[index];
+  }
+  [[nodiscard]] const std::vector<Entry> &entries() const { return entries_; }
+  [[nodiscard]] size_t hash_size() const { return hash_size_; }
+
+  // Empty when the index has no TREE extension
+  [[nodiscard]] const std::vector<CacheTree> &cache_tree() const {
+    return cache_tree_;
+  }
+  [[nodiscard]] bool sparse() const { return sparse_; }
+
+  // When the file was last written: an entry modified in or after that
+  // second may have changed without changing its stat data ("racy git")
+  [[nodiscard]] uint32_t mtime_sec() const { return mtime_sec_; }
+  [[nodiscard]] uint32_t mtime_nsec() const { return mtime_nsec_; }
+
+private:
+  IndexFile() = default;
+
+  void parse();
+  size_t parse_entries(const uint8_t *data, size_t end, size_t count);
+  void parse_cache_tree(const uint8_t *data, size_t size);
+
+  infra::MappedFile file_;
+  std::string path_;
+  std::string paths_; // Version 4 paths, back to back
+  std::vector<Entry> entries_;
+  std::vector<CacheTree> cache_tree_;
+  size_t hash_size_ = 20;
+  uint32_t version_ = 2;
+  uint32_t mtime_sec_ = 0;
+  uint32_t mtime_nsec_ = 0;
+  bool sparse_ = false;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,889 @@
+#include "index_status.hpp"
+
+#include "core/commit_graph.hpp"
+#include "core/object_database.hpp"
+#include "core/ref_snapshot.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_dir.hpp"
+#include "infra/process.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+
+namespace slayergit::core {
+
+namespace {
+
+// Entries a thread claims at a time; neighbours share directories, so a
+// block mostly checks each leading directory once
+constexpr size_t block_size = 512;
+// Paths per `git hash-object` when attributes may convert contents
+constexpr size_t hash_object_batch = 500;
+constexpr size_t read_chunk = 64 * 1024;
+// Files up to this size are read whole and hashed in batches, which lets
+// the multi-buffer hasher work on several at once; bigger ones stream
+constexpr uint64_t batched_file_limit = 1 << 20;
+constexpr size_t hash_batch_files = 64;
+constexpr size_t hash_batch_bytes = 8 << 20;
+
+constexpr uint32_t type_mask = 0170000;
+constexpr uint32_t type_regular = 0100000;
+constexpr uint32_t type_symlink = 0120000;
+constexpr uint32_t type_gitlink = 0160000;
+
+// Leading directories are only looked up through, never read; O_NOFOLLOW
+// makes one that became a symlink fail like a missing one
+#ifdef O_PATH
+constexpr int directory_flags = O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+#else
+constexpr int directory_flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+#endif
+
+bool parse_bool(std::string_view value) {
+  return value == "true" || value == "yes" || value == "on" || value == "1";
+}
+
+std::string lower(std::string_view text) {
+  std::string result(text);
+  std::transform(result.begin(), result.end(), result.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return result;
+}
+
+// lstat() as the index records it
+IndexFile::StatData stat_data(const struct stat &st) {
+  IndexFile::StatData data;
+  data.ctime_sec = static_cast<uint32_t>(st.st_ctim.tv_sec);
+  data.ctime_nsec = static_cast<uint32_t>(st.st_ctim.tv_nsec);
+  data.mtime_sec = static_cast<uint32_t>(st.st_mtim.tv_sec);
+  data.mtime_nsec = static_cast<uint32_t>(st.st_mtim.tv_nsec);
+  data.dev = static_cast<uint32_t>(st.st_dev);
+  data.ino = static_cast<uint32_t>(st.st_ino);
+  data.uid = static_cast<uint32_t>(st.st_uid);
+  data.gid = static_cast<uint32_t>(st.st_gid);
+  data.size = static_cast<uint32_t>(st.st_size);
+  return data;
+}
+
+bool same_stat(const IndexFile::StatData &a, const IndexFile::StatData &b) {
+  return a.ctime_sec == b.ctime_sec && a.ctime_nsec == b.ctime_nsec &&
+         a.mtime_sec == b.mtime_sec && a.mtime_nsec == b.mtime_nsec &&
+         a.dev == b.dev && a.ino == b.ino && a.uid == b.uid &&
+         a.gid == b.gid && a.size == b.size;
+}
+
+bool exists(const std::string &path) {
+  struct stat st;
+  return ::stat(path.c_str(), &st) == 0;
+}
+
+// Whether .gitattributes or autocrlf may make the blob differ from the
+// file's bytes; only then is a mismatching hash confirmed through git
+bool may_convert(const IndexFile &index, const infra::GitDirs &dirs,
+                 bool autocrlf) {
+  if (autocrlf || exists(dirs.common_dir + "/info/attributes")) {
+    return true;
+  }
+  if (const char *xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg) {
+    if (exists(std::string(xdg) + "/git/attributes")) {
+      return true;
+    }
+  } else if (const char *home = std::getenv("HOME"); home && *home) {
+    if (exists(std::string(home) + "/.config/git/attributes")) {
+      return true;
+    }
+  }
+  constexpr std::string_view name = ".gitattributes";
+  return std::any_of(
+      index.entries().begin(), index.entries().end(), [&](const auto &entry) {
+        std::string_view path = entry.path;
+        return path.size() >= name.size() &&
+               path.substr(path.size() - name.size()) == name &&
+               (path.size() == name.size() ||
+                path[path.size() - name.size() - 1] == '/');
+      });
+}
+
+// A file of HEAD, flattened from its trees
+struct HeadEntry {
+  std::string path;
+  uint32_t mode = 0;
+  std::string oid; // Raw
+};
+
+// What HEAD's trees hold, read in process. Subtrees whose id the cache tree
+// records for the same directory hold exactly the index's entries there:
+// they are not read, and those entries are marked `unchanged` instead.
+// False if an object is missing, so git can be asked.
+struct HeadWalk {
+  const ObjectDatabase &objects;
+  const IndexFile &index;
+  const std::unordered_set<std::string_view> &sparse_dirs;
+  const infra::CancellationToken &token;
+  std::unordered_map<std::string_view, std::string_view> cached; // Valid ones
+  std::vector<HeadEntry> head;
+  std::vector<bool> unchanged;
+
+  HeadWalk(const ObjectDatabase &objects, const IndexFile &index,
+           const std::unordered_set<std::string_view> &sparse_dirs,
+           const infra::CancellationToken &token)
+      : objects(objects), index(index), sparse_dirs(sparse_dirs),
+        token(token), unchanged(index.size(), false) {
+    for (const auto &tree : index.cache_tree()) {
+      if (tree.entry_count >= 0) {
+        cached.emplace(tree.path, tree.oid);
+      }
+    }
+  }
+
+  bool walk(const std::string &tree, const std::string &prefix) {
+    token.throw_if_cancelled();
+    auto object = objects.read(tree);
+    if (!object || object->type != ObjectType::Tree) {
+      return false;
+    }
+    for (const auto &entry : parse_tree(object->data, objects.hash_size())) {
+      std::string path = prefix + std::string(entry.name);
+      if ((entry.mode & type_mask) != 0040000) {
+        head.push_back(HeadEntry{std::move(path), entry.mode,
+                                 std::string(entry.oid)});
+        continue;
+      }
+      std::string dir = path + '/';
+      if (sparse_dirs.count(dir) != 0) {
+        head.push_back(HeadEntry{std::move(dir), entry.mode,
+                                 std::string(entry.oid)});
+        continue;
+      }
+      auto it = cached.find(path);
+      if (it != cached.end() && it->second == entry.oid) {
+        mark_unchanged(dir);
+        continue;
+      }
+      if (!walk(std::string(entry.oid), dir)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void mark_unchanged(std::string_view dir) {
+    const auto &entries = index.entries();
+    auto it = std::lower_bound(
+        entries.begin(), entries.end(), dir,
+        [](const IndexFile::Entry &entry, std::string_view path) {
+          return entry.path < path;
+        });
+    for (; it != entries.end() && it->path.substr(0, dir.size()) == dir; ++it) {
+      unchanged[static_cast<size_t>(it - entries.begin())] = true;
+    }
+  }
+};
+
+// HEAD's files as `git ls-tree -r` lists them, with the sparse
+// directories as trees
+std::vector<HeadEntry>
+list_head(infra::GitProcessExecutor &executor, const std::string &tree,
+          const std::unordered_set<std::string_view> &sparse_dirs,
+          const infra::CancellationToken &token) {
+  std::vector<HeadEntry> head;
+  std::vector<std::string> args{"ls-tree", "-r", "-z", "--full-tree"};
+  if (!sparse_dirs.empty()) {
+    args.push_back("-t");
+  }
+  args.push_back(CommitGraph::to_hex(tree));
+  auto result = executor.execute(args, token);
+  if (result.exit_code != 0) {
+    throw GitCommandException("git ls-tree", result.exit_code,
+                              result.stderr_output);
+  }
+  // "<mode> <type> <oid>\t<path>\0"
+  std::string_view rest = result.stdout_output;
+  while (!rest.empty()) {
+    size_t end = rest.find('\0');
+    std::string_view item = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    size_t space = item.find(' ');
+    size_t oid_start = item.find(' ', space + 1);
+    size_t tab = item.find('\t');
+    if (space == std::string_view::npos || oid_start == std::string_view::npos ||
+        tab == std::string_view::npos) {
+      throw ParseException("unexpected ls-tree entry");
+    }
+    HeadEntry entry;
+    entry.mode = static_cast<uint32_t>(
+        std::strtoul(std::string(item.substr(0, space)).c_str(), nullptr, 8));
+    entry.oid = CommitGraph::from_hex(
+        item.substr(oid_start + 1, tab - oid_start - 1));
+    entry.path = std::string(item.substr(tab + 1));
+    if (!sparse_dirs.empty()) {
+      bool inside = false;
+      for (size_t slash = entry.path.find('/');
+           slash != std::string::npos && !inside;
+           slash = entry.path.find('/', slash + 1)) {
+        inside = sparse_dirs.count(
+                     std::string_view(entry.path).substr(0, slash + 1)) != 0;
+      }
+      if (inside) {
+        continue;
+      }
+      if ((entry.mode & type_mask) == 0040000) {
+        entry.path += '/';
+        if (sparse_dirs.count(entry.path) == 0) {
+          continue;
+        }
+      }
+    }
+    head.push_back(std::move(entry));
+  }
+  return head;
+}
+
+} // namespace
+
+StatusOptions read_status_options(infra::GitProcessExecutor &executor) {
+  StatusOptions options;
+  auto result = executor.execute(
+      {"config", "-z", "--get-regexp",
+       "^(core\\.(filemode|symlinks|trustctime|checkstat|autocrlf)|"
+       "extensions\\.objectformat)$"});
+  // "key\nvalue\0"; a key set without a value is true
+  std::string_view rest = result.stdout_output;
+  while (!rest.empty()) {
+    size_t end = rest.find('\0');
+    std::string_view item = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    size_t newline = item.find('\n');
+    std::string key = lower(item.substr(0, newline));
+    bool has_value = newline != std::string_view::npos;
+    std::string value = has_value ? lower(item.substr(newline + 1)) : "true";
+    if (key == "core.filemode") {
+      options.filemode = parse_bool(value);
+    } else if (key == "core.symlinks") {
+      options.symlinks = parse_bool(value);
+    } else if (key == "core.trustctime") {
+      options.trust_ctime = parse_bool(value);
+    } else if (key == "core.checkstat") {
+      options.check_stat = value != "minimal";
+    } else if (key == "core.autocrlf") {
+      options.autocrlf = value == "input" || parse_bool(value);
+    } else if (key == "extensions.objectformat") {
+      options.algorithm =
+          value == "sha256" ? HashAlgorithm::Sha256 : HashAlgorithm::Sha1;
+    }
+  }
+  return options;
+}
+
+// One thread's share of unstaged(): the checks for the blocks it claims,
+// with its own hasher, read buffer and open leading directories
+struct IndexStatus::Check {
+  IndexStatus &status;
+  const IndexFile &index;
+  const std::string &work_tree;
+  bool convert;
+  uint32_t now; // Hashes of files changed in this second are not kept
+
+  Hasher hasher;
+  std::vector<char> buffer;
+  infra::UniqueFd root_fd;
+  // The directories of good_dir, outermost first. Files are looked up
+  // relative to the innermost, so the kernel resolves one name per lstat
+  // instead of the whole path.
+  std::vector<infra::UniqueFd> dir_fds;
+  std::string good_dir; // Relative, ending with '/': every part a real dir
+  std::string bad_dir;  // A part of this one is missing or a symlink
+  std::vector<std::pair<size_t, FileStatusType>> found;
+  std::vector<std::pair<size_t, IndexFile::StatData>> to_confirm;
+  std::vector<std::pair<std::string, Verified>> verified;
+
+  // Files read but not hashed yet, settled by flush()
+  struct Pending {
+    size_t index;
+    IndexFile::StatData stat;
+    std::string contents;
+  };
+  std::vector<Pending> pending;
+  size_t pending_bytes = 0;
+
+  Check(IndexStatus &status, const IndexFile &index,
+        const std::string &work_tree, bool convert, uint32_t now)
+      : status(status), index(index), work_tree(work_tree), convert(convert),
+        now(now), hasher(status.options_.algorithm), buffer(read_chunk),
+        // The work tree itself may be reached through a symlink
+        root_fd(::open(work_tree.c_str(), directory_flags & ~O_NOFOLLOW)) {
+    if (!root_fd.valid()) {
+      throw SlayerGitException("cannot open " + work_tree + ": " +
+                               std::strerror(errno));
+    }
+  }
+
+  void run(size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const auto &entry = index.entry(i);
+      if (entry.stage() != 0) {
+        // Once per path, at its first stage
+        if (i == 0 || index.entry(i - 1).path != entry.path) {
+          found.emplace_back(i, FileStatusType::Unmerged);
+        }
+        continue;
+      }
+      if (entry.sparse_directory() || entry.skipped_worktree() ||
+          entry.assumed_valid()) {
+        continue;
+      }
+      FileStatusType type = check(i, entry);
+      if (type != FileStatusType::Unmodified) {
+        found.emplace_back(i, type);
+      }
+    }
+    flush();
+  }
+
+  // The directory holding `path`, opened one part at a time from the
+  // deepest one shared with the last path; -1 if a part is gone or is no
+  // longer a real directory (a symlink counts), in which case git treats
+  // the entry as deleted
+  int parent_fd(std::string_view path) {
+    size_t slash = path.rfind('/');
+    std::string_view dir =
+        slash == std::string_view::npos ? "" : path.substr(0, slash + 1);
+    if (dir == good_dir) {
+      return dir_fds.empty() ? root_fd.get() : dir_fds.back().get();
+    }
+    if (!bad_dir.empty() && dir.substr(0, bad_dir.size()) == bad_dir) {
+      return -1;
+    }
+    size_t known = 0;
+    size_t depth = 0;
+    for (size_t i = 0; i < std::min(dir.size(), good_dir.size()); ++i) {
+      if (dir[i] != good_dir[i]) {
+        break;
+      }
+      if (dir[i] == '/') {
+        known = i + 1;
+        ++depth;
+      }
+    }
+    dir_fds.resize(depth);
+    good_dir.resize(known);
+    for (size_t end = dir.find('/', known); end != std::string_view::npos;
+         end = dir.find('/', known)) {
+      std::string name(dir.substr(known, end - known));
+      int parent = dir_fds.empty() ? root_fd.get() : dir_fds.back().get();
+      ++status.lstat_calls_;
+      infra::UniqueFd fd(::openat(parent, name.c_str(), directory_flags));
+      if (!fd.valid()) {
+        bad_dir = std::string(dir.substr(0, end + 1));
+        return -1;
+      }
+      dir_fds.push_back(std::move(fd));
+      good_dir.append(dir.substr(known, end + 1 - known));
+      known = end + 1;
+    }
+    return dir_fds.empty() ? root_fd.get() : dir_fds.back().get();
+  }
+
+  FileStatusType check(size_t i, const IndexFile::Entry &entry) {
+    const StatusOptions &options = status.options_;
+    int parent = parent_fd(entry.path);
+    if (parent < 0) {
+      return FileStatusType::Deleted;
+    }
+    size_t slash = entry.path.rfind('/');
+    std::string name(slash == std::string_view::npos
+                         ? entry.path
+                         : entry.path.substr(slash + 1));
+    struct stat st;
+    ++status.lstat_calls_;
+    if (::fstatat(parent, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+      return FileStatusType::Deleted;
+    }
+    uint32_t index_type = entry.mode & type_mask;
+    if (index_type == type_gitlink) {
+      return S_ISDIR(st.st_mode) ? check_submodule(entry)
+                                 : FileStatusType::TypeChanged;
+    }
+    if (S_ISDIR(st.st_mode)) {
+      return FileStatusType::Deleted;
+    }
+    if (entry.intended_to_add()) {
+      return FileStatusType::Added;
+    }
+    uint32_t type = S_ISREG(st.st_mode)   ? type_regular
+                    : S_ISLNK(st.st_mode) ? type_symlink
+                                          : 0;
+    // Without core.symlinks, git checks links out as plain files
+    if (!options.symlinks && index_type == type_symlink &&
+        type == type_regular) {
+      type = type_symlink;
+    }
+    if (type != index_type) {
+      return FileStatusType::TypeChanged;
+    }
+    if (type == type_regular && options.filemode &&
+        ((st.st_mode & 0100) != 0) != ((entry.mode & 0100) != 0)) {
+      return FileStatusType::Modified;
+    }
+
+    IndexFile::StatData current = stat_data(st);
+    const IndexFile::StatData &cached = entry.stat;
+    bool same_size = current.size == cached.size;
+    bool matches = same_size && current.mtime_sec == cached.mtime_sec &&
+                   (!options.trust_ctime ||
+                    current.ctime_sec == cached.ctime_sec);
+    if (options.check_stat) {
+      matches = matches && current.mtime_nsec == cached.mtime_nsec &&
+                (!options.trust_ctime ||
+                 current.ctime_nsec == cached.ctime_nsec) &&
+                current.ino == cached.ino && current.uid == cached.uid &&
+                current.gid == cached.gid;
+    }
+    // Racily clean: written in the second the index was, so a later
+    // change in that second would leave the same stat data
+    bool racy =
+        index.mtime_sec() != 0 && index.mtime_sec() <= cached.mtime_sec;
+    if (matches && !racy) {
+      return FileStatusType::Unmodified;
+    }
+    // An entry git smudged for being racy has size 0; anything else with
+    // a different size has changed
+    if (!same_size && cached.size != 0) {
+      return FileStatusType::Modified;
+    }
+    if (matches) {
+      ++status.racy_;
+    }
+
+    std::string path(entry.path);
+    {
+      std::lock_guard<std::mutex> lock(status.verified_mutex_);
+      auto it = status.verified_.find(path);
+      if (it != status.verified_.end() && same_stat(it->second.stat, current) &&
+          it->second.index_oid == entry.oid) {
+        ++status.cache_hits_;
+        verified.emplace_back(path, it->second);
+        return it->second.clean ? FileStatusType::Unmodified
+                                : FileStatusType::Modified;
+      }
+    }
+
+    if (S_ISREG(st.st_mode) &&
+        static_cast<uint64_t>(st.st_size) <= batched_file_limit) {
+      ++status.hashed_;
+      std::string contents;
+      if (!read_file(parent, name, st, contents)) {
+        return settle(i, current, false);
+      }
+      pending_bytes += contents.size();
+      pending.push_back(Pending{i, current, std::move(contents)});
+      if (pending.size() >= hash_batch_files ||
+          pending_bytes >= hash_batch_bytes) {
+        flush();
+      }
+      // Reported by flush() if it turns out modified
+      return FileStatusType::Unmodified;
+    }
+    return settle(i, current, hash_matches(entry, parent, name, st));
+  }
+
+  // The status of an entry whose contents were hashed: a mismatch may
+  // still be a clean filter's doing, which only git can tell
+  FileStatusType settle(size_t i, const IndexFile::StatData &current,
+                        bool clean) {
+    const auto &entry = index.entry(i);
+    if (!clean && convert) {
+      to_confirm.emplace_back(i, current);
+      return FileStatusType::Unmodified;
+    }
+    // Not kept while the file may still change within its mtime second
+    if (current.mtime_sec < now && current.ctime_sec < now) {
+      verified.emplace_back(std::string(entry.path),
+                            Verified{current, std::string(entry.oid), clean});
+    }
+    return clean ? FileStatusType::Unmodified : FileStatusType::Modified;
+  }
+
+  void flush() {
+    if (pending.empty()) {
+      return;
+    }
+    std::vector<std::string_view> contents;
+    contents.reserve(pending.size());
+    for (const auto &file : pending) {
+      contents.emplace_back(file.contents);
+    }
+    auto oids = hash_objects(status.options_.algorithm, "blob", contents);
+    for (size_t k = 0; k < pending.size(); ++k) {
+      size_t i = pending[k].index;
+      FileStatusType type =
+          settle(i, pending[k].stat, oids[k] == index.entry(i).oid);
+      if (type != FileStatusType::Unmodified) {
+        found.emplace_back(i, type);
+      }
+    }
+    pending.clear();
+    pending_bytes = 0;
+  }
+
+  // The whole of a regular file that lstat() said has st.st_size bytes;
+  // false if it cannot be read or its size changed meanwhile
+  static bool read_file(int parent, const std::string &name,
+                        const struct stat &st, std::string &contents) {
+    infra::UniqueFd fd(
+        ::openat(parent, name.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW));
+    if (!fd.valid()) {
+      return false;
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    // One byte more than expected, to notice a file that grew
+    contents.resize(size + 1);
+    size_t total = 0;
+    while (total < contents.size()) {
+      ssize_t got =
+          ::read(fd.get(), contents.data() + total, contents.size() - total);
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      if (got <= 0) {
+        break;
+      }
+      total += static_cast<size_t>(got);
+    }
+    contents.resize(size);
+    return total == size;
+  }
+
+  bool hash_matches(const IndexFile::Entry &entry, int parent,
+                    const std::string &name, const struct stat &st) {
+    ++status.hashed_;
+    hasher.reset();
+    if (S_ISLNK(st.st_mode)) {
+      // A link's blob is its target
+      buffer.resize(std::max<size_t>(read_chunk, st.st_size + 1));
+      ssize_t length =
+          ::readlinkat(parent, name.c_str(), buffer.data(), buffer.size());
+      if (length < 0 || static_cast<size_t>(length) == buffer.size()) {
+        return false;
+      }
+      hasher.update(object_header("blob", static_cast<uint64_t>(length)));
+      hasher.update(buffer.data(), static_cast<size_t>(length));
+      return hasher.finish() == entry.oid;
+    }
+
+    infra::UniqueFd fd(
+        ::openat(parent, name.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW));
+    if (!fd.valid()) {
+      return false;
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    hasher.update(object_header("blob", size));
+    uint64_t total = 0;
+    while (true) {
+      ssize_t got = ::read(fd.get(), buffer.data(), buffer.size());
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      if (got <= 0) {
+        break;
+      }
+      hasher.update(buffer.data(), static_cast<size_t>(got));
+      total += static_cast<uint64_t>(got);
+    }
+    // A file that changed while being read is modified either way
+    return total == size && hasher.finish() == entry.oid;
+  }
+
+  FileStatusType check_submodule(const IndexFile::Entry &entry) {
+    // Only the checked-out commit is compared, not changes inside it; an
+    // uninitialised submodule (no repository there) counts as unchanged
+    std::string head;
+    try {
+      head = RefSnapshot::read(work_tree + "/" + std::string(entry.path))
+                 ->head()
+                 .oid;
+    } catch (const SlayerGitException &) {
+      return FileStatusType::Unmodified;
+    }
+    return head.empty() || head == CommitGraph::to_hex(entry.oid)
+               ? FileStatusType::Unmodified
+               : FileStatusType::Modified;
+  }
+};
+
+IndexStatus::IndexStatus(infra::GitProcessExecutor &executor,
+                         StatusOptions options, const ObjectDatabase *objects)
+    : executor_(executor), options_(options), objects_(objects) {}
+
+std::vector<FileStatus>
+IndexStatus::unstaged(const IndexFile &index,
+                      const infra::CancellationToken &token) {
+  infra::GitDirs dirs = infra::resolve_git_dirs(executor_.repo_path());
+  if (dirs.work_tree.empty()) {
+    throw SlayerGitException("a bare repository has no work tree");
+  }
+  entries_ += index.size();
+  bool convert = may_convert(index, dirs, options_.autocrlf);
+  auto now = static_cast<uint32_t>(std::time(nullptr));
+
+  size_t blocks = (index.size() + block_size - 1) / block_size;
+  size_t thread_count = options_.threads != 0
+                            ? options_.threads
+                            : std::max(1u, std::thread::hardware_concurrency());
+  thread_count = std::max<size_t>(1, std::min(thread_count, blocks));
+  std::vector<Check> checks;
+  checks.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    checks.emplace_back(*this, index, dirs.work_tree, convert, now);
+  }
+
+  // Blocks are claimed in order; cancellation is noticed between blocks
+  std::atomic<size_t> next{0};
+  auto work = [&](Check &check) {
+    for (size_t block = next++; block < blocks; block = next++) {
+      if (token.cancelled()) {
+        return;
+      }
+      check.run(block * block_size,
+                std::min(index.size(), (block + 1) * block_size));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back(work, std::ref(checks[i]));
+  }
+  if (!checks.empty()) {
+    work(checks[0]);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  token.throw_if_cancelled();
+
+  std::vector<std::pair<size_t, FileStatusType>> found;
+  std::vector<size_t> to_confirm;
+  std::unordered_map<size_t, IndexFile::StatData> confirm_stat;
+  std::unordered_map<std::string, Verified> verified;
+  for (auto &check : checks) {
+    found.insert(found.end(), check.found.begin(), check.found.end());
+    for (auto &[i, stat] : check.to_confirm) {
+      to_confirm.push_back(i);
+      confirm_stat.emplace(i, stat);
+    }
+    for (auto &[path, entry] : check.verified) {
+      verified.insert_or_assign(std::move(path), std::move(entry));
+    }
+  }
+  if (!to_confirm.empty()) {
+    std::sort(to_confirm.begin(), to_confirm.end());
+    auto modified = confirm_with_git(index, to_confirm, token);
+    std::unordered_set<size_t> changed(modified.begin(), modified.end());
+    for (size_t i : to_confirm) {
+      bool clean = changed.count(i) == 0;
+      if (!clean) {
+        found.emplace_back(i, FileStatusType::Modified);
+      }
+      const auto &stat = confirm_stat[i];
+      if (stat.mtime_sec < now && stat.ctime_sec < now) {
+        verified.insert_or_assign(
+            std::string(index.entry(i).path),
+            Verified{stat, std::string(index.entry(i).oid), clean});
+      }
+    }
+  }
+  {
+    // Only what this refresh saw, so deleted files do not pile up
+    std::lock_guard<std::mutex> lock(verified_mutex_);
+    verified_ = std::move(verified);
+  }
+
+  std::sort(found.begin(), found.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  std::vector<FileStatus> result;
+  result.reserve(found.size());
+  for (const auto &[i, type] : found) {
+    FileStatus file;
+    file.path = std::string(index.entry(i).path);
+    file.unstaged_status = type;
+    result.push_back(std::move(file));
+  }
+  return result;
+}
+
+std::vector<size_t>
+IndexStatus::confirm_with_git(const IndexFile &index,
+                              const std::vector<size_t> &entries,
+                              const infra::CancellationToken &token) {
+  std::string work_tree =
+      infra::resolve_git_dirs(executor_.repo_path()).work_tree;
+  std::vector<size_t> modified;
+  for (size_t first = 0; first < entries.size(); first += hash_object_batch) {
+    size_t last = std::min(entries.size(), first + hash_object_batch);
+    std::vector<std::string> args{"hash-object", "--"};
+    for (size_t k = first; k < last; ++k) {
+      args.emplace_back(index.entry(entries[k]).path);
+    }
+    filtered_ += last - first;
+    auto result = executor_.execute_in_dir(work_tree, args, token);
+    // One id per line, in argument order
+    std::string_view rest = result.stdout_output;
+    for (size_t k = first; k < last; ++k) {
+      size_t newline = rest.find('\n');
+      std::string_view hex = rest.substr(0, newline);
+      rest.remove_prefix(newline == std::string_view::npos ? rest.size()
+                                                           : newline + 1);
+      if (result.exit_code != 0 ||
+          hex != CommitGraph::to_hex(index.entry(entries[k]).oid)) {
+        modified.push_back(entries[k]);
+      }
+    }
+  }
+  return modified;
+}
+
+std::string IndexStatus::head_tree(const infra::CancellationToken &token) {
+  std::string commit = RefSnapshot::read(executor_.repo_path())->head().oid;
+  if (commit.empty()) {
+    return {};
+  }
+  try {
+    if (auto graph = CommitGraph::open_repository(executor_.repo_path())) {
+      uint32_t position = graph->find_hex(commit);
+      if (position != CommitGraph::no_position) {
+        return std::string(graph->tree(position));
+      }
+    }
+  } catch (const SlayerGitException &) {
+    // Asked of git below
+  }
+  if (objects_ != nullptr) {
+    try {
+      if (auto tree = objects_->peel_to_tree(CommitGraph::from_hex(commit))) {
+        return *tree;
+      }
+    } catch (const SlayerGitException &) {
+      // Asked of git below
+    }
+  }
+  auto result = executor_.execute(
+      {"rev-parse", "--verify", "--quiet", commit + "^{tree}"}, token);
+  std::string hex = result.stdout_output.substr(
+      0, result.stdout_output.find_first_of("\r\n"));
+  if (result.exit_code != 0 || hex.empty()) {
+    throw GitCommandException("git rev-parse", result.exit_code,
+                              result.stderr_output);
+  }
+  return CommitGraph::from_hex(hex);
+}
+
+std::vector<FileStatus>
+IndexStatus::staged(const IndexFile &index,
+                    const infra::CancellationToken &token) {
+  std::string tree = head_tree(token);
+  const auto &cache_tree = index.cache_tree();
+  if (!tree.empty() && !cache_tree.empty() &&
+      cache_tree.front().entry_count >= 0 && cache_tree.front().oid == tree) {
+    return {};
+  }
+
+  // Sparse directories stand for whole trees of HEAD
+  std::unordered_set<std::string_view> sparse_dirs;
+  for (const auto &entry : index.entries()) {
+    if (entry.sparse_directory()) {
+      sparse_dirs.insert(entry.path);
+    }
+  }
+
+  std::vector<HeadEntry> head;
+  std::vector<bool> unchanged(index.size(), false);
+  if (!tree.empty()) {
+    ++trees_listed_;
+    bool walked = false;
+    if (objects_ != nullptr) {
+      try {
+        HeadWalk walk(*objects_, index, sparse_dirs, token);
+        if (walk.walk(tree, "")) {
+          head = std::move(walk.head);
+          unchanged = std::move(walk.unchanged);
+          walked = true;
+        }
+      } catch (const ParseException &) {
+        // A corrupt object: git will say what is wrong
+      }
+    }
+    if (!walked) {
+      head = list_head(executor_, tree, sparse_dirs, token);
+    }
+    auto by_path = [](const HeadEntry &a, const HeadEntry &b) {
+      return a.path < b.path;
+    };
+    if (!std::is_sorted(head.begin(), head.end(), by_path)) {
+      std::sort(head.begin(), head.end(), by_path);
+    }
+  }
+
+  // Both sides sorted by path: walk them together
+  std::vector<FileStatus> result;
+  auto report = [&result](std::string_view path, FileStatusType type) {
+    FileStatus file;
+    file.path = std::string(path);
+    file.staged_status = type;
+    result.push_back(std::move(file));
+  };
+  size_t h = 0;
+  const auto &entries = index.entries();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto &entry = entries[i];
+    if (unchanged[i] || entry.intended_to_add() ||
+        (i > 0 && entries[i - 1].path == entry.path)) {
+      continue;
+    }
+    while (h < head.size() && head[h].path < entry.path) {
+      report(head[h++].path, FileStatusType::Deleted);
+    }
+    bool in_head = h < head.size() && head[h].path == entry.path;
+    if (entry.stage() != 0) {
+      h += in_head ? 1 : 0; // Unmerged; unstaged() lists it
+      continue;
+    }
+    if (!in_head) {
+      report(entry.path, FileStatusType::Added);
+      continue;
+    }
+    const HeadEntry &before = head[h++];
+    if ((before.mode & type_mask) != (entry.mode & type_mask)) {
+      report(entry.path, FileStatusType::TypeChanged);
+    } else if (before.mode != entry.mode || before.oid != entry.oid) {
+      report(entry.path, FileStatusType::Modified);
+    }
+  }
+  while (h < head.size()) {
+    report(head[h++].path, FileStatusType::Deleted);
+  }
+  return result;
+}
+
+IndexStatus::Stats IndexStatus::stats() const {
+  Stats stats;
+  stats.entries = entries_;
+  stats.lstat_calls = lstat_calls_;
+  stats.hashed = hashed_;
+  stats.racy = racy_;
+  stats.cache_hits = cache_hits_;
+  stats.filtered = filtered_;
+  stats.trees_listed = trees_listed_;
+  return stats;
+}
+
+} // namespace slayergit::core
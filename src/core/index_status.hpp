@@ -0,0 +1,106 @@
+#pragma once
+
+#include "core/index_file.hpp"
+#include "core/models/file_status.hpp"
+#include "core/object_database.hpp"
+#include "core/object_hash.hpp"
+#include "infra/cancellation.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace slayergit::core {
+
+// The settings that change what git status reports for an index entry
+struct StatusOptions {
+  HashAlgorithm algorithm = HashAlgorithm::Sha1; // extensions.objectFormat
+  bool filemode = true;     // core.fileMode: the executable bit counts
+  bool symlinks = true;     // core.symlinks
+  bool trust_ctime = true;  // core.trustCtime
+  bool check_stat = true;   // core.checkStat=default; false for "minimal"
+  bool autocrlf = false;    // core.autocrlf is true or input
+  size_t threads = 0;       // 0: one per core
+};
+
+// Reads the above from git's config in one call
+StatusOptions read_status_options(infra::GitProcessExecutor &executor);
+
+// git status from the index, without running git for the common case.
+//
+// unstaged() compares each entry's cached stat data with lstat() on several
+// threads, as git's refresh does, and hashes a file only when the stat data
+// cannot tell: it changed but the size did not, or the entry is racily
+// clean (modified in the second the index was written). Files hashed once
+// are remembered by their stat data, so a touched but unchanged file is not
+// hashed again on every refresh; the index itself is never written.
+//
+// staged() compares the index with HEAD's tree. When the cache tree's root
+// is valid and equals HEAD's tree, nothing is staged and no tree is read.
+// Otherwise HEAD's trees are read through the object database when there
+// is one, skipping every subtree the cache tree shows unchanged, and listed
+// by `git ls-tree` when there is not.
+class IndexStatus {
+public:
+  struct Stats {
+    size_t entries = 0;
+    size_t lstat_calls = 0;
+    size_t hashed = 0;     // Files whose contents were read
+    size_t racy = 0;       // Entries hashed because of their timestamps
+    size_t cache_hits = 0; // Hashes skipped thanks to an earlier one
+    size_t filtered = 0;   // Left to `git hash-object` for attributes/eol
+    size_t trees_listed = 0; // staged() calls that had to read HEAD's trees
+  };
+
+  // `objects` may be null; it must outlive this
+  IndexStatus(infra::GitProcessExecutor &executor, StatusOptions options,
+              const ObjectDatabase *objects = nullptr);
+
+  // Index -> work tree, the second column of `git status --porcelain`,
+  // plus unmerged paths; in index order. Throws CancelledException.
+  std::vector<FileStatus> unstaged(const IndexFile &index,
+                                   const infra::CancellationToken &token);
+  // HEAD -> index, the first column, without rename detection
+  std::vector<FileStatus> staged(const IndexFile &index,
+                                 const infra::CancellationToken &token);
+
+  [[nodiscard]] const StatusOptions &options() const { return options_; }
+  [[nodiscard]] Stats stats() const;
+
+private:
+  struct Check;
+
+  // A file hashed earlier, valid while its stat data is unchanged
+  struct Verified {
+    IndexFile::StatData stat;
+    std::string index_oid;
+    bool clean = false;
+  };
+
+  // Raw id of HEAD's tree; empty on an unborn branch
+  std::string head_tree(const infra::CancellationToken &token);
+  // Files whose hash mismatched but whose contents git may convert
+  std::vector<size_t> confirm_with_git(const IndexFile &index,
+                                       const std::vector<size_t> &entries,
+                                       const infra::CancellationToken &token);
+
+  infra::GitProcessExecutor &executor_;
+  StatusOptions options_;
+  const ObjectDatabase *objects_;
+
+  std::mutex verified_mutex_;
+  std::unordered_map<std::string, Verified> verified_;
+
+  std::atomic<size_t> entries_{0};
+  std::atomic<size_t> lstat_calls_{0};
+  std::atomic<size_t> hashed_{0};
+  std::atomic<size_t> racy_{0};
+  std::atomic<size_t> cache_hits_{0};
+  std::atomic<size_t> filtered_{0};
+  std::atomic<size_t> trees_listed_{0};
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,191 @@
+#include "log_stream.hpp"
+
+#include "infra/exceptions.hpp"
+#include "infra/parsers/log_parser.hpp"
+
+#include <exception>
+
+namespace slayergit::core {
+
+LogStream::LogStream(infra::GitProcessExecutor &executor)
+    : LogStream(executor, Options{}) {}
+
+LogStream::LogStream(infra::GitProcessExecutor &executor, Options options)
+    : executor_(executor), options_(std::move(options)) {}
+
+LogStream::~LogStream() { stop(); }
+
+void LogStream::start(BatchCallback on_batch, DoneCallback on_done) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    restarting_ = true;
+  }
+  stop();
+  on_batch_ = std::move(on_batch);
+  on_done_ = std::move(on_done);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cursor_ = 0;
+    rows_loaded_ = 0;
+    paused_ = false;
+    stopping_ = false;
+    restarting_ = false;
+    finished_ = false;
+    cancel_ = infra::CancellationSource();
+  }
+  thread_ = std::thread([this] { run(); });
+}
+
+void LogStream::set_cursor(size_t row) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cursor_ = row;
+  }
+  cursor_changed_.notify_all();
+}
+
+void LogStream::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    cancel_.cancel();
+  }
+  cursor_changed_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+size_t LogStream::rows_loaded() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return rows_loaded_;
+}
+
+bool LogStream::paused() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return paused_;
+}
+
+bool LogStream::finished() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return finished_;
+}
+
+void LogStream::run() {
+  pending_.clear();
+  pending_.reserve(options_.first_batch_rows);
+  first_batch_sent_ = false;
+  last_publish_ = std::chrono::steady_clock::now();
+
+  auto args = infra::LogParser::log_args();
+  args.insert(args.end(), options_.extra_args.begin(),
+              options_.extra_args.end());
+
+  infra::CancellationToken token;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    token = cancel_.token();
+  }
+  infra::LogParser parser;
+  auto commit_callback = [this](Commit &&commit) {
+    on_commit(std::move(commit));
+  };
+
+  infra::OutputHandlers handlers;
+  std::string errors;
+  handlers.on_stdout = [&](const infra::OutputChunk &chunk) {
+    parser.feed(chunk.view(), commit_callback);
+  };
+  handlers.on_stderr = [&errors](const infra::OutputChunk &chunk) {
+    errors.append(chunk.data(), chunk.size());
+  };
+
+  int exit_code = -1;
+  try {
+    // Throwing Stopped out of a handler unwinds execute_streaming(), whose
+    // ChildProcess kills git on the way out. A silent git (--topo-order
+    // without a commit-graph) is killed through the token instead.
+    exit_code = executor_.execute_streaming(args, handlers, token);
+    parser.finish(commit_callback);
+    publish();
+  } catch (const Stopped &) {
+    exit_code = -1;
+    errors = "stopped";
+  } catch (const CancelledException &) {
+    exit_code = -1;
+    errors = "stopped";
+  } catch (const std::exception &e) {
+    // Also a parse error after git exited 0, which is no success
+    exit_code = -1;
+    errors = e.what();
+  }
+
+  bool superseded = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    paused_ = false;
+    superseded = restarting_;
+  }
+  if (on_done_ && !superseded) {
+    on_done_(exit_code, exit_code == 0 ? std::string() : errors);
+  }
+}
+
+void LogStream::on_commit(Commit &&commit) {
+  pending_.push_back(std::move(commit));
+
+  size_t target =
+      first_batch_sent_ ? options_.batch_rows : options_.first_batch_rows;
+  bool overdue = std::chrono::steady_clock::now() - last_publish_ >=
+                 options_.max_batch_delay;
+  if (pending_.size() >= target || overdue) {
+    publish();
+    wait_for_cursor();
+  }
+}
+
+void LogStream::publish() {
+  if (pending_.empty()) {
+    return;
+  }
+  size_t count = pending_.size();
+  std::vector<Commit> batch;
+  batch.swap(pending_);
+  pending_.reserve(options_.batch_rows);
+  first_batch_sent_ = true;
+  last_publish_ = std::chrono::steady_clock::now();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      throw Stopped{};
+    }
+    rows_loaded_ += count;
+  }
+  if (on_batch_) {
+    on_batch_(std::move(batch));
+  }
+}
+
+void LogStream::wait_for_cursor() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (stopping_) {
+    throw Stopped{};
+  }
+  if (rows_loaded_ < cursor_ + options_.max_rows_ahead) {
+    return;
+  }
+
+  // Far enough ahead; stop draining the pipe until the user scrolls closer
+  paused_ = true;
+  cursor_changed_.wait(lock, [this] {
+    return stopping_ || rows_loaded_ <= cursor_ + options_.resume_within;
+  });
+  paused_ = false;
+  if (stopping_) {
+    throw Stopped{};
+  }
+}
+
+} // namespace slayergit::core
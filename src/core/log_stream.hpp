@@ -0,0 +1,98 @@
+#pragma once
+
+#include "core/models/commit.hpp"
+#include "infra/cancellation.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace slayergit::core {
+
+// Streams `git log` into batches of commits on a background thread.
+//
+// The first batch is published as soon as one screenful of commits has been
+// parsed, so the History window can paint before git has finished. Reading
+// pauses once the parser is `max_rows_ahead` rows past the consumer's cursor
+// (git then blocks on its full pipe) and resumes when the cursor comes within
+// `resume_within` rows of the last loaded commit.
+class LogStream {
+public:
+  struct Options {
+    // Revision range, pathspec, ... appended after the format arguments
+    std::vector<std::string> extra_args;
+    size_t first_batch_rows = 100;
+    size_t batch_rows = 2000;
+    // Partial batches are published at least this often while git is slow
+    std::chrono::milliseconds max_batch_delay{50};
+    size_t max_rows_ahead = 20000;
+    size_t resume_within = 5000;
+  };
+
+  // Called on the background thread
+  using BatchCallback = std::function<void(std::vector<Commit> batch)>;
+  // Called on the background thread once; `error` is empty on success
+  using DoneCallback =
+      std::function<void(int exit_code, const std::string &error)>;
+
+  explicit LogStream(infra::GitProcessExecutor &executor);
+  LogStream(infra::GitProcessExecutor &executor, Options options);
+  ~LogStream();
+
+  LogStream(const LogStream &) = delete;
+  LogStream &operator=(const LogStream &) = delete;
+
+  // Stops a running stream first. That stream's on_done is not called: it
+  // was replaced, not stopped by the caller.
+  void start(BatchCallback on_batch, DoneCallback on_done = nullptr);
+
+  // Row the user is looking at; drives pausing and resuming
+  void set_cursor(size_t row);
+
+  // Stops reading and kills git if it is still running, also before its
+  // first line of output
+  void stop();
+
+  [[nodiscard]] size_t rows_loaded() const;
+  [[nodiscard]] bool paused() const;
+  [[nodiscard]] bool finished() const;
+
+private:
+  struct Stopped {};
+
+  void run();
+  void on_commit(Commit &&commit);
+  void publish();
+  void wait_for_cursor();
+
+  infra::GitProcessExecutor &executor_;
+  Options options_;
+  BatchCallback on_batch_;
+  DoneCallback on_done_;
+
+  // Touched only by the background thread
+  std::vector<Commit> pending_;
+  std::chrono::steady_clock::time_point last_publish_;
+  bool first_batch_sent_ = false;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cursor_changed_;
+  size_t cursor_ = 0;
+  size_t rows_loaded_ = 0;
+  bool paused_ = false;
+  bool stopping_ = false;
+  // Set while start() stops the stream it replaces
+  bool restarting_ = false;
+  // Cancelled by stop(), which kills git even while it prints nothing
+  infra::CancellationSource cancel_;
+  bool finished_ = false;
+  std::thread thread_;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace slayergit::core {
+
+struct Branch {
+  std::string name;          // e.g. "main", without refs/heads/
+  std::string hash;          // Tip commit
+  std::string upstream;      // e.g. "origin/main"; empty if not tracking
+  std::string upstream_hash; // Empty if the upstream ref does not exist
+  bool is_head = false;
+  bool has_counts = false; // ahead/behind below are known
+  uint32_t ahead = 0;
+  uint32_t behind = 0;
+};
+
+} // namespace slayergit::core
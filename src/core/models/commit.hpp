@@ -0,0 +1,20 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace slayergit::core {
+
+struct Commit {
+  std::string hash;
+  std::string short_hash; // First 7 chars
+  std::string author_name;
+  std::string author_email;
+  std::time_t author_date = 0;
+  std::string subject; // First line of message
+  std::string body;    // Rest of message
+  std::vector<std::string> parent_hashes;
+};
+
+} // namespace slayergit::core
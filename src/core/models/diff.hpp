@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace slayergit::core {
+
+struct DiffLine {
+  enum class Type { Context, Addition, Deletion, Header };
+  Type type = Type::Context;
+  std::string content; // Without the +/-/space prefix and the newline
+  int old_line_no = -1;
+  int new_line_no = -1;
+  bool no_newline_at_end = false; // Followed by "\ No newline at end of file"
+};
+
+struct DiffHunk {
+  std::string header; // @@ -10,7 +10,8 @@ function context
+  int old_start = 0;
+  int old_count = 0;
+  int new_start = 0;
+  int new_count = 0;
+  std::vector<DiffLine> lines;
+};
+
+struct FileDiff {
+  std::string old_path;
+  std::string new_path;
+  bool is_new_file = false;
+  bool is_deleted = false;
+  bool is_renamed = false;
+  bool is_binary = false;
+  bool is_too_large = false; // Skipped by the in-process engine's size limit
+  std::vector<DiffHunk> hunks;
+};
+
+struct Diff {
+  std::vector<FileDiff> files;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+
+namespace slayergit::core {
+
+enum class FileStatusType {
+  Unmodified,
+  Untracked,
+  Modified,
+  Added,
+  Deleted,
+  Renamed,
+  Copied,
+  TypeChanged,
+  Unmerged,
+};
+
+struct FileStatus {
+  std::string path;
+  FileStatusType staged_status = FileStatusType::Unmodified;   // HEAD -> index
+  FileStatusType unstaged_status = FileStatusType::Unmodified; // index -> work tree
+  std::string old_path; // Renames and copies only
+};
+
+// The letter `git status --porcelain` shows for `type`
+inline char status_code(FileStatusType type) {
+  switch (type) {
+  case FileStatusType::Unmodified:
+    return ' ';
+  case FileStatusType::Untracked:
+    return '?';
+  case FileStatusType::Modified:
+    return 'M';
+  case FileStatusType::Added:
+    return 'A';
+  case FileStatusType::Deleted:
+    return 'D';
+  case FileStatusType::Renamed:
+    return 'R';
+  case FileStatusType::Copied:
+    return 'C';
+  case FileStatusType::TypeChanged:
+    return 'T';
+  case FileStatusType::Unmerged:
+    return 'U';
+  }
+  return ' ';
+}
+
+} // namespace slayergit::core
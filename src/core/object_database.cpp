@@ -0,0 +1,1253 @@
+#include "object_database.hpp"
+
+#include "core/commit_graph.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_dir.hpp"
+#include "infra/mapped_file.hpp"
+#include "infra/process.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace slayergit::core {
+
+using infra::read_be32;
+using infra::read_be64;
+
+namespace {
+
+constexpr uint32_t idx_signature = 0xff744f63; // "\377tOc"
+constexpr uint32_t pack_signature = 0x5041434b; // "PACK"
+constexpr uint32_t midx_signature = 0x4d494458; // "MIDX"
+constexpr uint32_t chunk_pack_names = 0x504e414d;    // PNAM
+constexpr uint32_t chunk_oid_fanout = 0x4f494446;    // OIDF
+constexpr uint32_t chunk_oid_lookup = 0x4f49444c;    // OIDL
+constexpr uint32_t chunk_object_offsets = 0x4f4f4646; // OOFF
+constexpr uint32_t chunk_large_offsets = 0x4c4f4646;  // LOFF
+
+constexpr int type_ofs_delta = 6;
+constexpr int type_ref_delta = 7;
+// Longer chains than this are taken for a loop in a corrupt pack
+constexpr size_t max_delta_depth = 10000;
+// git's limit for nested alternates
+constexpr int max_alternate_depth = 5;
+// Bytes a window maps past its end, so an entry header starting near the
+// end is always readable from one window
+constexpr size_t window_overlap = 4096;
+// zlib's worst-case expansion; a size past it cannot be real data
+constexpr uint64_t max_inflate_ratio = 1032;
+
+// Position of `oid` in a sorted table found through a 256-entry fanout
+std::optional<uint32_t> fanout_lookup(const uint8_t *fanout,
+                                      const uint8_t *oids, size_t stride,
+                                      size_t hash_size, std::string_view oid) {
+  auto first = static_cast<uint8_t>(oid[0]);
+  uint32_t lo = first == 0 ? 0 : read_be32(fanout + 4 * (first - 1));
+  uint32_t hi = read_be32(fanout + 4 * first);
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    int order = std::memcmp(oids + size_t{mid} * stride, oid.data(), hash_size);
+    if (order == 0) {
+      return mid;
+    }
+    if (order < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<ObjectType> type_from_name(std::string_view name) {
+  if (name == "commit") {
+    return ObjectType::Commit;
+  }
+  if (name == "tree") {
+    return ObjectType::Tree;
+  }
+  if (name == "blob") {
+    return ObjectType::Blob;
+  }
+  if (name == "tag") {
+    return ObjectType::Tag;
+  }
+  return std::nullopt;
+}
+
+// Applies a git delta (pack-format.txt, "Deltified representation")
+std::string apply_delta(std::string_view base, std::string_view delta) {
+  size_t pos = 0;
+  auto varint = [&] {
+    uint64_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+      if (pos >= delta.size() || shift > 56) {
+        throw ParseException("truncated delta header");
+      }
+      byte = static_cast<uint8_t>(delta[pos++]);
+      value |= uint64_t{byte & 0x7fu} << shift;
+      shift += 7;
+    } while ((byte & 0x80) != 0);
+    return value;
+  };
+  uint64_t base_size = varint();
+  uint64_t result_size = varint();
+  if (base_size != base.size()) {
+    throw ParseException("delta base size mismatch");
+  }
+  // Each remaining delta byte yields at most one inserted byte or a copy no
+  // larger than the base
+  uint64_t per_byte = std::max<uint64_t>(base.size(), 1);
+  if (result_size / per_byte > delta.size() - pos) {
+    throw ParseException("delta result size out of range");
+  }
+
+  std::string result(result_size, '\0');
+  size_t out = 0;
+  while (pos < delta.size()) {
+    auto op = static_cast<uint8_t>(delta[pos++]);
+    if ((op & 0x80) != 0) {
+      // Copy from the base: offset and size bytes present per flag bit
+      uint64_t offset = 0;
+      uint64_t size = 0;
+      for (int i = 0; i < 4; ++i) {
+        if ((op & (1u << i)) != 0) {
+          if (pos >= delta.size()) {
+            throw ParseException("truncated delta copy");
+          }
+          offset |= uint64_t{static_cast<uint8_t>(delta[pos++])} << (8 * i);
+        }
+      }
+      for (int i = 0; i < 3; ++i) {
+        if ((op & (0x10u << i)) != 0) {
+          if (pos >= delta.size()) {
+            throw ParseException("truncated delta copy");
+          }
+          size |= uint64_t{static_cast<uint8_t>(delta[pos++])} << (8 * i);
+        }
+      }
+      if (size == 0) {
+        size = 0x10000;
+      }
+      if (offset + size > base.size() || out + size > result.size()) {
+        throw ParseException("delta copy out of bounds");
+      }
+      std::memcpy(&result[out], base.data() + offset, size);
+      out += size;
+    } else if (op != 0) {
+      // Insert the next `op` bytes of the delta
+      if (pos + op > delta.size() || out + op > result.size()) {
+        throw ParseException("delta insert out of bounds");
+      }
+      std::memcpy(&result[out], delta.data() + pos, op);
+      pos += op;
+      out += op;
+    } else {
+      throw ParseException("reserved delta opcode");
+    }
+  }
+  if (out != result.size()) {
+    throw ParseException("delta result size mismatch");
+  }
+  return result;
+}
+
+bool is_directory(const std::string &path) {
+  struct stat st;
+  return ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Changes whenever a pack is added or removed
+struct timespec directory_mtime(const std::string &path) {
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0) {
+    return {};
+  }
+  return st.st_mtim;
+}
+
+std::string canonical(const std::string &path) {
+  char *resolved = ::realpath(path.c_str(), nullptr);
+  if (resolved == nullptr) {
+    return path;
+  }
+  std::string result(resolved);
+  std::free(resolved);
+  return result;
+}
+
+} // namespace
+
+const char *object_type_name(ObjectType type) {
+  switch (type) {
+  case ObjectType::Commit:
+    return "commit";
+  case ObjectType::Tree:
+    return "tree";
+  case ObjectType::Blob:
+    return "blob";
+  case ObjectType::Tag:
+    return "tag";
+  }
+  return "unknown";
+}
+
+std::vector<TreeEntry> parse_tree(std::string_view data, size_t hash_size) {
+  // "<octal mode> <name>\0<raw oid>", repeated
+  std::vector<TreeEntry> entries;
+  size_t pos = 0;
+  while (pos < data.size()) {
+    size_t space = data.find(' ', pos);
+    size_t nul = data.find('\0', space == std::string_view::npos ? pos : space);
+    if (space == std::string_view::npos || nul == std::string_view::npos ||
+        nul + 1 + hash_size > data.size() || space == pos) {
+      throw ParseException("malformed tree entry");
+    }
+    TreeEntry entry;
+    for (size_t i = pos; i < space; ++i) {
+      if (data[i] < '0' || data[i] > '7') {
+        throw ParseException("malformed tree entry mode");
+      }
+      entry.mode = entry.mode * 8 + static_cast<uint32_t>(data[i] - '0');
+    }
+    entry.name = data.substr(space + 1, nul - space - 1);
+    entry.oid = data.substr(nul + 1, hash_size);
+    entries.push_back(entry);
+    pos = nul + 1 + hash_size;
+  }
+  return entries;
+}
+
+// A location in a pack: where an object's entry starts
+struct ObjectDatabase::Location {
+  std::shared_ptr<Pack> pack;
+  uint64_t offset = 0;
+};
+
+// One .pack file, read through mmap windows of Options::window_bytes. Its
+// .idx is mapped whole when the pack is not covered by a multi-pack-index.
+class ObjectDatabase::Pack {
+public:
+  // A mapped range of the pack; unmapped when the last user lets go
+  struct Window {
+    const ObjectDatabase *odb = nullptr;
+    const uint8_t *base = nullptr;
+    uint64_t start = 0;
+    size_t length = 0;
+    std::atomic<uint64_t> last_used{0};
+
+    ~Window() {
+      ::munmap(const_cast<uint8_t *>(base), length);
+      odb->mapped_bytes_ -= length;
+      ++odb->windows_unmapped_;
+    }
+  };
+
+  // Bytes from some offset to the end of the window holding it; `window`
+  // keeps them mapped
+  struct Span {
+    std::shared_ptr<Window> window;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+  };
+
+  Pack(const ObjectDatabase &odb, std::string pack_path, bool with_index)
+      : odb_(odb), path_(std::move(pack_path)) {
+    static std::atomic<uint64_t> next_id{1};
+    id_ = next_id++;
+    fd_.reset(::open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st;
+    if (!fd_.valid() || ::fstat(fd_.get(), &st) != 0) {
+      throw SlayerGitException("cannot open " + path_ + ": " +
+                               std::strerror(errno));
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+    uint8_t header[12];
+    if (::pread(fd_.get(), header, sizeof(header), 0) !=
+            static_cast<ssize_t>(sizeof(header)) ||
+        read_be32(header) != pack_signature) {
+      fail("bad signature");
+    }
+    uint32_t version = read_be32(header + 4);
+    if (version != 2 && version != 3) {
+      fail("unsupported version " + std::to_string(version));
+    }
+    count_ = read_be32(header + 8);
+    if (with_index) {
+      load_index(path_.substr(0, path_.size() - 5) + ".idx");
+    }
+  }
+
+  [[nodiscard]] uint64_t id() const { return id_; }
+  [[nodiscard]] const std::string &path() const { return path_; }
+  [[nodiscard]] uint64_t size() const { return size_; }
+
+  // Offset of `oid` through this pack's own .idx
+  [[nodiscard]] std::optional<uint64_t> find(std::string_view oid) const {
+    size_t hash_size = odb_.hash_size();
+    const uint8_t *fanout = index_.data() + (index_version_ == 2 ? 8 : 0);
+    if (index_version_ == 1) {
+      auto pos = fanout_lookup(fanout, fanout + 1024 + 4, 4 + hash_size,
+                               hash_size, oid);
+      if (!pos) {
+        return std::nullopt;
+      }
+      return read_be32(fanout + 1024 + *pos * (4 + hash_size));
+    }
+    const uint8_t *oids = fanout + 1024;
+    auto pos = fanout_lookup(fanout, oids, hash_size, hash_size, oid);
+    if (!pos) {
+      return std::nullopt;
+    }
+    const uint8_t *offsets = oids + size_t{count_} * (hash_size + 4);
+    uint32_t offset = read_be32(offsets + 4 * size_t{*pos});
+    if ((offset & 0x80000000u) == 0) {
+      return offset;
+    }
+    const uint8_t *large = offsets + 4 * size_t{count_};
+    size_t slot = offset & 0x7fffffffu;
+    if (large + 8 * (slot + 1) > index_.data() + index_.size()) {
+      fail("large offset out of range");
+    }
+    return read_be64(large + 8 * slot);
+  }
+
+  Span at(uint64_t offset) const {
+    // The trailing checksum is not part of any object
+    if (offset >= size_ - std::min<uint64_t>(size_, odb_.hash_size())) {
+      fail("offset " + std::to_string(offset) + " beyond the last object");
+    }
+    uint64_t window_bytes = odb_.options_.window_bytes;
+    uint64_t start = offset - offset % window_bytes;
+    std::shared_ptr<Window> window = find_window(start);
+    if (!window) {
+      window = map_window(start);
+    }
+    auto skip = static_cast<size_t>(offset - start);
+    Span span;
+    span.data = window->base + skip;
+    span.size = window->length - skip;
+    span.window = std::move(window);
+    return span;
+  }
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw ParseException("pack " + path_ + ": " + what);
+  }
+
+private:
+  void load_index(const std::string &idx_path) {
+    index_ = infra::MappedFile(idx_path);
+    size_t hash_size = odb_.hash_size();
+    const uint8_t *data = index_.data();
+    size_t size = index_.size();
+    auto bad = [&](const std::string &what) {
+      throw ParseException("pack index " + idx_path + ": " + what);
+    };
+    const uint8_t *fanout = data;
+    if (size >= 8 && read_be32(data) == idx_signature) {
+      if (read_be32(data + 4) != 2) {
+        bad("unsupported version " + std::to_string(read_be32(data + 4)));
+      }
+      index_version_ = 2;
+      fanout = data + 8;
+    } else {
+      index_version_ = 1;
+    }
+    if (fanout + 1024 > data + size) {
+      bad("truncated fanout");
+    }
+    uint32_t count = read_be32(fanout + 1020);
+    size_t entries = index_version_ == 2 ? count * (hash_size + 8)
+                                         : count * (hash_size + 4);
+    // Two trailing checksums
+    if (static_cast<size_t>(fanout - data) + 1024 + entries + 2 * hash_size >
+        size) {
+      bad("truncated");
+    }
+    if (count != count_) {
+      bad("has " + std::to_string(count) + " objects, its pack " +
+          std::to_string(count_));
+    }
+  }
+
+  std::shared_ptr<Window> find_window(uint64_t start) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &window : windows_) {
+      if (window->start == start) {
+        window->last_used = ++clock_;
+        return window;
+      }
+    }
+    return nullptr;
+  }
+
+  std::shared_ptr<Window> map_window(uint64_t start) const {
+    auto length = static_cast<size_t>(std::min<uint64_t>(
+        odb_.options_.window_bytes + window_overlap, size_ - start));
+    void *mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd_.get(),
+                           static_cast<off_t>(start));
+    if (mapping == MAP_FAILED) {
+      throw SlayerGitException("cannot map " + path_ + ": " +
+                               std::strerror(errno));
+    }
+    auto window = std::make_shared<Window>();
+    window->odb = &odb_;
+    window->base = static_cast<const uint8_t *>(mapping);
+    window->start = start;
+    window->length = length;
+    odb_.mapped_bytes_ += length;
+    ++odb_.windows_mapped_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Another thread may have mapped the same range meanwhile
+    for (const auto &other : windows_) {
+      if (other->start == start) {
+        other->last_used = ++clock_;
+        return other;
+      }
+    }
+    window->last_used = ++clock_;
+    windows_.push_back(window);
+    // Over the limit, this pack gives up its least recently used windows;
+    // readers still holding one keep it mapped until they finish
+    while (odb_.mapped_bytes_ > odb_.options_.mapped_bytes_limit &&
+           windows_.size() > 1) {
+      auto oldest = std::min_element(
+          windows_.begin(), windows_.end() - 1,
+          [](const auto &a, const auto &b) {
+            return a->last_used < b->last_used;
+          });
+      windows_.erase(oldest);
+    }
+    return window;
+  }
+
+  const ObjectDatabase &odb_;
+  std::string path_;
+  uint64_t id_ = 0;
+  infra::UniqueFd fd_;
+  uint64_t size_ = 0;
+  uint32_t count_ = 0;
+  infra::MappedFile index_;
+  int index_version_ = 0;
+
+  mutable std::mutex mutex_;
+  mutable std::vector<std::shared_ptr<Window>> windows_;
+  mutable uint64_t clock_ = 0;
+};
+
+// objects/pack/multi-pack-index: one sorted object table for many packs,
+// so a lookup is one binary search instead of one per pack
+class ObjectDatabase::MultiPackIndex {
+public:
+  MultiPackIndex(const ObjectDatabase &odb, const std::string &pack_dir)
+      : file_(pack_dir + "/multi-pack-index") {
+    const uint8_t *data = file_.data();
+    size_t size = file_.size();
+    size_t hash_size = odb.hash_size();
+    if (size < 12 || read_be32(data) != midx_signature) {
+      fail("bad signature");
+    }
+    if (data[4] != 1) {
+      fail("unsupported version " + std::to_string(data[4]));
+    }
+    size_t midx_hash = data[5] == 1 ? 20 : data[5] == 2 ? 32 : 0;
+    if (midx_hash != hash_size) {
+      fail("hash version does not match the repository");
+    }
+    size_t chunk_count = data[6];
+    if (data[7] != 0) {
+      fail("incremental multi-pack-index chains are not supported");
+    }
+    uint32_t pack_count = read_be32(data + 8);
+    if (12 + (chunk_count + 1) * 12 > size) {
+      fail("truncated chunk table");
+    }
+
+    const uint8_t *names = nullptr;
+    const uint8_t *names_end = nullptr;
+    for (size_t i = 0; i < chunk_count; ++i) {
+      const uint8_t *entry = data + 12 + i * 12;
+      uint32_t id = read_be32(entry);
+      uint64_t begin = read_be64(entry + 4);
+      uint64_t end = read_be64(entry + 16);
+      if (begin > end || end > size) {
+        fail("chunk out of range");
+      }
+      const uint8_t *chunk = data + begin;
+      size_t length = end - begin;
+      if (id == chunk_pack_names) {
+        names = chunk;
+        names_end = chunk + length;
+      } else if (id == chunk_oid_fanout && length == 1024) {
+        fanout_ = chunk;
+      } else if (id == chunk_oid_lookup) {
+        oids_ = chunk;
+        oids_size_ = length;
+      } else if (id == chunk_object_offsets) {
+        offsets_ = chunk;
+        offsets_size_ = length;
+      } else if (id == chunk_large_offsets) {
+        large_offsets_ = chunk;
+        large_offsets_count_ = length / 8;
+      }
+    }
+    if (names == nullptr || fanout_ == nullptr || oids_ == nullptr ||
+        offsets_ == nullptr) {
+      fail("missing a required chunk");
+    }
+    count_ = read_be32(fanout_ + 1020);
+    if (oids_size_ < size_t{count_} * hash_size ||
+        offsets_size_ < size_t{count_} * 8) {
+      fail("object table shorter than its fanout");
+    }
+    hash_size_ = hash_size;
+
+    // Names are "pack-<hash>.idx", NUL-terminated and possibly padded
+    const uint8_t *p = names;
+    while (pack_names_.size() < pack_count && p < names_end) {
+      const uint8_t *nul = static_cast<const uint8_t *>(
+          std::memchr(p, 0, static_cast<size_t>(names_end - p)));
+      if (nul == nullptr) {
+        fail("unterminated pack name");
+      }
+      if (nul != p) {
+        pack_names_.emplace_back(reinterpret_cast<const char *>(p),
+                                 static_cast<size_t>(nul - p));
+      }
+      p = nul + 1;
+    }
+    if (pack_names_.size() != pack_count) {
+      fail("lists " + std::to_string(pack_names_.size()) + " of " +
+           std::to_string(pack_count) + " packs");
+    }
+  }
+
+  [[nodiscard]] const std::vector<std::string> &pack_names() const {
+    return pack_names_;
+  }
+
+  // Pack number and offset of `oid`
+  [[nodiscard]] std::optional<std::pair<uint32_t, uint64_t>>
+  find(std::string_view oid) const {
+    auto pos = fanout_lookup(fanout_, oids_, hash_size_, hash_size_, oid);
+    if (!pos) {
+      return std::nullopt;
+    }
+    const uint8_t *entry = offsets_ + 8 * size_t{*pos};
+    uint32_t pack = read_be32(entry);
+    uint32_t offset = read_be32(entry + 4);
+    if (pack >= pack_names_.size()) {
+      fail("object in pack " + std::to_string(pack) + " of " +
+           std::to_string(pack_names_.size()));
+    }
+    if ((offset & 0x80000000u) == 0) {
+      return std::make_pair(pack, uint64_t{offset});
+    }
+    size_t slot = offset & 0x7fffffffu;
+    if (slot >= large_offsets_count_) {
+      fail("large offset out of range");
+    }
+    return std::make_pair(pack, read_be64(large_offsets_ + 8 * slot));
+  }
+
+private:
+  [[noreturn]] void fail(const std::string &what) const {
+    throw ParseException("multi-pack-index " + file_.path() + ": " + what);
+  }
+
+  infra::MappedFile file_;
+  size_t hash_size_ = 20;
+  uint32_t count_ = 0;
+  const uint8_t *fanout_ = nullptr;
+  const uint8_t *oids_ = nullptr;
+  size_t oids_size_ = 0;
+  const uint8_t *offsets_ = nullptr;
+  size_t offsets_size_ = 0;
+  const uint8_t *large_offsets_ = nullptr;
+  size_t large_offsets_count_ = 0;
+  std::vector<std::string> pack_names_;
+};
+
+// Recently inflated delta bases by pack and offset, least recently used
+// dropped first once their total size passes the limit
+class ObjectDatabase::BaseCache {
+public:
+  explicit BaseCache(size_t limit) : limit_(limit) {}
+
+  std::shared_ptr<const Object> get(uint64_t pack, uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = map_.find(Key{pack, offset});
+    if (it == map_.end()) {
+      ++misses_;
+      return nullptr;
+    }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->object;
+  }
+
+  void put(uint64_t pack, uint64_t offset,
+           std::shared_ptr<const Object> object) {
+    size_t size = object->data.size();
+    if (size > limit_) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Key key{pack, offset};
+    if (map_.count(key) != 0) {
+      return;
+    }
+    lru_.push_front(Item{key, std::move(object)});
+    map_.emplace(key, lru_.begin());
+    bytes_ += size;
+    while (bytes_ > limit_) {
+      const Item &oldest = lru_.back();
+      bytes_ -= oldest.object->data.size();
+      map_.erase(oldest.key);
+      lru_.pop_back();
+    }
+  }
+
+  [[nodiscard]] size_t hits() const { return hits_; }
+  [[nodiscard]] size_t misses() const { return misses_; }
+
+private:
+  struct Key {
+    uint64_t pack;
+    uint64_t offset;
+    bool operator==(const Key &other) const {
+      return pack == other.pack && offset == other.offset;
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return std::hash<uint64_t>()(key.offset * 0x9e3779b97f4a7c15ULL ^
+                                   key.pack);
+    }
+  };
+  struct Item {
+    Key key;
+    std::shared_ptr<const Object> object;
+  };
+
+  size_t limit_;
+  std::mutex mutex_;
+  std::list<Item> lru_;
+  std::unordered_map<Key, std::list<Item>::iterator, KeyHash> map_;
+  size_t bytes_ = 0;
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+};
+
+// One objects directory: the repository's or an alternate
+struct ObjectDatabase::Source {
+  struct Packs {
+    std::unique_ptr<MultiPackIndex> midx;
+    std::vector<std::shared_ptr<Pack>> midx_packs; // By pack number
+    std::vector<std::shared_ptr<Pack>> packs;      // The others, newest first
+  };
+
+  std::string objects_dir;
+  std::mutex mutex;
+  std::shared_ptr<const Packs> packs; // Replaced whole by scan()
+  struct timespec pack_dir_mtime {};
+
+  std::shared_ptr<const Packs> snapshot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return packs;
+  }
+};
+
+namespace {
+
+// A pack entry's header: the type, inflated size and, for deltas, where
+// the base is
+struct EntryHeader {
+  int type = 0;
+  uint64_t size = 0;
+  size_t length = 0;         // Bytes before the compressed data
+  uint64_t base_offset = 0;  // OFS_DELTA
+  std::string_view base_oid; // REF_DELTA, raw
+};
+
+EntryHeader parse_entry_header(const uint8_t *data, size_t available,
+                               uint64_t offset, size_t hash_size) {
+  EntryHeader header;
+  size_t pos = 0;
+  auto next = [&] {
+    if (pos >= available) {
+      throw ParseException("truncated pack entry header");
+    }
+    return data[pos++];
+  };
+  uint8_t byte = next();
+  header.type = (byte >> 4) & 7;
+  header.size = byte & 15u;
+  int shift = 4;
+  while ((byte & 0x80) != 0) {
+    byte = next();
+    if (shift > 57) {
+      throw ParseException("pack entry size overflows");
+    }
+    header.size |= uint64_t{byte & 0x7fu} << shift;
+    shift += 7;
+  }
+  if (header.type == type_ofs_delta) {
+    // Big-endian base-128 with an implied +1 per continuation byte
+    byte = next();
+    uint64_t distance = byte & 0x7fu;
+    while ((byte & 0x80) != 0) {
+      byte = next();
+      distance = ((distance + 1) << 7) | (byte & 0x7fu);
+    }
+    if (distance == 0 || distance > offset) {
+      throw ParseException("delta base offset out of range");
+    }
+    header.base_offset = offset - distance;
+  } else if (header.type == type_ref_delta) {
+    if (pos + hash_size > available) {
+      throw ParseException("truncated delta base id");
+    }
+    header.base_oid = std::string_view(
+        reinterpret_cast<const char *>(data + pos), hash_size);
+    pos += hash_size;
+  } else if (header.type < 1 || header.type > 4) {
+    throw ParseException("unknown pack entry type " +
+                         std::to_string(header.type));
+  }
+  header.length = pos;
+  return header;
+}
+
+// zlib stream state freed on every exit
+struct Inflater {
+  z_stream stream{};
+
+  Inflater() {
+    if (inflateInit(&stream) != Z_OK) {
+      throw SlayerGitException("cannot initialise zlib");
+    }
+  }
+  ~Inflater() { inflateEnd(&stream); }
+  Inflater(const Inflater &) = delete;
+  Inflater &operator=(const Inflater &) = delete;
+};
+
+} // namespace
+
+ObjectDatabase::ObjectDatabase(HashAlgorithm algorithm, Options options)
+    : algorithm_(algorithm), options_(options),
+      base_cache_(std::make_unique<BaseCache>(options.delta_base_cache_bytes)) {
+  // Windows start on multiples of their size, which mmap needs page-aligned
+  auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  options_.window_bytes =
+      std::max(page, (options_.window_bytes + page - 1) / page * page);
+}
+
+ObjectDatabase::~ObjectDatabase() = default;
+
+std::unique_ptr<ObjectDatabase>
+ObjectDatabase::open(const std::string &objects_dir, HashAlgorithm algorithm) {
+  return open(objects_dir, algorithm, Options());
+}
+
+std::unique_ptr<ObjectDatabase>
+ObjectDatabase::open(const std::string &objects_dir, HashAlgorithm algorithm,
+                     Options options) {
+  if (!is_directory(objects_dir)) {
+    throw SlayerGitException("no objects directory at " + objects_dir);
+  }
+  std::unique_ptr<ObjectDatabase> odb(new ObjectDatabase(algorithm, options));
+  odb->add_source(objects_dir, 0);
+  for (auto &source : odb->sources_) {
+    odb->scan(*source);
+  }
+  return odb;
+}
+
+std::unique_ptr<ObjectDatabase>
+ObjectDatabase::open_repository(const std::string &repo_path,
+                                HashAlgorithm algorithm) {
+  return open(infra::resolve_git_dirs(repo_path).objects_dir, algorithm);
+}
+
+void ObjectDatabase::add_source(const std::string &objects_dir, int depth) {
+  std::string path = canonical(objects_dir);
+  for (const auto &source : sources_) {
+    if (source->objects_dir == path) {
+      return;
+    }
+  }
+  auto source = std::make_unique<Source>();
+  source->objects_dir = path;
+  sources_.push_back(std::move(source));
+
+  // One directory per line, relative ones from this objects directory
+  std::ifstream alternates(path + "/info/alternates");
+  std::string line;
+  while (std::getline(alternates, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    if (line.size() >= 2 && line.front() == '"' && line.back() == '"') {
+      line = line.substr(1, line.size() - 2);
+    }
+    std::string alternate = line[0] == '/' ? line : path + "/" + line;
+    if (depth + 1 <= max_alternate_depth && is_directory(alternate)) {
+      add_source(alternate, depth + 1);
+    }
+  }
+}
+
+bool ObjectDatabase::scan(Source &source) const {
+  std::string pack_dir = source.objects_dir + "/pack";
+  struct timespec mtime = directory_mtime(pack_dir);
+  std::shared_ptr<const Source::Packs> old;
+  {
+    std::lock_guard<std::mutex> lock(source.mutex);
+    if (source.packs && mtime.tv_sec == source.pack_dir_mtime.tv_sec &&
+        mtime.tv_nsec == source.pack_dir_mtime.tv_nsec) {
+      return false;
+    }
+    old = source.packs;
+  }
+
+  // Packs already open are kept, so their windows and cached bases stay
+  std::unordered_map<std::string, std::shared_ptr<Pack>> existing;
+  if (old) {
+    for (const auto &pack : old->packs) {
+      existing.emplace(pack->path(), pack);
+    }
+    for (const auto &pack : old->midx_packs) {
+      existing.emplace(pack->path(), pack);
+    }
+  }
+  auto reuse = [&](const std::string &pack_path, bool with_index) {
+    auto it = existing.find(pack_path);
+    return it != existing.end()
+               ? it->second
+               : std::make_shared<Pack>(*this, pack_path, with_index);
+  };
+
+  auto packs = std::make_shared<Source::Packs>();
+  std::unordered_set<std::string> covered;
+  if (::access((pack_dir + "/multi-pack-index").c_str(), F_OK) == 0) {
+    packs->midx = std::make_unique<MultiPackIndex>(*this, pack_dir);
+    for (const auto &name : packs->midx->pack_names()) {
+      std::string base = name.substr(0, name.rfind('.'));
+      covered.insert(base);
+      packs->midx_packs.push_back(reuse(pack_dir + "/" + base + ".pack", false));
+    }
+  }
+
+  std::vector<std::pair<struct timespec, std::string>> found;
+  if (DIR *dir = ::opendir(pack_dir.c_str())) {
+    while (struct dirent *entry = ::readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".idx") != 0) {
+        continue;
+      }
+      std::string base = name.substr(0, name.size() - 4);
+      std::string pack_path = pack_dir + "/" + base + ".pack";
+      struct stat st;
+      if (covered.count(base) != 0 || ::stat(pack_path.c_str(), &st) != 0) {
+        continue;
+      }
+      found.emplace_back(st.st_mtim, pack_path);
+    }
+    ::closedir(dir);
+  }
+  // Newest first, as git searches them: recent objects are asked for most
+  std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) {
+    if (a.first.tv_sec != b.first.tv_sec) {
+      return a.first.tv_sec > b.first.tv_sec;
+    }
+    return a.first.tv_nsec > b.first.tv_nsec;
+  });
+  for (const auto &[time, pack_path] : found) {
+    packs->packs.push_back(reuse(pack_path, true));
+  }
+
+  std::lock_guard<std::mutex> lock(source.mutex);
+  source.packs = std::move(packs);
+  source.pack_dir_mtime = mtime;
+  return true;
+}
+
+bool ObjectDatabase::rescan() const {
+  ++rescans_;
+  bool changed = false;
+  for (const auto &source : sources_) {
+    changed = scan(*source) || changed;
+  }
+  return changed;
+}
+
+std::optional<ObjectDatabase::Location>
+ObjectDatabase::find_packed(std::string_view oid) const {
+  if (oid.size() != hash_size()) {
+    return std::nullopt;
+  }
+  for (const auto &source : sources_) {
+    auto packs = source->snapshot();
+    if (!packs) {
+      continue;
+    }
+    if (packs->midx) {
+      if (auto found = packs->midx->find(oid)) {
+        return Location{packs->midx_packs[found->first], found->second};
+      }
+    }
+    for (const auto &pack : packs->packs) {
+      if (auto offset = pack->find(oid)) {
+        return Location{pack, *offset};
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<Object> ObjectDatabase::read_loose(std::string_view oid) const {
+  if (oid.size() != hash_size()) {
+    return std::nullopt;
+  }
+  std::string hex = CommitGraph::to_hex(oid);
+  for (const auto &source : sources_) {
+    std::string path =
+        source->objects_dir + "/" + hex.substr(0, 2) + "/" + hex.substr(2);
+    infra::UniqueFd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!fd.valid()) {
+      continue;
+    }
+    std::string compressed;
+    char chunk[64 * 1024];
+    while (true) {
+      ssize_t got = ::read(fd.get(), chunk, sizeof(chunk));
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      if (got < 0) {
+        throw SlayerGitException("cannot read " + path + ": " +
+                                 std::strerror(errno));
+      }
+      if (got == 0) {
+        break;
+      }
+      compressed.append(chunk, static_cast<size_t>(got));
+    }
+    ++loose_reads_;
+    auto fail = [&path](const std::string &what) -> Object {
+      throw ParseException("loose object " + path + ": " + what);
+    };
+
+    // "<type> <size>\0" comes first; inflate that much to size the rest
+    Inflater inflater;
+    z_stream &z = inflater.stream;
+    z.next_in = reinterpret_cast<Bytef *>(compressed.data());
+    z.avail_in = static_cast<uInt>(compressed.size());
+    char head[64];
+    z.next_out = reinterpret_cast<Bytef *>(head);
+    z.avail_out = sizeof(head);
+    int status = inflate(&z, Z_NO_FLUSH);
+    if (status != Z_OK && status != Z_STREAM_END) {
+      return fail("inflate failed");
+    }
+    size_t produced = sizeof(head) - z.avail_out;
+    const char *nul =
+        static_cast<const char *>(std::memchr(head, '\0', produced));
+    const char *space =
+        static_cast<const char *>(std::memchr(head, ' ', produced));
+    if (nul == nullptr || space == nullptr || space > nul) {
+      return fail("bad header");
+    }
+    auto type = type_from_name(std::string_view(head, space - head));
+    if (!type) {
+      return fail("unknown type");
+    }
+    uint64_t size = 0;
+    for (const char *p = space + 1; p < nul; ++p) {
+      if (*p < '0' || *p > '9') {
+        return fail("bad size");
+      }
+      size = size * 10 + static_cast<uint64_t>(*p - '0');
+    }
+
+    if (size / max_inflate_ratio > compressed.size()) {
+      return fail("size out of range");
+    }
+
+    Object object;
+    object.type = *type;
+    object.data.resize(size);
+    size_t have = std::min<size_t>(size, produced - (nul + 1 - head));
+    std::memcpy(object.data.data(), nul + 1, have);
+    if (produced - (nul + 1 - head) > size) {
+      return fail("longer than its header says");
+    }
+    while (status != Z_STREAM_END) {
+      // Once full, a spare byte lets an overlong object show itself
+      char spare;
+      bool full = have == size;
+      z.next_out = full ? reinterpret_cast<Bytef *>(&spare)
+                        : reinterpret_cast<Bytef *>(object.data.data() + have);
+      z.avail_out =
+          full ? 1 : static_cast<uInt>(std::min<size_t>(size - have, UINT_MAX));
+      uInt before_in = z.avail_in;
+      uInt before_out = z.avail_out;
+      status = inflate(&z, Z_NO_FLUSH);
+      if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+        return fail("inflate failed");
+      }
+      size_t got = before_out - z.avail_out;
+      if (full && got > 0) {
+        return fail("longer than its header says");
+      }
+      have += got;
+      if (status != Z_STREAM_END && got == 0 && before_in == z.avail_in) {
+        return fail("truncated");
+      }
+    }
+    if (have != size) {
+      return fail("shorter than its header says");
+    }
+    return object;
+  }
+  return std::nullopt;
+}
+
+namespace {
+
+// Inflates the compressed data starting at `offset` into exactly `size`
+// bytes, crossing windows as needed
+template <typename Pack>
+std::string inflate_entry(const Pack &pack, uint64_t offset, uint64_t size) {
+  if (offset >= pack.size() ||
+      size / max_inflate_ratio > pack.size() - offset) {
+    pack.fail("entry at " + std::to_string(offset) + " claims " +
+              std::to_string(size) + " bytes");
+  }
+  std::string result(size, '\0');
+  Inflater inflater;
+  z_stream &z = inflater.stream;
+  uint64_t written = 0;
+  int status = Z_OK;
+  while (status != Z_STREAM_END) {
+    auto span = pack.at(offset);
+    z.next_in = const_cast<Bytef *>(span.data);
+    z.avail_in = static_cast<uInt>(std::min<size_t>(span.size, UINT_MAX));
+    // Once full, a spare byte lets an overlong entry show itself
+    char spare;
+    bool full = written == size;
+    z.next_out = full ? reinterpret_cast<Bytef *>(&spare)
+                      : reinterpret_cast<Bytef *>(result.data() + written);
+    z.avail_out =
+        full ? 1 : static_cast<uInt>(std::min<uint64_t>(size - written, UINT_MAX));
+    uInt before_in = z.avail_in;
+    uInt before_out = z.avail_out;
+    status = inflate(&z, Z_NO_FLUSH);
+    if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+      pack.fail("inflate failed at " + std::to_string(offset));
+    }
+    size_t got = before_out - z.avail_out;
+    if (full && got > 0) {
+      pack.fail("entry at " + std::to_string(offset) + " is too long");
+    }
+    written += got;
+    offset += before_in - z.avail_in;
+    if (status != Z_STREAM_END && got == 0 && before_in == z.avail_in) {
+      pack.fail("entry truncated at " + std::to_string(offset));
+    }
+  }
+  if (written != size) {
+    pack.fail("entry size mismatch at " + std::to_string(offset));
+  }
+  return result;
+}
+
+} // namespace
+
+Object ObjectDatabase::read_packed(const Location &location) const {
+  ++packed_reads_;
+  // Follow the chain down to something whole: a plain entry, a cached
+  // base, or a REF_DELTA base stored loose
+  struct Step {
+    Location location;
+    EntryHeader header;
+  };
+  std::vector<Step> chain;
+  std::shared_ptr<const Object> base;
+  Location current = location;
+  while (true) {
+    if (chain.size() > max_delta_depth) {
+      current.pack->fail("delta chain too long");
+    }
+    if (!chain.empty()) {
+      base = base_cache_->get(current.pack->id(), current.offset);
+      if (base) {
+        break;
+      }
+    }
+    auto span = current.pack->at(current.offset);
+    EntryHeader header =
+        parse_entry_header(span.data, span.size, current.offset, hash_size());
+    if (header.type >= 1 && header.type <= 4) {
+      auto object = std::make_shared<Object>();
+      object->type = static_cast<ObjectType>(header.type);
+      object->data = inflate_entry(*current.pack,
+                                   current.offset + header.length, header.size);
+      if (!chain.empty()) {
+        base_cache_->put(current.pack->id(), current.offset, object);
+      }
+      base = std::move(object);
+      break;
+    }
+    std::string base_oid(header.base_oid);
+    chain.push_back(Step{current, header});
+    if (header.type == type_ofs_delta) {
+      current.offset = header.base_offset;
+      continue;
+    }
+    if (auto found = find_packed(base_oid)) {
+      current = *found;
+      continue;
+    }
+    auto loose = read_loose(base_oid);
+    if (!loose) {
+      current.pack->fail("delta base " + CommitGraph::to_hex(base_oid) +
+                         " is missing");
+    }
+    base = std::make_shared<const Object>(std::move(*loose));
+    break;
+  }
+
+  if (chain.empty()) {
+    return std::move(*std::const_pointer_cast<Object>(base));
+  }
+  // Apply the deltas outwards; every intermediate result is some other
+  // delta's base, so it is worth caching
+  for (size_t i = chain.size(); i-- > 0;) {
+    const Step &step = chain[i];
+    std::string delta =
+        inflate_entry(*step.location.pack,
+                      step.location.offset + step.header.length,
+                      step.header.size);
+    auto object = std::make_shared<Object>();
+    object->type = base->type;
+    object->data = apply_delta(base->data, delta);
+    ++deltas_applied_;
+    if (i == 0) {
+      return std::move(*object);
+    }
+    base_cache_->put(step.location.pack->id(), step.location.offset, object);
+    base = std::move(object);
+  }
+  return {};
+}
+
+std::optional<Object> ObjectDatabase::read_once(std::string_view oid) const {
+  if (auto location = find_packed(oid)) {
+    return read_packed(*location);
+  }
+  return read_loose(oid);
+}
+
+std::optional<Object> ObjectDatabase::read(std::string_view oid) const {
+  if (auto object = read_once(oid)) {
+    return object;
+  }
+  // Possibly packed since the last scan, e.g. by a gc
+  if (rescan()) {
+    return read_once(oid);
+  }
+  return std::nullopt;
+}
+
+bool ObjectDatabase::contains(std::string_view oid) const {
+  auto present = [&] {
+    if (find_packed(oid)) {
+      return true;
+    }
+    std::string hex = CommitGraph::to_hex(oid);
+    for (const auto &source : sources_) {
+      std::string path =
+          source->objects_dir + "/" + hex.substr(0, 2) + "/" + hex.substr(2);
+      if (::access(path.c_str(), F_OK) == 0) {
+        return true;
+      }
+    }
+    return false;
+  };
+  if (oid.size() != hash_size()) {
+    return false;
+  }
+  return present() || (rescan() && present());
+}
+
+std::optional<std::string>
+ObjectDatabase::peel_to_tree(std::string_view oid) const {
+  std::string current(oid);
+  // Tags of tags are allowed, but not endlessly
+  for (int depth = 0; depth < 16; ++depth) {
+    auto object = read(current);
+    if (!object) {
+      return std::nullopt;
+    }
+    std::string_view data = object->data;
+    std::string_view field;
+    switch (object->type) {
+    case ObjectType::Tree:
+      return current;
+    case ObjectType::Blob:
+      return std::nullopt;
+    case ObjectType::Commit:
+      field = "tree ";
+      break;
+    case ObjectType::Tag:
+      field = "object ";
+      break;
+    }
+    size_t hex_size = 2 * hash_size();
+    if (data.substr(0, field.size()) != field ||
+        data.size() < field.size() + hex_size) {
+      throw ParseException(std::string(object_type_name(object->type)) + " " +
+                           CommitGraph::to_hex(current) +
+                           " does not start with its " +
+                           std::string(field.substr(0, field.size() - 1)));
+    }
+    current = CommitGraph::from_hex(data.substr(field.size(), hex_size));
+  }
+  return std::nullopt;
+}
+
+ObjectDatabase::Stats ObjectDatabase::stats() const {
+  Stats stats;
+  stats.loose_reads = loose_reads_;
+  stats.packed_reads = packed_reads_;
+  stats.deltas_applied = deltas_applied_;
+  stats.base_cache_hits = base_cache_->hits();
+  stats.base_cache_misses = base_cache_->misses();
+  stats.windows_mapped = windows_mapped_;
+  stats.windows_unmapped = windows_unmapped_;
+  stats.rescans = rescans_;
+  return stats;
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "core/object_hash.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::core {
+
+// Numbered as in a pack entry's header
+enum class ObjectType { Commit = 1, Tree = 2, Blob = 3, Tag = 4 };
+
+const char *object_type_name(ObjectType type);
+
+struct Object {
+  ObjectType type = ObjectType::Blob;
+  std::string data;
+};
+
+// One entry of a tree object. Views into the tree's data.
+struct TreeEntry {
+  uint32_t mode = 0;
+  std::string_view name;
+  std::string_view oid; // Raw
+};
+
+// Throws ParseException for a malformed tree
+std::vector<TreeEntry> parse_tree(std::string_view data, size_t hash_size);
+
+// Read-only access to a repository's objects without running git: loose
+// objects are inflated, packed ones found through each pack's .idx fanout
+// or the multi-pack-index, and delta chains (OFS and REF) resolved against
+// a size-bounded cache of recent bases. Packs are read through mmap
+// windows, so a large pack is never mapped whole. Alternates
+// (objects/info/alternates) are searched after the repository's own
+// objects.
+//
+// All reads may run concurrently from any thread. A pack written after
+// open() is found when an object is not: the pack directory is then
+// scanned again, as git does.
+class ObjectDatabase {
+public:
+  struct Options {
+    // Bytes of inflated delta bases kept (git's core.deltaBaseCacheLimit)
+    size_t delta_base_cache_bytes = 96 << 20;
+    // Size of one mapped piece of a pack
+    size_t window_bytes = 32 << 20;
+    // Mapped pack bytes across all packs before old windows are unmapped
+    size_t mapped_bytes_limit = size_t{1} << 30;
+  };
+
+  struct Stats {
+    size_t loose_reads = 0;
+    size_t packed_reads = 0;
+    size_t deltas_applied = 0;
+    size_t base_cache_hits = 0;
+    size_t base_cache_misses = 0;
+    size_t windows_mapped = 0;
+    size_t windows_unmapped = 0;
+    size_t rescans = 0;
+  };
+
+  // Throws SlayerGitException if `objects_dir` cannot be read and
+  // ParseException if a pack index or multi-pack-index is malformed
+  static std::unique_ptr<ObjectDatabase> open(const std::string &objects_dir,
+                                              HashAlgorithm algorithm);
+  static std::unique_ptr<ObjectDatabase>
+  open(const std::string &objects_dir, HashAlgorithm algorithm,
+       Options options);
+  // Resolves the objects directory of `repo_path` first
+  static std::unique_ptr<ObjectDatabase>
+  open_repository(const std::string &repo_path, HashAlgorithm algorithm);
+
+  ~ObjectDatabase();
+  ObjectDatabase(const ObjectDatabase &) = delete;
+  ObjectDatabase &operator=(const ObjectDatabase &) = delete;
+
+  // `oid` is raw (hash_size() bytes). nullopt if no such object; throws
+  // ParseException for a corrupt one.
+  [[nodiscard]] std::optional<Object> read(std::string_view oid) const;
+  [[nodiscard]] bool contains(std::string_view oid) const;
+
+  // Commit -> tree, tag -> its target followed until a tree; nullopt if
+  // the object is missing or leads elsewhere
+  [[nodiscard]] std::optional<std::string>
+  peel_to_tree(std::string_view oid) const;
+
+  [[nodiscard]] HashAlgorithm algorithm() const { return algorithm_; }
+  [[nodiscard]] size_t hash_size() const { return core::hash_size(algorithm_); }
+  [[nodiscard]] const Options &options() const { return options_; }
+  [[nodiscard]] Stats stats() const;
+
+private:
+  class Pack;
+  class MultiPackIndex;
+  class BaseCache;
+  struct Source;
+  struct Location;
+
+  ObjectDatabase(HashAlgorithm algorithm, Options options);
+
+  void add_source(const std::string &objects_dir, int depth);
+  // (Re)lists a source's packs; false if its pack directory is unchanged
+  bool scan(Source &source) const;
+  [[nodiscard]] bool rescan() const;
+
+  [[nodiscard]] std::optional<Location> find_packed(std::string_view oid) const;
+  [[nodiscard]] std::optional<Object> read_loose(std::string_view oid) const;
+  [[nodiscard]] Object read_packed(const Location &location) const;
+  [[nodiscard]] std::optional<Object> read_once(std::string_view oid) const;
+
+  HashAlgorithm algorithm_;
+  Options options_;
+  // The repository's own objects first, then its alternates
+  std::vector<std::unique_ptr<Source>> sources_;
+  std::unique_ptr<BaseCache> base_cache_;
+
+  mutable std::atomic<size_t> mapped_bytes_{0};
+  mutable std::atomic<size_t> loose_reads_{0};
+  mutable std::atomic<size_t> packed_reads_{0};
+  mutable std::atomic<size_t> deltas_applied_{0};
+  mutable std::atomic<size_t> windows_mapped_{0};
+  mutable std::atomic<size_t> windows_unmapped_{0};
+  mutable std::atomic<size_t> rescans_{0};
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,487 @@
+#include "object_hash.hpp"
+
+#include "object_hash_kernels.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace slayergit::core {
+
+namespace {
+
+constexpr uint32_t sha1_initial[5] = {0x67452301, 0xefcdab89, 0x98badcfe,
+                                      0x10325476, 0xc3d2e1f0};
+
+constexpr uint32_t sha256_initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                        0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                        0x1f83d9ab, 0x5be0cd19};
+
+constexpr uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline uint32_t load_be32(const uint8_t *p) {
+  return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) |
+         (uint32_t{p[2]} << 8) | uint32_t{p[3]};
+}
+
+inline void store_be32(uint8_t *p, uint32_t value) {
+  p[0] = static_cast<uint8_t>(value >> 24);
+  p[1] = static_cast<uint8_t>(value >> 16);
+  p[2] = static_cast<uint8_t>(value >> 8);
+  p[3] = static_cast<uint8_t>(value);
+}
+
+void sha1_compress(uint32_t *state, const uint8_t *block) {
+  uint32_t w[80];
+  for (int i = 0; i < 16; ++i) {
+    w[i] = load_be32(block + 4 * i);
+  }
+  for (int i = 16; i < 80; ++i) {
+    w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  }
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+           e = state[4];
+#pragma GCC unroll 80
+  for (int i = 0; i < 80; ++i) {
+    uint32_t f;
+    uint32_t k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5a827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ed9eba1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8f1bbcdc;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xca62c1d6;
+    }
+    uint32_t t = rotl(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = rotl(b, 30);
+    b = a;
+    a = t;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+void sha256_compress(uint32_t *state, const uint8_t *block) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i) {
+    w[i] = load_be32(block + 4 * i);
+  }
+  for (int i = 16; i < 64; ++i) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+           e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 64; ++i) {
+    uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+    uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + maj;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+} // namespace
+
+namespace detail {
+
+void sha1_blocks_scalar(uint32_t *state, const uint8_t *data, size_t blocks) {
+  for (; blocks > 0; --blocks, data += block_size) {
+    sha1_compress(state, data);
+  }
+}
+
+void sha256_blocks_scalar(uint32_t *state, const uint8_t *data,
+                          size_t blocks) {
+  for (; blocks > 0; --blocks, data += block_size) {
+    sha256_compress(state, data);
+  }
+}
+
+} // namespace detail
+
+namespace {
+
+using BlockFunction = void (*)(uint32_t *state, const uint8_t *data,
+                               size_t blocks);
+
+BlockFunction block_function(HashAlgorithm algorithm, HashBackend backend) {
+  bool sha1 = algorithm == HashAlgorithm::Sha1;
+  // Multi-buffer lanes need several buffers; alone, SHA-NI beats them
+  if (backend != HashBackend::Scalar && detail::cpu_has_sha_extensions()) {
+    return sha1 ? detail::sha1_blocks_shani : detail::sha256_blocks_shani;
+  }
+  return sha1 ? detail::sha1_blocks_scalar : detail::sha256_blocks_scalar;
+}
+
+const uint32_t *initial_state(HashAlgorithm algorithm) {
+  return algorithm == HashAlgorithm::Sha1 ? sha1_initial : sha256_initial;
+}
+
+size_t state_words(HashAlgorithm algorithm) {
+  return algorithm == HashAlgorithm::Sha1 ? 5 : 8;
+}
+
+std::string digest_of(HashAlgorithm algorithm, const uint32_t *state) {
+  std::string digest(hash_size(algorithm), '\0');
+  for (size_t i = 0; i < digest.size() / 4; ++i) {
+    store_be32(reinterpret_cast<uint8_t *>(&digest[4 * i]), state[i]);
+  }
+  return digest;
+}
+
+// One object as the padded message the compression functions see: header,
+// contents, 0x80, zeros and the bit length. Blocks wholly inside the
+// contents are hashed in place; the few around them are assembled.
+struct Message {
+  std::string header;
+  std::string_view data;
+  uint64_t blocks = 0;
+
+  Message(std::string_view type, std::string_view data)
+      : header(object_header(type, data.size())), data(data) {
+    // At least the 0x80 and 8 length bytes follow the object
+    blocks = (header.size() + data.size() + 9 + detail::block_size - 1) /
+             detail::block_size;
+  }
+
+  [[nodiscard]] uint64_t length() const {
+    return header.size() + data.size();
+  }
+
+  // Whether block i lies wholly in `data`
+  [[nodiscard]] bool in_place(uint64_t i) const {
+    uint64_t begin = i * detail::block_size;
+    return begin >= header.size() && begin + detail::block_size <= length();
+  }
+
+  const uint8_t *block(uint64_t i, uint8_t *scratch) const {
+    uint64_t begin = i * detail::block_size;
+    if (in_place(i)) {
+      return reinterpret_cast<const uint8_t *>(data.data()) +
+             (begin - header.size());
+    }
+    std::memset(scratch, 0, detail::block_size);
+    uint64_t end = begin + detail::block_size;
+    uint64_t total = length();
+    auto copy = [&](uint64_t from, uint64_t to, const char *source) {
+      uint64_t lo = std::max(begin, from);
+      uint64_t hi = std::min(end, to);
+      if (lo < hi) {
+        std::memcpy(scratch + (lo - begin), source + (lo - from), hi - lo);
+      }
+    };
+    copy(0, header.size(), header.data());
+    copy(header.size(), total, data.data());
+    if (total >= begin && total < end) {
+      scratch[total - begin] = 0x80;
+    }
+    if (i + 1 == blocks) {
+      uint64_t bits = total * 8;
+      store_be32(scratch + 56, static_cast<uint32_t>(bits >> 32));
+      store_be32(scratch + 60, static_cast<uint32_t>(bits));
+    }
+    return scratch;
+  }
+
+  // Blocks [first, blocks) through a one-buffer function
+  void finish(BlockFunction compress, uint32_t *state, uint64_t first) const {
+    uint8_t scratch[detail::block_size];
+    uint64_t i = first;
+    while (i < blocks) {
+      uint64_t run = 0;
+      while (i + run < blocks && in_place(i + run)) {
+        ++run;
+      }
+      if (run > 0) {
+        compress(state, block(i, scratch), run);
+        i += run;
+      } else {
+        compress(state, block(i, scratch), 1);
+        ++i;
+      }
+    }
+  }
+};
+
+void lanes_x8(HashAlgorithm algorithm, uint32_t (*state)[detail::lanes],
+              const uint8_t *const *blocks) {
+  if (algorithm == HashAlgorithm::Sha1) {
+    detail::sha1_x8_avx2(state, blocks);
+  } else {
+    detail::sha256_x8_avx2(state, blocks);
+  }
+}
+
+// Eight objects at a time, one per AVX2 lane. A lane that finishes takes
+// the next object, longest first so the lanes run out together; once too
+// few are left to be worth it, the rest finish on the one-buffer backend.
+std::vector<std::string>
+hash_multi_buffer(HashAlgorithm algorithm,
+                  const std::vector<Message> &messages) {
+  constexpr size_t none = static_cast<size_t>(-1);
+  constexpr size_t min_busy_lanes = 3;
+  const size_t words = state_words(algorithm);
+  const BlockFunction single =
+      block_function(algorithm, HashBackend::ShaExtensions);
+
+  std::vector<size_t> order(messages.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return messages[a].blocks > messages[b].blocks;
+  });
+
+  std::vector<std::string> digests(messages.size());
+  uint32_t state[8][detail::lanes];
+  size_t job[detail::lanes];
+  uint64_t position[detail::lanes] = {};
+  alignas(32) uint8_t scratch[detail::lanes][detail::block_size];
+  alignas(32) static const uint8_t idle[detail::block_size] = {};
+  const uint8_t *blocks[detail::lanes];
+
+  size_t next = 0;
+  auto start = [&](size_t lane) {
+    job[lane] = next < order.size() ? order[next++] : none;
+    position[lane] = 0;
+    const uint32_t *initial = initial_state(algorithm);
+    for (size_t w = 0; w < words; ++w) {
+      state[w][lane] = initial[w];
+    }
+  };
+  for (size_t lane = 0; lane < detail::lanes; ++lane) {
+    start(lane);
+  }
+
+  while (true) {
+    size_t busy = 0;
+    for (size_t lane = 0; lane < detail::lanes; ++lane) {
+      busy += job[lane] != none;
+    }
+    if (busy == 0) {
+      break;
+    }
+    if (busy < min_busy_lanes && next == order.size()) {
+      for (size_t lane = 0; lane < detail::lanes; ++lane) {
+        if (job[lane] == none) {
+          continue;
+        }
+        uint32_t lane_state[8];
+        for (size_t w = 0; w < words; ++w) {
+          lane_state[w] = state[w][lane];
+        }
+        messages[job[lane]].finish(single, lane_state, position[lane]);
+        digests[job[lane]] = digest_of(algorithm, lane_state);
+      }
+      break;
+    }
+    for (size_t lane = 0; lane < detail::lanes; ++lane) {
+      blocks[lane] = job[lane] == none
+                         ? idle
+                         : messages[job[lane]].block(position[lane],
+                                                     scratch[lane]);
+    }
+    lanes_x8(algorithm, state, blocks);
+    for (size_t lane = 0; lane < detail::lanes; ++lane) {
+      if (job[lane] == none ||
+          ++position[lane] < messages[job[lane]].blocks) {
+        continue;
+      }
+      uint32_t lane_state[8];
+      for (size_t w = 0; w < words; ++w) {
+        lane_state[w] = state[w][lane];
+      }
+      digests[job[lane]] = digest_of(algorithm, lane_state);
+      start(lane);
+    }
+  }
+  return digests;
+}
+
+} // namespace
+
+bool hash_backend_supported(HashBackend backend) {
+  switch (backend) {
+  case HashBackend::Scalar:
+    return true;
+  case HashBackend::ShaExtensions:
+    return detail::cpu_has_sha_extensions();
+  case HashBackend::MultiBuffer:
+    return detail::cpu_has_avx2();
+  }
+  return false;
+}
+
+const char *hash_backend_name(HashBackend backend) {
+  switch (backend) {
+  case HashBackend::Scalar:
+    return "scalar";
+  case HashBackend::ShaExtensions:
+    return "sha-ni";
+  case HashBackend::MultiBuffer:
+    return "avx2-x8";
+  }
+  return "unknown";
+}
+
+HashBackend default_hash_backend(HashAlgorithm algorithm) {
+  // SHA-NI's SHA-256 outruns eight AVX2 lanes, but its SHA-1 does not
+  bool sha_extensions = hash_backend_supported(HashBackend::ShaExtensions);
+  if (sha_extensions && algorithm == HashAlgorithm::Sha256) {
+    return HashBackend::ShaExtensions;
+  }
+  if (hash_backend_supported(HashBackend::MultiBuffer)) {
+    return HashBackend::MultiBuffer;
+  }
+  return sha_extensions ? HashBackend::ShaExtensions : HashBackend::Scalar;
+}
+
+Hasher::Hasher(HashAlgorithm algorithm)
+    : Hasher(algorithm, HashBackend::ShaExtensions) {}
+
+Hasher::Hasher(HashAlgorithm algorithm, HashBackend backend)
+    : algorithm_(algorithm), compress_(block_function(algorithm, backend)) {
+  reset();
+}
+
+void Hasher::reset() {
+  std::memcpy(state_, initial_state(algorithm_),
+              state_words(algorithm_) * sizeof(uint32_t));
+  buffered_ = 0;
+  length_ = 0;
+}
+
+void Hasher::update(const void *data, size_t size) {
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  length_ += size;
+  if (buffered_ > 0) {
+    size_t take = std::min(size, sizeof(buffer_) - buffered_);
+    std::memcpy(buffer_ + buffered_, bytes, take);
+    buffered_ += take;
+    bytes += take;
+    size -= take;
+    if (buffered_ < sizeof(buffer_)) {
+      return;
+    }
+    compress_(state_, buffer_, 1);
+    buffered_ = 0;
+  }
+  size_t blocks = size / sizeof(buffer_);
+  if (blocks > 0) {
+    compress_(state_, bytes, blocks);
+    bytes += blocks * sizeof(buffer_);
+    size -= blocks * sizeof(buffer_);
+  }
+  std::memcpy(buffer_, bytes, size);
+  buffered_ = size;
+}
+
+std::string Hasher::finish() {
+  // Both pad with 0x80, zeros and the bit length as a big-endian 64-bit
+  uint64_t bits = length_ * 8;
+  buffer_[buffered_++] = 0x80;
+  if (buffered_ > 56) {
+    std::memset(buffer_ + buffered_, 0, sizeof(buffer_) - buffered_);
+    compress_(state_, buffer_, 1);
+    buffered_ = 0;
+  }
+  std::memset(buffer_ + buffered_, 0, 56 - buffered_);
+  store_be32(buffer_ + 56, static_cast<uint32_t>(bits >> 32));
+  store_be32(buffer_ + 60, static_cast<uint32_t>(bits));
+  compress_(state_, buffer_, 1);
+  buffered_ = 0;
+  return digest_of(algorithm_, state_);
+}
+
+std::string object_header(std::string_view type, uint64_t size) {
+  std::string header(type);
+  header += ' ';
+  header += std::to_string(size);
+  header += '\0';
+  return header;
+}
+
+std::string hash_object(HashAlgorithm algorithm, std::string_view type,
+                        std::string_view data) {
+  Hasher hasher(algorithm);
+  hasher.update(object_header(type, data.size()));
+  hasher.update(data);
+  return hasher.finish();
+}
+
+std::vector<std::string>
+hash_objects(HashAlgorithm algorithm, std::string_view type,
+             const std::vector<std::string_view> &contents) {
+  return hash_objects(algorithm, type, contents,
+                      default_hash_backend(algorithm));
+}
+
+std::vector<std::string>
+hash_objects(HashAlgorithm algorithm, std::string_view type,
+             const std::vector<std::string_view> &contents,
+             HashBackend backend) {
+  std::vector<Message> messages;
+  messages.reserve(contents.size());
+  for (std::string_view data : contents) {
+    messages.emplace_back(type, data);
+  }
+  if (backend == HashBackend::MultiBuffer &&
+      hash_backend_supported(backend) && messages.size() > 1) {
+    return hash_multi_buffer(algorithm, messages);
+  }
+  const BlockFunction compress = block_function(algorithm, backend);
+  std::vector<std::string> digests;
+  digests.reserve(messages.size());
+  for (const Message &message : messages) {
+    uint32_t state[8];
+    std::memcpy(state, initial_state(algorithm),
+                state_words(algorithm) * sizeof(uint32_t));
+    message.finish(compress, state, 0);
+    digests.push_back(digest_of(algorithm, state));
+  }
+  return digests;
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::core {
+
+// The repository's object format (extensions.objectFormat)
+enum class HashAlgorithm { Sha1, Sha256 };
+
+constexpr size_t hash_size(HashAlgorithm algorithm) {
+  return algorithm == HashAlgorithm::Sha1 ? 20 : 32;
+}
+
+// How blocks are compressed. ShaExtensions is the x86 SHA instructions on
+// one buffer; MultiBuffer hashes eight buffers at once in AVX2 lanes, so it
+// only helps hash_objects() and a Hasher given it uses the best one-buffer
+// backend instead.
+enum class HashBackend { Scalar, ShaExtensions, MultiBuffer };
+
+bool hash_backend_supported(HashBackend backend);
+const char *hash_backend_name(HashBackend backend);
+
+// The fastest supported backend for batches of `algorithm`, picked at
+// runtime from the CPU's features
+HashBackend default_hash_backend(HashAlgorithm algorithm);
+
+// Incremental SHA-1 or SHA-256. finish() returns the raw digest
+// (hash_size() bytes) and leaves the hasher to be reset() before reuse.
+class Hasher {
+public:
+  explicit Hasher(HashAlgorithm algorithm);
+  // An unsupported backend falls back to the scalar one
+  Hasher(HashAlgorithm algorithm, HashBackend backend);
+
+  void reset();
+  void update(const void *data, size_t size);
+  void update(std::string_view data) { update(data.data(), data.size()); }
+  std::string finish();
+
+  [[nodiscard]] HashAlgorithm algorithm() const { return algorithm_; }
+
+private:
+  HashAlgorithm algorithm_;
+  void (*compress_)(uint32_t *state, const uint8_t *blocks, size_t count);
+  uint32_t state_[8];
+  uint8_t buffer_[64];
+  size_t buffered_ = 0;
+  uint64_t length_ = 0;
+};
+
+// "<type> <size>\0" as git prefixes it to an object before hashing
+std::string object_header(std::string_view type, uint64_t size);
+
+// Raw object id of `data` stored as `type` ("blob", "tree", ...)
+std::string hash_object(HashAlgorithm algorithm, std::string_view type,
+                        std::string_view data);
+
+// Raw object ids of many objects of one type, in order. Independent
+// objects are what lets the multi-buffer backend fill its lanes, so
+// callers should gather a batch rather than hash one at a time.
+std::vector<std::string>
+hash_objects(HashAlgorithm algorithm, std::string_view type,
+             const std::vector<std::string_view> &contents);
+std::vector<std::string>
+hash_objects(HashAlgorithm algorithm, std::string_view type,
+             const std::vector<std::string_view> &contents,
+             HashBackend backend);
+
+} // namespace slayergit::core
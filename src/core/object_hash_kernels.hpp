@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compression functions behind object_hash.hpp. Each takes whole 64-byte
+// blocks; padding is the caller's. The SIMD ones may only be called when
+// the matching cpu_has_*() returned true.
+namespace slayergit::core::detail {
+
+constexpr size_t block_size = 64;
+// Buffers the multi-buffer kernels hash side by side
+constexpr size_t lanes = 8;
+
+void sha1_blocks_scalar(uint32_t *state, const uint8_t *data, size_t blocks);
+void sha256_blocks_scalar(uint32_t *state, const uint8_t *data,
+                          size_t blocks);
+
+bool cpu_has_sha_extensions();
+bool cpu_has_avx2();
+
+// x86 SHA extensions (SHA-NI): one buffer
+void sha1_blocks_shani(uint32_t *state, const uint8_t *data, size_t blocks);
+void sha256_blocks_shani(uint32_t *state, const uint8_t *data, size_t blocks);
+
+// AVX2: one block of each of eight buffers. state[word][lane], so each
+// word of the eight states is one register.
+void sha1_x8_avx2(uint32_t (*state)[lanes], const uint8_t *const *blocks);
+void sha256_x8_avx2(uint32_t (*state)[lanes], const uint8_t *const *blocks);
+
+} // namespace slayergit::core::detail
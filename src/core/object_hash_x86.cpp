@@ -0,0 +1,391 @@
+#include "object_hash_kernels.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SLAYERGIT_X86_HASH 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace slayergit::core::detail {
+
+#ifdef SLAYERGIT_X86_HASH
+
+namespace {
+
+constexpr uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+struct CpuFeatures {
+  bool sha = false;
+  bool avx2 = false;
+};
+
+CpuFeatures detect() {
+  CpuFeatures features;
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+  bool ssse3 = (ecx & bit_SSSE3) != 0;
+  bool sse41 = (ecx & bit_SSE4_1) != 0;
+  // AVX registers are only usable if the OS saves them (XCR0 bits 1, 2)
+  bool os_avx = false;
+  if ((ecx & bit_OSXSAVE) != 0 && (ecx & bit_AVX) != 0) {
+    unsigned xcr0_low = 0, xcr0_high = 0;
+    __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    os_avx = (xcr0_low & 0x6) == 0x6;
+  }
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+  features.sha = (ebx & bit_SHA) != 0 && ssse3 && sse41;
+  features.avx2 = (ebx & bit_AVX2) != 0 && os_avx;
+  return features;
+}
+
+const CpuFeatures &features() {
+  static const CpuFeatures cpu = detect();
+  return cpu;
+}
+
+} // namespace
+
+bool cpu_has_sha_extensions() { return features().sha; }
+bool cpu_has_avx2() { return features().avx2; }
+
+// Intel's SHA-NI sequence: four rounds per sha1rnds4, with the message
+// schedule computed by sha1msg1/sha1msg2 alongside
+__attribute__((target("sha,sse4.1,ssse3"))) void
+sha1_blocks_shani(uint32_t *state, const uint8_t *data, size_t blocks) {
+  const __m128i byte_swap =
+      _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+  __m128i abcd = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0x1b);
+  __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+  for (; blocks > 0; --blocks, data += block_size) {
+    const __m128i abcd_save = abcd;
+    const __m128i e0_save = e0;
+    __m128i msg[4];
+    __m128i e1;
+#pragma GCC unroll 20
+    for (int g = 0; g < 20; ++g) {
+      if (g < 4) {
+        msg[g] = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * g)),
+            byte_swap);
+      }
+      __m128i &e = (g % 2 == 0) ? e0 : e1;
+      __m128i &other = (g % 2 == 0) ? e1 : e0;
+      if (g == 0) {
+        e0 = _mm_add_epi32(e0, msg[0]);
+      } else {
+        e = _mm_sha1nexte_epu32(e, msg[g % 4]);
+      }
+      other = abcd;
+      if (g >= 3 && g <= 18) {
+        msg[(g + 1) % 4] = _mm_sha1msg2_epu32(msg[(g + 1) % 4], msg[g % 4]);
+      }
+      switch (g / 5) {
+      case 0:
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+        break;
+      case 1:
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 1);
+        break;
+      case 2:
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 2);
+        break;
+      default:
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 3);
+        break;
+      }
+      if (g >= 1 && g <= 16) {
+        msg[(g + 3) % 4] = _mm_sha1msg1_epu32(msg[(g + 3) % 4], msg[g % 4]);
+      }
+      if (g >= 2 && g <= 17) {
+        msg[(g + 2) % 4] = _mm_xor_si128(msg[(g + 2) % 4], msg[g % 4]);
+      }
+    }
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state),
+                   _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+// Intel's SHA-NI sequence: the state is kept as ABEF/CDGH, two rounds per
+// sha256rnds2
+__attribute__((target("sha,sse4.1,ssse3"))) void
+sha256_blocks_shani(uint32_t *state, const uint8_t *data, size_t blocks) {
+  const __m128i byte_swap =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+  __m128i tmp = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0xb1);
+  __m128i state1 = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4)), 0x1b);
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+  for (; blocks > 0; --blocks, data += block_size) {
+    const __m128i abef_save = state0;
+    const __m128i cdgh_save = state1;
+    __m128i msg[4];
+#pragma GCC unroll 16
+    for (int g = 0; g < 16; ++g) {
+      if (g < 4) {
+        msg[g] = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * g)),
+            byte_swap);
+      }
+      __m128i words = _mm_add_epi32(
+          msg[g % 4],
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(sha256_k + 4 * g)));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, words);
+      if (g >= 3 && g <= 14) {
+        __m128i shifted = _mm_alignr_epi8(msg[g % 4], msg[(g + 3) % 4], 4);
+        msg[(g + 1) % 4] = _mm_sha256msg2_epu32(
+            _mm_add_epi32(msg[(g + 1) % 4], shifted), msg[g % 4]);
+      }
+      state0 = _mm_sha256rnds2_epu32(state0, state1,
+                                     _mm_shuffle_epi32(words, 0x0e));
+      if (g >= 1 && g <= 12) {
+        msg[(g + 3) % 4] = _mm_sha256msg1_epu32(msg[(g + 3) % 4], msg[g % 4]);
+      }
+    }
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1b);
+  state1 = _mm_shuffle_epi32(state1, 0xb1);
+  state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+  state1 = _mm_alignr_epi8(state1, tmp, 8);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), state1);
+}
+
+namespace {
+
+#define SLAYERGIT_AVX2 __attribute__((target("avx2")))
+
+SLAYERGIT_AVX2 inline __m256i rotl(__m256i x, int n) {
+  return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+}
+
+SLAYERGIT_AVX2 inline __m256i rotr(__m256i x, int n) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+SLAYERGIT_AVX2 inline __m256i add(__m256i a, __m256i b) {
+  return _mm256_add_epi32(a, b);
+}
+
+// The 16 big-endian words of one block of each lane, as words[i] holding
+// word i of all eight: two 8x8 transposes
+SLAYERGIT_AVX2 void load_words(const uint8_t *const *blocks, __m256i *words) {
+  const __m256i byte_swap = _mm256_set_epi8(
+      12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8,
+      9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  for (int half = 0; half < 2; ++half) {
+    __m256i r[lanes];
+    for (size_t lane = 0; lane < lanes; ++lane) {
+      r[lane] = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(blocks[lane] + 32 * half));
+    }
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    __m256i *out = words + 8 * half;
+    out[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    out[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    out[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    out[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    out[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    out[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    out[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    out[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+    for (int i = 0; i < 8; ++i) {
+      out[i] = _mm256_shuffle_epi8(out[i], byte_swap);
+    }
+  }
+}
+
+} // namespace
+
+SLAYERGIT_AVX2 void sha1_x8_avx2(uint32_t (*state)[lanes],
+                                 const uint8_t *const *blocks) {
+  __m256i w[16];
+  load_words(blocks, w);
+  __m256i s[5];
+  for (int i = 0; i < 5; ++i) {
+    s[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(state[i]));
+  }
+  __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+
+#pragma GCC unroll 80
+  for (int t = 0; t < 80; ++t) {
+    __m256i word;
+    if (t < 16) {
+      word = w[t];
+    } else {
+      word = rotl(_mm256_xor_si256(
+                      _mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]),
+                      _mm256_xor_si256(w[(t - 14) & 15], w[t & 15])),
+                  1);
+      w[t & 15] = word;
+    }
+    __m256i f;
+    uint32_t k;
+    if (t < 20) {
+      f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+      k = 0x5a827999;
+    } else if (t < 40) {
+      f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+      k = 0x6ed9eba1;
+    } else if (t < 60) {
+      f = _mm256_or_si256(_mm256_and_si256(b, c),
+                          _mm256_and_si256(d, _mm256_or_si256(b, c)));
+      k = 0x8f1bbcdc;
+    } else {
+      f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+      k = 0xca62c1d6;
+    }
+    __m256i temp =
+        add(add(rotl(a, 5), f),
+            add(add(e, _mm256_set1_epi32(static_cast<int>(k))), word));
+    e = d;
+    d = c;
+    c = rotl(b, 30);
+    b = a;
+    a = temp;
+  }
+
+  __m256i result[5] = {a, b, c, d, e};
+  for (int i = 0; i < 5; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(state[i]),
+                        add(result[i], s[i]));
+  }
+}
+
+SLAYERGIT_AVX2 void sha256_x8_avx2(uint32_t (*state)[lanes],
+                                   const uint8_t *const *blocks) {
+  __m256i w[16];
+  load_words(blocks, w);
+  __m256i s[8];
+  for (int i = 0; i < 8; ++i) {
+    s[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(state[i]));
+  }
+  __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5],
+          g = s[6], h = s[7];
+
+#pragma GCC unroll 64
+  for (int t = 0; t < 64; ++t) {
+    __m256i word;
+    if (t < 16) {
+      word = w[t];
+    } else {
+      __m256i w15 = w[(t - 15) & 15];
+      __m256i w2 = w[(t - 2) & 15];
+      __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr(w15, 7), rotr(w15, 18)),
+                                    _mm256_srli_epi32(w15, 3));
+      __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr(w2, 17), rotr(w2, 19)),
+                                    _mm256_srli_epi32(w2, 10));
+      word = add(add(w[t & 15], s0), add(w[(t - 7) & 15], s1));
+      w[t & 15] = word;
+    }
+    __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr(e, 6), rotr(e, 11)),
+                                      rotr(e, 25));
+    __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+    __m256i t1 = add(add(add(h, sigma1), add(ch, word)),
+                     _mm256_set1_epi32(static_cast<int>(sha256_k[t])));
+    __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr(a, 2), rotr(a, 13)),
+                                      rotr(a, 22));
+    __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b),
+                                  _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    __m256i t2 = add(sigma0, maj);
+    h = g;
+    g = f;
+    f = e;
+    e = add(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = add(t1, t2);
+  }
+
+  __m256i result[8] = {a, b, c, d, e, f, g, h};
+  for (int i = 0; i < 8; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(state[i]),
+                        add(result[i], s[i]));
+  }
+}
+
+#else // Not x86-64: only the scalar kernels exist
+
+bool cpu_has_sha_extensions() { return false; }
+bool cpu_has_avx2() { return false; }
+
+void sha1_blocks_shani(uint32_t *state, const uint8_t *data, size_t blocks) {
+  sha1_blocks_scalar(state, data, blocks);
+}
+
+void sha256_blocks_shani(uint32_t *state, const uint8_t *data,
+                         size_t blocks) {
+  sha256_blocks_scalar(state, data, blocks);
+}
+
+void sha1_x8_avx2(uint32_t (*state)[lanes], const uint8_t *const *blocks) {
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    uint32_t words[5];
+    for (int i = 0; i < 5; ++i) {
+      words[i] = state[i][lane];
+    }
+    sha1_blocks_scalar(words, blocks[lane], 1);
+    for (int i = 0; i < 5; ++i) {
+      state[i][lane] = words[i];
+    }
+  }
+}
+
+void sha256_x8_avx2(uint32_t (*state)[lanes], const uint8_t *const *blocks) {
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    uint32_t words[8];
+    for (int i = 0; i < 8; ++i) {
+      words[i] = state[i][lane];
+    }
+    sha256_blocks_scalar(words, blocks[lane], 1);
+    for (int i = 0; i < 8; ++i) {
+      state[i][lane] = words[i];
+    }
+  }
+}
+
+#endif
+
+} // namespace slayergit::core::detail
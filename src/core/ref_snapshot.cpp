@@ -0,0 +1,348 @@
+#include "ref_snapshot.hpp"
+
+#include "core/reftable.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_dir.hpp"
+#include "infra/mapped_file.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <system_error>
+
+namespace slayergit::core {
+
+struct RefSource {
+  std::string_view name;
+  std::string_view oid;
+  std::string_view peeled;
+  std::string_view symref;
+};
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Git gives up on symref chains deeper than this
+constexpr int max_symref_depth = 5;
+// Refs that belong to each worktree rather than to the repository
+constexpr std::string_view per_worktree_dirs[] = {"bisect", "worktree",
+                                                  "rewritten"};
+
+constexpr std::string_view symref_prefix = "ref: ";
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool is_hex_oid(std::string_view text) {
+  return (text.size() == 40 || text.size() == 64) &&
+         std::all_of(text.begin(), text.end(), [](char c) {
+           return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+         });
+}
+
+std::string_view trim_line(std::string_view text) {
+  size_t end = text.find('\n');
+  text = text.substr(0, end);
+  while (!text.empty() && (text.back() == '\r' || text.back() == ' ')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+// `<oid> <name>` lines, each optionally followed by `^<peeled oid>`
+std::vector<RefSource> parse_packed_refs(const infra::MappedFile &file) {
+  std::string_view rest(reinterpret_cast<const char *>(file.data()),
+                        file.size());
+  std::vector<RefSource> refs;
+  bool sorted = false;
+  while (!rest.empty()) {
+    size_t end = rest.find('\n');
+    std::string_view line = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (line.empty()) {
+      continue;
+    }
+    if (line[0] == '#') {
+      sorted = sorted || (starts_with(line, "# pack-refs with:") &&
+                          line.find(" sorted") != std::string_view::npos);
+      continue;
+    }
+    if (line[0] == '^') {
+      if (refs.empty() || !is_hex_oid(line.substr(1))) {
+        throw ParseException(file.path() + ": unexpected peeled line");
+      }
+      refs.back().peeled = line.substr(1);
+      continue;
+    }
+    size_t space = line.find(' ');
+    if (space == std::string_view::npos || !is_hex_oid(line.substr(0, space))) {
+      throw ParseException(file.path() + ": bad line");
+    }
+    refs.push_back({line.substr(space + 1), line.substr(0, space), {}, {}});
+  }
+  // Files from old gits may be unsorted; the last entry of a name wins
+  if (!sorted) {
+    std::stable_sort(refs.begin(), refs.end(),
+                     [](const RefSource &a, const RefSource &b) {
+                       return a.name < b.name;
+                     });
+    auto last = std::unique(refs.rbegin(), refs.rend(),
+                            [](const RefSource &a, const RefSource &b) {
+                              return a.name == b.name;
+                            });
+    refs.erase(refs.begin(), last.base());
+  }
+  return refs;
+}
+
+struct LooseRef {
+  std::string name;
+  std::string content;
+};
+
+std::string read_small_file(const fs::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+bool is_per_worktree(std::string_view name) {
+  for (auto dir : per_worktree_dirs) {
+    if (starts_with(name, "refs/") && starts_with(name.substr(5), dir) &&
+        starts_with(name.substr(5 + dir.size()), "/")) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Files under `git_dir/refs`, optionally only those that are (or are not)
+// per-worktree
+void collect_loose(const fs::path &git_dir, bool per_worktree_only,
+                   bool skip_per_worktree, std::deque<LooseRef> &out) {
+  fs::path refs_dir = git_dir / "refs";
+  std::error_code error;
+  if (!fs::is_directory(refs_dir, error)) {
+    return;
+  }
+  for (fs::recursive_directory_iterator it(refs_dir, error), end;
+       !error && it != end; it.increment(error)) {
+    if (!it->is_regular_file(error)) {
+      continue;
+    }
+    std::string name =
+        "refs/" + it->path().lexically_relative(refs_dir).generic_string();
+    if (name.size() >= 5 && name.compare(name.size() - 5, 5, ".lock") == 0) {
+      continue;
+    }
+    bool worktree_ref = is_per_worktree(name);
+    if ((per_worktree_only && !worktree_ref) ||
+        (skip_per_worktree && worktree_ref)) {
+      continue;
+    }
+    out.push_back({std::move(name), read_small_file(it->path())});
+  }
+}
+
+// Fills oid or symref from a loose ref or HEAD file; false if it is neither
+bool parse_ref_content(std::string_view content, RefSource &ref) {
+  content = trim_line(content);
+  if (starts_with(content, symref_prefix)) {
+    ref.symref = content.substr(symref_prefix.size());
+    return !ref.symref.empty();
+  }
+  ref.oid = content;
+  return is_hex_oid(content);
+}
+
+} // namespace
+
+std::shared_ptr<const RefSnapshot>
+RefSnapshot::read(const std::string &repo_path) {
+  infra::GitDirs dirs = infra::resolve_git_dirs(repo_path);
+  std::shared_ptr<RefSnapshot> snapshot(new RefSnapshot());
+  std::vector<RefSource> sources;
+  RefSource head;
+  std::string head_content;
+
+  std::error_code error;
+  fs::path reftable_dir = fs::path(dirs.common_dir) / "reftable";
+  std::vector<ReftableRef> reftable;
+  std::unique_ptr<infra::MappedFile> packed_file;
+  std::deque<LooseRef> loose;
+
+  if (fs::is_regular_file(reftable_dir / "tables.list", error)) {
+    // HEAD and the refs live in the tables; .git/HEAD is only a stub
+    snapshot->reftable_ = true;
+    reftable = read_reftable_stack(reftable_dir.string());
+    for (const auto &ref : reftable) {
+      RefSource source{ref.name, ref.oid, ref.peeled, ref.symref};
+      if (ref.name == "HEAD") {
+        head = source;
+      } else if (starts_with(ref.name, "refs/")) {
+        sources.push_back(source);
+      }
+    }
+  } else {
+    fs::path packed_path = fs::path(dirs.common_dir) / "packed-refs";
+    std::vector<RefSource> packed;
+    if (fs::is_regular_file(packed_path, error)) {
+      packed_file = std::make_unique<infra::MappedFile>(packed_path.string());
+      packed = parse_packed_refs(*packed_file);
+    }
+
+    bool linked_worktree = dirs.git_dir != dirs.common_dir;
+    collect_loose(dirs.common_dir, false, linked_worktree, loose);
+    if (linked_worktree) {
+      collect_loose(dirs.git_dir, true, false, loose);
+    }
+    std::vector<RefSource> loose_refs;
+    loose_refs.reserve(loose.size());
+    for (const auto &ref : loose) {
+      RefSource source{ref.name, {}, {}, {}};
+      // Half-written or foreign files are skipped, as git does
+      if (parse_ref_content(ref.content, source)) {
+        loose_refs.push_back(source);
+      }
+    }
+    std::sort(loose_refs.begin(), loose_refs.end(),
+              [](const RefSource &a, const RefSource &b) {
+                return a.name < b.name;
+              });
+
+    // A loose ref overrides its packed copy
+    sources.reserve(packed.size() + loose_refs.size());
+    size_t p = 0;
+    size_t l = 0;
+    while (p < packed.size() || l < loose_refs.size()) {
+      if (l == loose_refs.size() ||
+          (p < packed.size() && packed[p].name < loose_refs[l].name)) {
+        sources.push_back(packed[p++]);
+        continue;
+      }
+      if (p < packed.size() && packed[p].name == loose_refs[l].name) {
+        ++p;
+      }
+      sources.push_back(loose_refs[l++]);
+    }
+
+    head_content = read_small_file(fs::path(dirs.git_dir) / "HEAD");
+    if (!parse_ref_content(head_content, head)) {
+      throw ParseException("cannot read HEAD in " + dirs.git_dir);
+    }
+  }
+
+  snapshot->build(sources);
+
+  snapshot->head_.symref = std::string(head.symref);
+  snapshot->head_.oid = std::string(head.oid);
+  if (!head.symref.empty()) {
+    size_t index = snapshot->find(head.symref);
+    if (index != npos) {
+      snapshot->head_.oid = std::string(snapshot->oid(index));
+    }
+  }
+  return snapshot;
+}
+
+uint32_t RefSnapshot::store(std::string_view text) {
+  if (strings_.size() + text.size() > std::numeric_limits<uint32_t>::max()) {
+    throw SlayerGitException("too many refs");
+  }
+  auto offset = static_cast<uint32_t>(strings_.size());
+  strings_.append(text);
+  return offset;
+}
+
+void RefSnapshot::build(const std::vector<RefSource> &sources) {
+  size_t bytes = 0;
+  for (const auto &source : sources) {
+    bytes += source.name.size() + source.oid.size() + source.peeled.size() +
+             source.symref.size();
+  }
+  strings_.reserve(bytes);
+  refs_.reserve(sources.size());
+  for (const auto &source : sources) {
+    Ref ref;
+    ref.name = store(source.name);
+    ref.name_size = static_cast<uint32_t>(source.name.size());
+    ref.oid = store(source.oid);
+    ref.oid_size = static_cast<uint16_t>(source.oid.size());
+    ref.peeled = store(source.peeled);
+    ref.peeled_size = static_cast<uint16_t>(source.peeled.size());
+    ref.symref = store(source.symref);
+    ref.symref_size = static_cast<uint32_t>(source.symref.size());
+    refs_.push_back(ref);
+  }
+
+  // Symrefs take the object id at the end of their chain
+  for (auto &ref : refs_) {
+    uint32_t target = ref.symref;
+    uint32_t target_size = ref.symref_size;
+    for (int depth = 0; target_size > 0 && depth < max_symref_depth;
+         ++depth) {
+      size_t index = find(text(target, target_size));
+      if (index == npos) {
+        break;
+      }
+      const Ref &next = refs_[index];
+      if (next.symref_size == 0) {
+        ref.oid = next.oid;
+        ref.oid_size = next.oid_size;
+        break;
+      }
+      target = next.symref;
+      target_size = next.symref_size;
+    }
+  }
+}
+
+std::string_view RefSnapshot::name(size_t index) const {
+  return text(refs_[index].name, refs_[index].name_size);
+}
+
+std::string_view RefSnapshot::oid(size_t index) const {
+  return text(refs_[index].oid, refs_[index].oid_size);
+}
+
+std::string_view RefSnapshot::peeled(size_t index) const {
+  return text(refs_[index].peeled, refs_[index].peeled_size);
+}
+
+std::string_view RefSnapshot::symref(size_t index) const {
+  return text(refs_[index].symref, refs_[index].symref_size);
+}
+
+size_t RefSnapshot::find(std::string_view name) const {
+  auto it = std::lower_bound(
+      refs_.begin(), refs_.end(), name, [this](const Ref &ref, std::string_view key) {
+        return text(ref.name, ref.name_size) < key;
+      });
+  if (it == refs_.end() || text(it->name, it->name_size) != name) {
+    return npos;
+  }
+  return static_cast<size_t>(it - refs_.begin());
+}
+
+std::pair<size_t, size_t>
+RefSnapshot::range(std::string_view prefix) const {
+  auto first = std::lower_bound(
+      refs_.begin(), refs_.end(), prefix,
+      [this](const Ref &ref, std::string_view key) {
+        return text(ref.name, ref.name_size) < key;
+      });
+  // Names with the prefix sort right after it, so they are contiguous
+  auto last = std::partition_point(first, refs_.end(), [&](const Ref &ref) {
+    return starts_with(text(ref.name, ref.name_size), prefix);
+  });
+  return {static_cast<size_t>(first - refs_.begin()),
+          static_cast<size_t>(last - refs_.begin())};
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace slayergit::core {
+
+// A ref as read from the store, before symrefs are resolved; defined in
+// ref_snapshot.cpp
+struct RefSource;
+
+// All refs of a repository at one point in time, read without running git:
+// packed-refs through mmap with loose refs under refs/ on top, or the
+// reftable stack when the repository uses one.
+//
+// Refs are sorted by name (byte order, as git sorts them) and stored as
+// fixed-size entries pointing into one string buffer, so a tab can page
+// through the refs/tags/ range of 60k refs by index without copying any of
+// them. Immutable once read, so safe to share between threads.
+class RefSnapshot {
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  struct Head {
+    std::string symref; // e.g. "refs/heads/main"; empty when detached
+    std::string oid;    // Empty on an unborn branch
+  };
+
+  // Throws SlayerGitException if `repo_path` is not a repository and
+  // ParseException if a ref store is malformed
+  static std::shared_ptr<const RefSnapshot> read(const std::string &repo_path);
+
+  [[nodiscard]] size_t size() const { return refs_.size(); }
+  [[nodiscard]] std::string_view name(size_t index) const;
+  // Hex object id; for a symref, that of the ref it points to (empty if
+  // that does not exist)
+  [[nodiscard]] std::string_view oid(size_t index) const;
+  // What an annotated tag points to, from packed-refs' `^` lines or the
+  // reftable; empty if not a tag or not recorded (loose refs)
+  [[nodiscard]] std::string_view peeled(size_t index) const;
+  // Target of a symbolic ref (e.g. refs/remotes/origin/HEAD); else empty
+  [[nodiscard]] std::string_view symref(size_t index) const;
+
+  // Index of `name`, or npos
+  [[nodiscard]] size_t find(std::string_view name) const;
+  // Indices [first, last) of the refs starting with `prefix`, e.g.
+  // "refs/tags/"
+  [[nodiscard]] std::pair<size_t, size_t> range(std::string_view prefix) const;
+
+  [[nodiscard]] const Head &head() const { return head_; }
+  [[nodiscard]] bool uses_reftable() const { return reftable_; }
+
+private:
+  // Offsets into strings_; a string is absent when its size is 0
+  struct Ref {
+    uint32_t name = 0;
+    uint32_t name_size = 0;
+    uint32_t oid = 0;
+    uint32_t peeled = 0;
+    uint32_t symref = 0;
+    uint16_t oid_size = 0;
+    uint16_t peeled_size = 0;
+    uint32_t symref_size = 0;
+  };
+
+  RefSnapshot() = default;
+
+  // `sources` sorted by name and free of duplicates
+  void build(const std::vector<RefSource> &sources);
+  uint32_t store(std::string_view text);
+  [[nodiscard]] std::string_view text(uint32_t offset, size_t size) const {
+    return std::string_view(strings_).substr(offset, size);
+  }
+
+  std::vector<Ref> refs_;
+  std::string strings_;
+  Head head_;
+  bool reftable_ = false;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,53 @@
+#include "refresh_log.hpp"
+
+#include "infra/exceptions.hpp"
+
+#include <algorithm>
+#include <ctime>
+
+namespace slayergit::core {
+
+RefreshLog::RefreshLog(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+void RefreshLog::set_output(const std::string &path) {
+  std::ofstream output(path, std::ios::app);
+  if (!output) {
+    throw SlayerGitException("cannot open " + path);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  output_ = std::move(output);
+}
+
+void RefreshLog::record(std::string what, std::string cause,
+                        std::chrono::steady_clock::duration duration) {
+  Entry entry;
+  entry.at = std::chrono::system_clock::now();
+  entry.what = std::move(what);
+  entry.cause = std::move(cause);
+  entry.duration =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (output_.is_open()) {
+    std::time_t at = std::chrono::system_clock::to_time_t(entry.at);
+    std::tm local{};
+    localtime_r(&at, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+    output_ << stamp << " refresh " << entry.what << " "
+            << entry.duration.count() / 1000.0 << "ms <- " << entry.cause
+            << std::endl;
+  }
+  entries_.push_front(std::move(entry));
+  if (entries_.size() > capacity_) {
+    entries_.pop_back();
+  }
+}
+
+std::vector<RefreshLog::Entry> RefreshLog::recent(size_t max_entries) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = std::min(max_entries, entries_.size());
+  return std::vector<Entry>(entries_.begin(), entries_.begin() + count);
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace slayergit::core {
+
+// The refreshes watch mode triggered, with what caused each and how long it
+// took, so automatic refreshes stay as visible as a manual F5. Keeps the
+// most recent entries for the profiler overlay and can append every entry
+// to a file. Thread-safe.
+class RefreshLog {
+public:
+  struct Entry {
+    std::chrono::system_clock::time_point at;
+    std::string what;  // e.g. "branches"
+    std::string cause; // e.g. "src/main.cpp (+41 more)"
+    std::chrono::microseconds duration{0};
+  };
+
+  explicit RefreshLog(size_t capacity = 32);
+
+  // Appends one line per entry to `path`. Throws SlayerGitException if it
+  // cannot be opened.
+  void set_output(const std::string &path);
+
+  void record(std::string what, std::string cause,
+              std::chrono::steady_clock::duration duration);
+
+  // Newest first
+  [[nodiscard]] std::vector<Entry> recent(size_t max_entries) const;
+
+private:
+  size_t capacity_;
+  mutable std::mutex mutex_;
+  std::deque<Entry> entries_;
+  std::ofstream output_;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,83 @@
+#include "refresh_slot.hpp"
+
+#include <mutex>
+
+namespace slayergit::core {
+
+struct RefreshSlot::State {
+  std::mutex mutex;
+  uint64_t generation = 0;
+  infra::CancellationSource source;
+  Stats stats;
+};
+
+RefreshSlot::RefreshSlot(infra::TaskExecutor &tasks,
+                         infra::TaskPriority priority)
+    : tasks_(tasks), priority_(priority), state_(std::make_shared<State>()) {}
+
+RefreshSlot::~RefreshSlot() { cancel(); }
+
+std::pair<uint64_t, infra::CancellationToken> RefreshSlot::begin() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->source.cancel();
+  state_->source = infra::CancellationSource();
+  ++state_->stats.requested;
+  return {++state_->generation, state_->source.token()};
+}
+
+void RefreshSlot::cancel() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->source.cancel();
+  // Anything still running is now stale
+  ++state_->generation;
+}
+
+void RefreshSlot::deliver(State &state, uint64_t generation,
+                          const std::function<void()> &publish) {
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!publish || generation != state.generation) {
+    ++state.stats.superseded;
+    return;
+  }
+  publish();
+  ++state.stats.published;
+}
+
+void RefreshSlot::fail(State &state, uint64_t generation,
+                       const std::exception &e,
+                       const ErrorCallback &on_error) {
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (generation != state.generation) {
+    ++state.stats.superseded;
+    return;
+  }
+  ++state.stats.failed;
+  if (on_error) {
+    on_error(e);
+  }
+}
+
+bool RefreshSlot::Progress::publish(const std::function<void()> &publish) const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (generation_ != state_->generation) {
+    return false;
+  }
+  publish();
+  return true;
+}
+
+uint64_t RefreshSlot::generation() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->generation;
+}
+
+bool RefreshSlot::is_current(uint64_t generation) const {
+  return this->generation() == generation;
+}
+
+RefreshSlot::Stats RefreshSlot::stats() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->stats;
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "infra/cancellation.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/task_executor.hpp"
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace slayergit::core {
+
+// One piece of refreshable data (the diff of the selected row, the status
+// list, ...). Each request() supersedes the previous one: its token is
+// cancelled, which kills its git process, and its result is dropped even
+// if it finishes anyway. Only the latest request is ever published.
+class RefreshSlot {
+  struct State;
+
+public:
+  struct Stats {
+    uint64_t requested = 0;
+    uint64_t published = 0;
+    uint64_t superseded = 0; // Cancelled, or finished after a newer request
+    uint64_t failed = 0;
+  };
+
+  using ErrorCallback = std::function<void(const std::exception &)>;
+
+  // Lets a load publish partial results (e.g. batches of a streamed list)
+  // before it finishes, under the same rule as the final result
+  class Progress {
+  public:
+    // Runs `publish` under the slot's lock if this request is still the
+    // latest; false once it has been superseded
+    bool publish(const std::function<void()> &publish) const;
+
+  private:
+    friend class RefreshSlot;
+    Progress(std::shared_ptr<State> state, uint64_t generation)
+        : state_(std::move(state)), generation_(generation) {}
+
+    std::shared_ptr<State> state_;
+    uint64_t generation_;
+  };
+
+  explicit RefreshSlot(
+      infra::TaskExecutor &tasks,
+      infra::TaskPriority priority = infra::TaskPriority::Focused);
+  // Cancels the outstanding request; queued work then finishes without
+  // publishing
+  ~RefreshSlot();
+
+  RefreshSlot(const RefreshSlot &) = delete;
+  RefreshSlot &operator=(const RefreshSlot &) = delete;
+
+  // Runs `load(token)` on the executor and hands its result to
+  // `publish`, unless a newer request arrived in the meantime. Pass the
+  // token to GitProcessExecutor so superseded git processes are killed.
+  // `publish` and `on_error` run on a worker under the slot's lock and
+  // should only store the result and wake the UI.
+  //
+  // A load that also takes a `const Progress &` may publish parts of its
+  // result while it runs.
+  template <typename Load, typename Publish>
+  uint64_t request(Load load, Publish publish, ErrorCallback on_error = {}) {
+    auto [generation, token] = begin();
+    auto state = state_;
+    tasks_.post(
+        [state, generation, token = std::move(token), load = std::move(load),
+         publish = std::move(publish),
+         on_error = std::move(on_error)]() mutable {
+          try {
+            token.throw_if_cancelled();
+            auto result = [&] {
+              if constexpr (std::is_invocable_v<Load &,
+                                                const infra::CancellationToken &,
+                                                const Progress &>) {
+                return load(token, Progress(state, generation));
+              } else {
+                return load(token);
+              }
+            }();
+            deliver(*state, generation, [&] { publish(std::move(result)); });
+          } catch (const CancelledException &) {
+            deliver(*state, generation, nullptr);
+          } catch (const std::exception &e) {
+            fail(*state, generation, e, on_error);
+          }
+        },
+        priority_);
+    return generation;
+  }
+
+  // Cancels the outstanding request without starting a new one
+  void cancel();
+
+  [[nodiscard]] uint64_t generation() const;
+  [[nodiscard]] bool is_current(uint64_t generation) const;
+  [[nodiscard]] Stats stats() const;
+
+private:
+  std::pair<uint64_t, infra::CancellationToken> begin();
+  static void deliver(State &state, uint64_t generation,
+                      const std::function<void()> &publish);
+  static void fail(State &state, uint64_t generation, const std::exception &e,
+                   const ErrorCallback &on_error);
+
+  infra::TaskExecutor &tasks_;
+  infra::TaskPriority priority_;
+  // Shared with queued tasks, which may outlive the slot
+  std::shared_ptr<State> state_;
+};
+
+} // namespace slayergit::core
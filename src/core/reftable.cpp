@@ -0,0 +1,200 @@
+#include "reftable.hpp"
+
+#include "core/commit_graph.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/mapped_file.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+namespace slayergit::core {
+
+namespace {
+
+constexpr uint32_t hash_id_sha1 = 0x73686131;   // "sha1"
+constexpr uint32_t hash_id_sha256 = 0x73323536; // "s256"
+
+enum ValueType : uint8_t {
+  Deletion = 0,
+  Value = 1,
+  ValueWithPeeled = 2,
+  Symref = 3,
+};
+
+struct Record {
+  uint8_t type = Deletion;
+  std::string oid; // Raw
+  std::string peeled;
+  std::string symref;
+};
+
+uint32_t read_be24(const uint8_t *data) {
+  return (uint32_t{data[0]} << 16) | (uint32_t{data[1]} << 8) | data[2];
+}
+
+class TableReader {
+public:
+  explicit TableReader(const std::string &path) : file_(path) {}
+
+  void read(std::unordered_map<std::string, Record> &records) {
+    const uint8_t *data = file_.data();
+    size_t size = file_.size();
+    if (size < 24 || std::string_view(reinterpret_cast<const char *>(data), 4) !=
+                         "REFT") {
+      fail("not a reftable");
+    }
+    uint8_t version = data[4];
+    if (version != 1 && version != 2) {
+      fail("unsupported version " + std::to_string(version));
+    }
+    size_t header_size = version == 1 ? 24 : 28;
+    size_t footer_size = version == 1 ? 68 : 72;
+    if (size < header_size + footer_size) {
+      fail("truncated");
+    }
+    size_t block_size = infra::read_be32(data + 4) & 0xffffff;
+    hash_size_ = 20;
+    if (version == 2) {
+      uint32_t hash_id = infra::read_be32(data + 24);
+      if (hash_id == hash_id_sha256) {
+        hash_size_ = 32;
+      } else if (hash_id != hash_id_sha1) {
+        fail("unknown hash id");
+      }
+    }
+
+    // Ref blocks come first; the first one's length counts the file header
+    size_t end = size - footer_size;
+    size_t block_start = 0;
+    while (true) {
+      size_t type_at = block_start == 0 ? header_size : block_start;
+      if (type_at + 4 > end || data[type_at] != 'r') {
+        break;
+      }
+      size_t block_len = read_be24(data + type_at + 1);
+      size_t block_end = block_start + block_len;
+      if (block_end > end || block_end < type_at + 4 + 2) {
+        fail("ref block out of bounds");
+      }
+      size_t restart_count = infra::read_be16(data + block_end - 2);
+      if (block_end - 2 - type_at - 4 < 3 * restart_count) {
+        fail("restart table out of bounds");
+      }
+      read_block(data + type_at + 4, data + block_end - 2 - 3 * restart_count,
+                 records);
+
+      // Aligned tables pad each block with zeros up to block_size
+      size_t next = block_end;
+      if (block_size != 0 && block_len < block_size && next < end &&
+          data[next] == 0) {
+        next = block_start + block_size;
+      }
+      block_start = next;
+    }
+  }
+
+private:
+  [[noreturn]] void fail(const std::string &message) const {
+    throw ParseException(file_.path() + ": " + message);
+  }
+
+  uint64_t read_varint(const uint8_t *&pos, const uint8_t *end) const {
+    if (pos >= end) {
+      fail("truncated record");
+    }
+    uint64_t value = *pos & 0x7f;
+    while ((*pos & 0x80) != 0) {
+      if (++pos >= end || value > (uint64_t{1} << 56)) {
+        fail("bad varint");
+      }
+      value = ((value + 1) << 7) | (*pos & 0x7f);
+    }
+    ++pos;
+    return value;
+  }
+
+  std::string read_bytes(const uint8_t *&pos, const uint8_t *end,
+                         uint64_t count) const {
+    if (count > static_cast<uint64_t>(end - pos)) {
+      fail("truncated record");
+    }
+    std::string bytes(reinterpret_cast<const char *>(pos), count);
+    pos += count;
+    return bytes;
+  }
+
+  // Each name shares a prefix with the one before it in the block
+  void read_block(const uint8_t *pos, const uint8_t *end,
+                  std::unordered_map<std::string, Record> &records) const {
+    std::string name;
+    while (pos < end) {
+      uint64_t prefix = read_varint(pos, end);
+      uint64_t suffix_and_type = read_varint(pos, end);
+      if (prefix > name.size()) {
+        fail("bad name prefix");
+      }
+      name.resize(prefix);
+      name += read_bytes(pos, end, suffix_and_type >> 3);
+      read_varint(pos, end); // update_index delta
+
+      Record record;
+      record.type = static_cast<uint8_t>(suffix_and_type & 7);
+      switch (record.type) {
+      case Deletion:
+        break;
+      case ValueWithPeeled:
+        record.oid = read_bytes(pos, end, hash_size_);
+        record.peeled = read_bytes(pos, end, hash_size_);
+        break;
+      case Value:
+        record.oid = read_bytes(pos, end, hash_size_);
+        break;
+      case Symref:
+        record.symref = read_bytes(pos, end, read_varint(pos, end));
+        break;
+      default:
+        fail("unknown value type");
+      }
+      records[name] = std::move(record);
+    }
+  }
+
+  infra::MappedFile file_;
+  size_t hash_size_ = 20;
+};
+
+} // namespace
+
+std::vector<ReftableRef> read_reftable_stack(const std::string &reftable_dir) {
+  std::unordered_map<std::string, Record> records;
+  std::ifstream list(reftable_dir + "/tables.list");
+  std::string table;
+  while (std::getline(list, table)) {
+    if (!table.empty()) {
+      TableReader(reftable_dir + "/" + table).read(records);
+    }
+  }
+
+  std::vector<ReftableRef> refs;
+  refs.reserve(records.size());
+  for (auto &[name, record] : records) {
+    if (record.type == Deletion) {
+      continue;
+    }
+    ReftableRef ref;
+    ref.name = name;
+    ref.oid = record.oid.empty() ? "" : CommitGraph::to_hex(record.oid);
+    ref.peeled = record.peeled.empty() ? "" : CommitGraph::to_hex(record.peeled);
+    ref.symref = std::move(record.symref);
+    refs.push_back(std::move(ref));
+  }
+  std::sort(refs.begin(), refs.end(),
+            [](const ReftableRef &a, const ReftableRef &b) {
+              return a.name < b.name;
+            });
+  return refs;
+}
+
+} // namespace slayergit::core
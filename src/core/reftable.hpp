@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace slayergit::core {
+
+// A ref from a reftable stack; object ids in hex
+struct ReftableRef {
+  std::string name;
+  std::string oid;
+  std::string peeled; // Empty unless the table recorded one
+  std::string symref; // Set instead of oid for symbolic refs
+};
+
+// The refs of the stack in `reftable_dir`, as listed (oldest first) in its
+// tables.list: newer tables override older ones and deletions hide the
+// ref. Only ref blocks are read; logs and indexes are skipped. Sorted by
+// name. Throws ParseException on a malformed table.
+std::vector<ReftableRef> read_reftable_stack(const std::string &reftable_dir);
+
+} // namespace slayergit::core
@@ -0,0 +1,365 @@
+#include "repo_watcher.hpp"
+
+#include "core/index_file.hpp"
+#include "infra/exceptions.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace slayergit::core {
+
+namespace {
+
+// Refs can be anything in packed-refs or a reftable
+constexpr uint32_t any_ref = RefreshBranches | RefreshTags | RefreshCommits |
+                             RefreshStashes;
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool ends_with(std::string_view text, std::string_view suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// `path` relative to `dir`, if it is inside it
+bool relative_to(std::string_view path, std::string_view dir,
+                 std::string_view &rel) {
+  if (dir.empty() || !starts_with(path, dir)) {
+    return false;
+  }
+  if (path.size() == dir.size()) {
+    rel = {};
+    return true;
+  }
+  if (path[dir.size()] != '/') {
+    return false;
+  }
+  rel = path.substr(dir.size() + 1);
+  return true;
+}
+
+bool under(std::string_view rel, std::string_view dir) {
+  return rel == dir || (starts_with(rel, dir) && rel.size() > dir.size() &&
+                        rel[dir.size()] == '/');
+}
+
+// Files of one worktree's git dir
+uint32_t classify_worktree_git_file(std::string_view rel) {
+  if (rel == "HEAD") {
+    // Checkout: what is staged and the history shown both follow HEAD
+    return RefreshStatus | RefreshBranches | RefreshCommits;
+  }
+  if (rel == "index" || rel == "MERGE_HEAD" || rel == "CHERRY_PICK_HEAD" ||
+      rel == "REVERT_HEAD" || under(rel, "rebase-merge") ||
+      under(rel, "rebase-apply")) {
+    return RefreshStatus;
+  }
+  if (rel == "logs/HEAD") {
+    return RefreshReflog;
+  }
+  return 0;
+}
+
+// Files shared by all worktrees
+uint32_t classify_common_file(std::string_view rel) {
+  if (rel == "packed-refs" || under(rel, "reftable")) {
+    return any_ref;
+  }
+  if (under(rel, "refs/heads")) {
+    return RefreshBranches | RefreshCommits;
+  }
+  if (under(rel, "refs/remotes")) {
+    return RefreshBranches;
+  }
+  if (under(rel, "refs/tags")) {
+    return RefreshTags;
+  }
+  if (rel == "refs/stash" || rel == "logs/refs/stash") {
+    return RefreshStashes;
+  }
+  if (rel == "config") {
+    return RefreshBranches; // Upstreams
+  }
+  if (rel == "info/exclude") {
+    return RefreshStatus;
+  }
+  return 0;
+}
+
+} // namespace
+
+std::string describe_scopes(uint32_t scopes) {
+  static const std::pair<RefreshScope, const char *> names[] = {
+      {RefreshStatus, "status"},   {RefreshBranches, "branches"},
+      {RefreshCommits, "commits"}, {RefreshReflog, "reflog"},
+      {RefreshStashes, "stashes"}, {RefreshTags, "tags"},
+  };
+  std::string text;
+  for (const auto &[scope, name] : names) {
+    if ((scopes & scope) != 0) {
+      text += text.empty() ? "" : ", ";
+      text += name;
+    }
+  }
+  return text;
+}
+
+uint32_t classify_change(const infra::GitDirs &dirs, std::string_view path) {
+  if (path.empty()) {
+    return RefreshAll; // Events were lost
+  }
+  if (ends_with(path, ".lock")) {
+    return 0;
+  }
+  // The git dir usually sits inside the work tree, so it is checked first
+  std::string_view rel;
+  if (relative_to(path, dirs.git_dir, rel)) {
+    uint32_t scopes = classify_worktree_git_file(rel);
+    if (scopes != 0 || dirs.git_dir != dirs.common_dir) {
+      return scopes;
+    }
+  }
+  if (relative_to(path, dirs.common_dir, rel)) {
+    return classify_common_file(rel);
+  }
+  if (relative_to(path, dirs.work_tree, rel)) {
+    return RefreshStatus;
+  }
+  return 0;
+}
+
+RepoWatcher::RepoWatcher(const std::string &repo_path)
+    : RepoWatcher(repo_path, Options()) {}
+
+RepoWatcher::RepoWatcher(const std::string &repo_path, Options options)
+    : dirs_(infra::resolve_git_dirs(repo_path)), options_(std::move(options)) {}
+
+RepoWatcher::~RepoWatcher() { stop(); }
+
+void RepoWatcher::start(Handler handler) {
+  stop();
+  handler_ = std::move(handler);
+
+  // Objects are never watched: writing them changes nothing shown until a
+  // ref or the index points at them
+  const std::string &git_dir = dirs_.git_dir;
+  const std::string &common = dirs_.common_dir;
+  watcher_.add(git_dir, false);
+  watcher_.add(git_dir + "/logs", false);
+  if (common != git_dir) {
+    watcher_.add(common, false);
+  }
+  watcher_.add(common + "/refs", true);
+  watcher_.add(common + "/logs", true);
+  watcher_.add(common + "/reftable", false);
+  watcher_.add(common + "/info", false);
+  rules_.clear();
+  tracked_stale_ = true;
+  if (!dirs_.work_tree.empty()) {
+    watcher_.add(dirs_.work_tree, true, [this](const std::string &dir) {
+      return dir == dirs_.git_dir ||
+             std::filesystem::path(dir).filename() == ".git" ||
+             ignored_change(dir + "/");
+    });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = false;
+    pending_ = {};
+    stats_.watches = watcher_.watch_count();
+    stats_.watch_limit_reached = watcher_.limit_reached();
+  }
+  watcher_.start(
+      [this](const std::vector<std::string> &paths) { on_paths(paths); });
+  dispatcher_ = std::thread([this] { dispatch_loop(); });
+}
+
+void RepoWatcher::stop() {
+  watcher_.stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  if (dispatcher_.joinable()) {
+    dispatcher_.join();
+  }
+}
+
+RepoWatcher::Stats RepoWatcher::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.watches = watcher_.watch_count();
+  stats.watch_limit_reached = watcher_.limit_reached();
+  return stats;
+}
+
+void RepoWatcher::on_paths(const std::vector<std::string> &paths) {
+  auto now = std::chrono::steady_clock::now();
+  // Rules and the index first: a change to them is not ignored itself
+  for (const auto &path : paths) {
+    if (path.empty() || path == dirs_.git_dir + "/index") {
+      tracked_stale_ = true;
+    }
+    if (path.empty() || ends_with(path, "/.gitignore") ||
+        path == dirs_.common_dir + "/info/exclude" ||
+        path == options_.excludes_file) {
+      rules_.clear();
+    }
+  }
+  std::vector<uint32_t> scopes_of;
+  scopes_of.reserve(paths.size());
+  for (const auto &path : paths) {
+    scopes_of.push_back(ignored_change(path) ? 0
+                                             : classify_change(dirs_, path));
+  }
+
+  bool relevant = false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    const std::string &path = paths[i];
+    uint32_t scopes = scopes_of[i];
+    ++stats_.events;
+    if (scopes == 0) {
+      ++stats_.ignored;
+      continue;
+    }
+    if (pending_.scopes == 0) {
+      first_change_ = now;
+      std::string_view rel;
+      pending_.cause = relative_to(path, dirs_.work_tree, rel) && !rel.empty()
+                           ? std::string(rel)
+                           : path;
+    }
+    pending_.scopes |= scopes;
+    ++pending_.events;
+    last_change_ = now;
+    relevant = true;
+  }
+  if (relevant) {
+    changed_.notify_all();
+  }
+}
+
+bool RepoWatcher::ignored_change(std::string_view path) {
+  std::string_view rel;
+  if (relative_to(path, dirs_.git_dir, rel) ||
+      relative_to(path, dirs_.common_dir, rel) ||
+      !relative_to(path, dirs_.work_tree, rel)) {
+    return false;
+  }
+  bool is_dir = ends_with(rel, "/");
+  if (is_dir) {
+    rel.remove_suffix(1);
+  }
+  return !rel.empty() && ignored(rel, is_dir);
+}
+
+bool RepoWatcher::ignored(std::string_view rel, bool is_dir) {
+  if (tracked_stale_) {
+    load_tracked();
+  }
+  std::hash<std::string_view> hash;
+  if (!tracked_known_ || tracked_.count(hash(rel)) != 0) {
+    return false;
+  }
+  // Nothing below an ignored directory is shown unless it is tracked, so
+  // the first ignored component decides
+  for (size_t start = 0;;) {
+    size_t slash = rel.find('/', start);
+    if (rules_for(std::string(rel.substr(0, start)))
+            ->ignored(rel.substr(0, slash), is_dir || slash != rel.npos)) {
+      return true;
+    }
+    if (slash == rel.npos) {
+      return false;
+    }
+    start = slash + 1;
+  }
+}
+
+const std::shared_ptr<const IgnoreStack> &
+RepoWatcher::rules_for(const std::string &dir) {
+  auto found = rules_.find(dir);
+  if (found != rules_.end()) {
+    return found->second;
+  }
+  std::shared_ptr<const IgnoreStack> rules;
+  if (dir.empty()) {
+    // core.excludesFile loses to info/exclude, which loses to any .gitignore
+    if (!options_.excludes_file.empty()) {
+      rules = std::make_shared<IgnoreStack>(
+          IgnoreRules::read(options_.excludes_file, ""), rules);
+    }
+    rules = std::make_shared<IgnoreStack>(
+        IgnoreRules::read(dirs_.common_dir + "/info/exclude", ""), rules);
+  } else {
+    size_t slash = dir.rfind('/', dir.size() - 2);
+    rules =
+        rules_for(slash == std::string::npos ? "" : dir.substr(0, slash + 1));
+  }
+  IgnoreRules own =
+      IgnoreRules::read(dirs_.work_tree + "/" + dir + ".gitignore", dir);
+  if (!own.empty()) {
+    rules = std::make_shared<IgnoreStack>(std::move(own), rules);
+  }
+  return rules_.emplace(dir, std::move(rules)).first->second;
+}
+
+void RepoWatcher::load_tracked() {
+  tracked_stale_ = false;
+  tracked_.clear();
+  std::shared_ptr<const IndexFile> index;
+  try {
+    index = IndexFile::read(dirs_.git_dir + "/index", options_.algorithm);
+  } catch (const SlayerGitException &) {
+    // A split or corrupt index: filter nothing rather than miss a change
+    tracked_known_ = false;
+    return;
+  }
+  std::hash<std::string_view> hash;
+  for (const auto &entry : index->entries()) {
+    std::string_view path = entry.path;
+    if (ends_with(path, "/")) {
+      path.remove_suffix(1); // Sparse directory
+    }
+    tracked_.insert(hash(path));
+    // A directory already in has the ones above it in too
+    size_t slash = path.rfind('/');
+    while (slash != std::string_view::npos &&
+           tracked_.insert(hash(path.substr(0, slash))).second) {
+      slash = slash == 0 ? std::string_view::npos : path.rfind('/', slash - 1);
+    }
+  }
+  tracked_known_ = true;
+}
+
+void RepoWatcher::dispatch_loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [this] { return stopping_ || pending_.scopes != 0; });
+    // Every new change pushes the deadline back, up to max_delay
+    while (!stopping_) {
+      auto deadline = std::min(last_change_ + options_.debounce,
+                               first_change_ + options_.max_delay);
+      if (std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+      changed_.wait_until(lock, deadline);
+    }
+    if (stopping_) {
+      return;
+    }
+    Change change = std::move(pending_);
+    pending_ = {};
+    ++stats_.dispatched;
+    lock.unlock();
+    handler_(change);
+    lock.lock();
+  }
+}
+
+} // namespace slayergit::core
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "core/ignore_rules.hpp"
+#include "core/object_hash.hpp"
+#include "infra/fs_watcher.hpp"
+#include "infra/git_dir.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace slayergit::core {
+
+// What a change on disk makes stale, as the refresh_*() call covering it
+enum RefreshScope : uint32_t {
+  RefreshStatus = 1 << 0,
+  RefreshBranches = 1 << 1, // Local and remote branches
+  RefreshCommits = 1 << 2,
+  RefreshReflog = 1 << 3,
+  RefreshStashes = 1 << 4,
+  RefreshTags = 1 << 5,
+  RefreshAll = (1 << 6) - 1,
+};
+
+// "status, branches"
+std::string describe_scopes(uint32_t scopes);
+
+// Scopes affected by a change to `path` (absolute), or 0 if none: the index
+// maps to status, refs/heads to branches and commits, logs/HEAD to the
+// reflog, any work tree file to status, and so on. Lock files and objects
+// map to 0; the rename that completes a write reports the real file.
+uint32_t classify_change(const infra::GitDirs &dirs, std::string_view path);
+
+// Opt-in watch mode: watches the git dir (HEAD, index, refs, logs) and the
+// work tree with inotify, and turns bursts of changes into one call of the
+// handler with the union of their scopes.
+//
+// A burst ends after `debounce` without a relevant change, or `max_delay`
+// after its first one, whichever comes first, so a long-running checkout
+// still refreshes now and then. The handler runs on the watcher's own
+// thread.
+//
+// Work tree paths that .gitignore, info/exclude or core.excludesFile
+// ignore, and that the index does not track, are dropped before they are
+// classified, and ignored directories without tracked files are not
+// watched, so an in-tree build does not refresh status. A directory that
+// stops being ignored is watched from the next start().
+class RepoWatcher {
+public:
+  struct Options {
+    std::chrono::milliseconds debounce{150};
+    std::chrono::milliseconds max_delay{1000};
+    std::string excludes_file;                     // As excludes_file_path()
+    HashAlgorithm algorithm = HashAlgorithm::Sha1; // Of the index
+  };
+
+  struct Change {
+    uint32_t scopes = 0;
+    std::string cause; // First relevant path of the burst
+    size_t events = 0; // Relevant changes merged into this one
+  };
+  using Handler = std::function<void(const Change &change)>;
+
+  struct Stats {
+    uint64_t events = 0;
+    uint64_t ignored = 0; // Changes no refresh depends on, gitignored too
+    uint64_t dispatched = 0;
+    size_t watches = 0;
+    bool watch_limit_reached = false;
+  };
+
+  explicit RepoWatcher(const std::string &repo_path);
+  RepoWatcher(const std::string &repo_path, Options options);
+  ~RepoWatcher();
+
+  RepoWatcher(const RepoWatcher &) = delete;
+  RepoWatcher &operator=(const RepoWatcher &) = delete;
+
+  // Adds the watches and starts dispatching. Throws SlayerGitException
+  // where inotify is unavailable.
+  void start(Handler handler);
+  void stop();
+
+  [[nodiscard]] Stats stats() const;
+
+private:
+  void on_paths(const std::vector<std::string> &paths);
+  void dispatch_loop();
+
+  // Whether `path` (absolute) is in the work tree and ignored, holding
+  // nothing tracked
+  bool ignored_change(std::string_view path);
+  // The same for `rel`, relative to the work tree without a trailing '/'
+  bool ignored(std::string_view rel, bool is_dir);
+  // The rules in effect in `dir` ("" or ending with '/'), read once
+  const std::shared_ptr<const IgnoreStack> &rules_for(const std::string &dir);
+  void load_tracked();
+
+  infra::GitDirs dirs_;
+  Options options_;
+  Handler handler_;
+  infra::FsWatcher watcher_;
+
+  // Used by the watcher's thread, and by start() before it runs
+  std::unordered_map<std::string, std::shared_ptr<const IgnoreStack>> rules_;
+  // Hashes of the tracked paths and the directories above them; a
+  // collision only costs a refresh
+  std::unordered_set<size_t> tracked_;
+  bool tracked_stale_ = true;
+  bool tracked_known_ = false; // The index could be read
+
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  Change pending_;
+  std::chrono::steady_clock::time_point first_change_;
+  std::chrono::steady_clock::time_point last_change_;
+  bool stopping_ = false;
+  Stats stats_;
+  std::thread dispatcher_;
+};
+
+} // namespace slayergit::core
@@ -0,0 +1,427 @@
+#include "untracked.hpp"
+
+#include "infra/exceptions.hpp"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace slayergit::core {
+
+namespace {
+
+// Idle threads yield this many times before they start sleeping
+constexpr int idle_spins = 64;
+constexpr auto idle_sleep = std::chrono::microseconds(50);
+
+constexpr std::string_view gitlink_mode = "160000";
+
+struct DirEntry {
+  std::string name;
+  bool is_dir = false;
+  bool is_file = false; // Regular file or symlink; others are skipped
+};
+
+bool exists(const std::string &path) {
+  struct stat st;
+  return ::lstat(path.c_str(), &st) == 0;
+}
+
+// Entries of `path` other than "." and ".."; false if it cannot be read
+bool read_dir(const std::string &path, std::vector<DirEntry> &entries) {
+  DIR *dir = ::opendir(path.c_str());
+  if (dir == nullptr) {
+    return false;
+  }
+  while (const dirent *entry = ::readdir(dir)) {
+    std::string_view name = entry->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    DirEntry result{std::string(name)};
+    unsigned char type = entry->d_type;
+    if (type == DT_UNKNOWN) {
+      struct stat st;
+      if (::lstat((path + "/" + result.name).c_str(), &st) != 0) {
+        continue;
+      }
+      type = S_ISDIR(st.st_mode)   ? DT_DIR
+             : S_ISREG(st.st_mode) ? DT_REG
+             : S_ISLNK(st.st_mode) ? DT_LNK
+                                   : DT_UNKNOWN;
+    }
+    result.is_dir = type == DT_DIR;
+    result.is_file = type == DT_REG || type == DT_LNK;
+    entries.push_back(std::move(result));
+  }
+  ::closedir(dir);
+  return true;
+}
+
+} // namespace
+
+std::vector<std::string>
+list_tracked_paths(infra::GitProcessExecutor &executor,
+                   const infra::CancellationToken &token) {
+  auto result = executor.execute({"ls-files", "-z", "--stage"}, token);
+  if (result.exit_code != 0) {
+    throw GitCommandException("git ls-files", result.exit_code,
+                              result.stderr_output);
+  }
+  // "<mode> <oid> <stage>\t<path>\0"; a conflict lists a path per stage
+  std::vector<std::string> paths;
+  std::string_view rest = result.stdout_output;
+  while (!rest.empty()) {
+    size_t end = rest.find('\0');
+    std::string_view entry = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    size_t tab = entry.find('\t');
+    if (tab == std::string_view::npos) {
+      throw ParseException("unexpected ls-files entry");
+    }
+    std::string path(entry.substr(tab + 1));
+    if (entry.compare(0, gitlink_mode.size(), gitlink_mode) == 0) {
+      path += '/'; // Submodule
+    }
+    if (paths.empty() || paths.back() != path) {
+      paths.push_back(std::move(path));
+    }
+  }
+  return paths;
+}
+
+std::vector<std::string> list_tracked_paths(const IndexFile &index) {
+  std::vector<std::string> paths;
+  paths.reserve(index.size());
+  for (const auto &entry : index.entries()) {
+    std::string path(entry.path);
+    if ((entry.mode & 0170000) == 0160000) {
+      path += '/'; // Submodule
+    }
+    if (paths.empty() || paths.back() != path) {
+      paths.push_back(std::move(path));
+    }
+  }
+  return paths;
+}
+
+std::string excludes_file_path(infra::GitProcessExecutor &executor) {
+  auto result = executor.execute({"config", "--path", "core.excludesFile"});
+  std::string path = result.stdout_output;
+  while (!path.empty() && (path.back() == '\n' || path.back() == '\r')) {
+    path.pop_back();
+  }
+  if (!path.empty()) {
+    return path;
+  }
+  if (const char *xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg) {
+    return std::string(xdg) + "/git/ignore";
+  }
+  if (const char *home = std::getenv("HOME"); home && *home) {
+    return std::string(home) + "/.config/git/ignore";
+  }
+  return {};
+}
+
+// One walk over part of the work tree. Each thread owns a queue of
+// directories: it takes the newest from its own, depth first, and steals
+// the oldest, which root the largest unexplored subtrees, from others.
+struct UntrackedScanner::Walk {
+  struct Task {
+    std::string dir; // Relative, "" or ending with '/'
+    std::shared_ptr<const IgnoreStack> rules;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::vector<std::string> found;
+  };
+
+  UntrackedScanner &scanner;
+  const infra::CancellationToken &token;
+  std::string work_tree;
+  bool collapse = true;
+  bool recursive = true;
+  // Views into the caller's tracked paths
+  std::unordered_set<std::string_view> files;
+  std::unordered_set<std::string_view> dirs;
+  std::deque<Queue> queues;
+  std::atomic<size_t> pending{0};
+  std::atomic<bool> cancelled{false};
+
+  Walk(UntrackedScanner &scanner, const infra::CancellationToken &token,
+       std::string work_tree, const std::vector<std::string> &tracked)
+      : scanner(scanner), token(token), work_tree(std::move(work_tree)) {
+    files.reserve(tracked.size());
+    for (const auto &path : tracked) {
+      std::string_view view = path;
+      files.insert(view);
+      // Every directory above the path; a submodule's own '/' is not one
+      for (size_t slash = view.find('/');
+           slash != std::string_view::npos && slash + 1 < view.size();
+           slash = view.find('/', slash + 1)) {
+        dirs.insert(view.substr(0, slash));
+      }
+    }
+  }
+
+  void push(size_t self, Task task) {
+    ++pending;
+    Queue &queue = queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+
+  bool pop(size_t self, Task &task) {
+    {
+      Queue &own = queues[self];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty()) {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+      }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+      Queue &other = queues[(self + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(other.mutex);
+      if (!other.tasks.empty()) {
+        task = std::move(other.tasks.front());
+        other.tasks.pop_front();
+        ++scanner.steals_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void run(size_t self) {
+    int idle = 0;
+    Task task;
+    while (true) {
+      if (!pop(self, task)) {
+        if (pending == 0) {
+          return;
+        }
+        if (++idle < idle_spins) {
+          std::this_thread::yield();
+        } else {
+          std::this_thread::sleep_for(idle_sleep);
+        }
+        continue;
+      }
+      idle = 0;
+      if (!cancelled && token.cancelled()) {
+        cancelled = true;
+      }
+      if (!cancelled) {
+        visit(self, task);
+      }
+      --pending;
+    }
+  }
+
+  // Reads `dir`, adding its .gitignore on top of `rules`
+  bool open(const std::string &dir, std::shared_ptr<const IgnoreStack> &rules,
+            std::vector<DirEntry> &entries) {
+    ++scanner.directories_;
+    std::string path = work_tree + "/" + dir;
+    if (!read_dir(path, entries)) {
+      return false;
+    }
+    bool has_ignore_file =
+        std::any_of(entries.begin(), entries.end(), [](const DirEntry &entry) {
+          return !entry.is_dir && entry.name == ".gitignore";
+        });
+    if (has_ignore_file) {
+      ++scanner.ignore_files_;
+      rules = std::make_shared<IgnoreStack>(
+          IgnoreRules::read(path + ".gitignore", dir), rules);
+    }
+    return true;
+  }
+
+  bool is_nested_repo(const std::string &rel) const {
+    return exists(work_tree + "/" + rel + "/.git");
+  }
+
+  void visit(size_t self, const Task &task) {
+    std::shared_ptr<const IgnoreStack> rules = task.rules;
+    std::vector<DirEntry> entries;
+    if (!open(task.dir, rules, entries)) {
+      return;
+    }
+    auto &found = queues[self].found;
+    for (const auto &entry : entries) {
+      if (entry.name == ".git") {
+        continue;
+      }
+      std::string rel = task.dir + entry.name;
+      if (entry.is_dir) {
+        if (files.count(rel + "/") != 0 || rules->ignored(rel, true)) {
+          continue; // A submodule, or ignored with everything in it
+        }
+        if (dirs.count(rel) != 0) {
+          push(self, {rel + "/", rules});
+        } else if (is_nested_repo(rel)) {
+          found.push_back(rel + "/");
+        } else if (collapse || !recursive) {
+          if (contains_shown(rel + "/", rules)) {
+            found.push_back(rel + "/");
+          }
+        } else {
+          push(self, {rel + "/", rules});
+        }
+      } else if (entry.is_file && files.count(rel) == 0 &&
+                 !rules->ignored(rel, false)) {
+        found.push_back(std::move(rel));
+      }
+    }
+  }
+
+  // Whether an untracked directory holds anything status would show; stops
+  // at the first such entry
+  bool contains_shown(const std::string &dir,
+                      std::shared_ptr<const IgnoreStack> rules) {
+    std::vector<DirEntry> entries;
+    if (cancelled || !open(dir, rules, entries)) {
+      return false;
+    }
+    // Files first: they need no further reads
+    std::stable_partition(entries.begin(), entries.end(),
+                          [](const DirEntry &entry) { return !entry.is_dir; });
+    for (const auto &entry : entries) {
+      if (entry.name == ".git") {
+        continue;
+      }
+      std::string rel = dir + entry.name;
+      if (entry.is_file && !rules->ignored(rel, false)) {
+        return true;
+      }
+      if (entry.is_dir && !rules->ignored(rel, true) &&
+          (is_nested_repo(rel) || contains_shown(rel + "/", rules))) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+UntrackedScanner::UntrackedScanner(const std::string &repo_path)
+    : UntrackedScanner(repo_path, Options()) {}
+
+UntrackedScanner::UntrackedScanner(const std::string &repo_path,
+                                   Options options)
+    : repo_path_(repo_path), options_(std::move(options)) {}
+
+infra::GitDirs UntrackedScanner::resolve_dirs() const {
+  infra::GitDirs dirs = infra::resolve_git_dirs(repo_path_);
+  if (dirs.work_tree.empty()) {
+    throw SlayerGitException("untracked files need a work tree");
+  }
+  return dirs;
+}
+
+std::shared_ptr<const IgnoreStack>
+UntrackedScanner::rules_for(const infra::GitDirs &dirs,
+                            const std::string &dir) const {
+  // core.excludesFile loses to info/exclude, which loses to any .gitignore
+  std::shared_ptr<const IgnoreStack> rules;
+  if (!options_.excludes_file.empty()) {
+    rules = std::make_shared<IgnoreStack>(
+        IgnoreRules::read(options_.excludes_file, ""), rules);
+  }
+  rules = std::make_shared<IgnoreStack>(
+      IgnoreRules::read(dirs.common_dir + "/info/exclude", ""), rules);
+  // .gitignore files of the directories above `dir`; its own is read by
+  // the walk
+  for (size_t slash = 0; slash != std::string::npos;
+       slash = dir.find('/', slash + 1)) {
+    std::string parent = slash == 0 ? "" : dir.substr(0, slash + 1);
+    if (parent == dir) {
+      break;
+    }
+    IgnoreRules parent_rules =
+        IgnoreRules::read(dirs.work_tree + "/" + parent + ".gitignore", parent);
+    if (!parent_rules.empty()) {
+      rules = std::make_shared<IgnoreStack>(std::move(parent_rules), rules);
+    }
+  }
+  return rules;
+}
+
+std::vector<std::string>
+UntrackedScanner::walk(const std::vector<std::string> &tracked,
+                       const std::string &start, bool collapse, bool recursive,
+                       const infra::CancellationToken &token) {
+  infra::GitDirs dirs = resolve_dirs();
+  Walk walk(*this, token, dirs.work_tree, tracked);
+  walk.collapse = collapse;
+  walk.recursive = recursive;
+  size_t threads = options_.threads != 0
+                       ? options_.threads
+                       : std::max(1u, std::thread::hardware_concurrency());
+  if (!recursive) {
+    threads = 1;
+  }
+  walk.queues.resize(threads);
+  walk.push(0, {start, rules_for(dirs, start)});
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < threads; ++i) {
+    workers.emplace_back([&walk, i] { walk.run(i); });
+  }
+  walk.run(0);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  token.throw_if_cancelled();
+
+  std::vector<std::string> found;
+  for (auto &queue : walk.queues) {
+    found.insert(found.end(), std::make_move_iterator(queue.found.begin()),
+                 std::make_move_iterator(queue.found.end()));
+  }
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+std::vector<std::string>
+UntrackedScanner::scan(const std::vector<std::string> &tracked,
+                       const infra::CancellationToken &token) {
+  return walk(tracked, "", true, true, token);
+}
+
+std::vector<std::string>
+UntrackedScanner::scan_all(const std::vector<std::string> &tracked,
+                           const infra::CancellationToken &token) {
+  return walk(tracked, "", false, true, token);
+}
+
+std::vector<std::string>
+UntrackedScanner::expand(const std::string &dir,
+                         const infra::CancellationToken &token) {
+  if (exists(resolve_dirs().work_tree + "/" + dir + ".git")) {
+    return {};
+  }
+  // Nothing below an untracked directory is tracked
+  return walk({}, dir, true, false, token);
+}
+
+UntrackedScanner::Stats UntrackedScanner::stats() const {
+  Stats stats;
+  stats.directories = directories_;
+  stats.ignore_files = ignore_files_;
+  stats.steals = steals_;
+  return stats;
+}
+
+} // namespace slayergit::core
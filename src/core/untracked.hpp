@@ -0,0 +1,91 @@
+#pragma once
+
+#include "core/ignore_rules.hpp"
+#include "core/index_file.hpp"
+#include "infra/cancellation.hpp"
+#include "infra/git_dir.hpp"
+#include "infra/git_process_executor.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace slayergit::core {
+
+// Paths in the index, as `git ls-files` lists them
+std::vector<std::string> list_tracked_paths(infra::GitProcessExecutor &executor,
+                                            const infra::CancellationToken &token);
+
+// The same, from an index already read
+std::vector<std::string> list_tracked_paths(const IndexFile &index);
+
+// core.excludesFile, or git's default under $XDG_CONFIG_HOME or ~/.config;
+// empty if there is none
+std::string excludes_file_path(infra::GitProcessExecutor &executor);
+
+// Lists untracked files without `git status`: walks the work tree on
+// several threads, each taking directories from its own queue and stealing
+// from the others' when it runs dry, and skips what the .gitignore files,
+// info/exclude and core.excludesFile ignore. The threads are its own: the
+// TaskExecutor's workers may be the ones waiting for the scan.
+//
+// Like `git status --untracked-files=normal`, a directory with no tracked
+// files is listed once as "dir/" if anything in it would be shown; expand()
+// lists what is inside when the user opens it. Paths are relative to the
+// work tree and sorted bytewise; directories end with '/'.
+class UntrackedScanner {
+public:
+  struct Options {
+    size_t threads = 0; // 0: one per core
+    std::string excludes_file;
+  };
+
+  struct Stats {
+    size_t directories = 0; // Read, including those only checked for content
+    size_t ignore_files = 0;
+    size_t steals = 0;      // Directories a thread took from another's queue
+  };
+
+  explicit UntrackedScanner(const std::string &repo_path);
+  UntrackedScanner(const std::string &repo_path, Options options);
+
+  // `tracked` is the index, as list_tracked_paths() returns it. Throws
+  // CancelledException when `token` is cancelled, and SlayerGitException
+  // for a bare repository.
+  std::vector<std::string> scan(const std::vector<std::string> &tracked,
+                                const infra::CancellationToken &token);
+  // Every untracked file, with no directory collapsed, as
+  // `--untracked-files=all` lists them
+  std::vector<std::string> scan_all(const std::vector<std::string> &tracked,
+                                    const infra::CancellationToken &token);
+  // The entries directly inside `dir`, an untracked directory scan()
+  // returned, collapsed the same way; none for a nested repository
+  std::vector<std::string> expand(const std::string &dir,
+                                  const infra::CancellationToken &token);
+
+  [[nodiscard]] Stats stats() const;
+
+private:
+  struct Walk;
+
+  std::vector<std::string> walk(const std::vector<std::string> &tracked,
+                                const std::string &start, bool collapse,
+                                bool recursive,
+                                const infra::CancellationToken &token);
+  // The rules in effect in `dir` (relative, ending with '/'), reading every
+  // .gitignore on the way down from the root
+  std::shared_ptr<const IgnoreStack> rules_for(const infra::GitDirs &dirs,
+                                               const std::string &dir) const;
+  [[nodiscard]] infra::GitDirs resolve_dirs() const;
+
+  std::string repo_path_;
+  Options options_;
+
+  std::atomic<size_t> directories_{0};
+  std::atomic<size_t> ignore_files_{0};
+  std::atomic<size_t> steals_{0};
+};
+
+} // namespace slayergit::core
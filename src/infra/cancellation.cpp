@@ -0,0 +1,92 @@
+#include "cancellation.hpp"
+
+#include "exceptions.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace slayergit::infra {
+
+namespace detail {
+
+struct CancellationState {
+  std::atomic<bool> cancelled{false};
+  std::mutex mutex;
+  uint64_t next_id = 1;
+  std::unordered_map<uint64_t, std::function<void()>> callbacks;
+};
+
+} // namespace detail
+
+CancellationToken::Registration::Registration(Registration &&other) noexcept
+    : state_(std::move(other.state_)), id_(other.id_) {}
+
+CancellationToken::Registration &
+CancellationToken::Registration::operator=(Registration &&other) noexcept {
+  if (this != &other) {
+    reset();
+    state_ = std::move(other.state_);
+    id_ = other.id_;
+  }
+  return *this;
+}
+
+void CancellationToken::Registration::reset() {
+  if (state_) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->callbacks.erase(id_);
+  }
+  state_.reset();
+}
+
+bool CancellationToken::cancelled() const {
+  return state_ && state_->cancelled.load(std::memory_order_acquire);
+}
+
+void CancellationToken::throw_if_cancelled() const {
+  if (cancelled()) {
+    throw CancelledException();
+  }
+}
+
+CancellationToken::Registration
+CancellationToken::on_cancel(std::function<void()> callback) const {
+  if (!state_) {
+    return {};
+  }
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (state_->cancelled) {
+    callback();
+    return {};
+  }
+  uint64_t id = state_->next_id++;
+  state_->callbacks.emplace(id, std::move(callback));
+  return Registration(state_, id);
+}
+
+CancellationSource::CancellationSource()
+    : state_(std::make_shared<detail::CancellationState>()) {}
+
+CancellationToken CancellationSource::token() const {
+  return CancellationToken(state_);
+}
+
+void CancellationSource::cancel() {
+  // Callbacks run under the lock so that a Registration being destroyed
+  // concurrently waits for them to finish
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (state_->cancelled.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  for (auto &[id, callback] : state_->callbacks) {
+    callback();
+  }
+  state_->callbacks.clear();
+}
+
+bool CancellationSource::cancelled() const {
+  return state_->cancelled.load(std::memory_order_acquire);
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace slayergit::infra {
+
+namespace detail {
+struct CancellationState;
+}
+
+// Read side of a cancellation flag. A default-constructed token is never
+// cancelled, so APIs can take one unconditionally.
+class CancellationToken {
+public:
+  // Unregisters its callback when destroyed; once that returns, the
+  // callback is not running and will not run
+  class Registration {
+  public:
+    Registration() = default;
+    ~Registration() { reset(); }
+
+    Registration(const Registration &) = delete;
+    Registration &operator=(const Registration &) = delete;
+    Registration(Registration &&other) noexcept;
+    Registration &operator=(Registration &&other) noexcept;
+
+    void reset();
+
+  private:
+    friend class CancellationToken;
+    Registration(std::shared_ptr<detail::CancellationState> state,
+                 uint64_t id)
+        : state_(std::move(state)), id_(id) {}
+
+    std::shared_ptr<detail::CancellationState> state_;
+    uint64_t id_ = 0;
+  };
+
+  CancellationToken() = default;
+
+  [[nodiscard]] bool cancelled() const;
+  // Throws CancelledException
+  void throw_if_cancelled() const;
+
+  // `callback` runs once, on the thread that cancels (or right here if
+  // already cancelled). Keep it short: it runs under the token's lock.
+  [[nodiscard]] Registration on_cancel(std::function<void()> callback) const;
+
+private:
+  friend class CancellationSource;
+  explicit CancellationToken(std::shared_ptr<detail::CancellationState> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<detail::CancellationState> state_;
+};
+
+// Owner side: hands out tokens and cancels them all at once
+class CancellationSource {
+public:
+  CancellationSource();
+
+  [[nodiscard]] CancellationToken token() const;
+  void cancel();
+  [[nodiscard]] bool cancelled() const;
+
+private:
+  std::shared_ptr<detail::CancellationState> state_;
+};
+
+} // namespace slayergit::infra
@@ -0,0 +1,473 @@
+#include "cat_file_pool.hpp"
+
+#include "exceptions.hpp"
+#include "process.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <pthread.h>
+#include <thread>
+#include <unistd.h>
+
+namespace slayergit::infra {
+
+namespace {
+
+constexpr size_t read_chunk_size = 64 * 1024;
+
+bool ends_with(std::string_view text, std::string_view suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Parses "<oid> <type> <size>". Returns false on anything else.
+bool parse_header(std::string_view header, ObjectInfo &info) {
+  size_t first = header.find(' ');
+  size_t second =
+      first == std::string_view::npos ? first : header.find(' ', first + 1);
+  if (second == std::string_view::npos) {
+    return false;
+  }
+  info.oid.assign(header.substr(0, first));
+  info.type.assign(header.substr(first + 1, second - first - 1));
+  size_t size = 0;
+  for (char c : header.substr(second + 1)) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    size = size * 10 + static_cast<size_t>(c - '0');
+  }
+  info.size = size;
+  info.status = ObjectStatus::Found;
+  return true;
+}
+
+} // namespace
+
+// One git coprocess plus the I/O thread that feeds it. All pipe I/O is
+// non-blocking and happens on that thread, so callers never wait on git.
+class CatFilePool::Worker {
+public:
+  enum class Kind { Contents, Info };
+
+  struct Counters {
+    std::atomic<size_t> requests{0};
+    std::atomic<size_t> restarts{0};
+    std::atomic<size_t> failures{0};
+  };
+
+  Worker(Kind kind, std::vector<std::string> argv, bool batch_command,
+         int max_attempts)
+      : kind_(kind), argv_(std::move(argv)), batch_command_(batch_command),
+        max_attempts_(max_attempts) {
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+      throw SlayerGitException(std::string("pipe2 failed: ") +
+                               std::strerror(errno));
+    }
+    wake_read_.reset(fds[0]);
+    wake_write_.reset(fds[1]);
+    set_nonblocking(wake_read_.get());
+    set_nonblocking(wake_write_.get());
+    thread_ = std::thread([this] { run(); });
+  }
+
+  ~Worker() { stop(); }
+
+  std::future<GitObject> submit_contents(const std::string &spec) {
+    Request request;
+    request.spec = spec;
+    auto future = request.contents.get_future();
+    enqueue(std::move(request));
+    return future;
+  }
+
+  std::future<ObjectInfo> submit_info(const std::string &spec) {
+    Request request;
+    request.spec = spec;
+    auto future = request.info.get_future();
+    enqueue(std::move(request));
+    return future;
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        return;
+      }
+      stopping_ = true;
+    }
+    wake();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  [[nodiscard]] size_t load() const { return load_.load(); }
+  [[nodiscard]] const Counters &counters() const { return counters_; }
+
+private:
+  struct Request {
+    std::string spec;
+    std::promise<GitObject> contents;
+    std::promise<ObjectInfo> info;
+    int attempts = 0;
+  };
+
+  void enqueue(Request request) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        throw SlayerGitException("cat-file pool has been shut down");
+      }
+      append_command(request.spec);
+      pending_.push_back(std::move(request));
+      load_ = pending_.size();
+    }
+    ++counters_.requests;
+    wake();
+  }
+
+  void append_command(const std::string &spec) {
+    if (kind_ == Kind::Contents && batch_command_) {
+      outgoing_ += "contents ";
+    }
+    outgoing_ += spec;
+    outgoing_ += '\n';
+  }
+
+  void wake() {
+    char byte = 1;
+    [[maybe_unused]] ssize_t n = ::write(wake_write_.get(), &byte, 1);
+  }
+
+  void run() {
+    // Writes to a crashed git must surface as EPIPE, not kill the app. The
+    // signal is synchronous, so blocking it on this thread is sufficient.
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+      if (!child_.running() && !pending_.empty()) {
+        respawn();
+      }
+
+      pollfd fds[3];
+      nfds_t count = 0;
+      fds[count++] = pollfd{wake_read_.get(), POLLIN, 0};
+      int stdout_index = -1;
+      int stdin_index = -1;
+      if (child_.running()) {
+        stdout_index = static_cast<int>(count);
+        fds[count++] = pollfd{child_.stdout_fd(), POLLIN, 0};
+        if (out_pos_ < outgoing_.size()) {
+          stdin_index = static_cast<int>(count);
+          fds[count++] = pollfd{child_.stdin_fd(), POLLOUT, 0};
+        }
+      }
+
+      lock.unlock();
+      int rc = ::poll(fds, count, -1);
+      lock.lock();
+      if (rc < 0) {
+        continue;
+      }
+
+      if (fds[0].revents & POLLIN) {
+        char sink[64];
+        while (::read(wake_read_.get(), sink, sizeof(sink)) > 0) {
+        }
+      }
+      if (stopping_) {
+        break;
+      }
+      if (stdin_index >= 0 && fds[stdin_index].revents) {
+        flush_outgoing();
+      }
+      if (stdout_index >= 0 && fds[stdout_index].revents) {
+        read_responses();
+      }
+    }
+
+    // Closing stdin makes cat-file exit on its own. Closing stdout as well
+    // turns a response nobody will read into EPIPE instead of a blocked write.
+    child_.close_stdin();
+    child_.close_stdout();
+    if (child_.running()) {
+      child_.wait();
+    }
+    fail_all(std::make_exception_ptr(
+        SlayerGitException("cat-file pool has been shut down")));
+  }
+
+  void respawn() {
+    try {
+      child_ = ChildProcess::spawn(argv_, SpawnOptions{true, true, false});
+    } catch (...) {
+      fail_all(std::current_exception());
+      return;
+    }
+    inbuf_.clear();
+    out_pos_ = 0;
+    outgoing_.clear();
+    for (const auto &request : pending_) {
+      append_command(request.spec);
+    }
+  }
+
+  // Called when git died or spoke out of turn. Unanswered requests are
+  // retried on a fresh process until they run out of attempts.
+  void handle_crash() {
+    child_.kill();
+    child_.wait();
+    ++counters_.restarts;
+
+    auto error = std::make_exception_ptr(
+        SlayerGitException("cat-file worker exited unexpectedly"));
+    std::deque<Request> retry;
+    for (auto &request : pending_) {
+      if (++request.attempts >= max_attempts_) {
+        fail(request, error);
+      } else {
+        retry.push_back(std::move(request));
+      }
+    }
+    pending_ = std::move(retry);
+    load_ = pending_.size();
+    outgoing_.clear();
+    out_pos_ = 0;
+    // The main loop respawns as soon as something is pending
+  }
+
+  void flush_outgoing() {
+    while (out_pos_ < outgoing_.size()) {
+      ssize_t n = ::write(child_.stdin_fd(), outgoing_.data() + out_pos_,
+                          outgoing_.size() - out_pos_);
+      if (n > 0) {
+        out_pos_ += static_cast<size_t>(n);
+        continue;
+      }
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+      }
+      handle_crash();
+      return;
+    }
+    outgoing_.clear();
+    out_pos_ = 0;
+  }
+
+  void read_responses() {
+    char buffer[read_chunk_size];
+    for (;;) {
+      ssize_t n = ::read(child_.stdout_fd(), buffer, sizeof(buffer));
+      if (n > 0) {
+        inbuf_.append(buffer, static_cast<size_t>(n));
+        continue;
+      }
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      }
+      // EOF or error: the process is gone
+      parse_responses();
+      handle_crash();
+      return;
+    }
+    if (!parse_responses()) {
+      handle_crash();
+    }
+  }
+
+  // Completes every request whose response is fully buffered. Returns false
+  // on a protocol error.
+  bool parse_responses() {
+    size_t pos = 0;
+    while (pos < inbuf_.size()) {
+      size_t newline = inbuf_.find('\n', pos);
+      if (newline == std::string::npos) {
+        break;
+      }
+      if (pending_.empty()) {
+        return false;
+      }
+
+      std::string_view header(inbuf_.data() + pos, newline - pos);
+      Request &request = pending_.front();
+      ObjectInfo info;
+      size_t consumed = newline + 1 - pos;
+
+      if (ends_with(header, " missing")) {
+        info.status = ObjectStatus::Missing;
+      } else if (ends_with(header, " ambiguous")) {
+        info.status = ObjectStatus::Ambiguous;
+      } else if (!parse_header(header, info)) {
+        return false;
+      }
+
+      GitObject object;
+      if (kind_ == Kind::Contents && info.status == ObjectStatus::Found) {
+        // Body is followed by a single LF
+        if (inbuf_.size() - (newline + 1) < info.size + 1) {
+          break;
+        }
+        object.data.assign(inbuf_, newline + 1, info.size);
+        consumed += info.size + 1;
+      }
+
+      if (kind_ == Kind::Contents) {
+        object.info = std::move(info);
+        request.contents.set_value(std::move(object));
+      } else {
+        request.info.set_value(std::move(info));
+      }
+      pending_.pop_front();
+      load_ = pending_.size();
+      pos += consumed;
+    }
+    inbuf_.erase(0, pos);
+    return true;
+  }
+
+  void fail(Request &request, const std::exception_ptr &error) {
+    ++counters_.failures;
+    if (kind_ == Kind::Contents) {
+      request.contents.set_exception(error);
+    } else {
+      request.info.set_exception(error);
+    }
+  }
+
+  void fail_all(const std::exception_ptr &error) {
+    for (auto &request : pending_) {
+      fail(request, error);
+    }
+    pending_.clear();
+    load_ = 0;
+    outgoing_.clear();
+    out_pos_ = 0;
+  }
+
+  const Kind kind_;
+  const std::vector<std::string> argv_;
+  const bool batch_command_;
+  const int max_attempts_;
+
+  std::mutex mutex_;
+  bool stopping_ = false;
+  ChildProcess child_;
+  std::deque<Request> pending_;
+  std::string outgoing_;
+  size_t out_pos_ = 0;
+  std::string inbuf_;
+  std::atomic<size_t> load_{0};
+  Counters counters_;
+
+  UniqueFd wake_read_;
+  UniqueFd wake_write_;
+  std::thread thread_;
+};
+
+CatFilePool::CatFilePool(std::string repo_path)
+    : CatFilePool(std::move(repo_path), Options{}) {}
+
+CatFilePool::CatFilePool(std::string repo_path, Options options)
+    : repo_path_(std::move(repo_path)), options_(std::move(options)) {
+  auto make_argv = [this](const char *mode) {
+    return std::vector<std::string>{options_.git_binary, "-C", repo_path_,
+                                    "cat-file", mode};
+  };
+
+  const char *contents_mode =
+      options_.use_batch_command ? "--batch-command" : "--batch";
+  for (size_t i = 0; i < options_.content_workers; ++i) {
+    content_workers_.push_back(std::make_unique<Worker>(
+        Worker::Kind::Contents, make_argv(contents_mode),
+        options_.use_batch_command, options_.max_attempts));
+  }
+  for (size_t i = 0; i < options_.info_workers; ++i) {
+    info_workers_.push_back(std::make_unique<Worker>(
+        Worker::Kind::Info, make_argv("--batch-check"), false,
+        options_.max_attempts));
+  }
+}
+
+CatFilePool::~CatFilePool() { shutdown(); }
+
+std::future<GitObject> CatFilePool::read_object(const std::string &spec) {
+  if (spec.find('\n') != std::string::npos) {
+    throw SlayerGitException("Object name contains a newline: " + spec);
+  }
+  if (shut_down_ || content_workers_.empty()) {
+    throw SlayerGitException("cat-file pool has no content workers");
+  }
+  return pick(content_workers_).submit_contents(spec);
+}
+
+std::future<ObjectInfo> CatFilePool::object_info(const std::string &spec) {
+  if (spec.find('\n') != std::string::npos) {
+    throw SlayerGitException("Object name contains a newline: " + spec);
+  }
+  if (shut_down_) {
+    throw SlayerGitException("cat-file pool has been shut down");
+  }
+  if (info_workers_.empty()) {
+    // Without dedicated check workers, answer from the contents path
+    auto object = std::make_shared<std::future<GitObject>>(read_object(spec));
+    return std::async(std::launch::deferred,
+                      [object] { return object->get().info; });
+  }
+  return pick(info_workers_).submit_info(spec);
+}
+
+void CatFilePool::shutdown() {
+  if (shut_down_.exchange(true)) {
+    return;
+  }
+  for (auto &worker : content_workers_) {
+    worker->stop();
+  }
+  for (auto &worker : info_workers_) {
+    worker->stop();
+  }
+}
+
+CatFilePool::Stats CatFilePool::stats() const {
+  Stats stats;
+  auto add = [&stats](const std::vector<WorkerPtr> &workers) {
+    for (const auto &worker : workers) {
+      stats.requests += worker->counters().requests;
+      stats.restarts += worker->counters().restarts;
+      stats.failures += worker->counters().failures;
+    }
+  };
+  add(content_workers_);
+  add(info_workers_);
+  return stats;
+}
+
+CatFilePool::Worker &CatFilePool::pick(std::vector<WorkerPtr> &workers) {
+  Worker *best = workers.front().get();
+  for (const auto &worker : workers) {
+    if (worker->load() < best->load()) {
+      best = worker.get();
+    }
+  }
+  return *best;
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace slayergit::infra {
+
+enum class ObjectStatus { Found, Missing, Ambiguous };
+
+struct ObjectInfo {
+  ObjectStatus status = ObjectStatus::Missing;
+  std::string oid;
+  std::string type; // "blob", "tree", "commit" or "tag"
+  size_t size = 0;
+};
+
+struct GitObject {
+  ObjectInfo info;
+  std::string data;
+};
+
+// Pool of long-lived `git cat-file` coprocesses. Spawning git costs several
+// milliseconds, which dominates per-row lookups such as commit bodies or tag
+// targets; these workers stay alive and answer requests over their pipes.
+//
+// Requests are pipelined: callers get a future immediately and a worker's
+// I/O thread matches responses to requests in FIFO order. A worker whose
+// git process dies is restarted and its unanswered requests are re-sent.
+class CatFilePool {
+public:
+  struct Options {
+    // Workers running `cat-file --batch-command` (contents lookups)
+    size_t content_workers = 2;
+    // Workers running `cat-file --batch-check` (type/size lookups)
+    size_t info_workers = 1;
+    std::string git_binary = "git";
+    // Git older than 2.36 lacks --batch-command; fall back to --batch
+    bool use_batch_command = true;
+    // Attempts per request before its future receives an exception
+    int max_attempts = 2;
+  };
+
+  struct Stats {
+    size_t requests = 0;
+    size_t restarts = 0;
+    size_t failures = 0;
+  };
+
+  explicit CatFilePool(std::string repo_path);
+  CatFilePool(std::string repo_path, Options options);
+  ~CatFilePool();
+
+  CatFilePool(const CatFilePool &) = delete;
+  CatFilePool &operator=(const CatFilePool &) = delete;
+
+  // `spec` is anything git accepts as an object name ("HEAD:README.md",
+  // a full OID, "v1.0^{tag}", ...). Throws SlayerGitException for specs
+  // containing a newline or after shutdown().
+  std::future<GitObject> read_object(const std::string &spec);
+  std::future<ObjectInfo> object_info(const std::string &spec);
+
+  // Stops all workers; outstanding requests fail. Called by the destructor.
+  void shutdown();
+
+  [[nodiscard]] Stats stats() const;
+
+private:
+  class Worker;
+  using WorkerPtr = std::unique_ptr<Worker>;
+
+  Worker &pick(std::vector<WorkerPtr> &workers);
+
+  std::string repo_path_;
+  Options options_;
+  std::vector<WorkerPtr> content_workers_;
+  std::vector<WorkerPtr> info_workers_;
+  std::atomic<bool> shut_down_{false};
+};
+
+} // namespace slayergit::infra
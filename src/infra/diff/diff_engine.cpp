@@ -0,0 +1,1226 @@
+#include "diff_engine.hpp"
+
+#include "infra/diff/line_hash.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// The algorithms below follow git's xdiff (xprepare.c, xdiffi.c,
+// xhistogram.c, xemit.c) step by step, including its tie-breaking and
+// heuristics: any deviation shows up as a different (if equally valid) diff
+// from the one `git diff` prints.
+
+namespace slayergit::infra {
+
+namespace {
+
+// Lines matching more than this many lines of the other side may be
+// discarded before Myers runs
+constexpr long max_eq_limit = 1024;
+constexpr long simscan_window = 100;
+constexpr long kpdis_run = 4;
+// Myers gives up looking for the optimal path after about sqrt(N) steps
+constexpr long max_cost_min = 256;
+constexpr long heur_min_cost = 256;
+constexpr long snake_count = 20;
+constexpr long k_heuristic = 4;
+constexpr long line_max = std::numeric_limits<long>::max();
+
+constexpr unsigned histogram_max_chain = 64;
+constexpr uint64_t golden_ratio_prime = 0x9e37fffffffc0001ULL;
+
+// Git treats a buffer as binary when its first 8000 bytes contain a NUL
+constexpr size_t binary_probe_bytes = 8000;
+constexpr size_t func_name_max = 80;
+
+long bogosqrt(long n) {
+  long i = 1;
+  for (; n > 0; n >>= 2) {
+    i <<= 1;
+  }
+  return i;
+}
+
+bool is_binary(std::string_view text) {
+  return std::memchr(text.data(), '\0',
+                     std::min(text.size(), binary_probe_bytes)) != nullptr;
+}
+
+// Both sides' lines, mapped to equivalence classes numbered in order of
+// first appearance (old side first), like xdiff's classifier
+struct Classified {
+  std::vector<LineRef> lines1;
+  std::vector<LineRef> lines2;
+  std::vector<uint32_t> ids1;
+  std::vector<uint32_t> ids2;
+  size_t class_count = 0;
+};
+
+Classified classify(std::string_view text1, std::string_view text2) {
+  Classified result;
+  result.lines1 = hash_lines(text1);
+  result.lines2 = hash_lines(text2);
+
+  size_t total = result.lines1.size() + result.lines2.size();
+  size_t capacity = 16;
+  while (capacity < total * 2) {
+    capacity <<= 1;
+  }
+  size_t mask = capacity - 1;
+
+  struct Class {
+    const char *data;
+    uint32_t size;
+    uint64_t hash;
+  };
+  std::vector<Class> classes;
+  classes.reserve(total);
+  std::vector<uint32_t> table(capacity, 0); // class + 1, 0 = empty
+
+  auto assign = [&](std::string_view text, const std::vector<LineRef> &lines,
+                    std::vector<uint32_t> &ids) {
+    ids.resize(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+      const LineRef &line = lines[i];
+      const char *data = text.data() + line.offset;
+      size_t slot = line.hash & mask;
+      while (true) {
+        uint32_t entry = table[slot];
+        if (entry == 0) {
+          table[slot] = static_cast<uint32_t>(classes.size() + 1);
+          ids[i] = static_cast<uint32_t>(classes.size());
+          classes.push_back({data, line.size, line.hash});
+          break;
+        }
+        const Class &candidate = classes[entry - 1];
+        if (candidate.hash == line.hash && candidate.size == line.size &&
+            std::memcmp(candidate.data, data, line.size) == 0) {
+          ids[i] = entry - 1;
+          break;
+        }
+        slot = (slot + 1) & mask;
+      }
+    }
+  };
+  assign(text1, result.lines1, result.ids1);
+  assign(text2, result.lines2, result.ids2);
+  result.class_count = classes.size();
+  return result;
+}
+
+// xdiff's Myers: common prefix/suffix trimming, discarding of lines without
+// (or with too many) matches, then a divide-and-conquer middle-snake search
+// that falls back to heuristics once the edit cost exceeds ~sqrt(N)
+class MyersDiff {
+public:
+  MyersDiff(size_t class_count, bool minimal, const CancellationToken &token)
+      : count1_(class_count, 0), count2_(class_count, 0), minimal_(minimal),
+        token_(token) {}
+
+  // Marks changed lines of ids1[0, n1) and ids2[0, n2) in rchg1/rchg2
+  void run(const uint32_t *ids1, long n1, const uint32_t *ids2, long n2,
+           char *rchg1, char *rchg2) {
+    token_.throw_if_cancelled();
+    rchg1_ = rchg1;
+    rchg2_ = rchg2;
+
+    for (long i = 0; i < n1; ++i) {
+      ++count1_[ids1[i]];
+    }
+    for (long i = 0; i < n2; ++i) {
+      ++count2_[ids2[i]];
+    }
+
+    // Trim the common prefix and suffix
+    long lim = std::min(n1, n2);
+    long dstart = 0;
+    while (dstart < lim && ids1[dstart] == ids2[dstart]) {
+      ++dstart;
+    }
+    long suffix = 0;
+    for (lim -= dstart;
+         suffix < lim && ids1[n1 - 1 - suffix] == ids2[n2 - 1 - suffix];
+         ++suffix) {
+    }
+    long dend1 = n1 - suffix - 1;
+    long dend2 = n2 - suffix - 1;
+
+    cleanup_records(ids1, n1, ids2, n2, dstart, dend1, dend2);
+
+    for (long i = 0; i < n1; ++i) {
+      count1_[ids1[i]] = 0;
+    }
+    for (long i = 0; i < n2; ++i) {
+      count2_[ids2[i]] = 0;
+    }
+
+    auto nreff1 = static_cast<long>(ha1_.size());
+    auto nreff2 = static_cast<long>(ha2_.size());
+    long ndiags = nreff1 + nreff2 + 3;
+    kvd_.assign(static_cast<size_t>(2 * ndiags + 2), 0);
+    long *kvdf = kvd_.data() + nreff2 + 1;
+    long *kvdb = kvd_.data() + ndiags + nreff2 + 1;
+    max_cost_ = std::max(bogosqrt(ndiags), max_cost_min);
+
+    compare(0, nreff1, 0, nreff2, kvdf, kvdb, minimal_);
+  }
+
+private:
+  struct Split {
+    long i1 = 0;
+    long i2 = 0;
+    bool min_lo = false;
+    bool min_hi = false;
+  };
+
+  // Lines with no match on the other side are changed outright; lines with
+  // many matches are dropped when they sit among unmatched lines. The rest
+  // are handed to the search in ha/rindex.
+  void cleanup_records(const uint32_t *ids1, long n1, const uint32_t *ids2,
+                       long n2, long dstart, long dend1, long dend2) {
+    dis_.assign(static_cast<size_t>(n1 + n2 + 2), 0);
+    char *dis1 = dis_.data();
+    char *dis2 = dis1 + n1 + 1;
+
+    long mlim = std::min(bogosqrt(n1), max_eq_limit);
+    for (long i = dstart; i <= dend1; ++i) {
+      long nm = count2_[ids1[i]];
+      dis1[i] = nm == 0 ? 0 : (nm >= mlim && !minimal_) ? 2 : 1;
+    }
+    mlim = std::min(bogosqrt(n2), max_eq_limit);
+    for (long i = dstart; i <= dend2; ++i) {
+      long nm = count1_[ids2[i]];
+      dis2[i] = nm == 0 ? 0 : (nm >= mlim && !minimal_) ? 2 : 1;
+    }
+
+    auto keep = [](const uint32_t *ids, const char *dis, long dstart,
+                   long dend, char *rchg, std::vector<uint32_t> &ha,
+                   std::vector<long> &rindex) {
+      ha.clear();
+      rindex.clear();
+      for (long i = dstart; i <= dend; ++i) {
+        if (dis[i] == 1 ||
+            (dis[i] == 2 && !clean_mmatch(dis, i, dstart, dend))) {
+          rindex.push_back(i);
+          ha.push_back(ids[i]);
+        } else {
+          rchg[i] = 1;
+        }
+      }
+    };
+    keep(ids1, dis1, dstart, dend1, rchg1_, ha1_, rindex1_);
+    keep(ids2, dis2, dstart, dend2, rchg2_, ha2_, rindex2_);
+  }
+
+  // Whether multi-match line `i` lies in a run dominated by unmatched lines
+  static bool clean_mmatch(const char *dis, long i, long s, long e) {
+    if (i - s > simscan_window) {
+      s = i - simscan_window;
+    }
+    if (e - i > simscan_window) {
+      e = i + simscan_window;
+    }
+
+    long r;
+    long rdis0 = 0;
+    long rpdis0 = 1;
+    for (r = 1; i - r >= s; ++r) {
+      if (dis[i - r] == 0) {
+        ++rdis0;
+      } else if (dis[i - r] == 2) {
+        ++rpdis0;
+      } else {
+        break;
+      }
+    }
+    if (rdis0 == 0) {
+      return false;
+    }
+
+    long rdis1 = 0;
+    long rpdis1 = 1;
+    for (r = 1; i + r <= e; ++r) {
+      if (dis[i + r] == 0) {
+        ++rdis1;
+      } else if (dis[i + r] == 2) {
+        ++rpdis1;
+      } else {
+        break;
+      }
+    }
+    if (rdis1 == 0) {
+      return false;
+    }
+    rdis1 += rdis0;
+    rpdis1 += rpdis0;
+    return rpdis1 * kpdis_run < rpdis1 + rdis1;
+  }
+
+  void compare(long off1, long lim1, long off2, long lim2, long *kvdf,
+               long *kvdb, bool need_min) {
+    const uint32_t *ha1 = ha1_.data();
+    const uint32_t *ha2 = ha2_.data();
+
+    // Shrink the box by walking through the diagonal snakes at both ends
+    for (; off1 < lim1 && off2 < lim2 && ha1[off1] == ha2[off2];
+         ++off1, ++off2) {
+    }
+    for (; off1 < lim1 && off2 < lim2 && ha1[lim1 - 1] == ha2[lim2 - 1];
+         --lim1, --lim2) {
+    }
+
+    if (off1 == lim1) {
+      for (; off2 < lim2; ++off2) {
+        rchg2_[rindex2_[off2]] = 1;
+      }
+    } else if (off2 == lim2) {
+      for (; off1 < lim1; ++off1) {
+        rchg1_[rindex1_[off1]] = 1;
+      }
+    } else {
+      Split spl;
+      split(off1, lim1, off2, lim2, kvdf, kvdb, need_min, spl);
+      compare(off1, spl.i1, off2, spl.i2, kvdf, kvdb, spl.min_lo);
+      compare(spl.i1, lim1, spl.i2, lim2, kvdf, kvdb, spl.min_hi);
+    }
+  }
+
+  // Finds the middle snake of the box, or a good-enough split point once the
+  // cost heuristics kick in
+  void split(long off1, long lim1, long off2, long lim2, long *kvdf,
+             long *kvdb, bool need_min, Split &spl) {
+    const uint32_t *ha1 = ha1_.data();
+    const uint32_t *ha2 = ha2_.data();
+    long dmin = off1 - lim2;
+    long dmax = lim1 - off2;
+    long fmid = off1 - off2;
+    long bmid = lim1 - lim2;
+    bool odd = ((fmid - bmid) & 1) != 0;
+    long fmin = fmid;
+    long fmax = fmid;
+    long bmin = bmid;
+    long bmax = bmid;
+
+    kvdf[fmid] = off1;
+    kvdb[bmid] = lim1;
+
+    for (long ec = 1;; ++ec) {
+      if ((ec & 0x3f) == 0) {
+        token_.throw_if_cancelled();
+      }
+      bool got_snake = false;
+
+      // Extend the forward diagonal domain by one, or shrink it against the
+      // box boundary
+      if (fmin > dmin) {
+        kvdf[--fmin - 1] = -1;
+      } else {
+        ++fmin;
+      }
+      if (fmax < dmax) {
+        kvdf[++fmax + 1] = -1;
+      } else {
+        --fmax;
+      }
+
+      for (long d = fmax; d >= fmin; d -= 2) {
+        long i1 = kvdf[d - 1] >= kvdf[d + 1] ? kvdf[d - 1] + 1 : kvdf[d + 1];
+        long prev1 = i1;
+        long i2 = i1 - d;
+        for (; i1 < lim1 && i2 < lim2 && ha1[i1] == ha2[i2]; ++i1, ++i2) {
+        }
+        if (i1 - prev1 > snake_count) {
+          got_snake = true;
+        }
+        kvdf[d] = i1;
+        if (odd && bmin <= d && d <= bmax && kvdb[d] <= i1) {
+          spl = {i1, i2, true, true};
+          return;
+        }
+      }
+
+      if (bmin > dmin) {
+        kvdb[--bmin - 1] = line_max;
+      } else {
+        ++bmin;
+      }
+      if (bmax < dmax) {
+        kvdb[++bmax + 1] = line_max;
+      } else {
+        --bmax;
+      }
+
+      for (long d = bmax; d >= bmin; d -= 2) {
+        long i1 = kvdb[d - 1] < kvdb[d + 1] ? kvdb[d - 1] : kvdb[d + 1] - 1;
+        long prev1 = i1;
+        long i2 = i1 - d;
+        for (; i1 > off1 && i2 > off2 && ha1[i1 - 1] == ha2[i2 - 1];
+             --i1, --i2) {
+        }
+        if (prev1 - i1 > snake_count) {
+          got_snake = true;
+        }
+        kvdb[d] = i1;
+        if (!odd && fmin <= d && d <= fmax && i1 <= kvdf[d]) {
+          spl = {i1, i2, true, true};
+          return;
+        }
+      }
+
+      if (need_min) {
+        continue;
+      }
+
+      // Past the heuristic threshold, accept a diagonal that has come far
+      // from the corner along a long snake
+      if (got_snake && ec > heur_min_cost) {
+        long best = 0;
+        for (long d = fmax; d >= fmin; d -= 2) {
+          long dd = d > fmid ? d - fmid : fmid - d;
+          long i1 = kvdf[d];
+          long i2 = i1 - d;
+          long v = (i1 - off1) + (i2 - off2) - dd;
+          if (v > k_heuristic * ec && v > best && off1 + snake_count <= i1 &&
+              i1 < lim1 && off2 + snake_count <= i2 && i2 < lim2) {
+            for (long k = 1; ha1[i1 - k] == ha2[i2 - k]; ++k) {
+              if (k == snake_count) {
+                best = v;
+                spl.i1 = i1;
+                spl.i2 = i2;
+                break;
+              }
+            }
+          }
+        }
+        if (best > 0) {
+          spl.min_lo = true;
+          spl.min_hi = false;
+          return;
+        }
+
+        best = 0;
+        for (long d = bmax; d >= bmin; d -= 2) {
+          long dd = d > bmid ? d - bmid : bmid - d;
+          long i1 = kvdb[d];
+          long i2 = i1 - d;
+          long v = (lim1 - i1) + (lim2 - i2) - dd;
+          if (v > k_heuristic * ec && v > best && off1 < i1 &&
+              i1 <= lim1 - snake_count && off2 < i2 &&
+              i2 <= lim2 - snake_count) {
+            for (long k = 0; ha1[i1 + k] == ha2[i2 + k]; ++k) {
+              if (k == snake_count - 1) {
+                best = v;
+                spl.i1 = i1;
+                spl.i2 = i2;
+                break;
+              }
+            }
+          }
+        }
+        if (best > 0) {
+          spl.min_lo = false;
+          spl.min_hi = true;
+          return;
+        }
+      }
+
+      // Enough is enough: split at the furthest-reaching path found so far
+      if (ec >= max_cost_) {
+        long fbest = -1;
+        long fbest1 = -1;
+        for (long d = fmax; d >= fmin; d -= 2) {
+          long i1 = std::min(kvdf[d], lim1);
+          long i2 = i1 - d;
+          if (lim2 < i2) {
+            i1 = lim2 + d;
+            i2 = lim2;
+          }
+          if (fbest < i1 + i2) {
+            fbest = i1 + i2;
+            fbest1 = i1;
+          }
+        }
+
+        long bbest = line_max;
+        long bbest1 = line_max;
+        for (long d = bmax; d >= bmin; d -= 2) {
+          long i1 = std::max(off1, kvdb[d]);
+          long i2 = i1 - d;
+          if (i2 < off2) {
+            i1 = off2 + d;
+            i2 = off2;
+          }
+          if (i1 + i2 < bbest) {
+            bbest = i1 + i2;
+            bbest1 = i1;
+          }
+        }
+
+        if ((lim1 + lim2) - bbest < fbest - (off1 + off2)) {
+          spl = {fbest1, fbest - fbest1, true, false};
+        } else {
+          spl = {bbest1, bbest - bbest1, false, true};
+        }
+        return;
+      }
+    }
+  }
+
+  std::vector<uint32_t> count1_;
+  std::vector<uint32_t> count2_;
+  bool minimal_;
+  const CancellationToken &token_;
+
+  std::vector<char> dis_;
+  std::vector<uint32_t> ha1_;
+  std::vector<uint32_t> ha2_;
+  std::vector<long> rindex1_;
+  std::vector<long> rindex2_;
+  std::vector<long> kvd_;
+  char *rchg1_ = nullptr;
+  char *rchg2_ = nullptr;
+  long max_cost_ = 0;
+};
+
+// Histogram diff: recursively splits both sides around the longest common
+// region whose lines occur least often, falling back to Myers when every
+// candidate line is too common. Line numbers are 1-based as in xhistogram.c.
+class HistogramDiff {
+public:
+  HistogramDiff(const uint32_t *ids1, const uint32_t *ids2, char *rchg1,
+                char *rchg2, MyersDiff &fallback,
+                const CancellationToken &token)
+      : ids1_(ids1), ids2_(ids2), rchg1_(rchg1), rchg2_(rchg2),
+        fallback_(fallback), token_(token) {}
+
+  void run(int line1, int count1, int line2, int count2) {
+    while (true) {
+      token_.throw_if_cancelled();
+      if (count1 <= 0 && count2 <= 0) {
+        return;
+      }
+      if (count1 == 0) {
+        while (count2-- > 0) {
+          rchg2_[line2++ - 1] = 1;
+        }
+        return;
+      }
+      if (count2 == 0) {
+        while (count1-- > 0) {
+          rchg1_[line1++ - 1] = 1;
+        }
+        return;
+      }
+
+      Region lcs;
+      if (find_lcs(lcs, line1, count1, line2, count2)) {
+        fallback_.run(ids1_ + line1 - 1, count1, ids2_ + line2 - 1, count2,
+                      rchg1_ + line1 - 1, rchg2_ + line2 - 1);
+        return;
+      }
+      if (lcs.begin1 == 0 && lcs.begin2 == 0) {
+        while (count1-- > 0) {
+          rchg1_[line1++ - 1] = 1;
+        }
+        while (count2-- > 0) {
+          rchg2_[line2++ - 1] = 1;
+        }
+        return;
+      }
+
+      run(line1, static_cast<int>(lcs.begin1) - line1, line2,
+          static_cast<int>(lcs.begin2) - line2);
+      int end1 = line1 + count1 - 1;
+      int end2 = line2 + count2 - 1;
+      count1 = end1 - static_cast<int>(lcs.end1);
+      line1 = static_cast<int>(lcs.end1) + 1;
+      count2 = end2 - static_cast<int>(lcs.end2);
+      line2 = static_cast<int>(lcs.end2) + 1;
+    }
+  }
+
+private:
+  struct Region {
+    unsigned begin1 = 0;
+    unsigned end1 = 0;
+    unsigned begin2 = 0;
+    unsigned end2 = 0;
+  };
+
+  // One distinct line of side 1: its first occurrence and occurrence count
+  struct Record {
+    unsigned ptr;
+    unsigned cnt;
+    int next;
+  };
+
+  [[nodiscard]] bool same(unsigned l1, unsigned l2) const {
+    return ids1_[l1 - 1] == ids2_[l2 - 1];
+  }
+
+  [[nodiscard]] bool same1(unsigned a, unsigned b) const {
+    return ids1_[a - 1] == ids1_[b - 1];
+  }
+
+  [[nodiscard]] size_t bucket(const uint32_t *ids, unsigned line) const {
+    return static_cast<size_t>((uint64_t{ids[line - 1]} * golden_ratio_prime) >>
+                               (64 - table_bits_));
+  }
+
+  unsigned &next_ptr(unsigned ptr) { return next_ptrs_[ptr - ptr_shift_]; }
+
+  [[nodiscard]] unsigned count_of(unsigned ptr) const {
+    return records_[static_cast<size_t>(line_map_[ptr - ptr_shift_])].cnt;
+  }
+
+  // Returns true when the caller should fall back to Myers
+  bool find_lcs(Region &lcs, int line1, int count1, int line2, int count2) {
+    table_bits_ = 1;
+    while ((1u << table_bits_) < static_cast<unsigned>(count1) &&
+           table_bits_ < 31) {
+      ++table_bits_;
+    }
+    buckets_.assign(size_t{1} << table_bits_, -1);
+    line_map_.assign(static_cast<size_t>(count1), -1);
+    next_ptrs_.assign(static_cast<size_t>(count1), 0);
+    records_.clear();
+    ptr_shift_ = static_cast<unsigned>(line1);
+
+    if (!scan_a(line1, count1)) {
+      return true;
+    }
+
+    cnt_ = histogram_max_chain + 1;
+    has_common_ = false;
+    int end2 = line2 + count2 - 1;
+    for (int b_ptr = line2; b_ptr <= end2;) {
+      b_ptr = try_lcs(lcs, static_cast<unsigned>(b_ptr), line1, count1, line2,
+                      count2);
+    }
+    return has_common_ && histogram_max_chain < cnt_;
+  }
+
+  // Indexes side 1 from the bottom up so each record's ptr ends up at the
+  // first occurrence, with next_ptr() chaining the later ones
+  bool scan_a(int line1, int count1) {
+    auto end1 = static_cast<unsigned>(line1 + count1 - 1);
+    for (unsigned ptr = end1; static_cast<unsigned>(line1) <= ptr; --ptr) {
+      size_t index = bucket(ids1_, ptr);
+      unsigned chain_length = 0;
+      int rec = buckets_[index];
+      bool found = false;
+      while (rec != -1) {
+        Record &record = records_[static_cast<size_t>(rec)];
+        if (same1(record.ptr, ptr)) {
+          next_ptr(ptr) = record.ptr;
+          record.ptr = ptr;
+          record.cnt = std::min<unsigned>(std::numeric_limits<int>::max(),
+                                          record.cnt + 1);
+          line_map_[ptr - ptr_shift_] = rec;
+          found = true;
+          break;
+        }
+        rec = record.next;
+        ++chain_length;
+      }
+      if (found) {
+        continue;
+      }
+      if (chain_length == histogram_max_chain) {
+        return false;
+      }
+      records_.push_back({ptr, 1, buckets_[index]});
+      buckets_[index] = static_cast<int>(records_.size() - 1);
+      line_map_[ptr - ptr_shift_] = buckets_[index];
+    }
+    return true;
+  }
+
+  int try_lcs(Region &lcs, unsigned b_ptr, int line1, int count1, int line2,
+              int count2) {
+    unsigned b_next = b_ptr + 1;
+    auto end1 = static_cast<unsigned>(line1 + count1 - 1);
+    auto end2 = static_cast<unsigned>(line2 + count2 - 1);
+    auto first1 = static_cast<unsigned>(line1);
+    auto first2 = static_cast<unsigned>(line2);
+
+    for (int rec = buckets_[bucket(ids2_, b_ptr)]; rec != -1;
+         rec = records_[static_cast<size_t>(rec)].next) {
+      const Record &record = records_[static_cast<size_t>(rec)];
+      if (record.cnt > cnt_) {
+        if (!has_common_) {
+          has_common_ = same(record.ptr, b_ptr);
+        }
+        continue;
+      }
+
+      unsigned as = record.ptr;
+      if (!same(as, b_ptr)) {
+        continue;
+      }
+
+      has_common_ = true;
+      while (true) {
+        unsigned np = next_ptr(as);
+        unsigned bs = b_ptr;
+        unsigned ae = as;
+        unsigned be = bs;
+        unsigned rc = record.cnt;
+
+        while (first1 < as && first2 < bs && same(as - 1, bs - 1)) {
+          --as;
+          --bs;
+          if (1 < rc) {
+            rc = std::min(rc, count_of(as));
+          }
+        }
+        while (ae < end1 && be < end2 && same(ae + 1, be + 1)) {
+          ++ae;
+          ++be;
+          if (1 < rc) {
+            rc = std::min(rc, count_of(ae));
+          }
+        }
+
+        if (b_next <= be) {
+          b_next = be + 1;
+        }
+        if (lcs.end1 - lcs.begin1 < ae - as || rc < cnt_) {
+          lcs = {as, ae, bs, be};
+          cnt_ = rc;
+        }
+
+        if (np == 0) {
+          break;
+        }
+        while (np <= ae) {
+          np = next_ptr(np);
+          if (np == 0) {
+            break;
+          }
+        }
+        if (np == 0) {
+          break;
+        }
+        as = np;
+      }
+    }
+    return static_cast<int>(b_next);
+  }
+
+  const uint32_t *ids1_;
+  const uint32_t *ids2_;
+  char *rchg1_;
+  char *rchg2_;
+  MyersDiff &fallback_;
+  const CancellationToken &token_;
+
+  std::vector<int> buckets_;
+  std::vector<Record> records_;
+  std::vector<int> line_map_;
+  std::vector<unsigned> next_ptrs_;
+  unsigned table_bits_ = 1;
+  unsigned ptr_shift_ = 0;
+  unsigned cnt_ = 0;
+  bool has_common_ = false;
+};
+
+// One side of the diff during compaction. rchg has a zero sentinel at [-1]
+// and [nrec].
+struct Side {
+  std::string_view text;
+  const LineRef *lines;
+  const uint32_t *ids;
+  char *rchg;
+  long nrec;
+};
+
+struct Group {
+  long start = 0;
+  long end = 0; // Exclusive
+};
+
+void group_init(const Side &side, Group &g) {
+  g.start = 0;
+  g.end = 0;
+  while (side.rchg[g.end] != 0) {
+    ++g.end;
+  }
+}
+
+bool group_next(const Side &side, Group &g) {
+  if (g.end == side.nrec) {
+    return false;
+  }
+  g.start = g.end + 1;
+  for (g.end = g.start; side.rchg[g.end] != 0; ++g.end) {
+  }
+  return true;
+}
+
+bool group_previous(const Side &side, Group &g) {
+  if (g.start == 0) {
+    return false;
+  }
+  g.end = g.start - 1;
+  for (g.start = g.end; side.rchg[g.start - 1] != 0; --g.start) {
+  }
+  return true;
+}
+
+bool group_slide_down(Side &side, Group &g) {
+  if (g.end < side.nrec && side.ids[g.start] == side.ids[g.end]) {
+    side.rchg[g.start++] = 0;
+    side.rchg[g.end++] = 1;
+    while (side.rchg[g.end] != 0) {
+      ++g.end;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool group_slide_up(Side &side, Group &g) {
+  if (g.start > 0 && side.ids[g.start - 1] == side.ids[g.end - 1]) {
+    side.rchg[--g.start] = 1;
+    side.rchg[--g.end] = 0;
+    while (side.rchg[g.start - 1] != 0) {
+      --g.start;
+    }
+    return true;
+  }
+  return false;
+}
+
+// Indent heuristic (xdiffi.c): scores each position a slidable group can
+// take by the indentation and blank lines around its two boundaries
+constexpr int max_indent = 200;
+constexpr int max_blanks = 20;
+constexpr long indent_heuristic_max_sliding = 100;
+constexpr int start_of_file_penalty = 1;
+constexpr int end_of_file_penalty = 21;
+constexpr int total_blank_weight = -30;
+constexpr int post_blank_weight = 6;
+constexpr int relative_indent_penalty = -4;
+constexpr int relative_indent_with_blank_penalty = 10;
+constexpr int relative_outdent_penalty = 24;
+constexpr int relative_outdent_with_blank_penalty = 17;
+constexpr int relative_dedent_penalty = 23;
+constexpr int relative_dedent_with_blank_penalty = 17;
+constexpr int indent_weight = 60;
+
+struct SplitMeasurement {
+  bool end_of_file = false;
+  int indent = -1;
+  int pre_blank = 0;
+  int pre_indent = -1;
+  int post_blank = 0;
+  int post_indent = -1;
+};
+
+struct SplitScore {
+  int effective_indent = 0;
+  int penalty = 0;
+};
+
+// Indentation width of a line, or -1 if it is blank
+int get_indent(const Side &side, long line) {
+  std::string_view text = side.lines[line].view(side.text);
+  int ret = 0;
+  for (char c : text) {
+    if (std::isspace(static_cast<unsigned char>(c)) == 0) {
+      return ret;
+    }
+    if (c == ' ') {
+      ret += 1;
+    } else if (c == '\t') {
+      ret += 8 - ret % 8;
+    }
+    if (ret >= max_indent) {
+      return max_indent;
+    }
+  }
+  return -1;
+}
+
+SplitMeasurement measure_split(const Side &side, long split) {
+  SplitMeasurement m;
+  if (split >= side.nrec) {
+    m.end_of_file = true;
+    m.indent = -1;
+  } else {
+    m.indent = get_indent(side, split);
+  }
+
+  for (long i = split - 1; i >= 0; --i) {
+    m.pre_indent = get_indent(side, i);
+    if (m.pre_indent != -1) {
+      break;
+    }
+    m.pre_blank += 1;
+    if (m.pre_blank == max_blanks) {
+      m.pre_indent = 0;
+      break;
+    }
+  }
+
+  for (long i = split + 1; i < side.nrec; ++i) {
+    m.post_indent = get_indent(side, i);
+    if (m.post_indent != -1) {
+      break;
+    }
+    m.post_blank += 1;
+    if (m.post_blank == max_blanks) {
+      m.post_indent = 0;
+      break;
+    }
+  }
+  return m;
+}
+
+void score_add_split(const SplitMeasurement &m, SplitScore &s) {
+  if (m.pre_indent == -1 && m.pre_blank == 0) {
+    s.penalty += start_of_file_penalty;
+  }
+  if (m.end_of_file) {
+    s.penalty += end_of_file_penalty;
+  }
+
+  int post_blank = m.indent == -1 ? 1 + m.post_blank : 0;
+  int total_blank = m.pre_blank + post_blank;
+  s.penalty += total_blank_weight * total_blank;
+  s.penalty += post_blank_weight * post_blank;
+
+  int indent = m.indent != -1 ? m.indent : m.post_indent;
+  bool any_blanks = total_blank != 0;
+  s.effective_indent += indent;
+
+  if (indent == -1 || m.pre_indent == -1 || indent == m.pre_indent) {
+    return;
+  }
+  if (indent > m.pre_indent) {
+    s.penalty += any_blanks ? relative_indent_with_blank_penalty
+                            : relative_indent_penalty;
+  } else if (m.post_indent != -1 && m.post_indent > indent) {
+    s.penalty += any_blanks ? relative_outdent_with_blank_penalty
+                            : relative_outdent_penalty;
+  } else {
+    s.penalty += any_blanks ? relative_dedent_with_blank_penalty
+                            : relative_dedent_penalty;
+  }
+}
+
+int score_cmp(const SplitScore &s1, const SplitScore &s2) {
+  int cmp_indents = (s1.effective_indent > s2.effective_indent) -
+                    (s1.effective_indent < s2.effective_indent);
+  return indent_weight * cmp_indents + (s1.penalty - s2.penalty);
+}
+
+// Slides each group of changed lines in `side` as far as it can go, merging
+// with neighbours, then settles it next to a change on the other side or at
+// the position the indent heuristic prefers
+void change_compact(Side &side, Side &other, bool indent_heuristic) {
+  Group g;
+  Group go;
+  group_init(side, g);
+  group_init(other, go);
+
+  while (true) {
+    if (g.end != g.start) {
+      long groupsize;
+      long earliest_end;
+      long end_matching_other;
+      do {
+        groupsize = g.end - g.start;
+        end_matching_other = -1;
+
+        while (group_slide_up(side, g)) {
+          group_previous(other, go);
+        }
+        earliest_end = g.end;
+        if (go.end > go.start) {
+          end_matching_other = g.end;
+        }
+
+        while (group_slide_down(side, g)) {
+          group_next(other, go);
+          if (go.end > go.start) {
+            end_matching_other = g.end;
+          }
+        }
+      } while (groupsize != g.end - g.start);
+
+      if (g.end == earliest_end) {
+        // Not slidable
+      } else if (end_matching_other != -1) {
+        // Line up with the last change on the other side it can align with
+        while (go.end == go.start) {
+          group_slide_up(side, g);
+          group_previous(other, go);
+        }
+      } else if (indent_heuristic) {
+        long shift = earliest_end;
+        if (g.end - groupsize - 1 > shift) {
+          shift = g.end - groupsize - 1;
+        }
+        if (g.end - indent_heuristic_max_sliding > shift) {
+          shift = g.end - indent_heuristic_max_sliding;
+        }
+        long best_shift = -1;
+        SplitScore best_score;
+        for (; shift <= g.end; ++shift) {
+          SplitScore score;
+          score_add_split(measure_split(side, shift), score);
+          score_add_split(measure_split(side, shift - groupsize), score);
+          if (best_shift == -1 || score_cmp(score, best_score) <= 0) {
+            best_score = score;
+            best_shift = shift;
+          }
+        }
+        while (g.end > best_shift) {
+          group_slide_up(side, g);
+          group_previous(other, go);
+        }
+      }
+    }
+
+    if (!group_next(side, g)) {
+      break;
+    }
+    group_next(other, go);
+  }
+}
+
+struct Change {
+  long i1;
+  long i2;
+  long chg1;
+  long chg2;
+};
+
+std::vector<Change> build_script(const Side &side1, const Side &side2) {
+  std::vector<Change> changes;
+  long i1 = 0;
+  long i2 = 0;
+  while (i1 < side1.nrec || i2 < side2.nrec) {
+    if (side1.rchg[i1] == 0 && side2.rchg[i2] == 0) {
+      ++i1;
+      ++i2;
+      continue;
+    }
+    long start1 = i1;
+    long start2 = i2;
+    while (side1.rchg[i1] != 0) {
+      ++i1;
+    }
+    while (side2.rchg[i2] != 0) {
+      ++i2;
+    }
+    changes.push_back({start1, start2, i1 - start1, i2 - start2});
+  }
+  return changes;
+}
+
+// Git's default function-name rule: the line starts with a letter, '_' or
+// '$'; it is cut to 80 bytes and trailing whitespace is dropped
+bool match_func_line(std::string_view line, std::string &out) {
+  if (line.empty()) {
+    return false;
+  }
+  auto first = static_cast<unsigned char>(line.front());
+  if (std::isalpha(first) == 0 && first != '_' && first != '$') {
+    return false;
+  }
+  size_t len = std::min(line.size(), func_name_max);
+  while (len > 0 &&
+         std::isspace(static_cast<unsigned char>(line[len - 1])) != 0) {
+    --len;
+  }
+  out.assign(line.data(), len);
+  return true;
+}
+
+core::DiffLine make_line(const Side &side, long index,
+                         core::DiffLine::Type type, int old_line_no,
+                         int new_line_no) {
+  std::string_view text = side.lines[index].view(side.text);
+  core::DiffLine line;
+  line.type = type;
+  line.old_line_no = old_line_no;
+  line.new_line_no = new_line_no;
+  if (!text.empty() && text.back() == '\n') {
+    text.remove_suffix(1);
+  } else {
+    line.no_newline_at_end = true;
+  }
+  line.content.assign(text.data(), text.size());
+  return line;
+}
+
+std::string hunk_range(long start, long count) {
+  std::string out = std::to_string(count != 0 ? start + 1 : start);
+  if (count != 1) {
+    out += ',';
+    out += std::to_string(count);
+  }
+  return out;
+}
+
+std::vector<core::DiffHunk> emit_hunks(const Side &side1, const Side &side2,
+                                       const std::vector<Change> &changes,
+                                       long context) {
+  using Type = core::DiffLine::Type;
+  std::vector<core::DiffHunk> hunks;
+  std::string func_name;
+  long func_prev = -1;
+
+  size_t first = 0;
+  while (first < changes.size()) {
+    size_t last = first;
+    while (last + 1 < changes.size() &&
+           changes[last + 1].i1 - (changes[last].i1 + changes[last].chg1) <=
+               2 * context) {
+      ++last;
+    }
+
+    const Change &head = changes[first];
+    const Change &tail = changes[last];
+    long s1 = std::max(head.i1 - context, 0L);
+    long s2 = std::max(head.i2 - context, 0L);
+    long e1 = std::min(tail.i1 + tail.chg1 + context, side1.nrec);
+    long e2 = std::min(tail.i2 + tail.chg2 + context, side2.nrec);
+
+    // Nearest function line above the hunk; the previous one is kept when
+    // nothing matches between the two hunks
+    for (long l = s1 - 1; l != func_prev && l >= 0; --l) {
+      if (match_func_line(side1.lines[l].view(side1.text), func_name)) {
+        break;
+      }
+    }
+    func_prev = s1 - 1;
+
+    core::DiffHunk hunk;
+    hunk.old_start = static_cast<int>(e1 - s1 != 0 ? s1 + 1 : s1);
+    hunk.old_count = static_cast<int>(e1 - s1);
+    hunk.new_start = static_cast<int>(e2 - s2 != 0 ? s2 + 1 : s2);
+    hunk.new_count = static_cast<int>(e2 - s2);
+    hunk.header = "@@ -" + hunk_range(s1, e1 - s1) + " +" +
+                  hunk_range(s2, e2 - s2) + " @@";
+    if (!func_name.empty()) {
+      hunk.header += ' ';
+      hunk.header += func_name;
+    }
+
+    long cur1 = s1;
+    long cur2 = s2;
+    auto emit_context = [&](long until1) {
+      for (; cur1 < until1; ++cur1, ++cur2) {
+        hunk.lines.push_back(make_line(side1, cur1, Type::Context,
+                                       static_cast<int>(cur1 + 1),
+                                       static_cast<int>(cur2 + 1)));
+      }
+    };
+    for (size_t c = first; c <= last; ++c) {
+      const Change &change = changes[c];
+      emit_context(change.i1);
+      for (long i = change.i1; i < change.i1 + change.chg1; ++i) {
+        hunk.lines.push_back(
+            make_line(side1, i, Type::Deletion, static_cast<int>(i + 1), -1));
+      }
+      for (long i = change.i2; i < change.i2 + change.chg2; ++i) {
+        hunk.lines.push_back(
+            make_line(side2, i, Type::Addition, -1, static_cast<int>(i + 1)));
+      }
+      cur1 = change.i1 + change.chg1;
+      cur2 = change.i2 + change.chg2;
+    }
+    emit_context(e1);
+
+    hunks.push_back(std::move(hunk));
+    first = last + 1;
+  }
+  return hunks;
+}
+
+} // namespace
+
+core::FileDiff DiffEngine::diff(std::string_view old_text,
+                                std::string_view new_text,
+                                const DiffOptions &options,
+                                const CancellationToken &token) {
+  core::FileDiff result;
+  if (old_text == new_text) {
+    return result;
+  }
+  if (old_text.size() > options.max_input_bytes ||
+      new_text.size() > options.max_input_bytes) {
+    result.is_too_large = true;
+    return result;
+  }
+  if (is_binary(old_text) || is_binary(new_text)) {
+    result.is_binary = true;
+    return result;
+  }
+
+  Classified classified = classify(old_text, new_text);
+  auto n1 = static_cast<long>(classified.ids1.size());
+  auto n2 = static_cast<long>(classified.ids2.size());
+  std::vector<char> rchg1(static_cast<size_t>(n1 + 2), 0);
+  std::vector<char> rchg2(static_cast<size_t>(n2 + 2), 0);
+  Side side1{old_text, classified.lines1.data(), classified.ids1.data(),
+             rchg1.data() + 1, n1};
+  Side side2{new_text, classified.lines2.data(), classified.ids2.data(),
+             rchg2.data() + 1, n2};
+
+  MyersDiff myers(classified.class_count, options.minimal, token);
+  if (options.algorithm == DiffAlgorithm::Histogram) {
+    HistogramDiff histogram(side1.ids, side2.ids, side1.rchg, side2.rchg,
+                            myers, token);
+    histogram.run(1, static_cast<int>(n1), 1, static_cast<int>(n2));
+  } else {
+    myers.run(side1.ids, n1, side2.ids, n2, side1.rchg, side2.rchg);
+  }
+  token.throw_if_cancelled();
+
+  change_compact(side1, side2, options.indent_heuristic);
+  change_compact(side2, side1, options.indent_heuristic);
+
+  result.hunks = emit_hunks(side1, side2, build_script(side1, side2),
+                            std::max(options.context_lines, 0));
+  return result;
+}
+
+std::string DiffEngine::format_hunks(const core::FileDiff &diff) {
+  std::string out;
+  for (const auto &hunk : diff.hunks) {
+    out += hunk.header;
+    out += '\n';
+    for (const auto &line : hunk.lines) {
+      switch (line.type) {
+      case core::DiffLine::Type::Addition:
+        out += '+';
+        break;
+      case core::DiffLine::Type::Deletion:
+        out += '-';
+        break;
+      case core::DiffLine::Type::Context:
+        out += ' ';
+        break;
+      case core::DiffLine::Type::Header:
+        break;
+      }
+      out += line.content;
+      out += '\n';
+      if (line.no_newline_at_end) {
+        out += "\\ No newline at end of file\n";
+      }
+    }
+  }
+  return out;
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core/models/diff.hpp"
+#include "infra/cancellation.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace slayergit::infra {
+
+enum class DiffAlgorithm { Myers, Histogram };
+
+struct DiffOptions {
+  DiffAlgorithm algorithm = DiffAlgorithm::Myers;
+  int context_lines = 3;
+  bool indent_heuristic = true; // git's default since 2.14
+  bool minimal = false;         // --minimal: never give up on the cost bound
+  // Inputs larger than this are not diffed; the result is marked
+  // is_too_large instead
+  size_t max_input_bytes = size_t{64} << 20;
+};
+
+// In-process line diff producing the same hunks as `git diff` with git's
+// default settings: the Myers variant from libxdiff (including its cost
+// heuristics, which bound the work on huge inputs), histogram diff with the
+// Myers fallback, slider compaction with the indent heuristic, and hunk
+// headers with the default function-name lookup.
+//
+// Paths are left empty; callers fill in the FileDiff metadata.
+class DiffEngine {
+public:
+  // Throws CancelledException when `token` is cancelled mid-diff
+  static core::FileDiff diff(std::string_view old_text,
+                             std::string_view new_text,
+                             const DiffOptions &options = {},
+                             const CancellationToken &token = {});
+
+  // Renders the hunks in unified format ("@@ ... @@", then prefixed lines)
+  static std::string format_hunks(const core::FileDiff &diff);
+};
+
+} // namespace slayergit::infra
@@ -0,0 +1,231 @@
+#include "line_hash.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SLAYERGIT_LINE_HASH_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SLAYERGIT_LINE_HASH_NEON 1
+#endif
+
+namespace slayergit::infra {
+
+namespace {
+
+constexpr uint64_t key_lo = 0xbe4ba423396cfeb8ULL;
+constexpr uint64_t key_hi = 0x1cad21f72c81017cULL;
+constexpr uint64_t seed_lo = 0x9e3779b185ebca87ULL;
+constexpr uint64_t seed_hi = 0xc2b2ae3d27d4eb4fULL;
+
+uint64_t finalize(uint64_t lo, uint64_t hi, size_t size) {
+  uint64_t h = lo ^ ((hi << 29) | (hi >> 35)) ^ (size * 0x165667b19e3779f9ULL);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 29;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 32;
+  return h;
+}
+
+// Both paths fold every 16-byte block into two 64-bit lanes:
+//   acc[i] += lo32(d[i] ^ key[i]) * hi32(d[i] ^ key[i]) + d[1 - i]
+// Lines shorter than 16 bytes are zero-padded to one block; longer lines end
+// with an overlapping block covering their last 16 bytes.
+
+#if defined(SLAYERGIT_LINE_HASH_SSE2)
+
+uint64_t hash_blocks(const char *data, size_t size) {
+  const __m128i key = _mm_set_epi64x(static_cast<long long>(key_hi),
+                                     static_cast<long long>(key_lo));
+  __m128i acc = _mm_set_epi64x(static_cast<long long>(seed_hi),
+                               static_cast<long long>(seed_lo));
+  auto fold = [&](__m128i block) {
+    __m128i keyed = _mm_xor_si128(block, key);
+    __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+    __m128i swapped = _mm_shuffle_epi32(block, _MM_SHUFFLE(1, 0, 3, 2));
+    acc = _mm_add_epi64(acc, _mm_add_epi64(product, swapped));
+  };
+
+  if (size < 16) {
+    char padded[16] = {};
+    std::memcpy(padded, data, size);
+    fold(_mm_loadu_si128(reinterpret_cast<const __m128i *>(padded)));
+  } else {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+      fold(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+    }
+    if (i < size) {
+      fold(_mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(data + size - 16)));
+    }
+  }
+
+  alignas(16) uint64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+  return finalize(lanes[0], lanes[1], size);
+}
+
+void find_newlines(const char *data, size_t size, std::vector<uint32_t> &ends) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    auto mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+    while (mask != 0) {
+      ends.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask)));
+      mask &= mask - 1;
+    }
+  }
+  for (; i < size; ++i) {
+    if (data[i] == '\n') {
+      ends.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+#elif defined(SLAYERGIT_LINE_HASH_NEON)
+
+uint64_t hash_blocks(const char *data, size_t size) {
+  const uint64x2_t key = vcombine_u64(vcreate_u64(key_lo), vcreate_u64(key_hi));
+  uint64x2_t acc = vcombine_u64(vcreate_u64(seed_lo), vcreate_u64(seed_hi));
+  auto fold = [&](const char *p) {
+    uint64x2_t block = vreinterpretq_u64_u8(
+        vld1q_u8(reinterpret_cast<const uint8_t *>(p)));
+    uint64x2_t keyed = veorq_u64(block, key);
+    uint64x2_t product =
+        vmull_u32(vmovn_u64(keyed), vshrn_n_u64(keyed, 32));
+    acc = vaddq_u64(acc, vaddq_u64(product, vextq_u64(block, block, 1)));
+  };
+
+  if (size < 16) {
+    char padded[16] = {};
+    std::memcpy(padded, data, size);
+    fold(padded);
+  } else {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+      fold(data + i);
+    }
+    if (i < size) {
+      fold(data + size - 16);
+    }
+  }
+  return finalize(vgetq_lane_u64(acc, 0), vgetq_lane_u64(acc, 1), size);
+}
+
+void find_newlines(const char *data, size_t size, std::vector<uint32_t> &ends) {
+  const uint8x16_t newline = vdupq_n_u8('\n');
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t eq =
+        vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(data + i)), newline);
+    // Four mask bits per byte
+    uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+    while (mask != 0) {
+      int bit = __builtin_ctzll(mask);
+      ends.push_back(static_cast<uint32_t>(i + bit / 4));
+      mask &= ~(uint64_t{0xf} << (bit & ~3));
+    }
+  }
+  for (; i < size; ++i) {
+    if (data[i] == '\n') {
+      ends.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+#else
+
+uint64_t load64(const char *p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint64_t hash_blocks(const char *data, size_t size) {
+  uint64_t acc_lo = seed_lo;
+  uint64_t acc_hi = seed_hi;
+  auto fold = [&](const char *p) {
+    uint64_t lo = load64(p);
+    uint64_t hi = load64(p + 8);
+    uint64_t keyed_lo = lo ^ key_lo;
+    uint64_t keyed_hi = hi ^ key_hi;
+    acc_lo += (keyed_lo & 0xffffffffULL) * (keyed_lo >> 32) + hi;
+    acc_hi += (keyed_hi & 0xffffffffULL) * (keyed_hi >> 32) + lo;
+  };
+
+  if (size < 16) {
+    char padded[16] = {};
+    std::memcpy(padded, data, size);
+    fold(padded);
+  } else {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+      fold(data + i);
+    }
+    if (i < size) {
+      fold(data + size - 16);
+    }
+  }
+  return finalize(acc_lo, acc_hi, size);
+}
+
+void find_newlines(const char *data, size_t size, std::vector<uint32_t> &ends) {
+  const char *p = data;
+  const char *end = data + size;
+  while (p < end) {
+    const void *hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    if (hit == nullptr) {
+      break;
+    }
+    p = static_cast<const char *>(hit);
+    ends.push_back(static_cast<uint32_t>(p - data));
+    ++p;
+  }
+}
+
+#endif
+
+} // namespace
+
+uint64_t hash_line(const char *data, size_t size) {
+  return hash_blocks(data, size);
+}
+
+std::vector<LineRef> hash_lines(std::string_view text) {
+  std::vector<uint32_t> ends;
+  // Source code averages well over 16 bytes per line
+  ends.reserve(text.size() / 16 + 1);
+  find_newlines(text.data(), text.size(), ends);
+
+  std::vector<LineRef> lines;
+  lines.reserve(ends.size() + 1);
+  uint32_t start = 0;
+  for (uint32_t end : ends) {
+    uint32_t size = end + 1 - start;
+    lines.push_back({start, size, hash_blocks(text.data() + start, size)});
+    start = end + 1;
+  }
+  if (start < text.size()) {
+    auto size = static_cast<uint32_t>(text.size() - start);
+    lines.push_back({start, size, hash_blocks(text.data() + start, size)});
+  }
+  return lines;
+}
+
+const char *line_hash_backend() {
+#if defined(SLAYERGIT_LINE_HASH_SSE2)
+  return "sse2";
+#elif defined(SLAYERGIT_LINE_HASH_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+} // namespace slayergit::infra
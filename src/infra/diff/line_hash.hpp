@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::infra {
+
+// One line of a buffer, including its trailing '\n' (the last line may lack
+// one). Lines with the same bytes have the same hash.
+struct LineRef {
+  uint32_t offset = 0;
+  uint32_t size = 0;
+  uint64_t hash = 0;
+
+  [[nodiscard]] std::string_view view(std::string_view text) const {
+    return text.substr(offset, size);
+  }
+};
+
+// Splits `text` into lines and hashes each one. Newlines are located 16 bytes
+// at a time (SSE2 / NEON) and lines are hashed in 16-byte lanes, with a
+// scalar path producing identical hashes on other targets.
+std::vector<LineRef> hash_lines(std::string_view text);
+
+// Hash of a single line as computed by hash_lines()
+uint64_t hash_line(const char *data, size_t size);
+
+// Name of the code path hash_lines() uses on this build ("sse2", "neon" or
+// "scalar"), reported by the benchmarks
+const char *line_hash_backend();
+
+} // namespace slayergit::infra
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace slayergit {
+
+class SlayerGitException : public std::runtime_error {
+public:
+  explicit SlayerGitException(const std::string &message)
+      : std::runtime_error(message) {}
+};
+
+class GitCommandException : public SlayerGitException {
+public:
+  GitCommandException(std::string command, int exit_code,
+                      std::string stderr_output)
+      : SlayerGitException(format_message(command, exit_code, stderr_output)),
+        command_(std::move(command)), exit_code_(exit_code),
+        stderr_output_(std::move(stderr_output)) {}
+
+  [[nodiscard]] const std::string &command() const { return command_; }
+  [[nodiscard]] int exit_code() const { return exit_code_; }
+  [[nodiscard]] const std::string &stderr_output() const {
+    return stderr_output_;
+  }
+
+private:
+  static std::string format_message(const std::string &command, int exit_code,
+                                    const std::string &stderr_output) {
+    return "Git command failed: " + command +
+           " (exit code: " + std::to_string(exit_code) + ")\n" +
+           stderr_output;
+  }
+
+  std::string command_;
+  int exit_code_;
+  std::string stderr_output_;
+};
+
+class ParseException : public SlayerGitException {
+public:
+  explicit ParseException(const std::string &message)
+      : SlayerGitException("Parse error: " + message) {}
+};
+
+// Thrown when work is abandoned through a CancellationToken
+class CancelledException : public SlayerGitException {
+public:
+  CancelledException() : SlayerGitException("Operation cancelled") {}
+};
+
+} // namespace slayergit
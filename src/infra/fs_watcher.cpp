@@ -0,0 +1,210 @@
+#include "fs_watcher.hpp"
+
+#include "exceptions.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <poll.h>
+#include <system_error>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace slayergit::infra {
+
+namespace {
+
+#ifdef __linux__
+// Writes are reported once, on close, unless IN_MODIFY is asked for; it
+// fires per write()
+constexpr uint32_t watch_mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB |
+                                IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+
+constexpr size_t event_buffer_size = 64 * 1024;
+
+} // namespace
+
+FsWatcher::FsWatcher(bool every_write) {
+#ifdef __linux__
+  mask_ = watch_mask | (every_write ? IN_MODIFY : 0);
+#else
+  (void)every_write;
+#endif
+#ifdef __linux__
+  inotify_.reset(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+#endif
+  int fds[2];
+  if (::pipe2(fds, O_CLOEXEC) != 0) {
+    throw SlayerGitException(std::string("cannot create pipe: ") +
+                             std::strerror(errno));
+  }
+  wake_read_.reset(fds[0]);
+  wake_write_.reset(fds[1]);
+}
+
+FsWatcher::~FsWatcher() { stop(); }
+
+bool FsWatcher::add(const std::string &dir, bool recursive, Filter skip) {
+  auto filter = skip ? std::make_shared<const Filter>(std::move(skip))
+                     : std::shared_ptr<const Filter>();
+  if (!recursive) {
+    return add_one(dir, false, filter);
+  }
+  if (!add_one(dir, true, filter)) {
+    return false;
+  }
+  add_tree(dir, filter);
+  return true;
+}
+
+bool FsWatcher::add_one(const std::string &dir, bool recursive,
+                        const std::shared_ptr<const Filter> &skip) {
+#ifdef __linux__
+  if (!inotify_.valid()) {
+    return false;
+  }
+  int wd = ::inotify_add_watch(inotify_.get(), dir.c_str(), mask_);
+  if (wd < 0) {
+    if (errno == ENOSPC) {
+      limit_reached_ = true;
+    }
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  watches_[wd] = Watch{dir, recursive, skip};
+  return true;
+#else
+  (void)dir;
+  (void)recursive;
+  (void)skip;
+  return false;
+#endif
+}
+
+void FsWatcher::add_tree(const std::string &dir,
+                         const std::shared_ptr<const Filter> &skip) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  for (fs::recursive_directory_iterator it(dir, error), end;
+       !error && it != end; it.increment(error)) {
+    if (!it->is_directory(error) || it->is_symlink(error)) {
+      continue;
+    }
+    std::string path = it->path().string();
+    if ((skip && (*skip)(path)) || !add_one(path, true, skip)) {
+      it.disable_recursion_pending();
+    }
+  }
+}
+
+void FsWatcher::start(Callback callback) {
+  stop();
+#ifndef __linux__
+  throw SlayerGitException("file watching needs inotify (Linux)");
+#endif
+  if (!inotify_.valid()) {
+    throw SlayerGitException("inotify is not available");
+  }
+  callback_ = std::move(callback);
+  stopping_ = false;
+  thread_ = std::thread([this] { run(); });
+}
+
+void FsWatcher::stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  stopping_ = true;
+  char byte = 0;
+  [[maybe_unused]] ssize_t written = ::write(wake_write_.get(), &byte, 1);
+  thread_.join();
+  // Consume the wake byte so a later start() does not return at once
+  [[maybe_unused]] ssize_t drained = ::read(wake_read_.get(), &byte, 1);
+}
+
+size_t FsWatcher::watch_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return watches_.size();
+}
+
+void FsWatcher::run() {
+  std::vector<std::string> paths;
+  while (!stopping_) {
+    pollfd fds[2] = {{inotify_.get(), POLLIN, 0}, {wake_read_.get(), POLLIN, 0}};
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (stopping_ || (fds[1].revents & POLLIN) != 0) {
+      break;
+    }
+    paths.clear();
+    read_events(paths);
+    if (!paths.empty()) {
+      callback_(paths);
+    }
+  }
+}
+
+void FsWatcher::read_events(std::vector<std::string> &paths) {
+#ifdef __linux__
+  alignas(inotify_event) char buffer[event_buffer_size];
+  while (true) {
+    ssize_t length = ::read(inotify_.get(), buffer, sizeof(buffer));
+    if (length <= 0) {
+      return; // EAGAIN: drained
+    }
+    for (ssize_t offset = 0; offset < length;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+      if ((event->mask & IN_Q_OVERFLOW) != 0) {
+        paths.emplace_back();
+        continue;
+      }
+      Watch watch;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = watches_.find(event->wd);
+        if (it == watches_.end()) {
+          continue;
+        }
+        if ((event->mask & IN_IGNORED) != 0) {
+          watches_.erase(it); // Directory deleted or unmounted
+          continue;
+        }
+        watch = it->second;
+      }
+      std::string path = watch.dir;
+      if (event->len > 0) {
+        path += '/';
+        path += event->name;
+      }
+      // Watch new directories too. Files created in one before its watch
+      // existed are covered by the directory's own event.
+      if (watch.recursive && (event->mask & IN_ISDIR) != 0 &&
+          (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0 &&
+          !(watch.skip && (*watch.skip)(path)) &&
+          add_one(path, true, watch.skip)) {
+        add_tree(path, watch.skip);
+      }
+      if ((event->mask & IN_ISDIR) != 0) {
+        path += '/';
+      }
+      paths.push_back(std::move(path));
+    }
+  }
+#else
+  (void)paths;
+#endif
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "process.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace slayergit::infra {
+
+// Reports changes below watched directories through inotify, on a reader
+// thread of its own. Linux only: elsewhere add() watches nothing and
+// start() throws SlayerGitException.
+class FsWatcher {
+public:
+  // Absolute paths of the entries that changed, one batch per read;
+  // directories end with '/'. An empty path means the kernel queue
+  // overflowed and events were lost.
+  using Callback = std::function<void(const std::vector<std::string> &paths)>;
+  // True to leave a directory, and everything below it, unwatched
+  using Filter = std::function<bool(const std::string &dir)>;
+
+  // Writes are reported when the file is closed. With `every_write`,
+  // each write() and truncate is reported too (IN_MODIFY), for files kept
+  // open or mapped while written.
+  explicit FsWatcher(bool every_write = false);
+  ~FsWatcher();
+
+  FsWatcher(const FsWatcher &) = delete;
+  FsWatcher &operator=(const FsWatcher &) = delete;
+
+  // Watches `dir`; with `recursive`, also its subdirectories, including
+  // those created later. False if `dir` could not be watched.
+  bool add(const std::string &dir, bool recursive, Filter skip = {});
+
+  void start(Callback callback);
+  void stop();
+
+  [[nodiscard]] size_t watch_count() const;
+  // Set once fs.inotify.max_user_watches stopped a watch from being added
+  [[nodiscard]] bool limit_reached() const { return limit_reached_; }
+
+private:
+  struct Watch {
+    std::string dir;
+    bool recursive = false;
+    std::shared_ptr<const Filter> skip;
+  };
+
+  bool add_one(const std::string &dir, bool recursive,
+               const std::shared_ptr<const Filter> &skip);
+  void add_tree(const std::string &dir,
+                const std::shared_ptr<const Filter> &skip);
+  void run();
+  void read_events(std::vector<std::string> &paths);
+
+  uint32_t mask_ = 0;
+  UniqueFd inotify_;
+  UniqueFd wake_read_;
+  UniqueFd wake_write_;
+  mutable std::mutex mutex_;
+  std::unordered_map<int, Watch> watches_;
+  std::atomic<bool> limit_reached_{false};
+  std::atomic<bool> stopping_{false};
+  Callback callback_;
+  std::thread thread_;
+};
+
+} // namespace slayergit::infra
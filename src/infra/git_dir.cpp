@@ -0,0 +1,97 @@
+#include "git_dir.hpp"
+
+#include "exceptions.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace slayergit::infra {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// First line of a small text file, without the newline
+std::string read_line(const fs::path &path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+    line.pop_back();
+  }
+  return line;
+}
+
+fs::path resolve(const fs::path &base, const std::string &path) {
+  fs::path result(path);
+  if (result.is_relative()) {
+    result = base / result;
+  }
+  return result.lexically_normal();
+}
+
+bool is_git_dir(const fs::path &dir) {
+  std::error_code error;
+  return fs::is_regular_file(dir / "HEAD", error) &&
+         (fs::is_directory(dir / "objects", error) ||
+          fs::is_regular_file(dir / "commondir", error));
+}
+
+std::string without_trailing_slash(const fs::path &path) {
+  std::string value = path.string();
+  while (value.size() > 1 && value.back() == '/') {
+    value.pop_back();
+  }
+  return value;
+}
+
+GitDirs make_dirs(const fs::path &work_tree, const fs::path &git_dir) {
+  GitDirs dirs;
+  dirs.work_tree = work_tree.empty() ? "" : without_trailing_slash(work_tree);
+  dirs.git_dir = without_trailing_slash(git_dir);
+  fs::path common = git_dir;
+  std::error_code error;
+  if (fs::is_regular_file(git_dir / "commondir", error)) {
+    common = resolve(git_dir, read_line(git_dir / "commondir"));
+  }
+  dirs.common_dir = without_trailing_slash(common);
+  dirs.objects_dir = without_trailing_slash(common / "objects");
+  return dirs;
+}
+
+} // namespace
+
+GitDirs resolve_git_dirs(const std::string &repo_path) {
+  std::error_code error;
+  fs::path dir = fs::absolute(repo_path, error).lexically_normal();
+  if (error) {
+    throw SlayerGitException("cannot resolve " + repo_path);
+  }
+
+  // Walk up like git does, so a subdirectory of a work tree works too
+  for (fs::path current = dir; !current.empty();
+       current = current.parent_path()) {
+    fs::path dot_git = current / ".git";
+    if (fs::is_directory(dot_git, error) && is_git_dir(dot_git)) {
+      return make_dirs(current, dot_git);
+    }
+    if (fs::is_regular_file(dot_git, error)) {
+      std::string line = read_line(dot_git);
+      const std::string prefix = "gitdir: ";
+      if (line.compare(0, prefix.size(), prefix) == 0) {
+        return make_dirs(current,
+                         resolve(current, line.substr(prefix.size())));
+      }
+    }
+    if (is_git_dir(current)) {
+      return make_dirs({}, current);
+    }
+    if (current == current.root_path()) {
+      break;
+    }
+  }
+  throw SlayerGitException("not a git repository: " + repo_path);
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+namespace slayergit::infra {
+
+// Where a repository keeps its files. In a linked worktree, the per-worktree
+// git dir (HEAD, index) differs from the common dir (refs, objects).
+struct GitDirs {
+  std::string work_tree; // Empty for a bare repository
+  std::string git_dir;
+  std::string common_dir;
+  std::string objects_dir;
+};
+
+// Resolves the directories for `repo_path` without running git: follows a
+// `.git` file ("gitdir: ...") and `commondir`, and accepts a bare repository
+// or a git dir itself. Throws SlayerGitException if none is found.
+GitDirs resolve_git_dirs(const std::string &repo_path);
+
+} // namespace slayergit::infra
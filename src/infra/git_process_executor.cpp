@@ -0,0 +1,181 @@
+#include "git_process_executor.hpp"
+
+#include "exceptions.hpp"
+#include "process.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+namespace slayergit::infra {
+
+namespace {
+
+// Per-pipe reader state: the block currently being filled and where to
+// deliver what was read into it
+struct PipeReader {
+  int fd = -1;
+  OutputBuffer buffer;
+  const std::function<void(const OutputChunk &)> *handler = nullptr;
+  bool open = true;
+};
+
+// Reads everything currently available on the pipe. Returns false once the
+// write end has been closed.
+bool drain(PipeReader &reader, OutputArena &arena) {
+  for (;;) {
+    if (!reader.buffer.valid() || reader.buffer.full()) {
+      reader.buffer = arena.acquire();
+    }
+
+    ssize_t n = ::read(reader.fd, reader.buffer.write_ptr(),
+                       reader.buffer.writable());
+    if (n > 0) {
+      OutputChunk chunk = reader.buffer.commit(static_cast<size_t>(n));
+      if (reader.handler && *reader.handler) {
+        (*reader.handler)(chunk);
+      }
+      continue;
+    }
+    if (n == 0) {
+      return false;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true;
+    }
+    throw SlayerGitException(std::string("Reading git output failed: ") +
+                             std::strerror(errno));
+  }
+}
+
+void pump(ChildProcess &child, OutputArena &arena,
+          const OutputHandlers &handlers) {
+  PipeReader readers[2];
+  readers[0].fd = child.stdout_fd();
+  readers[0].handler = &handlers.on_stdout;
+  readers[1].fd = child.stderr_fd();
+  readers[1].handler = &handlers.on_stderr;
+
+  while (readers[0].open || readers[1].open) {
+    pollfd fds[2];
+    nfds_t count = 0;
+    PipeReader *polled[2];
+    for (auto &reader : readers) {
+      if (reader.open) {
+        fds[count] = pollfd{reader.fd, POLLIN, 0};
+        polled[count] = &reader;
+        ++count;
+      }
+    }
+
+    int rc = ::poll(fds, count, -1);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw SlayerGitException(std::string("poll failed: ") +
+                               std::strerror(errno));
+    }
+
+    for (nfds_t i = 0; i < count; ++i) {
+      if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+        polled[i]->open = drain(*polled[i], arena);
+      }
+    }
+  }
+}
+
+} // namespace
+
+GitProcessExecutor::GitProcessExecutor(std::string repo_path,
+                                       std::string git_binary)
+    : repo_path_(std::move(repo_path)), git_binary_(std::move(git_binary)),
+      arena_(OutputArena::create()) {}
+
+ProcessResult
+GitProcessExecutor::execute(const std::vector<std::string> &args) {
+  return execute_in_dir(repo_path_, args);
+}
+
+ProcessResult GitProcessExecutor::execute(const std::vector<std::string> &args,
+                                          const CancellationToken &token) {
+  return execute_in_dir(repo_path_, args, token);
+}
+
+std::future<ProcessResult>
+GitProcessExecutor::execute_async(std::vector<std::string> args) {
+  return std::async(std::launch::async, [this, args = std::move(args)] {
+    return execute(args);
+  });
+}
+
+std::future<ProcessResult>
+GitProcessExecutor::execute_async(std::vector<std::string> args,
+                                  TaskExecutor &tasks, TaskPriority priority) {
+  return tasks.submit(
+      [this, args = std::move(args)] { return execute(args); }, priority);
+}
+
+ProcessResult
+GitProcessExecutor::execute_in_dir(const std::string &dir,
+                                   const std::vector<std::string> &args,
+                                   const CancellationToken &token) {
+  ProcessResult result;
+  OutputHandlers handlers;
+  handlers.on_stdout = [&result](const OutputChunk &chunk) {
+    result.stdout_output.append(chunk.data(), chunk.size());
+  };
+  handlers.on_stderr = [&result](const OutputChunk &chunk) {
+    result.stderr_output.append(chunk.data(), chunk.size());
+  };
+  result.exit_code = execute_streaming_in_dir(dir, args, handlers, token);
+  return result;
+}
+
+int GitProcessExecutor::execute_streaming(const std::vector<std::string> &args,
+                                          const OutputHandlers &handlers) {
+  return execute_streaming_in_dir(repo_path_, args, handlers);
+}
+
+int GitProcessExecutor::execute_streaming(const std::vector<std::string> &args,
+                                          const OutputHandlers &handlers,
+                                          const CancellationToken &token) {
+  return execute_streaming_in_dir(repo_path_, args, handlers, token);
+}
+
+int GitProcessExecutor::execute_streaming_in_dir(
+    const std::string &dir, const std::vector<std::string> &args,
+    const OutputHandlers &handlers, const CancellationToken &token) {
+  token.throw_if_cancelled();
+  ChildProcess child = ChildProcess::spawn(build_argv(dir, args));
+  {
+    // SIGTERM lets git remove its lock files; its pipes then close, which
+    // ends pump(). Unregistered before wait() so a reaped pid is never
+    // signalled.
+    auto registration = token.on_cancel([&child] { child.terminate(); });
+    pump(child, *arena_, handlers);
+  }
+  int exit_code = child.wait();
+  token.throw_if_cancelled();
+  return exit_code;
+}
+
+std::vector<std::string>
+GitProcessExecutor::build_argv(const std::string &dir,
+                               const std::vector<std::string> &args) const {
+  std::vector<std::string> argv;
+  argv.reserve(args.size() + 3);
+  argv.push_back(git_binary_);
+  if (!dir.empty()) {
+    argv.push_back("-C");
+    argv.push_back(dir);
+  }
+  argv.insert(argv.end(), args.begin(), args.end());
+  return argv;
+}
+
+} // namespace slayergit::infra
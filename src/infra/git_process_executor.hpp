@@ -0,0 +1,76 @@
+#pragma once
+
+#include "cancellation.hpp"
+#include "output_arena.hpp"
+#include "task_executor.hpp"
+
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace slayergit::infra {
+
+struct ProcessResult {
+  int exit_code = -1;
+  std::string stdout_output;
+  std::string stderr_output;
+};
+
+// Receives output while the command is still running. Handlers run on the
+// thread that called execute_streaming(); chunks stay valid for as long as
+// the handler keeps a copy of them.
+struct OutputHandlers {
+  std::function<void(const OutputChunk &)> on_stdout;
+  std::function<void(const OutputChunk &)> on_stderr;
+};
+
+// Runs git as a child process. Output is read without blocking from both
+// pipes into blocks of a shared OutputArena and handed out as chunks, so
+// large outputs (log, diff) can be parsed while git is still producing them.
+class GitProcessExecutor {
+public:
+  explicit GitProcessExecutor(std::string repo_path,
+                              std::string git_binary = "git");
+  virtual ~GitProcessExecutor() = default;
+
+  // Collects the full output; for commands whose output is small
+  virtual ProcessResult execute(const std::vector<std::string> &args);
+  // Cancelling `token` sends SIGTERM to git and throws CancelledException
+  // from here once it has exited
+  ProcessResult execute(const std::vector<std::string> &args,
+                        const CancellationToken &token);
+  std::future<ProcessResult> execute_async(std::vector<std::string> args);
+  // Runs on the shared pool instead of a thread of its own
+  std::future<ProcessResult>
+  execute_async(std::vector<std::string> args, TaskExecutor &tasks,
+                TaskPriority priority = TaskPriority::Visible);
+  ProcessResult execute_in_dir(const std::string &dir,
+                               const std::vector<std::string> &args,
+                               const CancellationToken &token = {});
+
+  // Streams output to the handlers and returns git's exit code
+  virtual int execute_streaming(const std::vector<std::string> &args,
+                                const OutputHandlers &handlers);
+  int execute_streaming(const std::vector<std::string> &args,
+                        const OutputHandlers &handlers,
+                        const CancellationToken &token);
+  int execute_streaming_in_dir(const std::string &dir,
+                               const std::vector<std::string> &args,
+                               const OutputHandlers &handlers,
+                               const CancellationToken &token = {});
+
+  [[nodiscard]] const std::string &repo_path() const { return repo_path_; }
+  [[nodiscard]] const OutputArenaPtr &arena() const { return arena_; }
+
+private:
+  [[nodiscard]] std::vector<std::string>
+  build_argv(const std::string &dir,
+             const std::vector<std::string> &args) const;
+
+  std::string repo_path_;
+  std::string git_binary_;
+  OutputArenaPtr arena_;
+};
+
+} // namespace slayergit::infra
@@ -0,0 +1,66 @@
+#include "mapped_file.hpp"
+
+#include "exceptions.hpp"
+#include "process.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace slayergit::infra {
+
+MappedFile::MappedFile(const std::string &path) : path_(path) {
+  UniqueFd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!fd.valid()) {
+    throw SlayerGitException("cannot open " + path + ": " +
+                             std::strerror(errno));
+  }
+  struct stat info {};
+  if (::fstat(fd.get(), &info) != 0) {
+    throw SlayerGitException("cannot stat " + path + ": " +
+                             std::strerror(errno));
+  }
+  size_ = static_cast<size_t>(info.st_size);
+  // mmap rejects empty mappings; an empty file is simply no data
+  if (size_ == 0) {
+    return;
+  }
+  void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (mapping == MAP_FAILED) {
+    throw SlayerGitException("cannot map " + path + ": " +
+                             std::strerror(errno));
+  }
+  data_ = static_cast<const uint8_t *>(mapping);
+}
+
+MappedFile::~MappedFile() { reset(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : path_(std::move(other.path_)), data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    reset();
+    path_ = std::move(other.path_);
+    data_ = other.data_;
+    size_ = other.size_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+void MappedFile::reset() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<uint8_t *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+} // namespace slayergit::infra
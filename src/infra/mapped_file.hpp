@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace slayergit::infra {
+
+// Read-only mmap of a whole file. Git's binary files (commit-graph, index,
+// pack indexes, ...) are read in place through this instead of being
+// copied into memory.
+class MappedFile {
+public:
+  MappedFile() = default;
+  // Throws SlayerGitException if the file cannot be opened or mapped
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  [[nodiscard]] const uint8_t *data() const { return data_; }
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] std::string_view view() const {
+    return {reinterpret_cast<const char *>(data_), size_};
+  }
+  [[nodiscard]] const std::string &path() const { return path_; }
+
+private:
+  void reset();
+
+  std::string path_;
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Big-endian readers for on-disk git formats
+inline uint32_t read_be32(const uint8_t *p) {
+  return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) |
+         (uint32_t{p[2]} << 8) | uint32_t{p[3]};
+}
+
+inline uint64_t read_be64(const uint8_t *p) {
+  return (uint64_t{read_be32(p)} << 32) | read_be32(p + 4);
+}
+
+inline uint16_t read_be16(const uint8_t *p) {
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,65 @@
+#include "output_arena.hpp"
+
+namespace slayergit::infra {
+
+OutputChunk OutputBuffer::commit(size_t length) {
+  const char *start = block_.get() + filled_;
+  filled_ += length;
+  return OutputChunk(std::shared_ptr<const char>(block_), start, length);
+}
+
+OutputArena::OutputArena(size_t block_size, size_t max_free_blocks)
+    : block_size_(block_size), max_free_blocks_(max_free_blocks) {}
+
+std::shared_ptr<OutputArena> OutputArena::create(size_t block_size,
+                                                 size_t max_free_blocks) {
+  return std::shared_ptr<OutputArena>(
+      new OutputArena(block_size, max_free_blocks));
+}
+
+OutputBuffer OutputArena::acquire() {
+  std::unique_ptr<char[]> block;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_blocks_.empty()) {
+      block = std::move(free_blocks_.back());
+      free_blocks_.pop_back();
+      ++stats_.blocks_reused;
+    } else {
+      ++stats_.blocks_allocated;
+    }
+  }
+  if (!block) {
+    block.reset(new char[block_size_]);
+  }
+
+  // The deleter only holds a weak reference, so outstanding chunks never
+  // keep a destroyed arena alive; orphaned blocks are simply freed.
+  std::weak_ptr<OutputArena> weak_arena = weak_from_this();
+  std::shared_ptr<char> shared(block.release(), [weak_arena](char *raw) {
+    if (auto arena = weak_arena.lock()) {
+      arena->release(raw);
+    } else {
+      delete[] raw;
+    }
+  });
+  return OutputBuffer(std::move(shared), block_size_);
+}
+
+OutputArena::Stats OutputArena::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.blocks_free = free_blocks_.size();
+  return stats;
+}
+
+void OutputArena::release(char *block) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_blocks_.size() < max_free_blocks_) {
+    free_blocks_.emplace_back(block);
+  } else {
+    delete[] block;
+  }
+}
+
+} // namespace slayergit::infra
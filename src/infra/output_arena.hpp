@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::infra {
+
+// Read-only view of bytes inside an arena block. Holding a chunk keeps its
+// block alive; the block goes back to the arena once every chunk that points
+// into it has been dropped.
+class OutputChunk {
+public:
+  OutputChunk() = default;
+  OutputChunk(std::shared_ptr<const char> block, const char *data, size_t size)
+      : block_(std::move(block)), data_(data), size_(size) {}
+
+  [[nodiscard]] const char *data() const { return data_; }
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  [[nodiscard]] std::string_view view() const { return {data_, size_}; }
+
+  // Narrows the view without touching the bytes
+  [[nodiscard]] OutputChunk slice(size_t offset, size_t length) const {
+    return OutputChunk(block_, data_ + offset, length);
+  }
+
+private:
+  std::shared_ptr<const char> block_;
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Writable block owned by the reader side of a pipe. Bytes are read straight
+// into it and then published as OutputChunks, so they are never copied on
+// their way to a consumer.
+class OutputBuffer {
+public:
+  OutputBuffer() = default;
+  OutputBuffer(std::shared_ptr<char> block, size_t capacity)
+      : block_(std::move(block)), capacity_(capacity) {}
+
+  [[nodiscard]] bool valid() const { return block_ != nullptr; }
+  [[nodiscard]] char *write_ptr() { return block_.get() + filled_; }
+  [[nodiscard]] size_t writable() const { return capacity_ - filled_; }
+  [[nodiscard]] bool full() const { return filled_ == capacity_; }
+
+  // Publishes the next `length` bytes written at write_ptr()
+  OutputChunk commit(size_t length);
+
+private:
+  std::shared_ptr<char> block_;
+  size_t capacity_ = 0;
+  size_t filled_ = 0;
+};
+
+// Pool of fixed-size blocks that process output is read into. Released
+// blocks are kept on a free list (up to a limit), so streaming a large
+// command reuses a handful of blocks instead of growing one string.
+class OutputArena : public std::enable_shared_from_this<OutputArena> {
+public:
+  static constexpr size_t default_block_size = 64 * 1024;
+  static constexpr size_t default_max_free_blocks = 32;
+
+  struct Stats {
+    size_t blocks_allocated = 0;
+    size_t blocks_reused = 0;
+    size_t blocks_free = 0;
+  };
+
+  static std::shared_ptr<OutputArena>
+  create(size_t block_size = default_block_size,
+         size_t max_free_blocks = default_max_free_blocks);
+
+  [[nodiscard]] OutputBuffer acquire();
+
+  [[nodiscard]] size_t block_size() const { return block_size_; }
+  [[nodiscard]] Stats stats() const;
+
+private:
+  OutputArena(size_t block_size, size_t max_free_blocks);
+
+  void release(char *block);
+
+  size_t block_size_;
+  size_t max_free_blocks_;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<char[]>> free_blocks_;
+  Stats stats_;
+};
+
+using OutputArenaPtr = std::shared_ptr<OutputArena>;
+
+} // namespace slayergit::infra
@@ -0,0 +1,192 @@
+#include "diff_parser.hpp"
+
+#include "infra/exceptions.hpp"
+
+namespace slayergit::infra {
+
+namespace {
+
+bool starts_with(std::string_view value, std::string_view prefix) {
+  return value.substr(0, prefix.size()) == prefix;
+}
+
+int parse_number(std::string_view &value, std::string_view line) {
+  if (value.empty() || value.front() < '0' || value.front() > '9') {
+    throw ParseException("invalid hunk header '" + std::string(line) + "'");
+  }
+  int result = 0;
+  while (!value.empty() && value.front() >= '0' && value.front() <= '9') {
+    result = result * 10 + (value.front() - '0');
+    value.remove_prefix(1);
+  }
+  return result;
+}
+
+// Parses "-start[,count]" / "+start[,count]"; count defaults to 1
+void parse_range(std::string_view &value, char sign, int &start, int &count,
+                 std::string_view line) {
+  if (value.empty() || value.front() != sign) {
+    throw ParseException("invalid hunk header '" + std::string(line) + "'");
+  }
+  value.remove_prefix(1);
+  start = parse_number(value, line);
+  count = 1;
+  if (!value.empty() && value.front() == ',') {
+    value.remove_prefix(1);
+    count = parse_number(value, line);
+  }
+}
+
+core::DiffHunk parse_hunk_header(std::string_view line) {
+  core::DiffHunk hunk;
+  hunk.header = std::string(line);
+  std::string_view rest = line.substr(3); // "@@ "
+  parse_range(rest, '-', hunk.old_start, hunk.old_count, line);
+  if (rest.empty() || rest.front() != ' ') {
+    throw ParseException("invalid hunk header '" + std::string(line) + "'");
+  }
+  rest.remove_prefix(1);
+  parse_range(rest, '+', hunk.new_start, hunk.new_count, line);
+  if (!starts_with(rest, " @@")) {
+    throw ParseException("invalid hunk header '" + std::string(line) + "'");
+  }
+  return hunk;
+}
+
+// "a/path" -> "path"; quoted names keep their escapes
+std::string strip_prefix(std::string_view path) {
+  if (path.size() >= 2 && path.front() == '"' && path.back() == '"') {
+    path = path.substr(1, path.size() - 2);
+  }
+  if (path.size() > 2 && path[1] == '/' && (path[0] == 'a' || path[0] == 'b')) {
+    path.remove_prefix(2);
+  }
+  return std::string(path);
+}
+
+// "--- a/path" / "+++ b/path", with the tab git appends to names containing
+// spaces
+std::string parse_marker_path(std::string_view line) {
+  std::string_view path = line.substr(4);
+  if (!path.empty() && path.back() == '\t') {
+    path.remove_suffix(1);
+  }
+  if (path == "/dev/null") {
+    return {};
+  }
+  return strip_prefix(path);
+}
+
+} // namespace
+
+std::vector<std::string> DiffParser::diff_args() {
+  return {"diff", "--no-color", "--no-ext-diff", "--no-textconv", "-U3"};
+}
+
+core::Diff DiffParser::parse(std::string_view output) {
+  core::Diff diff;
+  core::FileDiff *file = nullptr;
+  core::DiffHunk *hunk = nullptr;
+  int old_left = 0;
+  int new_left = 0;
+  int old_line = 0;
+  int new_line = 0;
+
+  while (!output.empty()) {
+    size_t newline = output.find('\n');
+    std::string_view line = output.substr(0, newline);
+    output.remove_prefix(newline == std::string_view::npos ? output.size()
+                                                           : newline + 1);
+
+    if (hunk != nullptr && (old_left > 0 || new_left > 0)) {
+      core::DiffLine diff_line;
+      char marker = line.empty() ? ' ' : line.front();
+      diff_line.content =
+          std::string(line.empty() ? line : line.substr(1));
+      if (marker == ' ' && old_left > 0 && new_left > 0) {
+        diff_line.type = core::DiffLine::Type::Context;
+        diff_line.old_line_no = old_line++;
+        diff_line.new_line_no = new_line++;
+        --old_left;
+        --new_left;
+      } else if (marker == '-' && old_left > 0) {
+        diff_line.type = core::DiffLine::Type::Deletion;
+        diff_line.old_line_no = old_line++;
+        --old_left;
+      } else if (marker == '+' && new_left > 0) {
+        diff_line.type = core::DiffLine::Type::Addition;
+        diff_line.new_line_no = new_line++;
+        --new_left;
+      } else if (marker == '\\' && !hunk->lines.empty()) {
+        hunk->lines.back().no_newline_at_end = true;
+        continue;
+      } else {
+        throw ParseException("unexpected line in hunk '" + std::string(line) +
+                             "'");
+      }
+      hunk->lines.push_back(std::move(diff_line));
+      continue;
+    }
+
+    if (starts_with(line, "\\")) {
+      // "\ No newline at end of file" after the last line of a hunk
+      if (hunk != nullptr && !hunk->lines.empty()) {
+        hunk->lines.back().no_newline_at_end = true;
+      }
+    } else if (starts_with(line, "diff --git ")) {
+      diff.files.emplace_back();
+      file = &diff.files.back();
+      hunk = nullptr;
+      std::string_view names = line.substr(11);
+      size_t split = names.find(" b/");
+      if (split == std::string_view::npos) {
+        split = names.find(" \"b/");
+      }
+      if (split != std::string_view::npos) {
+        file->old_path = strip_prefix(names.substr(0, split));
+        file->new_path = strip_prefix(names.substr(split + 1));
+      }
+    } else if (file == nullptr) {
+      continue;
+    } else if (starts_with(line, "@@ ")) {
+      file->hunks.push_back(parse_hunk_header(line));
+      hunk = &file->hunks.back();
+      old_left = hunk->old_count;
+      new_left = hunk->new_count;
+      old_line = hunk->old_start;
+      new_line = hunk->new_start;
+    } else if (hunk != nullptr) {
+      continue; // Trailing garbage between files is not expected
+    } else if (starts_with(line, "new file mode")) {
+      file->is_new_file = true;
+    } else if (starts_with(line, "deleted file mode")) {
+      file->is_deleted = true;
+    } else if (starts_with(line, "rename from ")) {
+      file->is_renamed = true;
+      file->old_path = std::string(line.substr(12));
+    } else if (starts_with(line, "rename to ")) {
+      file->is_renamed = true;
+      file->new_path = std::string(line.substr(10));
+    } else if (starts_with(line, "Binary files ") ||
+               starts_with(line, "GIT binary patch")) {
+      file->is_binary = true;
+    } else if (starts_with(line, "--- ")) {
+      std::string path = parse_marker_path(line);
+      if (!path.empty()) {
+        file->old_path = std::move(path);
+      }
+    } else if (starts_with(line, "+++ ")) {
+      std::string path = parse_marker_path(line);
+      if (!path.empty()) {
+        file->new_path = std::move(path);
+      }
+    }
+  }
+
+  if (hunk != nullptr && (old_left > 0 || new_left > 0)) {
+    throw ParseException("truncated hunk '" + hunk->header + "'");
+  }
+  return diff;
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "core/models/diff.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::infra {
+
+// Parses unified `git diff` output (with `diff --git` headers, as printed by
+// diff, show and diff --no-index) into per-file hunks
+class DiffParser {
+public:
+  // Arguments that pin the output format regardless of user configuration
+  static std::vector<std::string> diff_args();
+
+  // Throws ParseException on malformed hunk headers or truncated hunks
+  static core::Diff parse(std::string_view output);
+};
+
+} // namespace slayergit::infra
@@ -0,0 +1,139 @@
+#include "log_parser.hpp"
+
+#include "infra/exceptions.hpp"
+
+#include <cstring>
+
+namespace slayergit::infra {
+
+namespace {
+
+std::time_t parse_timestamp(std::string_view value) {
+  if (value.empty()) {
+    throw ParseException("empty commit timestamp");
+  }
+  std::time_t result = 0;
+  for (char c : value) {
+    if (c < '0' || c > '9') {
+      throw ParseException("invalid commit timestamp '" + std::string(value) +
+                           "'");
+    }
+    result = result * 10 + (c - '0');
+  }
+  return result;
+}
+
+std::vector<std::string> split_parents(std::string_view value) {
+  std::vector<std::string> parents;
+  while (!value.empty()) {
+    size_t space = value.find(' ');
+    parents.emplace_back(value.substr(0, space));
+    if (space == std::string_view::npos) {
+      break;
+    }
+    value.remove_prefix(space + 1);
+  }
+  return parents;
+}
+
+// Git leaves the newline that ends the message on %b
+std::string_view trim_trailing_newlines(std::string_view value) {
+  while (!value.empty() && value.back() == '\n') {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+} // namespace
+
+std::vector<std::string> LogParser::log_args() {
+  return {"log", "-z", std::string("--format=") + format};
+}
+
+std::vector<core::Commit> LogParser::parse(std::string_view output) {
+  std::vector<core::Commit> commits;
+  LogParser parser;
+  auto collect = [&commits](core::Commit &&commit) {
+    commits.push_back(std::move(commit));
+  };
+  parser.feed(output, collect);
+  parser.finish(collect);
+  return commits;
+}
+
+void LogParser::feed(std::string_view chunk, const CommitCallback &on_commit) {
+  while (!chunk.empty()) {
+    const void *nul = std::memchr(chunk.data(), '\0', chunk.size());
+    if (!nul) {
+      partial_.append(chunk.data(), chunk.size());
+      return;
+    }
+
+    size_t length = static_cast<size_t>(static_cast<const char *>(nul) -
+                                        chunk.data());
+    if (partial_.empty()) {
+      // Common case: the whole field is inside this chunk
+      complete_field(chunk.substr(0, length), on_commit);
+    } else {
+      partial_.append(chunk.data(), length);
+      complete_field(partial_, on_commit);
+      partial_.clear();
+    }
+    chunk.remove_prefix(length + 1);
+  }
+}
+
+void LogParser::finish(const CommitCallback &on_commit) {
+  if (field_ == field_count - 1) {
+    complete_field(partial_, on_commit);
+  } else if (field_ != 0 || !partial_.empty()) {
+    reset();
+    throw ParseException("truncated git log output");
+  }
+  partial_.clear();
+}
+
+void LogParser::reset() {
+  current_ = core::Commit{};
+  field_ = 0;
+  partial_.clear();
+}
+
+void LogParser::complete_field(std::string_view value,
+                               const CommitCallback &on_commit) {
+  switch (field_) {
+  case 0:
+    // Record separators from `git log -z` with format: (not tformat:) show
+    // up as a leading newline on the hash
+    while (!value.empty() && value.front() == '\n') {
+      value.remove_prefix(1);
+    }
+    current_.hash.assign(value);
+    current_.short_hash.assign(value.substr(0, 7));
+    break;
+  case 1:
+    current_.author_name.assign(value);
+    break;
+  case 2:
+    current_.author_email.assign(value);
+    break;
+  case 3:
+    current_.author_date = parse_timestamp(value);
+    break;
+  case 4:
+    current_.subject.assign(value);
+    break;
+  case 5:
+    current_.body.assign(trim_trailing_newlines(value));
+    break;
+  case 6:
+    current_.parent_hashes = split_parents(value);
+    on_commit(std::move(current_));
+    current_ = core::Commit{};
+    field_ = 0;
+    return;
+  }
+  ++field_;
+}
+
+} // namespace slayergit::infra
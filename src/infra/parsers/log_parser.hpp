@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core/models/commit.hpp"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::infra {
+
+// Parses `git log -z` output produced with LogParser::format. Every field,
+// including the last one of each commit, is terminated by a NUL byte, so
+// commits can be emitted as soon as their final NUL arrives.
+//
+// The parser is incremental: feed() accepts arbitrary chunk boundaries and
+// only the field that straddles a boundary is buffered.
+class LogParser {
+public:
+  using CommitCallback = std::function<void(core::Commit &&)>;
+
+  static constexpr const char *format =
+      "%H%x00%an%x00%ae%x00%at%x00%s%x00%b%x00%P";
+
+  // Arguments for `git log` that produce output this parser understands
+  static std::vector<std::string> log_args();
+
+  // Parses a complete output buffer. Throws ParseException on bad input.
+  static std::vector<core::Commit> parse(std::string_view output);
+
+  void feed(std::string_view chunk, const CommitCallback &on_commit);
+
+  // Flushes a final commit that was not NUL-terminated
+  void finish(const CommitCallback &on_commit);
+
+  void reset();
+
+private:
+  static constexpr int field_count = 7;
+
+  void complete_field(std::string_view value, const CommitCallback &on_commit);
+
+  core::Commit current_;
+  int field_ = 0;
+  std::string partial_;
+};
+
+} // namespace slayergit::infra
@@ -0,0 +1,235 @@
+#include "process.hpp"
+
+#include "exceptions.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace slayergit::infra {
+
+namespace {
+
+struct Pipe {
+  UniqueFd read_end;
+  UniqueFd write_end;
+};
+
+Pipe make_pipe() {
+  int fds[2];
+#ifdef __linux__
+  if (::pipe2(fds, O_CLOEXEC) != 0) {
+    throw SlayerGitException(std::string("pipe2 failed: ") +
+                             std::strerror(errno));
+  }
+#else
+  if (::pipe(fds) != 0) {
+    throw SlayerGitException(std::string("pipe failed: ") +
+                             std::strerror(errno));
+  }
+  ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+  return Pipe{UniqueFd(fds[0]), UniqueFd(fds[1])};
+}
+
+// RAII holder so every exit path destroys the spawn attributes
+class FileActions {
+public:
+  FileActions() { posix_spawn_file_actions_init(&actions_); }
+  ~FileActions() { posix_spawn_file_actions_destroy(&actions_); }
+  FileActions(const FileActions &) = delete;
+  FileActions &operator=(const FileActions &) = delete;
+
+  posix_spawn_file_actions_t *get() { return &actions_; }
+
+private:
+  posix_spawn_file_actions_t actions_;
+};
+
+int decode_status(int status) {
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  if (WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+  return -1;
+}
+
+} // namespace
+
+UniqueFd &UniqueFd::operator=(UniqueFd &&other) noexcept {
+  if (this != &other) {
+    reset(other.release());
+  }
+  return *this;
+}
+
+int UniqueFd::release() {
+  int fd = fd_;
+  fd_ = -1;
+  return fd;
+}
+
+void UniqueFd::reset(int fd) {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  fd_ = fd;
+}
+
+void set_nonblocking(int fd) {
+  int flags = ::fcntl(fd, F_GETFL, 0);
+  if (flags >= 0) {
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  }
+}
+
+ChildProcess::~ChildProcess() { reap(); }
+
+void ChildProcess::reap() {
+  // Closing our ends first lets a well-behaved child exit on EOF/EPIPE
+  stdin_.reset();
+  stdout_.reset();
+  stderr_.reset();
+  if (running()) {
+    kill();
+    wait();
+  }
+}
+
+ChildProcess::ChildProcess(ChildProcess &&other) noexcept
+    : pid_(other.pid_), stdin_(std::move(other.stdin_)),
+      stdout_(std::move(other.stdout_)), stderr_(std::move(other.stderr_)) {
+  other.pid_ = -1;
+}
+
+ChildProcess &ChildProcess::operator=(ChildProcess &&other) noexcept {
+  if (this != &other) {
+    reap();
+    pid_ = other.pid_;
+    stdin_ = std::move(other.stdin_);
+    stdout_ = std::move(other.stdout_);
+    stderr_ = std::move(other.stderr_);
+    other.pid_ = -1;
+  }
+  return *this;
+}
+
+ChildProcess ChildProcess::spawn(const std::vector<std::string> &argv,
+                                 const SpawnOptions &options) {
+  if (argv.empty()) {
+    throw SlayerGitException("Cannot spawn a process without argv");
+  }
+
+  FileActions actions;
+  Pipe in_pipe;
+  Pipe out_pipe;
+  Pipe err_pipe;
+
+  // The child's ends are dup2'ed onto 0/1/2, which clears FD_CLOEXEC on the
+  // copies; the originals are closed by exec.
+  if (options.pipe_stdin) {
+    in_pipe = make_pipe();
+    posix_spawn_file_actions_adddup2(actions.get(), in_pipe.read_end.get(), 0);
+  } else {
+    posix_spawn_file_actions_addopen(actions.get(), 0, "/dev/null", O_RDONLY,
+                                     0);
+  }
+  if (options.pipe_stdout) {
+    out_pipe = make_pipe();
+    posix_spawn_file_actions_adddup2(actions.get(), out_pipe.write_end.get(),
+                                     1);
+  } else {
+    posix_spawn_file_actions_addopen(actions.get(), 1, "/dev/null", O_WRONLY,
+                                     0);
+  }
+  if (options.pipe_stderr) {
+    err_pipe = make_pipe();
+    posix_spawn_file_actions_adddup2(actions.get(), err_pipe.write_end.get(),
+                                     2);
+  } else {
+    posix_spawn_file_actions_addopen(actions.get(), 2, "/dev/null", O_WRONLY,
+                                     0);
+  }
+
+  std::vector<char *> c_argv;
+  c_argv.reserve(argv.size() + 1);
+  for (const auto &arg : argv) {
+    c_argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  c_argv.push_back(nullptr);
+
+  // glibc implements posix_spawn with CLONE_VM | CLONE_VFORK, so the parent's
+  // address space is never copied no matter how large it is.
+  pid_t pid = -1;
+  int rc = posix_spawnp(&pid, c_argv[0], actions.get(), nullptr, c_argv.data(),
+                        environ);
+  if (rc != 0) {
+    throw SlayerGitException("Failed to spawn '" + argv[0] +
+                             "': " + std::strerror(rc));
+  }
+
+  ChildProcess child;
+  child.pid_ = pid;
+  if (options.pipe_stdin) {
+    child.stdin_ = std::move(in_pipe.write_end);
+    set_nonblocking(child.stdin_.get());
+  }
+  if (options.pipe_stdout) {
+    child.stdout_ = std::move(out_pipe.read_end);
+    set_nonblocking(child.stdout_.get());
+  }
+  if (options.pipe_stderr) {
+    child.stderr_ = std::move(err_pipe.read_end);
+    set_nonblocking(child.stderr_.get());
+  }
+  return child;
+}
+
+int ChildProcess::wait() {
+  if (!running()) {
+    return -1;
+  }
+  int status = 0;
+  pid_t rc;
+  do {
+    rc = ::waitpid(pid_, &status, 0);
+  } while (rc < 0 && errno == EINTR);
+  pid_ = -1;
+  return rc < 0 ? -1 : decode_status(status);
+}
+
+bool ChildProcess::try_wait(int &exit_code) {
+  if (!running()) {
+    exit_code = -1;
+    return true;
+  }
+  int status = 0;
+  pid_t rc = ::waitpid(pid_, &status, WNOHANG);
+  if (rc == 0) {
+    return false;
+  }
+  pid_ = -1;
+  exit_code = rc < 0 ? -1 : decode_status(status);
+  return true;
+}
+
+void ChildProcess::terminate() { send_signal(SIGTERM); }
+
+void ChildProcess::kill() { send_signal(SIGKILL); }
+
+void ChildProcess::send_signal(int signal) {
+  if (running()) {
+    ::kill(pid_, signal);
+  }
+}
+
+} // namespace slayergit::infra
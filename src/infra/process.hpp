@@ -0,0 +1,87 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+namespace slayergit::infra {
+
+// Owning wrapper around a POSIX file descriptor
+class UniqueFd {
+public:
+  UniqueFd() = default;
+  explicit UniqueFd(int fd) : fd_(fd) {}
+  ~UniqueFd() { reset(); }
+
+  UniqueFd(const UniqueFd &) = delete;
+  UniqueFd &operator=(const UniqueFd &) = delete;
+  UniqueFd(UniqueFd &&other) noexcept : fd_(other.release()) {}
+  UniqueFd &operator=(UniqueFd &&other) noexcept;
+
+  [[nodiscard]] int get() const { return fd_; }
+  [[nodiscard]] bool valid() const { return fd_ >= 0; }
+  int release();
+  void reset(int fd = -1);
+
+private:
+  int fd_ = -1;
+};
+
+// Which standard streams of the child are connected to pipes. Streams that
+// are not piped are redirected to /dev/null.
+struct SpawnOptions {
+  bool pipe_stdin = false;
+  bool pipe_stdout = true;
+  bool pipe_stderr = true;
+};
+
+// A child process started with posix_spawn, together with the parent ends
+// of its pipes. The parent ends are non-blocking and close-on-exec.
+class ChildProcess {
+public:
+  ChildProcess() = default;
+  ~ChildProcess();
+
+  ChildProcess(const ChildProcess &) = delete;
+  ChildProcess &operator=(const ChildProcess &) = delete;
+  ChildProcess(ChildProcess &&other) noexcept;
+  ChildProcess &operator=(ChildProcess &&other) noexcept;
+
+  // argv[0] is looked up in PATH. Throws SlayerGitException on failure.
+  static ChildProcess spawn(const std::vector<std::string> &argv,
+                            const SpawnOptions &options = {});
+
+  [[nodiscard]] pid_t pid() const { return pid_; }
+  [[nodiscard]] bool running() const { return pid_ > 0; }
+
+  [[nodiscard]] int stdin_fd() const { return stdin_.get(); }
+  [[nodiscard]] int stdout_fd() const { return stdout_.get(); }
+  [[nodiscard]] int stderr_fd() const { return stderr_.get(); }
+  void close_stdin() { stdin_.reset(); }
+  void close_stdout() { stdout_.reset(); }
+
+  // Blocks until the child exits. Returns its exit code, or 128 + signal
+  // number if it was killed by a signal.
+  int wait();
+
+  // Non-blocking variant of wait(). Returns false while the child runs.
+  bool try_wait(int &exit_code);
+
+  void terminate();
+  void kill();
+
+private:
+  void send_signal(int signal);
+  void reap();
+
+  pid_t pid_ = -1;
+  UniqueFd stdin_;
+  UniqueFd stdout_;
+  UniqueFd stderr_;
+};
+
+// Marks a descriptor as non-blocking
+void set_nonblocking(int fd);
+
+} // namespace slayergit::infra
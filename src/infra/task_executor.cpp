@@ -0,0 +1,334 @@
+#include "task_executor.hpp"
+
+#include <algorithm>
+
+namespace slayergit::infra {
+
+namespace detail {
+
+struct TaskState {
+  enum class Status { Waiting, Queued, Running, Done, Failed, Cancelled };
+
+  std::function<void()> function;
+  TaskPriority priority = TaskPriority::Visible;
+  uint64_t generation = 0;
+  // One extra count is held by post() while dependencies are registered
+  std::atomic<size_t> unfinished_dependencies{1};
+  std::chrono::steady_clock::time_point ready_at;
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  Status status = Status::Waiting;
+  std::vector<std::shared_ptr<TaskState>> dependents;
+
+  // Caller holds `mutex`
+  [[nodiscard]] bool is_finished() const {
+    return status == Status::Done || status == Status::Failed ||
+           status == Status::Cancelled;
+  }
+};
+
+} // namespace detail
+
+using detail::TaskState;
+using Status = TaskState::Status;
+
+namespace {
+
+// Lets post() called from a task put continuations on the local queue
+thread_local const TaskExecutor *current_executor = nullptr;
+thread_local size_t current_worker = 0;
+
+void update_max(std::atomic<uint64_t> &max, uint64_t value) {
+  uint64_t current = max.load(std::memory_order_relaxed);
+  while (value > current &&
+         !max.compare_exchange_weak(current, value,
+                                    std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace
+
+bool TaskHandle::done() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->is_finished();
+}
+
+bool TaskHandle::cancelled() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->status == Status::Cancelled;
+}
+
+bool TaskHandle::failed() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->status == Status::Failed;
+}
+
+void TaskHandle::wait() const {
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  state_->finished.wait(lock, [this] { return state_->is_finished(); });
+}
+
+TaskExecutor::TaskExecutor(size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // Started after all queues exist, since workers steal from each other
+  for (size_t i = 0; i < threads; ++i) {
+    workers_[i]->thread = std::thread([this, i] { run_worker(i); });
+  }
+}
+
+TaskExecutor::~TaskExecutor() {
+  stopping_ = true;
+  cancel_all();
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+  }
+  sleep_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker->thread.join();
+  }
+  // Continuations queued by tasks that were still running
+  cancel_all();
+}
+
+TaskHandle TaskExecutor::post(std::function<void()> function,
+                              TaskPriority priority,
+                              const std::vector<TaskHandle> &after) {
+  auto task = std::make_shared<TaskState>();
+  task->function = std::move(function);
+  task->priority = priority;
+  task->generation = generation_.load();
+
+  counters_[static_cast<size_t>(priority)].submitted++;
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    ++outstanding_;
+  }
+
+  bool dependency_cancelled = stopping_;
+  for (const auto &dependency : after) {
+    if (!dependency.valid()) {
+      continue;
+    }
+    auto &state = *dependency.state_;
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.status == Status::Cancelled) {
+      dependency_cancelled = true;
+    } else if (!state.is_finished()) {
+      task->unfinished_dependencies++;
+      state.dependents.push_back(task);
+    }
+  }
+
+  if (dependency_cancelled) {
+    cancel(task);
+  } else if (--task->unfinished_dependencies == 0) {
+    schedule(task);
+  }
+  return TaskHandle(task);
+}
+
+void TaskExecutor::schedule(const TaskPtr &task) {
+  if (task->generation != generation_.load()) {
+    cancel(task);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    if (task->status != Status::Waiting) {
+      return;
+    }
+    task->status = Status::Queued;
+    task->ready_at = std::chrono::steady_clock::now();
+  }
+
+  auto priority = static_cast<size_t>(task->priority);
+  size_t target = current_executor == this
+                      ? current_worker
+                      : next_worker_++ % workers_.size();
+  counters_[priority].queued++;
+  ready_++;
+  {
+    std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+    workers_[target]->queues[priority].push_back(task);
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+  }
+  sleep_cv_.notify_one();
+}
+
+void TaskExecutor::run_worker(size_t index) {
+  current_executor = this;
+  current_worker = index;
+
+  for (;;) {
+    if (auto task = find_task(index)) {
+      run(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.wait(lock, [this] { return stopping_ || ready_ > 0; });
+    if (stopping_) {
+      return;
+    }
+  }
+}
+
+TaskExecutor::TaskPtr TaskExecutor::find_task(size_t index) {
+  size_t count = workers_.size();
+  for (size_t priority = 0; priority < priority_count; ++priority) {
+    // Own queue first, oldest task first
+    for (size_t offset = 0; offset < count; ++offset) {
+      auto &worker = *workers_[(index + offset) % count];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      auto &queue = worker.queues[priority];
+      if (queue.empty()) {
+        continue;
+      }
+
+      TaskPtr task;
+      if (offset == 0) {
+        task = std::move(queue.front());
+        queue.pop_front();
+      } else {
+        // Steal the newest task, which the owner would reach last
+        task = std::move(queue.back());
+        queue.pop_back();
+        steals_++;
+      }
+      ready_--;
+      counters_[priority].queued--;
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void TaskExecutor::run(const TaskPtr &task) {
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    if (task->status != Status::Queued) {
+      return;
+    }
+    task->status = Status::Running;
+  }
+
+  auto &counters = counters_[static_cast<size_t>(task->priority)];
+  auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - task->ready_at)
+                  .count();
+  counters.waits++;
+  counters.wait_ns += static_cast<uint64_t>(wait);
+  update_max(counters.max_wait_ns, static_cast<uint64_t>(wait));
+
+  bool failed = false;
+  try {
+    task->function();
+  } catch (...) {
+    failed = true;
+  }
+  // Release captured state before dependents run
+  task->function = nullptr;
+
+  std::vector<TaskPtr> dependents;
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->status = failed ? Status::Failed : Status::Done;
+    dependents = std::move(task->dependents);
+  }
+  task->finished.notify_all();
+  counters.completed++;
+
+  release_dependents(std::move(dependents), false);
+  task_retired();
+}
+
+void TaskExecutor::cancel(const TaskPtr &task) {
+  std::function<void()> function;
+  std::vector<TaskPtr> dependents;
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    if (task->is_finished() || task->status == Status::Running) {
+      return;
+    }
+    task->status = Status::Cancelled;
+    function = std::move(task->function);
+    dependents = std::move(task->dependents);
+  }
+  task->finished.notify_all();
+  // Destroying a packaged_task here breaks the caller's future
+  function = nullptr;
+  counters_[static_cast<size_t>(task->priority)].cancelled++;
+
+  release_dependents(std::move(dependents), true);
+  task_retired();
+}
+
+void TaskExecutor::release_dependents(std::vector<TaskPtr> dependents,
+                                      bool cancelled) {
+  for (auto &dependent : dependents) {
+    if (cancelled) {
+      cancel(dependent);
+    } else if (--dependent->unfinished_dependencies == 0) {
+      schedule(dependent);
+    }
+  }
+}
+
+void TaskExecutor::task_retired() {
+  std::lock_guard<std::mutex> lock(idle_mutex_);
+  if (--outstanding_ == 0) {
+    idle_cv_.notify_all();
+  }
+}
+
+void TaskExecutor::wait_all() {
+  std::unique_lock<std::mutex> lock(idle_mutex_);
+  idle_cv_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+void TaskExecutor::cancel_all() {
+  generation_++;
+
+  std::vector<TaskPtr> dropped;
+  for (auto &worker : workers_) {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    for (size_t priority = 0; priority < priority_count; ++priority) {
+      auto &queue = worker->queues[priority];
+      ready_ -= queue.size();
+      counters_[priority].queued -= queue.size();
+      std::move(queue.begin(), queue.end(), std::back_inserter(dropped));
+      queue.clear();
+    }
+  }
+  for (auto &task : dropped) {
+    cancel(task);
+  }
+}
+
+TaskExecutor::Stats TaskExecutor::stats() const {
+  Stats stats;
+  for (size_t priority = 0; priority < priority_count; ++priority) {
+    const auto &counters = counters_[priority];
+    auto &out = stats.priorities[priority];
+    out.queued = counters.queued;
+    out.submitted = counters.submitted;
+    out.completed = counters.completed;
+    out.cancelled = counters.cancelled;
+    uint64_t waits = counters.waits;
+    out.average_wait_us =
+        waits == 0 ? 0.0 : static_cast<double>(counters.wait_ns) / waits / 1e3;
+    out.max_wait_us = static_cast<double>(counters.max_wait_ns) / 1e3;
+  }
+  stats.steals = steals_;
+  return stats;
+}
+
+} // namespace slayergit::infra
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace slayergit::infra {
+
+// Lower values run first. A worker only picks a Background task when no
+// Focused or Visible task is queued anywhere in the pool.
+enum class TaskPriority {
+  Focused = 0, // Data for the focused window
+  Visible = 1, // Other windows on screen
+  Background = 2, // Prefetching, cache warming
+};
+
+namespace detail {
+struct TaskState;
+}
+
+// Completion token of a task; pass it as a dependency to run follow-up
+// work without blocking a thread on the first task
+class TaskHandle {
+public:
+  TaskHandle() = default;
+
+  [[nodiscard]] bool valid() const { return state_ != nullptr; }
+  // Finished, successfully or not, or cancelled
+  [[nodiscard]] bool done() const;
+  [[nodiscard]] bool cancelled() const;
+  // The task threw; the exception was swallowed by the executor
+  [[nodiscard]] bool failed() const;
+  // Blocks the caller; never call from a task, use a dependency instead
+  void wait() const;
+
+private:
+  friend class TaskExecutor;
+  explicit TaskHandle(std::shared_ptr<detail::TaskState> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<detail::TaskState> state_;
+};
+
+// Fixed-size thread pool (docs §3.1.3). Each worker owns one queue per
+// priority; idle workers steal from the others, highest priority first.
+// Tasks posted from a worker (continuations) stay on that worker's queue.
+class TaskExecutor {
+public:
+  struct PriorityStats {
+    size_t queued = 0; // Ready to run right now
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t cancelled = 0;
+    // Time from becoming ready to starting on a worker
+    double average_wait_us = 0;
+    double max_wait_us = 0;
+  };
+
+  struct Stats {
+    std::array<PriorityStats, 3> priorities;
+    uint64_t steals = 0;
+
+    [[nodiscard]] const PriorityStats &
+    operator[](TaskPriority priority) const {
+      return priorities[static_cast<size_t>(priority)];
+    }
+  };
+
+  // 0 picks std::thread::hardware_concurrency()
+  explicit TaskExecutor(size_t threads = 0);
+  // Cancels queued tasks and waits for running ones
+  ~TaskExecutor();
+
+  TaskExecutor(const TaskExecutor &) = delete;
+  TaskExecutor &operator=(const TaskExecutor &) = delete;
+
+  // Runs `function` once every task in `after` has finished. If one of
+  // them is cancelled, so is this task. Exceptions are caught and only
+  // reported through TaskHandle::failed().
+  TaskHandle post(std::function<void()> function,
+                  TaskPriority priority = TaskPriority::Visible,
+                  const std::vector<TaskHandle> &after = {});
+
+  // Like post(), with the result (or exception) delivered through a
+  // future. A cancelled task leaves the future with std::future_error.
+  template <typename Function>
+  auto submit(Function &&function,
+              TaskPriority priority = TaskPriority::Visible,
+              const std::vector<TaskHandle> &after = {})
+      -> std::future<std::invoke_result_t<std::decay_t<Function>>> {
+    using Result = std::invoke_result_t<std::decay_t<Function>>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Function>(function));
+    auto future = task->get_future();
+    post([task] { (*task)(); }, priority, after);
+    return future;
+  }
+
+  // Blocks until every posted task has finished or been cancelled
+  void wait_all();
+  // Drops all tasks that have not started yet, and their dependents
+  void cancel_all();
+
+  [[nodiscard]] size_t thread_count() const { return workers_.size(); }
+  [[nodiscard]] Stats stats() const;
+
+private:
+  using TaskPtr = std::shared_ptr<detail::TaskState>;
+  static constexpr size_t priority_count = 3;
+
+  struct Worker {
+    std::mutex mutex;
+    std::array<std::deque<TaskPtr>, priority_count> queues;
+    std::thread thread;
+  };
+
+  struct Counters {
+    std::atomic<size_t> queued{0};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> cancelled{0};
+    std::atomic<uint64_t> waits{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+  };
+
+  void run_worker(size_t index);
+  TaskPtr find_task(size_t index);
+  void schedule(const TaskPtr &task);
+  void run(const TaskPtr &task);
+  void cancel(const TaskPtr &task);
+  void release_dependents(std::vector<TaskPtr> dependents, bool cancelled);
+  void task_retired();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::array<Counters, priority_count> counters_;
+  std::atomic<uint64_t> steals_{0};
+  std::atomic<size_t> next_worker_{0};
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic<size_t> ready_{0};
+  std::atomic<bool> stopping_{false};
+  // Bumped by cancel_all(); tasks posted before that never start
+  std::atomic<uint64_t> generation_{0};
+
+  // Posted but not yet finished or cancelled
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+  size_t outstanding_ = 0;
+};
+
+using TaskExecutorPtr = std::shared_ptr<TaskExecutor>;
+
+} // namespace slayergit::infra
@@ -1,51 +1,635 @@
+#include "core/ahead_behind.hpp"
+#include "core/branches.hpp"
+#include "core/commit_graph.hpp"
+#include "core/diff_cache.hpp"
+#include "core/file_history.hpp"
+#include "core/fsmonitor.hpp"
+#include "core/index_status.hpp"
+#include "core/log_stream.hpp"
+#include "core/object_database.hpp"
+#include "core/ref_snapshot.hpp"
+#include "core/refresh_log.hpp"
+#include "core/refresh_slot.hpp"
+#include "core/repo_watcher.hpp"
+#include "core/untracked.hpp"
+#include "infra/cat_file_pool.hpp"
+#include "infra/exceptions.hpp"
+#include "infra/git_dir.hpp"
+#include "infra/git_process_executor.hpp"
+#include "infra/parsers/log_parser.hpp"
+#include "infra/task_executor.hpp"
+#include "ui/components/profiler_overlay.hpp"
+#include "ui/frame_profiler.hpp"
+#include "ui/input_coalescer.hpp"
 #include "ui/input_handler.hpp"
+#include "ui/tabs/branches_tab.hpp"
+#include "ui/tabs/changes_tab.hpp"
+#include "ui/tabs/commits_tab.hpp"
+#include "ui/tabs/diff_tab.hpp"
+#include "ui/tabs/refs_tab.hpp"
+#include "ui/tabs/untracked_tab.hpp"
 #include "ui/window_manager.hpp"
 
 #include <ftxui/component/component.hpp>
+#include <ftxui/component/loop.hpp>
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/dom/elements.hpp>
 
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 using namespace ftxui;
+using namespace slayergit;
 using namespace slayergit::ui;
 
-int main() {
+namespace {
+
+// Upper bound on redraws per second
+constexpr int max_fps = 60;
+
+struct CommandLine {
+  bool watch = false;   // Refresh on file changes instead of only on F5
+  std::string watch_log; // Where watch mode appends its refreshes
+  bool fsmonitor = false; // Answer git's fsmonitor hook while running
+};
+
+bool parse_command_line(int argc, char **argv, CommandLine &command_line) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--watch") {
+      command_line.watch = true;
+    } else if (arg == "--watch-log" && i + 1 < argc) {
+      command_line.watch = true;
+      command_line.watch_log = argv[++i];
+    } else if (arg == "--fsmonitor") {
+      command_line.fsmonitor = true;
+    } else {
+      std::cerr << "usage: slayergit [--watch] [--watch-log <file>] "
+                   "[--fsmonitor]\n"
+                   "       slayergit fsmonitor --daemon\n"
+                   "       slayergit fsmonitor <version> <token>\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+// `slayergit fsmonitor --daemon` serves the current repository until
+// interrupted; `slayergit fsmonitor <version> <token>` is the hook git runs
+int run_fsmonitor(int argc, char **argv) {
+  if (argc == 3 && std::string(argv[2]) == "--daemon") {
+    // Blocked before any thread starts, so only sigwait() sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    try {
+      core::FsMonitorDaemon daemon(".");
+      daemon.start();
+      std::cerr << "fsmonitor listening on " << daemon.socket_path() << "\n";
+      int signal = 0;
+      sigwait(&signals, &signal);
+    } catch (const std::exception &e) {
+      std::cerr << "slayergit fsmonitor: " << e.what() << "\n";
+      return 1;
+    }
+    return 0;
+  }
+  if (argc == 4) {
+    return core::run_fsmonitor_hook(".", argv[2], argv[3], std::cout);
+  }
+  std::cerr << "usage: slayergit fsmonitor --daemon\n"
+               "       slayergit fsmonitor <version> <token>\n";
+  return 2;
+}
+
+// "src/main.cpp (+41 more)"
+std::string describe_cause(const core::RepoWatcher::Change &change) {
+  if (change.events <= 1) {
+    return change.cause;
+  }
+  return change.cause + " (+" + std::to_string(change.events - 1) + " more)";
+}
+
+// "12 commits changed src/main.cpp; Bloom filters skipped 98% of the
+// history, 0.4% false positives"
+std::string describe_history(const std::string &path,
+                             const core::FileHistory::Stats &stats) {
+  std::string text = std::to_string(stats.matches) + " commits changed " + path;
+  uint64_t asked = stats.bloom_definitely_not + stats.bloom_maybe;
+  if (asked == 0) {
+    return text + "; no Bloom filters in the commit-graph";
+  }
+  char rates[96];
+  std::snprintf(rates, sizeof(rates),
+                "; Bloom filters skipped %.0f%% of the history, %.1f%% false "
+                "positives",
+                100.0 * static_cast<double>(stats.bloom_definitely_not) /
+                    static_cast<double>(stats.commits_walked),
+                100.0 * stats.false_positive_rate());
+  return text + rates;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc > 1 && std::string(argv[1]) == "fsmonitor") {
+    return run_fsmonitor(argc, argv);
+  }
+  CommandLine command_line;
+  if (!parse_command_line(argc, argv, command_line)) {
+    return 2;
+  }
+  // Refreshes started by watch mode, shown in the profiler panel
+  core::RefreshLog refresh_log;
+  if (!command_line.watch_log.empty()) {
+    refresh_log.set_output(command_line.watch_log);
+  }
+
   auto screen = ScreenInteractive::Fullscreen();
 
+  // Frame and latency samples; F12 shows them over the windows
+  FrameProfiler profiler;
+  profiler.install_terminal_hook();
+
   // Create the window manager
   WindowManager wm;
+  wm.set_profiler(&profiler);
 
   // Create Window 1 with tabs
   auto window1 = wm.add_window("Window 1");
   window1->add_tab("Status");
-  window1->add_tab("Changes");
-  window1->add_tab("Staged");
+  auto changes_tab =
+      std::make_shared<ChangesTab>("Changes", ChangesTab::Side::Unstaged);
+  window1->add_tab(changes_tab);
+  auto staged_tab =
+      std::make_shared<ChangesTab>("Staged", ChangesTab::Side::Staged);
+  window1->add_tab(staged_tab);
+  auto untracked_tab = std::make_shared<UntrackedTab>("Untracked");
+  window1->add_tab(untracked_tab);
   window1->add_tab("test");
 
   // Create Window 2 with tabs
   auto window2 = wm.add_window("Window 2");
-  window2->add_tab("Log");
-  window2->add_tab("Branches");
-  window2->add_tab("Remotes");
+  auto commits_tab = std::make_shared<CommitsTab>("Log");
+  window2->add_tab(commits_tab);
+  auto file_log_tab = std::make_shared<CommitsTab>("File log");
+  file_log_tab->set_status("Enter on a changed file shows its history");
+  window2->add_tab(file_log_tab);
+  auto branches_tab = std::make_shared<BranchesTab>("Branches");
+  window2->add_tab(branches_tab);
+  auto remotes_tab = std::make_shared<RefsTab>("Remotes", "refs/remotes/");
+  window2->add_tab(remotes_tab);
+  auto tags_tab = std::make_shared<RefsTab>("Tags", "refs/tags/");
+  window2->add_tab(tags_tab);
 
   // Create Window 3 with tabs
   auto window3 = wm.add_window("Window 3");
-  window3->add_tab("Diff");
+  auto diff_tab = std::make_shared<DiffTab>("Diff");
+  diff_tab->set_status("Select a commit or a file");
+  window3->add_tab(diff_tab);
   window3->add_tab("Stash");
   window3->add_tab("Reflog");
 
   // Create the input handler
   InputHandler input_handler(wm);
   input_handler.set_quit_callback([&screen] { screen.ExitLoopClosure()(); });
+  input_handler.set_profiler(&profiler);
 
   // Create the main component from window manager
   auto main_component = wm.create_component();
 
-  main_component = CatchEvent(main_component, [&](Event event) {
-    auto result = input_handler.handle_event(event);
-    return result.handled;
+  // Held keys are merged into one command per frame
+  InputCoalescer coalescer(input_handler);
+  main_component = with_input_coalescing(main_component, coalescer);
+  main_component = with_profiler_overlay(
+      main_component, profiler, wm,
+      command_line.watch ? &refresh_log : nullptr);
+
+  // Stream the history in the background; batches repaint as they arrive.
+  // Declared after the screen so it is stopped before the screen goes away.
+  infra::GitProcessExecutor executor(".");
+  // Children before parents, as the lane graph wants. git streams
+  // --topo-order incrementally only with a commit-graph file; without one
+  // it walks the whole history before the first commit, so the log comes
+  // in date order instead and the graph copes with skewed parents.
+  bool has_commit_graph = false;
+  try {
+    has_commit_graph =
+        core::CommitGraph::open_repository(executor.repo_path()) != nullptr;
+  } catch (const SlayerGitException &) {
+    // Not a repository, or a malformed graph git ignores too; the tabs
+    // report what git says
+  }
+  core::LogStream::Options log_options;
+  if (has_commit_graph) {
+    log_options.extra_args = {"--topo-order"};
+  } else {
+    commits_tab->set_topological(false);
+  }
+  core::LogStream log_stream(executor, log_options);
+  // Ahead/behind for every branch in one history walk; outlives the tasks
+  core::AheadBehindCounter ahead_behind(executor);
+  // Untracked files without git status; outlives the tasks too
+  core::UntrackedScanner::Options untracked_options;
+  untracked_options.excludes_file = core::excludes_file_path(executor);
+  core::UntrackedScanner untracked(executor.repo_path(), untracked_options);
+  // Changed and staged files from the index, without git status
+  auto status_options = core::read_status_options(executor);
+  // Objects read in process; without it, HEAD's trees are listed by git
+  std::unique_ptr<core::ObjectDatabase> objects;
+  try {
+    objects = core::ObjectDatabase::open_repository(executor.repo_path(),
+                                                    status_options.algorithm);
+  } catch (const SlayerGitException &) {
+    // No readable objects directory; git still works
+  }
+  core::IndexStatus index_status(executor, status_options, objects.get());
+  // Blobs for the diff cache; outlives the tasks
+  infra::CatFilePool diff_pool(executor.repo_path());
+  // Empty for a bare repository, or outside one: unstaged diffs then fail
+  // with a message in the diff tab
+  std::string work_tree;
+  try {
+    work_tree = infra::resolve_git_dirs(executor.repo_path()).work_tree;
+  } catch (const SlayerGitException &) {
+    // Not a repository; every tab shows git's error
+  }
+  infra::TaskExecutor tasks;
+  // One diff per blob pair, shared by the commit and status views; the
+  // rows around the cursor are loaded ahead
+  core::DiffCache diff_cache(tasks, core::DiffCache::blob_loader(diff_pool));
+  // Commits never change, so their file lists are kept; `git diff-tree`
+  // is the only git run left on a cursor move, and none on a revisit
+  constexpr size_t kept_commit_changes = 1024;
+  std::mutex commit_changes_mutex;
+  std::unordered_map<std::string, std::vector<core::DiffEntry>>
+      commit_changes;
+  auto changes_of = [&](const std::string &hash,
+                        const infra::CancellationToken &token) {
+    {
+      std::lock_guard<std::mutex> lock(commit_changes_mutex);
+      auto found = commit_changes.find(hash);
+      if (found != commit_changes.end()) {
+        return found->second;
+      }
+    }
+    auto entries = core::commit_changes(executor, hash, token);
+    std::lock_guard<std::mutex> lock(commit_changes_mutex);
+    if (commit_changes.size() >= kept_commit_changes) {
+      commit_changes.clear();
+    }
+    commit_changes.emplace(hash, entries);
+    return entries;
+  };
+  auto show_diff = [&](std::vector<core::DiffEntry> entries,
+                       const infra::CancellationToken &token) {
+    core::Diff diff;
+    for (const auto &entry : entries) {
+      diff.files.push_back(
+          core::with_paths(entry, *diff_cache.get(entry.key, token)));
+    }
+    return diff;
+  };
+  // Loads capture the locals above by reference. The slots below cancel
+  // theirs when they go, then this waits for the running ones before any
+  // of those locals is destroyed.
+  struct DrainTasks {
+    infra::TaskExecutor &tasks;
+    ~DrainTasks() {
+      tasks.cancel_all();
+      tasks.wait_all();
+    }
+  } drain_tasks{tasks};
+  core::RefreshSlot diff_slot(tasks);
+  core::RefreshSlot prefetch_slot(tasks, infra::TaskPriority::Background);
+  auto request_diff = [&](auto load) {
+    diff_slot.request(
+        std::move(load),
+        [&](core::Diff diff) {
+          diff_tab->set_diff(std::move(diff));
+          screen.PostEvent(Event::Custom);
+        },
+        [&](const std::exception &e) {
+          diff_tab->clear();
+          diff_tab->set_status(e.what());
+          screen.PostEvent(Event::Custom);
+        });
+  };
+  auto prefetch_diffs = [&](auto list_keys) {
+    prefetch_slot.request(std::move(list_keys),
+                          [&](std::vector<core::DiffKey> keys) {
+                            diff_cache.prefetch(keys);
+                          });
+  };
+  // Merges show their changes against the first parent
+  auto show_commit = [&](const CommitsTab &tab, size_t row) {
+    std::string hash = tab.hash_at(row);
+    if (hash.empty()) {
+      return;
+    }
+    request_diff([&, hash](const infra::CancellationToken &token) {
+      return show_diff(changes_of(hash, token), token);
+    });
+    std::vector<std::string> around;
+    for (size_t other : core::rows_around(row, tab.commit_count())) {
+      around.push_back(tab.hash_at(other));
+    }
+    prefetch_diffs([&, around](const infra::CancellationToken &token) {
+      // The first screen of each; a large commit is not read whole
+      constexpr size_t files_per_commit = 16;
+      std::vector<core::DiffKey> keys;
+      for (const auto &other : around) {
+        auto entries = changes_of(other, token);
+        for (size_t i = 0; i < entries.size() && i < files_per_commit; ++i) {
+          keys.push_back(std::move(entries[i].key));
+        }
+      }
+      return keys;
+    });
+  };
+  auto show_change = [&](const ChangesTab &tab, size_t row) {
+    auto file = tab.file_at(row);
+    if (!file) {
+      return;
+    }
+    bool staged = tab.side() == ChangesTab::Side::Staged;
+    auto change_of = [&, staged](const core::FileStatus &status) {
+      return core::status_change(diff_pool, work_tree, status, staged,
+                                 status_options.algorithm);
+    };
+    request_diff([&, change_of, file = *file](
+                     const infra::CancellationToken &token) {
+      return show_diff({change_of(file)}, token);
+    });
+    std::vector<core::FileStatus> around;
+    for (size_t other : core::rows_around(row, tab.file_count())) {
+      if (auto neighbour = tab.file_at(other)) {
+        around.push_back(std::move(*neighbour));
+      }
+    }
+    prefetch_diffs([change_of, around](const infra::CancellationToken &token) {
+      std::vector<core::DiffKey> keys;
+      for (const auto &neighbour : around) {
+        token.throw_if_cancelled();
+        keys.push_back(change_of(neighbour).key);
+      }
+      return keys;
+    });
+  };
+  // Refs are read in-process; one snapshot feeds all the ref tabs
+  struct Refs {
+    std::shared_ptr<const core::RefSnapshot> snapshot;
+    std::vector<core::Branch> branches;
+  };
+  core::RefreshSlot refs_slot(tasks, infra::TaskPriority::Visible);
+  // `cause` is set for refreshes watch mode started; those are logged
+  auto refresh_refs = [&](std::string cause) {
+    auto started = std::chrono::steady_clock::now();
+    refs_slot.request(
+        [&](const infra::CancellationToken &token) {
+          Refs refs;
+          refs.snapshot = core::RefSnapshot::read(executor.repo_path());
+          refs.branches =
+              core::list_branches(executor, *refs.snapshot, token);
+          ahead_behind.fill(refs.branches, token);
+          return refs;
+        },
+        [&, started, cause](Refs refs) {
+          branches_tab->set_branches(std::move(refs.branches));
+          branches_tab->set_status("");
+          remotes_tab->set_snapshot(refs.snapshot);
+          tags_tab->set_snapshot(std::move(refs.snapshot));
+          if (!cause.empty()) {
+            refresh_log.record("refs", cause,
+                               std::chrono::steady_clock::now() - started);
+          }
+          screen.PostEvent(Event::Custom);
+        },
+        [&](const std::exception &e) {
+          branches_tab->set_status(e.what());
+          remotes_tab->set_status(e.what());
+          tags_tab->set_status(e.what());
+          screen.PostEvent(Event::Custom);
+        });
+  };
+  auto refresh_commits = [&](std::string cause) {
+    auto started = std::chrono::steady_clock::now();
+    // start() joins the previous stream, which reports nothing, before this
+    // one runs, so clearing on its first callback cannot interleave with old
+    // rows
+    auto cleared = std::make_shared<bool>(false);
+    auto clear_once = [&, cleared] {
+      if (!*cleared) {
+        commits_tab->clear();
+        *cleared = true;
+      }
+    };
+    log_stream.start(
+        [&, clear_once](std::vector<core::Commit> batch) {
+          clear_once();
+          commits_tab->append_commits(std::move(batch));
+          screen.PostEvent(Event::Custom);
+        },
+        [&, clear_once, started, cause](int exit_code,
+                                        const std::string &error) {
+          clear_once();
+          commits_tab->set_status(exit_code == 0 ? "" : error);
+          if (!cause.empty()) {
+            refresh_log.record("commits", cause,
+                               std::chrono::steady_clock::now() - started);
+          }
+          screen.PostEvent(Event::Custom);
+        });
+  };
+  // Both sides of the index, read in place and checked against lstat
+  struct Changes {
+    std::vector<core::FileStatus> unstaged;
+    std::vector<core::FileStatus> staged;
+  };
+  core::RefreshSlot status_slot(tasks, infra::TaskPriority::Visible);
+  auto refresh_status = [&](std::string cause) {
+    auto started = std::chrono::steady_clock::now();
+    status_slot.request(
+        [&](const infra::CancellationToken &token) {
+          auto index = core::IndexFile::read_repository(
+              executor.repo_path(), status_options.algorithm);
+          Changes changes;
+          changes.unstaged = index_status.unstaged(*index, token);
+          changes.staged = index_status.staged(*index, token);
+          return changes;
+        },
+        [&, started, cause](Changes changes) {
+          changes_tab->set_files(std::move(changes.unstaged));
+          changes_tab->set_status("");
+          staged_tab->set_files(std::move(changes.staged));
+          staged_tab->set_status("");
+          if (!cause.empty()) {
+            refresh_log.record("status", cause,
+                               std::chrono::steady_clock::now() - started);
+          }
+          screen.PostEvent(Event::Custom);
+        },
+        [&](const std::exception &e) {
+          changes_tab->set_status(e.what());
+          staged_tab->set_status(e.what());
+          screen.PostEvent(Event::Custom);
+        });
+  };
+  // Untracked files from a parallel walk; directories open on Enter
+  core::RefreshSlot untracked_slot(tasks);
+  auto refresh_untracked = [&](std::string cause) {
+    auto started = std::chrono::steady_clock::now();
+    untracked_slot.request(
+        [&](const infra::CancellationToken &token) {
+          auto index = core::IndexFile::read_repository(
+              executor.repo_path(), status_options.algorithm);
+          return untracked.scan(core::list_tracked_paths(*index), token);
+        },
+        [&, started, cause](std::vector<std::string> entries) {
+          untracked_tab->set_entries(std::move(entries));
+          untracked_tab->set_status("");
+          if (!cause.empty()) {
+            refresh_log.record("untracked", cause,
+                               std::chrono::steady_clock::now() - started);
+          }
+          screen.PostEvent(Event::Custom);
+        },
+        [&](const std::exception &e) {
+          untracked_tab->set_status(e.what());
+          screen.PostEvent(Event::Custom);
+        });
+  };
+  untracked_tab->set_expand_callback([&](const std::string &dir) {
+    tasks.post([&, dir] {
+      try {
+        untracked_tab->set_children(dir, untracked.expand(dir, {}));
+      } catch (const std::exception &e) {
+        untracked_tab->set_status(e.what());
+      }
+      screen.PostEvent(Event::Custom);
+    });
   });
+  // Commits that changed one file, streamed from the commit-graph's Bloom
+  // filters; without a commit-graph, git log lists them
+  core::RefreshSlot file_history_slot(tasks);
+  auto show_file_history = [&](const std::string &path) {
+    if (path.empty()) {
+      return;
+    }
+    file_log_tab->set_status("History of " + path + "...");
+    file_history_slot.request(
+        [&, path](const infra::CancellationToken &token,
+                  const core::RefreshSlot::Progress &progress) {
+          // Batches go through the slot too, so a superseded walk never
+          // adds rows after a newer one cleared the tab
+          progress.publish([&] { file_log_tab->clear(); });
+          auto append = [&](std::vector<core::Commit> batch) {
+            progress.publish([&] {
+              file_log_tab->append_commits(std::move(batch));
+              screen.PostEvent(Event::Custom);
+            });
+            token.throw_if_cancelled();
+          };
+          std::string tip =
+              core::RefSnapshot::read(executor.repo_path())->head().oid;
+          if (tip.empty()) {
+            return std::string("No commits yet");
+          }
+          auto graph = core::CommitGraph::open_repository(executor.repo_path());
+          if (graph && objects) {
+            core::FileHistory history(*graph, *objects);
+            return describe_history(path, history.run(tip, path, append, token));
+          }
+          auto args = infra::LogParser::log_args();
+          args.insert(args.end(), {"--topo-order", "--parents", tip, "--", path});
+          auto result = executor.execute(args, token);
+          if (result.exit_code != 0) {
+            throw GitCommandException("git log", result.exit_code,
+                                      result.stderr_output);
+          }
+          auto commits = infra::LogParser::parse(result.stdout_output);
+          std::string status =
+              std::to_string(commits.size()) + " commits changed " + path;
+          append(std::move(commits));
+          return status;
+        },
+        [&](std::string status) {
+          file_log_tab->set_status(std::move(status));
+          screen.PostEvent(Event::Custom);
+        },
+        [&](const std::exception &e) {
+          file_log_tab->set_status(e.what());
+          screen.PostEvent(Event::Custom);
+        });
+  };
+  changes_tab->set_activate_callback([&] {
+    show_file_history(changes_tab->path_at(changes_tab->list()->selected()));
+  });
+  staged_tab->set_activate_callback([&] {
+    show_file_history(staged_tab->path_at(staged_tab->list()->selected()));
+  });
+  commits_tab->set_cursor_callback([&](size_t row) {
+    log_stream.set_cursor(row);
+    show_commit(*commits_tab, row);
+  });
+  file_log_tab->set_cursor_callback(
+      [&](size_t row) { show_commit(*file_log_tab, row); });
+  changes_tab->set_cursor_callback(
+      [&](size_t row) { show_change(*changes_tab, row); });
+  staged_tab->set_cursor_callback(
+      [&](size_t row) { show_change(*staged_tab, row); });
+  refresh_refs("");
+  refresh_commits("");
+  refresh_status("");
+  refresh_untracked("");
+
+  // Watch mode: each burst of changes refreshes only the views it touched.
+  // Reflog and stashes have no views yet.
+  std::unique_ptr<core::RepoWatcher> watcher;
+  if (command_line.watch) {
+    core::RepoWatcher::Options watch_options;
+    watch_options.excludes_file = untracked_options.excludes_file;
+    watch_options.algorithm = status_options.algorithm;
+    watcher = std::make_unique<core::RepoWatcher>(executor.repo_path(),
+                                                  watch_options);
+    watcher->start([&](const core::RepoWatcher::Change &change) {
+      std::string cause = describe_cause(change);
+      if ((change.scopes & (core::RefreshBranches | core::RefreshTags)) != 0) {
+        refresh_refs(cause);
+      }
+      if ((change.scopes & core::RefreshStatus) != 0) {
+        refresh_status(cause);
+        refresh_untracked(cause);
+      }
+      if ((change.scopes & core::RefreshCommits) != 0) {
+        refresh_commits(cause);
+      }
+    });
+  }
+
+  // git status, from here or any shell, asks this process what changed
+  std::unique_ptr<core::FsMonitorDaemon> fsmonitor;
+  if (command_line.fsmonitor) {
+    fsmonitor = std::make_unique<core::FsMonitorDaemon>(executor.repo_path());
+    fsmonitor->start();
+  }
 
-  screen.Loop(main_component);
+  // Redraws are capped: events that arrive while a frame's budget is slept
+  // out are handled together and produce a single frame
+  FramePacer pacer(max_fps);
+  Loop loop(&screen, main_component);
+  while (!loop.HasQuitted()) {
+    loop.RunOnceBlocking();
+    pacer.wait_for_next_frame();
+  }
 
   return 0;
 }
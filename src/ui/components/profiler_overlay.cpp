@@ -0,0 +1,159 @@
+#include "profiler_overlay.hpp"
+
+#include "ui/window_manager.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace slayergit::ui {
+
+namespace {
+
+constexpr size_t sparkline_width = 48;
+constexpr size_t refresh_rows = 5;
+
+std::string format_us(uint32_t us) {
+  char buffer[32];
+  if (us >= 1000) {
+    std::snprintf(buffer, sizeof(buffer), "%.1fms", us / 1000.0);
+  } else {
+    std::snprintf(buffer, sizeof(buffer), "%uus", us);
+  }
+  return buffer;
+}
+
+std::string format_bytes(uint32_t bytes) {
+  char buffer[32];
+  if (bytes >= 1024) {
+    std::snprintf(buffer, sizeof(buffer), "%.1fK", bytes / 1024.0);
+  } else {
+    std::snprintf(buffer, sizeof(buffer), "%uB", bytes);
+  }
+  return buffer;
+}
+
+ftxui::Element metric_row(const std::string &label,
+                          const FrameProfiler::Summary &summary,
+                          std::string (*format)(uint32_t)) {
+  using namespace ftxui;
+  auto cell = [](const std::string &value) {
+    return text(value) | size(WIDTH, EQUAL, 8) | align_right;
+  };
+  if (summary.samples == 0) {
+    return hbox({text(label) | size(WIDTH, EQUAL, 16), cell("-"), cell("-"),
+                 cell("-")});
+  }
+  return hbox({text(label) | size(WIDTH, EQUAL, 16),
+               cell(format(summary.p50)), cell(format(summary.p95)),
+               cell(format(summary.p99))});
+}
+
+// One block glyph per frame, scaled to the slowest frame shown
+std::string sparkline(const std::vector<uint32_t> &samples) {
+  static const char *const levels[] = {"▁", "▂", "▃", "▄",
+                                       "▅", "▆", "▇", "█"};
+  uint32_t peak = 1;
+  for (uint32_t sample : samples) {
+    peak = std::max(peak, sample);
+  }
+
+  std::string line;
+  for (uint32_t sample : samples) {
+    size_t level = static_cast<size_t>(sample) * 7 / peak;
+    line += levels[level];
+  }
+  return line;
+}
+
+std::string format_duration(std::chrono::microseconds duration) {
+  return format_us(static_cast<uint32_t>(
+      std::min<int64_t>(duration.count(), UINT32_MAX)));
+}
+
+ftxui::Element render_panel(const FrameProfiler &profiler,
+                            const WindowManager &wm,
+                            const core::RefreshLog *refreshes) {
+  using namespace ftxui;
+  using Metric = FrameProfiler::Metric;
+
+  auto header =
+      hbox({text("") | size(WIDTH, EQUAL, 16),
+            text("p50") | size(WIDTH, EQUAL, 8) | align_right,
+            text("p95") | size(WIDTH, EQUAL, 8) | align_right,
+            text("p99") | size(WIDTH, EQUAL, 8) | align_right}) |
+      bold;
+
+  auto frames = profiler.recent(Metric::Frame, sparkline_width);
+  auto stats = wm.render_stats();
+  char cache_line[64];
+  std::snprintf(cache_line, sizeof(cache_line), "content cache hits %.0f%%",
+                stats.hit_ratio() * 100.0);
+
+  Elements watch_rows;
+  if (refreshes != nullptr) {
+    watch_rows.push_back(separator());
+    auto entries = refreshes->recent(refresh_rows);
+    if (entries.empty()) {
+      watch_rows.push_back(text("watch: no refreshes yet") | dim);
+    }
+    for (const auto &entry : entries) {
+      watch_rows.push_back(hbox({
+          text(entry.what) | size(WIDTH, EQUAL, 16),
+          text(format_duration(entry.duration)) | size(WIDTH, EQUAL, 8) |
+              align_right,
+          text(" " + entry.cause) | dim | size(WIDTH, LESS_THAN, 24),
+      }));
+    }
+  }
+
+  return window(
+             text(" Profiler (F12) "),
+             vbox({
+                 header,
+                 metric_row("event->render",
+                            profiler.summarize(Metric::EventToRender),
+                            format_us),
+                 metric_row("window render",
+                            profiler.summarize(Metric::WindowRender),
+                            format_us),
+                 metric_row("terminal flush",
+                            profiler.summarize(Metric::TerminalFlush),
+                            format_us),
+                 metric_row("frame", profiler.summarize(Metric::Frame),
+                            format_us),
+                 metric_row("bytes/frame",
+                            profiler.summarize(Metric::OutputBytes),
+                            format_bytes),
+                 separator(),
+                 text(frames.empty() ? "no frames yet" : sparkline(frames)),
+                 text(cache_line) | dim,
+                 vbox(std::move(watch_rows)),
+             })) |
+         clear_under;
+}
+
+} // namespace
+
+ftxui::Component with_profiler_overlay(ftxui::Component main,
+                                       FrameProfiler &profiler,
+                                       const WindowManager &wm,
+                                       const core::RefreshLog *refreshes) {
+  using namespace ftxui;
+
+  return Renderer(main, [main, &profiler, &wm, refreshes] {
+    profiler.mark_frame_begin();
+    Element frame = main->Render();
+    if (profiler.visible()) {
+      frame = dbox({
+          frame,
+          vbox({hbox({filler(), render_panel(profiler, wm, refreshes)}), filler()}),
+      });
+    }
+    profiler.mark_frame_built();
+    return frame;
+  });
+}
+
+} // namespace slayergit::ui
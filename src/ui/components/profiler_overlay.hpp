@@ -0,0 +1,21 @@
+#pragma once
+
+#include "core/refresh_log.hpp"
+#include "ui/frame_profiler.hpp"
+
+#include <ftxui/component/component.hpp>
+
+namespace slayergit::ui {
+
+class WindowManager;
+
+// Wraps the main component: marks frame boundaries for the profiler and,
+// while the profiler is visible, draws a latency panel in the top-right
+// corner on top of it. With `refreshes`, the panel also lists the latest
+// refreshes watch mode triggered.
+[[nodiscard]] ftxui::Component
+with_profiler_overlay(ftxui::Component main, FrameProfiler &profiler,
+                      const WindowManager &wm,
+                      const core::RefreshLog *refreshes = nullptr);
+
+} // namespace slayergit::ui
@@ -0,0 +1,165 @@
+#include "virtual_list.hpp"
+
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/box.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <algorithm>
+
+namespace slayergit::ui {
+
+// Leaf node that asks for no minimum size and fills whatever space it gets.
+// Rows are created in SetBox(), when the height is finally known.
+class VirtualListNode : public ftxui::Node {
+public:
+  explicit VirtualListNode(VirtualListPtr list) : list_(std::move(list)) {}
+
+  void ComputeRequirement() override {
+    requirement_.min_x = 0;
+    requirement_.min_y = 0;
+    requirement_.flex_grow_x = 1;
+    requirement_.flex_grow_y = 1;
+    requirement_.flex_shrink_x = 1;
+    requirement_.flex_shrink_y = 1;
+  }
+
+  void SetBox(ftxui::Box box) override {
+    // A memoized node is laid out again every frame; keep its rows when
+    // neither the box nor the list moved since they were built
+    if (built_ && same_box(box, box_) && list_->version() == built_version_) {
+      list_->set_rows_built(0);
+      return;
+    }
+
+    ftxui::Node::SetBox(box);
+    children_.clear();
+    built_ = false;
+
+    int height = box.y_max - box.y_min + 1;
+    if (height <= 0 || box.x_max < box.x_min) {
+      list_->set_rows_built(0);
+      return;
+    }
+    list_->set_viewport_height(static_cast<size_t>(height));
+
+    size_t first = list_->scroll_offset();
+    size_t last = std::min(list_->row_count(), first + height);
+    children_.reserve(last - first);
+    int y = box.y_min;
+    for (size_t row = first; row < last; ++row, ++y) {
+      ftxui::Element element = list_->build_row(row);
+      element->ComputeRequirement();
+      element->SetBox(ftxui::Box{box.x_min, box.x_max, y, y});
+      children_.push_back(std::move(element));
+    }
+    list_->set_rows_built(children_.size());
+    built_ = true;
+    built_version_ = list_->version();
+  }
+
+  void Render(ftxui::Screen &screen) override {
+    for (auto &child : children_) {
+      child->Render(screen);
+    }
+  }
+
+private:
+  static bool same_box(const ftxui::Box &a, const ftxui::Box &b) {
+    return a.x_min == b.x_min && a.x_max == b.x_max && a.y_min == b.y_min &&
+           a.y_max == b.y_max;
+  }
+
+  VirtualListPtr list_;
+  bool built_ = false;
+  uint64_t built_version_ = 0;
+};
+
+VirtualList::VirtualList(RowCount row_count, RowBuilder row_builder)
+    : row_count_(std::move(row_count)), row_builder_(std::move(row_builder)) {}
+
+ftxui::Element VirtualList::render() {
+  clamp_selection();
+  return std::make_shared<VirtualListNode>(shared_from_this());
+}
+
+size_t VirtualList::row_count() const { return row_count_ ? row_count_() : 0; }
+
+void VirtualList::select(size_t row) {
+  size_t previous = selected_;
+  selected_ = row;
+  clamp_selection();
+  scroll_to_selection();
+  if (selected_ != previous) {
+    ++version_;
+    if (selection_callback_) {
+      selection_callback_(selected_);
+    }
+  }
+}
+
+void VirtualList::select_next(size_t count) { select(selected_ + count); }
+
+void VirtualList::select_previous(size_t count) {
+  select(selected_ > count ? selected_ - count : 0);
+}
+
+void VirtualList::page_down() { select_next(viewport_height_); }
+
+void VirtualList::page_up() { select_previous(viewport_height_); }
+
+void VirtualList::select_first() { select(0); }
+
+void VirtualList::select_last() {
+  size_t count = row_count();
+  select(count == 0 ? 0 : count - 1);
+}
+
+void VirtualList::set_viewport_height(size_t height) {
+  viewport_height_ = std::max<size_t>(height, 1);
+  clamp_selection();
+  scroll_to_selection();
+}
+
+ftxui::Element VirtualList::build_row(size_t row) {
+  bool is_selected = row == selected_;
+  ftxui::Element element = row_builder_(row, is_selected);
+  if (is_selected) {
+    element = element | ftxui::inverted;
+  }
+  return element;
+}
+
+void VirtualList::clamp_selection() {
+  size_t count = row_count();
+  size_t previous = selected_;
+  if (count == 0) {
+    selected_ = 0;
+  } else if (selected_ >= count) {
+    selected_ = count - 1;
+  }
+  if (selected_ != previous) {
+    ++version_;
+  }
+}
+
+void VirtualList::scroll_to_selection() {
+  size_t previous = scroll_offset_;
+  if (selected_ < scroll_offset_) {
+    scroll_offset_ = selected_;
+  } else if (selected_ >= scroll_offset_ + viewport_height_) {
+    scroll_offset_ = selected_ - viewport_height_ + 1;
+  }
+
+  // Do not leave empty space below the last row after the list shrinks
+  size_t count = row_count();
+  if (count <= viewport_height_) {
+    scroll_offset_ = 0;
+  } else if (scroll_offset_ > count - viewport_height_) {
+    scroll_offset_ = count - viewport_height_;
+  }
+  if (scroll_offset_ != previous) {
+    ++version_;
+  }
+}
+
+} // namespace slayergit::ui
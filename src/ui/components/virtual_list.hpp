@@ -0,0 +1,80 @@
+#pragma once
+
+#include <ftxui/dom/elements.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace slayergit::ui {
+
+// Scrollable list that only builds Elements for the rows inside its
+// viewport. The row count and the rows themselves come from callbacks, so
+// the list never copies the underlying data and a frame costs the same for
+// ten rows as for ten million.
+//
+// The viewport height is only known during layout, so render() returns a
+// node that creates its rows once FTXUI assigns it a box. Must be owned by
+// a std::shared_ptr (the node keeps the list alive).
+class VirtualList : public std::enable_shared_from_this<VirtualList> {
+public:
+  using RowCount = std::function<size_t()>;
+  using RowBuilder = std::function<ftxui::Element(size_t row, bool selected)>;
+  using SelectionCallback = std::function<void(size_t row)>;
+
+  VirtualList(RowCount row_count, RowBuilder row_builder);
+
+  [[nodiscard]] ftxui::Element render();
+
+  // Navigation; all of them clamp to the current row count
+  void select(size_t row);
+  void select_next(size_t count = 1);
+  void select_previous(size_t count = 1);
+  void page_down();
+  void page_up();
+  void select_first();
+  void select_last();
+
+  [[nodiscard]] size_t selected() const { return selected_; }
+  [[nodiscard]] size_t scroll_offset() const { return scroll_offset_; }
+  [[nodiscard]] size_t viewport_height() const { return viewport_height_; }
+  [[nodiscard]] size_t row_count() const;
+
+  // Rows built during the last layout; stays at the viewport height no
+  // matter how long the list is
+  [[nodiscard]] size_t rows_built_last_frame() const {
+    return rows_built_last_frame_;
+  }
+
+  void set_selection_callback(SelectionCallback callback) {
+    selection_callback_ = std::move(callback);
+  }
+
+  // Bumped when the selection or scroll offset changes
+  [[nodiscard]] uint64_t version() const { return version_; }
+
+private:
+  friend class VirtualListNode;
+
+  // Layout-time hooks used by the node
+  void set_viewport_height(size_t height);
+  [[nodiscard]] ftxui::Element build_row(size_t row);
+  void set_rows_built(size_t count) { rows_built_last_frame_ = count; }
+
+  void clamp_selection();
+  void scroll_to_selection();
+
+  RowCount row_count_;
+  RowBuilder row_builder_;
+  SelectionCallback selection_callback_;
+  size_t selected_ = 0;
+  size_t scroll_offset_ = 0;
+  size_t viewport_height_ = 1;
+  size_t rows_built_last_frame_ = 0;
+  uint64_t version_ = 0;
+};
+
+using VirtualListPtr = std::shared_ptr<VirtualList>;
+
+} // namespace slayergit::ui
@@ -0,0 +1,157 @@
+#include "frame_profiler.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace slayergit::ui {
+
+namespace {
+
+int64_t now_ticks() {
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+uint32_t to_us(std::chrono::steady_clock::duration duration) {
+  auto us =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  if (us < 0) {
+    return 0;
+  }
+  return us > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(us);
+}
+
+} // namespace
+
+// Forwards to the real std::cout buffer while timing the writes. The time
+// and byte count accumulated since the previous flush are reported when
+// the stream is flushed.
+class FrameProfiler::TerminalMeter : public std::streambuf {
+public:
+  TerminalMeter(FrameProfiler &profiler, std::streambuf *target)
+      : profiler_(profiler), target_(target) {}
+
+protected:
+  int_type overflow(int_type ch) override {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+      return traits_type::not_eof(ch);
+    }
+    auto start = std::chrono::steady_clock::now();
+    int_type result = target_->sputc(traits_type::to_char_type(ch));
+    write_time_ += std::chrono::steady_clock::now() - start;
+    ++bytes_;
+    return result;
+  }
+
+  std::streamsize xsputn(const char *data, std::streamsize count) override {
+    auto start = std::chrono::steady_clock::now();
+    std::streamsize written = target_->sputn(data, count);
+    write_time_ += std::chrono::steady_clock::now() - start;
+    bytes_ += static_cast<size_t>(written);
+    return written;
+  }
+
+  int sync() override {
+    auto start = std::chrono::steady_clock::now();
+    int result = target_->pubsync();
+    write_time_ += std::chrono::steady_clock::now() - start;
+    if (bytes_ > 0) {
+      profiler_.on_terminal_flush(write_time_, bytes_);
+    }
+    write_time_ = {};
+    bytes_ = 0;
+    return result;
+  }
+
+private:
+  FrameProfiler &profiler_;
+  std::streambuf *target_;
+  std::chrono::steady_clock::duration write_time_{};
+  size_t bytes_ = 0;
+};
+
+FrameProfiler::FrameProfiler() = default;
+
+FrameProfiler::~FrameProfiler() {
+  if (terminal_meter_) {
+    std::cout.flush();
+    std::cout.rdbuf(original_cout_);
+  }
+}
+
+void FrameProfiler::record(Metric metric,
+                           std::chrono::steady_clock::duration duration) {
+  record_value(metric, to_us(duration));
+}
+
+void FrameProfiler::record_value(Metric metric, uint32_t value) {
+  rings_[static_cast<size_t>(metric)].push(value);
+}
+
+FrameProfiler::Summary FrameProfiler::summarize(Metric metric) const {
+  std::vector<uint32_t> samples = ring(metric).snapshot(ring_capacity);
+  Summary summary;
+  summary.samples = samples.size();
+  if (samples.empty()) {
+    return summary;
+  }
+
+  // Sorting a copy of at most ring_capacity values only happens while the
+  // overlay is drawn, never on the recording side
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&samples](double p) {
+    size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+  };
+  summary.p50 = percentile(0.50);
+  summary.p95 = percentile(0.95);
+  summary.p99 = percentile(0.99);
+  return summary;
+}
+
+std::vector<uint32_t> FrameProfiler::recent(Metric metric,
+                                            size_t max_samples) const {
+  return ring(metric).snapshot(max_samples);
+}
+
+void FrameProfiler::mark_event() {
+  // Keep the oldest unrendered event: that is the latency the user feels
+  int64_t expected = 0;
+  pending_event_.compare_exchange_strong(expected, now_ticks(),
+                                         std::memory_order_relaxed);
+}
+
+void FrameProfiler::mark_frame_begin() {
+  frame_begin_.store(now_ticks(), std::memory_order_relaxed);
+}
+
+void FrameProfiler::mark_frame_built() {
+  int64_t event = pending_event_.exchange(0, std::memory_order_relaxed);
+  if (event != 0) {
+    record(Metric::EventToRender,
+           std::chrono::steady_clock::duration(now_ticks() - event));
+  }
+}
+
+void FrameProfiler::install_terminal_hook() {
+  if (terminal_meter_) {
+    return;
+  }
+  original_cout_ = std::cout.rdbuf();
+  terminal_meter_ = std::make_unique<TerminalMeter>(*this, original_cout_);
+  std::cout.rdbuf(terminal_meter_.get());
+}
+
+void FrameProfiler::on_terminal_flush(
+    std::chrono::steady_clock::duration write_time, size_t bytes) {
+  record(Metric::TerminalFlush, write_time);
+  record_value(Metric::OutputBytes,
+               bytes > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(bytes));
+
+  int64_t begin = frame_begin_.exchange(0, std::memory_order_relaxed);
+  if (begin != 0) {
+    record(Metric::Frame,
+           std::chrono::steady_clock::duration(now_ticks() - begin));
+  }
+}
+
+} // namespace slayergit::ui
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "sample_ring.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Collects frame timings for the profiler overlay. Every metric is a
+// lock-free SampleRing, so recording costs two clock reads and an atomic
+// increment on the render path.
+class FrameProfiler {
+public:
+  enum class Metric {
+    EventToRender, // InputHandler::handle_event() until the frame is built
+    WindowRender,  // One Window::render() call
+    TerminalFlush, // Time spent writing the frame to the terminal
+    Frame,         // Start of the frame until the terminal flush finished
+    OutputBytes,   // Bytes written to the terminal per frame (not a time)
+  };
+  static constexpr size_t metric_count = 5;
+  static constexpr size_t ring_capacity = 1024;
+
+  struct Summary {
+    size_t samples = 0;
+    uint32_t p50 = 0;
+    uint32_t p95 = 0;
+    uint32_t p99 = 0;
+  };
+
+  FrameProfiler();
+  ~FrameProfiler();
+
+  FrameProfiler(const FrameProfiler &) = delete;
+  FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+  // Times are recorded in microseconds
+  void record(Metric metric, std::chrono::steady_clock::duration duration);
+  void record_value(Metric metric, uint32_t value);
+
+  // Percentiles over the samples currently held for `metric`
+  [[nodiscard]] Summary summarize(Metric metric) const;
+  [[nodiscard]] std::vector<uint32_t> recent(Metric metric,
+                                             size_t max_samples) const;
+
+  // Hooks for the event loop
+  void mark_event();
+  void mark_frame_begin();
+  void mark_frame_built();
+
+  // Routes std::cout through a meter that times each terminal flush (FTXUI
+  // writes every frame to std::cout and flushes once). Undone on destruction.
+  void install_terminal_hook();
+
+  [[nodiscard]] bool visible() const { return visible_; }
+  void set_visible(bool visible) { visible_ = visible; }
+  void toggle_visible() { visible_ = !visible_; }
+
+private:
+  class TerminalMeter;
+
+  using Ring = SampleRing<ring_capacity>;
+
+  [[nodiscard]] const Ring &ring(Metric metric) const {
+    return rings_[static_cast<size_t>(metric)];
+  }
+  void on_terminal_flush(std::chrono::steady_clock::duration write_time,
+                         size_t bytes);
+
+  std::array<Ring, metric_count> rings_;
+  // steady_clock ticks; 0 means "nothing pending"
+  std::atomic<int64_t> pending_event_{0};
+  std::atomic<int64_t> frame_begin_{0};
+  bool visible_ = false;
+
+  std::unique_ptr<TerminalMeter> terminal_meter_;
+  std::streambuf *original_cout_ = nullptr;
+};
+
+// Times a scope and records it on destruction; no-op without a profiler
+class ScopedSample {
+public:
+  ScopedSample(FrameProfiler *profiler, FrameProfiler::Metric metric)
+      : profiler_(profiler), metric_(metric),
+        start_(profiler ? std::chrono::steady_clock::now()
+                        : std::chrono::steady_clock::time_point{}) {}
+  ~ScopedSample() {
+    if (profiler_) {
+      profiler_->record(metric_, std::chrono::steady_clock::now() - start_);
+    }
+  }
+
+  ScopedSample(const ScopedSample &) = delete;
+  ScopedSample &operator=(const ScopedSample &) = delete;
+
+private:
+  FrameProfiler *profiler_;
+  FrameProfiler::Metric metric_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace slayergit::ui
@@ -0,0 +1,130 @@
+#include "headless_renderer.hpp"
+
+#include "input_handler.hpp"
+#include "window_manager.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace slayergit::ui {
+
+namespace {
+
+ftxui::Screen make_screen(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    throw std::invalid_argument("Screen size must be positive");
+  }
+  return ftxui::Screen::Create(ftxui::Dimension::Fixed(width),
+                               ftxui::Dimension::Fixed(height));
+}
+
+std::string read_file(const std::string &path, bool &exists) {
+  std::ifstream in(path, std::ios::binary);
+  exists = static_cast<bool>(in);
+  std::ostringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+std::string line_at(const std::string &text, size_t line) {
+  std::istringstream stream(text);
+  std::string current;
+  for (size_t i = 0; i <= line; ++i) {
+    if (!std::getline(stream, current)) {
+      return "<missing>";
+    }
+  }
+  return current;
+}
+
+} // namespace
+
+HeadlessRenderer::HeadlessRenderer(WindowManager &wm, InputHandler &input,
+                                   int width, int height)
+    : input_(input), root_(wm.create_component()),
+      screen_(make_screen(width, height)) {}
+
+void HeadlessRenderer::resize(int width, int height) {
+  screen_ = make_screen(width, height);
+}
+
+bool HeadlessRenderer::send(const ftxui::Event &event) {
+  if (input_.handle_event(event).handled) {
+    return true;
+  }
+  return root_->OnEvent(event);
+}
+
+void HeadlessRenderer::send_keys(std::string_view keys) {
+  for (char key : keys) {
+    send(ftxui::Event::Character(key));
+  }
+}
+
+const ftxui::Screen &HeadlessRenderer::render_frame() {
+  auto start = std::chrono::steady_clock::now();
+
+  screen_.Clear();
+  ftxui::Render(screen_, root_->Render());
+  // ScreenInteractive moves the cursor back and rewrites the whole screen
+  // every frame
+  size_t bytes = screen_.ResetPosition().size() + screen_.ToString().size();
+
+  auto end = std::chrono::steady_clock::now();
+  ++stats_.frames;
+  stats_.total_us +=
+      std::chrono::duration<double, std::micro>(end - start).count();
+  stats_.output_bytes += bytes;
+  return screen_;
+}
+
+std::string HeadlessRenderer::snapshot() const {
+  // at() is non-const in FTXUI; the screen is not modified here
+  auto &screen = const_cast<ftxui::Screen &>(screen_);
+
+  std::string out;
+  for (int y = 0; y < screen.dimy(); ++y) {
+    std::string line;
+    for (int x = 0; x < screen.dimx(); ++x) {
+      // Wide characters leave an empty cell after them
+      line += screen.at(x, y);
+    }
+    line.erase(line.find_last_not_of(' ') + 1);
+    out += line;
+    out += '\n';
+  }
+  return out;
+}
+
+HeadlessRenderer::GoldenResult
+HeadlessRenderer::compare_golden(const std::string &path, bool update,
+                                 std::string *diff) const {
+  std::string actual = snapshot();
+  bool exists = false;
+  std::string expected = read_file(path, exists);
+
+  if (!exists || update) {
+    std::ofstream(path, std::ios::binary) << actual;
+    return GoldenResult::Written;
+  }
+  if (expected == actual) {
+    return GoldenResult::Match;
+  }
+
+  if (diff) {
+    size_t line = 0;
+    size_t i = 0;
+    while (i < expected.size() && i < actual.size() &&
+           expected[i] == actual[i]) {
+      line += expected[i] == '\n';
+      ++i;
+    }
+    *diff = "line " + std::to_string(line + 1) + ":\n  expected: " +
+            line_at(expected, line) + "\n  actual:   " + line_at(actual, line);
+  }
+  return GoldenResult::Mismatch;
+}
+
+} // namespace slayergit::ui
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ftxui/component/component.hpp>
+#include <ftxui/component/event.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace slayergit::ui {
+
+class InputHandler;
+class WindowManager;
+
+// Renders the WindowManager into an off-screen ftxui::Screen instead of the
+// terminal, so frames can be driven by synthetic events, timed and compared
+// against golden snapshots in benchmarks and tools.
+class HeadlessRenderer {
+public:
+  struct FrameStats {
+    uint64_t frames = 0;
+    double total_us = 0;
+    // What ScreenInteractive would write for these frames
+    uint64_t output_bytes = 0;
+
+    [[nodiscard]] double fps() const {
+      return total_us > 0 ? frames * 1e6 / total_us : 0.0;
+    }
+    [[nodiscard]] double bytes_per_frame() const {
+      return frames > 0 ? static_cast<double>(output_bytes) / frames : 0.0;
+    }
+  };
+
+  enum class GoldenResult { Match, Mismatch, Written };
+
+  // Builds the window manager's component tree; like create_component(),
+  // do this once per WindowManager
+  HeadlessRenderer(WindowManager &wm, InputHandler &input, int width,
+                   int height);
+
+  [[nodiscard]] int width() const { return screen_.dimx(); }
+  [[nodiscard]] int height() const { return screen_.dimy(); }
+  // Throws std::invalid_argument for non-positive sizes
+  void resize(int width, int height);
+
+  // Routed through InputHandler first, then to the component tree, the way
+  // CatchEvent does it in the interactive app. Returns whether it was used.
+  bool send(const ftxui::Event &event);
+  // One Character event per byte of `keys`
+  void send_keys(std::string_view keys);
+
+  // Lays out and draws one frame, then serializes it as the terminal would
+  const ftxui::Screen &render_frame();
+
+  // Characters of the last frame, one line per row with trailing blanks
+  // removed; styles are not included
+  [[nodiscard]] std::string snapshot() const;
+
+  // Compares snapshot() with the file at `path`. A missing file, or
+  // `update`, (re)writes it. On mismatch `diff` describes the first
+  // differing line.
+  GoldenResult compare_golden(const std::string &path, bool update,
+                              std::string *diff = nullptr) const;
+
+  [[nodiscard]] const FrameStats &stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
+private:
+  InputHandler &input_;
+  ftxui::Component root_;
+  ftxui::Screen screen_;
+  FrameStats stats_;
+};
+
+} // namespace slayergit::ui
@@ -0,0 +1,82 @@
+#include "input_coalescer.hpp"
+
+#include "frame_profiler.hpp"
+
+#include <thread>
+
+namespace slayergit::ui {
+
+bool InputCoalescer::handle_event(const ftxui::Event &event) {
+  if (auto *profiler = input_.profiler()) {
+    profiler->mark_event();
+  }
+
+  InputResult result = input_.translate(event);
+  if (!result.handled) {
+    // The component tree handles it next; it must see earlier commands
+    flush();
+    return false;
+  }
+  ++stats_.events;
+
+  if (is_repeatable(result.command)) {
+    if (result.command != pending_) {
+      flush();
+      pending_ = result.command;
+    }
+    ++pending_count_;
+    return true;
+  }
+
+  flush();
+  ++stats_.commands;
+  input_.execute_command(result.command);
+  return true;
+}
+
+void InputCoalescer::flush() {
+  if (pending_count_ == 0) {
+    return;
+  }
+  Command cmd = pending_;
+  size_t count = pending_count_;
+  pending_ = Command::None;
+  pending_count_ = 0;
+
+  ++stats_.commands;
+  input_.execute_command(cmd, count);
+}
+
+void FramePacer::set_max_fps(int max_fps) {
+  max_fps_ = max_fps > 0 ? max_fps : 0;
+  interval_ = max_fps_ > 0 ? std::chrono::duration_cast<
+                                 std::chrono::steady_clock::duration>(
+                                 std::chrono::seconds(1)) /
+                                 max_fps_
+                           : std::chrono::steady_clock::duration::zero();
+}
+
+void FramePacer::wait_for_next_frame() {
+  auto now = std::chrono::steady_clock::now();
+  auto next = last_frame_ + interval_;
+  if (max_fps_ > 0 && now < next) {
+    std::this_thread::sleep_until(next);
+    now = next;
+  }
+  last_frame_ = now;
+}
+
+ftxui::Component with_input_coalescing(ftxui::Component main,
+                                       InputCoalescer &coalescer) {
+  using namespace ftxui;
+
+  main = CatchEvent(main, [&coalescer](Event event) {
+    return coalescer.handle_event(event);
+  });
+  return Renderer(main, [main, &coalescer] {
+    coalescer.flush();
+    return main->Render();
+  });
+}
+
+} // namespace slayergit::ui
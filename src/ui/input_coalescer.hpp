@@ -0,0 +1,65 @@
+#pragma once
+
+#include "input_handler.hpp"
+
+#include <ftxui/component/component.hpp>
+#include <ftxui/component/event.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace slayergit::ui {
+
+// Sits in front of InputHandler. A held navigation key delivers a run of
+// identical events; repeatable commands (see is_repeatable()) are merged
+// into one command with a repeat count and applied once, right before the
+// next frame. Any other event first applies the pending run, so Quit and
+// friends keep their place in the input order.
+class InputCoalescer {
+public:
+  struct Stats {
+    uint64_t events = 0;   // Events that mapped to a command
+    uint64_t commands = 0; // Commands actually executed
+  };
+
+  explicit InputCoalescer(InputHandler &input) : input_(input) {}
+
+  // For CatchEvent: true when the event was consumed as a command
+  bool handle_event(const ftxui::Event &event);
+
+  // Executes the pending run, if any
+  void flush();
+
+  [[nodiscard]] const Stats &stats() const { return stats_; }
+
+private:
+  InputHandler &input_;
+  Command pending_ = Command::None;
+  size_t pending_count_ = 0;
+  Stats stats_;
+};
+
+// Upper bound on redraws: wait_for_next_frame() sleeps out the rest of the
+// frame budget so events arriving meanwhile are handled as one batch
+class FramePacer {
+public:
+  // 0 disables the cap
+  explicit FramePacer(int max_fps = 60) { set_max_fps(max_fps); }
+
+  void set_max_fps(int max_fps);
+  [[nodiscard]] int max_fps() const { return max_fps_; }
+
+  void wait_for_next_frame();
+
+private:
+  int max_fps_ = 0;
+  std::chrono::steady_clock::duration interval_{};
+  std::chrono::steady_clock::time_point last_frame_{};
+};
+
+// Routes events through the coalescer and flushes it before each frame
+[[nodiscard]] ftxui::Component with_input_coalescing(ftxui::Component main,
+                                                     InputCoalescer &coalescer);
+
+} // namespace slayergit::ui
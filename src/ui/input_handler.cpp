@@ -1,12 +1,43 @@
 #include "input_handler.hpp"
 
+#include "frame_profiler.hpp"
 #include "window_manager.hpp"
 
 namespace slayergit::ui {
 
 InputHandler::InputHandler(WindowManager &wm) : window_manager_(wm) {}
 
+bool is_repeatable(Command cmd) {
+  switch (cmd) {
+  case Command::FocusNextWindow:
+  case Command::FocusPreviousWindow:
+  case Command::NextTab:
+  case Command::PreviousTab:
+  case Command::CursorUp:
+  case Command::CursorDown:
+  case Command::CursorPageUp:
+  case Command::CursorPageDown:
+  case Command::CursorTop:
+  case Command::CursorBottom:
+    return true;
+  default:
+    return false;
+  }
+}
+
 InputResult InputHandler::handle_event(const ftxui::Event &event) {
+  if (profiler_) {
+    profiler_->mark_event();
+  }
+
+  InputResult result = translate(event);
+  if (result.handled) {
+    execute_command(result.command);
+  }
+  return result;
+}
+
+InputResult InputHandler::translate(const ftxui::Event &event) const {
   InputResult result;
 
   // Check for quit
@@ -14,7 +45,6 @@ InputResult InputHandler::handle_event(const ftxui::Event &event) {
       event == ftxui::Event::Character('Q')) {
     result.handled = true;
     result.command = Command::Quit;
-    execute_command(result.command);
     return result;
   }
 
@@ -22,55 +52,46 @@ InputResult InputHandler::handle_event(const ftxui::Event &event) {
   if (event == ftxui::Event::Character('1')) {
     result.handled = true;
     result.command = Command::FocusWindow1;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('2')) {
     result.handled = true;
     result.command = Command::FocusWindow2;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('3')) {
     result.handled = true;
     result.command = Command::FocusWindow3;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('4')) {
     result.handled = true;
     result.command = Command::FocusWindow4;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('5')) {
     result.handled = true;
     result.command = Command::FocusWindow5;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('6')) {
     result.handled = true;
     result.command = Command::FocusWindow6;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('7')) {
     result.handled = true;
     result.command = Command::FocusWindow7;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('8')) {
     result.handled = true;
     result.command = Command::FocusWindow8;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::Character('9')) {
     result.handled = true;
     result.command = Command::FocusWindow9;
-    execute_command(result.command);
     return result;
   }
 
@@ -78,20 +99,66 @@ InputResult InputHandler::handle_event(const ftxui::Event &event) {
   if (event == ftxui::Event::Tab) {
     result.handled = true;
     result.command = Command::NextTab;
-    execute_command(result.command);
     return result;
   }
   if (event == ftxui::Event::TabReverse) {
     result.handled = true;
     result.command = Command::PreviousTab;
-    execute_command(result.command);
+    return result;
+  }
+
+  // Cursor movement in the focused tab's list
+  if (event == ftxui::Event::ArrowUp) {
+    result.handled = true;
+    result.command = Command::CursorUp;
+    return result;
+  }
+  if (event == ftxui::Event::ArrowDown) {
+    result.handled = true;
+    result.command = Command::CursorDown;
+    return result;
+  }
+  if (event == ftxui::Event::PageUp) {
+    result.handled = true;
+    result.command = Command::CursorPageUp;
+    return result;
+  }
+  if (event == ftxui::Event::PageDown) {
+    result.handled = true;
+    result.command = Command::CursorPageDown;
+    return result;
+  }
+  if (event == ftxui::Event::Home) {
+    result.handled = true;
+    result.command = Command::CursorTop;
+    return result;
+  }
+  if (event == ftxui::Event::End) {
+    result.handled = true;
+    result.command = Command::CursorBottom;
+    return result;
+  }
+
+  if (event == ftxui::Event::Return) {
+    result.handled = true;
+    result.command = Command::Activate;
+    return result;
+  }
+
+  // Profiler overlay
+  if (event == ftxui::Event::F12) {
+    result.handled = true;
+    result.command = Command::ToggleProfiler;
     return result;
   }
 
   return result;
 }
 
-void InputHandler::execute_command(Command cmd) {
+void InputHandler::execute_command(Command cmd, size_t repeat) {
+  // Cycling wraps around, so whole laps are no-ops
+  auto laps = [repeat](size_t count) { return count ? repeat % count : 0; };
+
   switch (cmd) {
   case Command::Quit:
     if (quit_callback_) {
@@ -128,20 +195,51 @@ void InputHandler::execute_command(Command cmd) {
     break;
 
   case Command::FocusNextWindow:
-    window_manager_.focus_next_window();
+    for (size_t i = laps(window_manager_.window_count()); i > 0; --i) {
+      window_manager_.focus_next_window();
+    }
     break;
   case Command::FocusPreviousWindow:
-    window_manager_.focus_previous_window();
+    for (size_t i = laps(window_manager_.window_count()); i > 0; --i) {
+      window_manager_.focus_previous_window();
+    }
     break;
 
   case Command::NextTab:
     if (auto window = window_manager_.get_focused_window()) {
-      window->select_next_tab();
+      for (size_t i = laps(window->tab_count()); i > 0; --i) {
+        window->select_next_tab();
+      }
     }
     break;
   case Command::PreviousTab:
     if (auto window = window_manager_.get_focused_window()) {
-      window->select_previous_tab();
+      for (size_t i = laps(window->tab_count()); i > 0; --i) {
+        window->select_previous_tab();
+      }
+    }
+    break;
+
+  case Command::CursorUp:
+  case Command::CursorDown:
+  case Command::CursorPageUp:
+  case Command::CursorPageDown:
+  case Command::CursorTop:
+  case Command::CursorBottom:
+    move_cursor(cmd, repeat);
+    break;
+
+  case Command::Activate:
+    if (auto window = window_manager_.get_focused_window()) {
+      if (auto tab = window->get_current_tab()) {
+        tab->activate();
+      }
+    }
+    break;
+
+  case Command::ToggleProfiler:
+    if (profiler_) {
+      profiler_->toggle_visible();
     }
     break;
 
@@ -150,4 +248,40 @@ void InputHandler::execute_command(Command cmd) {
   }
 }
 
+void InputHandler::move_cursor(Command cmd, size_t repeat) {
+  auto window = window_manager_.get_focused_window();
+  auto tab = window ? window->get_current_tab() : nullptr;
+  if (!tab || !tab->list()) {
+    return;
+  }
+
+  const auto &list = tab->list();
+  switch (cmd) {
+  case Command::CursorUp:
+    list->select_previous(repeat);
+    break;
+  case Command::CursorDown:
+    list->select_next(repeat);
+    break;
+  case Command::CursorPageUp:
+    for (size_t i = 0; i < repeat; ++i) {
+      list->page_up();
+    }
+    break;
+  case Command::CursorPageDown:
+    for (size_t i = 0; i < repeat; ++i) {
+      list->page_down();
+    }
+    break;
+  case Command::CursorTop:
+    list->select_first();
+    break;
+  case Command::CursorBottom:
+    list->select_last();
+    break;
+  default:
+    break;
+  }
+}
+
 } // namespace slayergit::ui
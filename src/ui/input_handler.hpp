@@ -9,7 +9,8 @@
 
 namespace slayergit::ui {
 
-// Forward declaration
+// Forward declarations
+class FrameProfiler;
 class WindowManager;
 
 // Command types that can be executed
@@ -29,8 +30,20 @@ enum class Command {
   FocusPreviousWindow,
   NextTab,
   PreviousTab,
+  CursorUp,
+  CursorDown,
+  CursorPageUp,
+  CursorPageDown,
+  CursorTop,
+  CursorBottom,
+  Activate,
+  ToggleProfiler,
 };
 
+// Commands that can be merged into one command with a repeat count when
+// the same key arrives several times before a frame
+[[nodiscard]] bool is_repeatable(Command cmd);
+
 // Result of handling an event
 struct InputResult {
   bool handled = false;
@@ -48,14 +61,27 @@ public:
     quit_callback_ = std::move(callback);
   }
 
+  // Optional; events are timestamped for the event-to-render latency and
+  // F12 toggles its overlay
+  void set_profiler(FrameProfiler *profiler) { profiler_ = profiler; }
+
+  [[nodiscard]] FrameProfiler *profiler() const { return profiler_; }
+
   // Process an event and return the result
   InputResult handle_event(const ftxui::Event &event);
 
+  // Maps an event to a command without executing it
+  [[nodiscard]] InputResult translate(const ftxui::Event &event) const;
+
+  // Runs `cmd` as if its key had been pressed `repeat` times
+  void execute_command(Command cmd, size_t repeat = 1);
+
 private:
-  void execute_command(Command cmd);
+  void move_cursor(Command cmd, size_t repeat);
 
   WindowManager &window_manager_;
   QuitCallback quit_callback_;
+  FrameProfiler *profiler_ = nullptr;
 };
 
 } // namespace slayergit::ui
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Fixed-size ring of the most recent samples. push() is wait-free (one
+// fetch_add and one relaxed store), so recording from the render path never
+// takes a lock; readers copy a snapshot that may mix in a concurrent write.
+template <size_t Capacity> class SampleRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  void push(uint32_t value) {
+    uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    slots_[index & (Capacity - 1)].store(value, std::memory_order_relaxed);
+  }
+
+  // Total number of samples ever pushed
+  [[nodiscard]] uint64_t count() const {
+    return head_.load(std::memory_order_relaxed);
+  }
+
+  // Up to `max_samples` most recent samples, oldest first
+  [[nodiscard]] std::vector<uint32_t> snapshot(size_t max_samples) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t available = head < Capacity ? head : Capacity;
+    size_t n = static_cast<size_t>(
+        available < max_samples ? available : max_samples);
+
+    std::vector<uint32_t> samples(n);
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t index = head - n + i;
+      samples[i] = slots_[index & (Capacity - 1)].load(
+          std::memory_order_relaxed);
+    }
+    return samples;
+  }
+
+  static constexpr size_t capacity() { return Capacity; }
+
+private:
+  std::array<std::atomic<uint32_t>, Capacity> slots_{};
+  std::atomic<uint64_t> head_{0};
+};
+
+} // namespace slayergit::ui
@@ -0,0 +1,158 @@
+#include "diff_highlighter.hpp"
+
+#include <algorithm>
+
+namespace slayergit::ui {
+
+DiffHighlighter::DiffHighlighter(std::vector<FileDiffPtr> files,
+                                 Options options)
+    : files_(std::move(files)), options_(options) {
+  options_.checkpoint_interval =
+      std::max<size_t>(options_.checkpoint_interval, 1);
+  options_.cache_rows = std::max<size_t>(options_.cache_rows, 1);
+
+  for (uint32_t file = 0; file < files_.size(); ++file) {
+    const auto &diff = *files_[file];
+    const std::string &path =
+        diff.is_deleted || diff.new_path.empty() ? diff.old_path
+                                                 : diff.new_path;
+    languages_.push_back(language_for_path(path));
+
+    sections_.push_back({row_count_, file, no_hunk});
+    row_count_ += 1;
+    for (uint32_t hunk = 0; hunk < diff.hunks.size(); ++hunk) {
+      sections_.push_back({row_count_, file, hunk});
+      row_count_ += 1 + diff.hunks[hunk].lines.size();
+    }
+  }
+
+  size_t checkpoint_count = row_count_ / options_.checkpoint_interval + 1;
+  checkpoints_.resize(checkpoint_count);
+  checkpoint_known_.resize(checkpoint_count, false);
+  cache_.resize(options_.cache_rows);
+}
+
+DiffHighlighter::Row DiffHighlighter::row(size_t row) const {
+  const Section &section = section_of(row);
+  const core::FileDiff *file = files_[section.file].get();
+  if (section.hunk == no_hunk) {
+    return {RowKind::FileHeader, file, nullptr, nullptr};
+  }
+  const core::DiffHunk *hunk = &file->hunks[section.hunk];
+  size_t offset = row - section.first_row;
+  if (offset == 0) {
+    return {RowKind::HunkHeader, file, hunk, nullptr};
+  }
+  return {RowKind::Line, file, hunk, &hunk->lines[offset - 1]};
+}
+
+const std::vector<StyledSpan> &DiffHighlighter::spans(size_t row) {
+  CacheSlot &slot = cache_[row % cache_.size()];
+  if (slot.row == row) {
+    ++stats_.cache_hits;
+    return slot.spans;
+  }
+
+  SideStates before = state_before(row);
+  slot.spans.clear();
+  slot.after = advance(row, before, &slot.spans);
+  slot.row = row;
+  ++stats_.rows_lexed;
+  return slot.spans;
+}
+
+const DiffHighlighter::Section &DiffHighlighter::section_of(size_t row) const {
+  auto it = std::upper_bound(
+      sections_.begin(), sections_.end(), row,
+      [](size_t value, const Section &section) {
+        return value < section.first_row;
+      });
+  return *(it - 1);
+}
+
+DiffHighlighter::SideStates DiffHighlighter::state_before(size_t row) {
+  // Scrolling and drawing a viewport top to bottom hit this
+  if (row > 0) {
+    const CacheSlot &above = cache_[(row - 1) % cache_.size()];
+    if (above.row == row - 1) {
+      return above.after;
+    }
+  }
+
+  // The section's header resets the state, so checkpoints above it do not
+  // matter and nothing above it is ever scanned
+  size_t start = section_of(row).first_row;
+  size_t interval = options_.checkpoint_interval;
+  size_t first = (start + interval - 1) / interval;
+  size_t last = row / interval;
+  if (first > last) {
+    return scan(start, {}, row);
+  }
+
+  // Resume from the nearest known checkpoint and record the ones passed
+  size_t next = last + 1;
+  while (next > first && !checkpoint_known_[next - 1]) {
+    --next;
+  }
+  size_t from = start;
+  SideStates state;
+  if (next > first) {
+    from = (next - 1) * interval;
+    state = checkpoints_[next - 1];
+  }
+  for (; next <= last; ++next) {
+    size_t target = next * interval;
+    state = scan(from, state, target);
+    checkpoints_[next] = state;
+    checkpoint_known_[next] = true;
+    ++stats_.checkpoints;
+    from = target;
+  }
+  return scan(from, state, row);
+}
+
+DiffHighlighter::SideStates
+DiffHighlighter::scan(size_t from_row, SideStates state, size_t to_row) {
+  for (size_t row = from_row; row < to_row; ++row) {
+    state = advance(row, state, nullptr);
+    ++stats_.rows_scanned;
+  }
+  return state;
+}
+
+DiffHighlighter::SideStates
+DiffHighlighter::advance(size_t row, SideStates state,
+                         std::vector<StyledSpan> *spans) const {
+  Row current = this->row(row);
+  if (current.kind != RowKind::Line) {
+    return {};
+  }
+  const Language *language = languages_[section_of(row).file];
+  if (language == nullptr) {
+    return state;
+  }
+
+  const std::string &text = current.line->content;
+  switch (current.line->type) {
+  case core::DiffLine::Type::Addition:
+    state.new_side = lex_line(*language, text, state.new_side, spans);
+    break;
+  case core::DiffLine::Type::Deletion:
+    state.old_side = lex_line(*language, text, state.old_side, spans);
+    break;
+  case core::DiffLine::Type::Context: {
+    // Shown in the new file's colours; the old side only needs its state
+    LexState old_side = state.old_side;
+    bool same = old_side == state.new_side;
+    state.new_side = lex_line(*language, text, state.new_side, spans);
+    state.old_side =
+        same ? state.new_side : lex_line(*language, text, old_side, nullptr);
+    break;
+  }
+  case core::DiffLine::Type::Header:
+    break;
+  }
+  return state;
+}
+
+} // namespace slayergit::ui
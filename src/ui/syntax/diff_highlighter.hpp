@@ -0,0 +1,104 @@
+#pragma once
+
+#include "core/models/diff.hpp"
+#include "ui/syntax/syntax_lexer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Flattens diffs into rows (one per file header, hunk header and line) and
+// syntax-highlights them on demand. Only rows that are asked for are lexed,
+// so the cost of a frame depends on the viewport, not on the diff size.
+//
+// Two things keep that true anywhere in a huge diff:
+// - Lexer state is checkpointed every `checkpoint_interval` rows. Reaching
+//   a row lexes state-only from the nearest checkpoint (or hunk header,
+//   which resets the state) instead of from the top.
+// - Spans are cached per row in a fixed ring of slots that keep their
+//   capacity, so scrolling over rows already seen does not allocate.
+//
+// Deleted lines continue the old file's state and added lines the new
+// file's; context lines advance both. Not thread-safe.
+class DiffHighlighter {
+public:
+  using FileDiffPtr = std::shared_ptr<const core::FileDiff>;
+
+  enum class RowKind : uint8_t { FileHeader, HunkHeader, Line };
+
+  struct Row {
+    RowKind kind;
+    const core::FileDiff *file;
+    const core::DiffHunk *hunk; // nullptr for a file header
+    const core::DiffLine *line; // nullptr for headers
+  };
+
+  struct Options {
+    size_t checkpoint_interval = 256;
+    size_t cache_rows = 512; // Several viewports of the tallest terminal
+  };
+
+  struct Stats {
+    uint64_t rows_lexed = 0;   // Rows tokenized into spans
+    uint64_t rows_scanned = 0; // Rows lexed state-only to reach a row
+    uint64_t cache_hits = 0;
+    size_t checkpoints = 0;
+  };
+
+  DiffHighlighter() : DiffHighlighter({}, Options{}) {}
+  explicit DiffHighlighter(std::vector<FileDiffPtr> files)
+      : DiffHighlighter(std::move(files), Options{}) {}
+  DiffHighlighter(std::vector<FileDiffPtr> files, Options options);
+
+  [[nodiscard]] size_t row_count() const { return row_count_; }
+  [[nodiscard]] Row row(size_t row) const;
+
+  // Spans of the row's text (the line content, or the header). The
+  // reference stays valid until the next call.
+  const std::vector<StyledSpan> &spans(size_t row);
+
+  [[nodiscard]] const Stats &stats() const { return stats_; }
+
+private:
+  struct SideStates {
+    LexState old_side = LexState::Normal;
+    LexState new_side = LexState::Normal;
+  };
+
+  // A file header (hunk == npos) or a hunk header and its lines
+  struct Section {
+    size_t first_row;
+    uint32_t file;
+    uint32_t hunk;
+  };
+
+  struct CacheSlot {
+    size_t row = static_cast<size_t>(-1);
+    SideStates after; // State after this row, for the row below
+    std::vector<StyledSpan> spans;
+  };
+
+  static constexpr uint32_t no_hunk = static_cast<uint32_t>(-1);
+
+  [[nodiscard]] const Section &section_of(size_t row) const;
+  SideStates state_before(size_t row);
+  SideStates scan(size_t from_row, SideStates state, size_t to_row);
+  SideStates advance(size_t row, SideStates state,
+                     std::vector<StyledSpan> *spans) const;
+
+  std::vector<FileDiffPtr> files_;
+  std::vector<const Language *> languages_; // Per file; nullptr = plain
+  std::vector<Section> sections_;
+  size_t row_count_ = 0;
+  Options options_;
+  // checkpoints_[k] is the state before row k * checkpoint_interval
+  std::vector<SideStates> checkpoints_;
+  std::vector<bool> checkpoint_known_;
+  std::vector<CacheSlot> cache_;
+  Stats stats_;
+};
+
+} // namespace slayergit::ui
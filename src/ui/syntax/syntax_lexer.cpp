@@ -0,0 +1,359 @@
+#include "syntax_lexer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <initializer_list>
+
+namespace slayergit::ui {
+
+namespace {
+
+Language make_language(Language language) {
+  std::sort(language.keywords.begin(), language.keywords.end());
+  for (std::string_view opener :
+       {language.line_comment, language.block_open}) {
+    if (!opener.empty()) {
+      language.delimiters[static_cast<unsigned char>(opener.front())] = true;
+    }
+  }
+  language.delimiters['"'] = true;
+  language.delimiters['\''] = language.single_quote_strings;
+  return language;
+}
+
+const Language &cpp_language() {
+  static const Language language = make_language(
+      {"cpp", "//", "/*", "*/", true, false, true,
+       {"alignas",   "alignof",      "auto",          "bool",
+        "break",     "case",         "catch",         "char",
+        "char16_t",  "char32_t",     "char8_t",       "class",
+        "co_await",  "co_return",    "co_yield",      "concept",
+        "const",     "const_cast",   "consteval",     "constexpr",
+        "constinit", "continue",     "decltype",      "default",
+        "delete",    "do",           "double",        "dynamic_cast",
+        "else",      "enum",         "explicit",      "export",
+        "extern",    "false",        "final",         "float",
+        "for",       "friend",       "goto",          "if",
+        "inline",    "int",          "long",          "mutable",
+        "namespace", "new",          "noexcept",      "nullptr",
+        "operator",  "override",     "private",       "protected",
+        "public",    "register",     "reinterpret_cast", "requires",
+        "return",    "short",        "signed",        "sizeof",
+        "static",    "static_assert", "static_cast",  "struct",
+        "switch",    "template",     "this",          "thread_local",
+        "throw",     "true",         "try",           "typedef",
+        "typeid",    "typename",     "union",         "unsigned",
+        "using",     "virtual",      "void",          "volatile",
+        "wchar_t",   "while"}});
+  return language;
+}
+
+// Java, C#, JavaScript, TypeScript, Go, Rust, ... share one keyword list;
+// a stray keyword from a sibling language is harmless in a diff
+const Language &c_like_language() {
+  static const Language language = make_language(
+      {"c-like", "//", "/*", "*/", false, false, true,
+       {"abstract", "as",        "async",      "await",    "boolean",
+        "break",    "byte",      "case",       "catch",    "char",
+        "class",    "const",     "continue",   "default",  "defer",
+        "delete",   "do",        "double",     "else",     "enum",
+        "export",   "extends",   "false",      "final",    "finally",
+        "float",    "fn",        "for",        "func",     "function",
+        "go",       "if",        "impl",       "implements", "import",
+        "in",       "instanceof", "int",       "interface", "let",
+        "long",     "loop",      "match",      "mod",      "mut",
+        "namespace", "new",      "null",       "package",  "private",
+        "protected", "pub",      "public",     "return",   "self",
+        "short",    "static",    "struct",     "super",    "switch",
+        "this",     "throw",     "throws",     "trait",    "true",
+        "try",      "type",      "typeof",     "use",      "var",
+        "void",     "while",     "yield"}});
+  return language;
+}
+
+const Language &python_language() {
+  static const Language language = make_language(
+      {"python", "#", "", "", false, true, true,
+       {"False",  "None",     "True",   "and",    "as",     "assert",
+        "async",  "await",    "break",  "class",  "continue", "def",
+        "del",    "elif",     "else",   "except", "finally", "for",
+        "from",   "global",   "if",     "import", "in",     "is",
+        "lambda", "nonlocal", "not",    "or",     "pass",   "raise",
+        "return", "try",      "while",  "with",   "yield"}});
+  return language;
+}
+
+const Language &shell_language() {
+  static const Language language = make_language(
+      {"shell", "#", "", "", false, false, true,
+       {"case", "do", "done", "elif", "else", "esac", "export", "fi", "for",
+        "function", "if", "in", "local", "readonly", "return", "then",
+        "until", "while"}});
+  return language;
+}
+
+const Language &cmake_language() {
+  static const Language language = make_language(
+      {"cmake", "#", "", "", false, false, false,
+       {"add_executable", "add_library", "add_subdirectory", "else",
+        "elseif", "endforeach", "endfunction", "endif", "endmacro",
+        "endwhile", "find_package", "foreach", "function", "if", "include",
+        "macro", "option", "project", "return", "set",
+        "target_compile_definitions", "target_compile_options",
+        "target_include_directories", "target_link_libraries", "while"}});
+  return language;
+}
+
+bool ends_with(std::string_view value, std::string_view suffix) {
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+bool matches_any(std::string_view extension,
+                 std::initializer_list<std::string_view> candidates) {
+  return std::find(candidates.begin(), candidates.end(), extension) !=
+         candidates.end();
+}
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+bool is_identifier_start(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+bool is_identifier_char(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+bool starts_at(std::string_view line, size_t pos, std::string_view token) {
+  return !token.empty() && line.compare(pos, token.size(), token) == 0;
+}
+
+class LineLexer {
+public:
+  LineLexer(const Language &language, std::string_view line,
+            std::vector<StyledSpan> *spans)
+      : language_(language), line_(line), spans_(spans) {}
+
+  LexState run(LexState state) {
+    switch (state) {
+    case LexState::BlockComment:
+      if (!close(language_.block_close, TokenKind::Comment)) {
+        return state;
+      }
+      break;
+    case LexState::TripleDoubleQuote:
+      if (!close("\"\"\"", TokenKind::String)) {
+        return state;
+      }
+      break;
+    case LexState::TripleSingleQuote:
+      if (!close("'''", TokenKind::String)) {
+        return state;
+      }
+      break;
+    case LexState::Normal:
+      if (language_.preprocessor) {
+        directive();
+      }
+      break;
+    }
+
+    while (pos_ < line_.size()) {
+      char c = line_[pos_];
+      if (spans_ == nullptr &&
+          !language_.delimiters[static_cast<unsigned char>(c)]) {
+        // Words and numbers never contain a delimiter, so skipping them
+        // byte by byte reaches the same state
+        ++pos_;
+      } else if (is_space(c)) {
+        ++pos_;
+      } else if (starts_line_comment()) {
+        emit(pos_, line_.size(), TokenKind::Comment);
+        return LexState::Normal;
+      } else if (starts_at(line_, pos_, language_.block_open)) {
+        if (!open(language_.block_open, language_.block_close,
+                  TokenKind::Comment)) {
+          return LexState::BlockComment;
+        }
+      } else if (language_.triple_quotes && starts_at(line_, pos_, "\"\"\"")) {
+        if (!open("\"\"\"", "\"\"\"", TokenKind::String)) {
+          return LexState::TripleDoubleQuote;
+        }
+      } else if (language_.triple_quotes && starts_at(line_, pos_, "'''")) {
+        if (!open("'''", "'''", TokenKind::String)) {
+          return LexState::TripleSingleQuote;
+        }
+      } else if (c == '"' || (c == '\'' && language_.single_quote_strings)) {
+        quoted(c);
+      } else if (is_digit(c) ||
+                 (c == '.' && pos_ + 1 < line_.size() &&
+                  is_digit(line_[pos_ + 1]))) {
+        number();
+      } else if (is_identifier_start(c)) {
+        word();
+      } else {
+        ++pos_;
+      }
+    }
+    return LexState::Normal;
+  }
+
+private:
+  void emit(size_t begin, size_t end, TokenKind kind) {
+    if (spans_ != nullptr && end > begin) {
+      spans_->push_back({static_cast<uint32_t>(begin),
+                         static_cast<uint32_t>(end - begin), kind});
+    }
+  }
+
+  // Finishes a construct carried over from the previous line. Returns
+  // false if it does not end on this line.
+  bool close(std::string_view terminator, TokenKind kind) {
+    size_t end = line_.find(terminator);
+    if (end == std::string_view::npos) {
+      emit(0, line_.size(), kind);
+      return false;
+    }
+    pos_ = end + terminator.size();
+    emit(0, pos_, kind);
+    return true;
+  }
+
+  // Starts a construct at pos_. Returns false if it runs past the line.
+  bool open(std::string_view opener, std::string_view terminator,
+            TokenKind kind) {
+    size_t begin = pos_;
+    size_t end = line_.find(terminator, pos_ + opener.size());
+    if (end == std::string_view::npos) {
+      emit(begin, line_.size(), kind);
+      pos_ = line_.size();
+      return false;
+    }
+    pos_ = end + terminator.size();
+    emit(begin, pos_, kind);
+    return true;
+  }
+
+  // '#' only starts a comment at the start of a word, so `${#array[@]}`
+  // and `a#b` in shell stay code
+  bool starts_line_comment() const {
+    if (!starts_at(line_, pos_, language_.line_comment)) {
+      return false;
+    }
+    return language_.line_comment != "#" || pos_ == 0 ||
+           is_space(line_[pos_ - 1]);
+  }
+
+  void directive() {
+    size_t hash = 0;
+    while (hash < line_.size() && is_space(line_[hash])) {
+      ++hash;
+    }
+    if (hash >= line_.size() || line_[hash] != '#') {
+      return;
+    }
+    size_t end = hash + 1;
+    while (end < line_.size() && is_space(line_[end])) {
+      ++end;
+    }
+    size_t name = end;
+    while (end < line_.size() && is_identifier_char(line_[end])) {
+      ++end;
+    }
+    emit(hash, end, TokenKind::Preprocessor);
+    pos_ = end;
+
+    // #include <path>: the path reads as a string
+    if (line_.substr(name, end - name) == "include") {
+      while (pos_ < line_.size() && is_space(line_[pos_])) {
+        ++pos_;
+      }
+      if (pos_ < line_.size() && line_[pos_] == '<') {
+        size_t close = line_.find('>', pos_);
+        size_t stop = close == std::string_view::npos ? line_.size() : close + 1;
+        emit(pos_, stop, TokenKind::String);
+        pos_ = stop;
+      }
+    }
+  }
+
+  // Unterminated quotes end at the end of the line
+  void quoted(char quote) {
+    size_t begin = pos_++;
+    while (pos_ < line_.size() && line_[pos_] != quote) {
+      pos_ += line_[pos_] == '\\' ? 2 : 1;
+    }
+    pos_ = std::min(pos_ + 1, line_.size());
+    emit(begin, pos_, TokenKind::String);
+  }
+
+  void number() {
+    size_t begin = pos_++;
+    while (pos_ < line_.size() &&
+           (is_identifier_char(line_[pos_]) || line_[pos_] == '.')) {
+      ++pos_;
+    }
+    emit(begin, pos_, TokenKind::Number);
+  }
+
+  void word() {
+    size_t begin = pos_++;
+    while (pos_ < line_.size() && is_identifier_char(line_[pos_])) {
+      ++pos_;
+    }
+    if (spans_ != nullptr &&
+        std::binary_search(language_.keywords.begin(),
+                           language_.keywords.end(),
+                           line_.substr(begin, pos_ - begin))) {
+      emit(begin, pos_, TokenKind::Keyword);
+    }
+  }
+
+  const Language &language_;
+  std::string_view line_;
+  std::vector<StyledSpan> *spans_;
+  size_t pos_ = 0;
+};
+
+} // namespace
+
+const Language *language_for_path(std::string_view path) {
+  size_t slash = path.find_last_of('/');
+  std::string_view file =
+      slash == std::string_view::npos ? path : path.substr(slash + 1);
+  if (file == "CMakeLists.txt" || ends_with(file, ".cmake")) {
+    return &cmake_language();
+  }
+
+  size_t dot = file.find_last_of('.');
+  if (dot == std::string_view::npos) {
+    return nullptr;
+  }
+  std::string_view extension = file.substr(dot + 1);
+  if (matches_any(extension, {"c", "cc", "cpp", "cxx", "h", "hh", "hpp",
+                              "hxx", "inl", "ipp", "m", "mm"})) {
+    return &cpp_language();
+  }
+  if (matches_any(extension, {"cs", "go", "java", "js", "jsx", "kt", "rs",
+                              "scala", "swift", "ts", "tsx"})) {
+    return &c_like_language();
+  }
+  if (matches_any(extension, {"py", "pyi"})) {
+    return &python_language();
+  }
+  if (matches_any(extension, {"sh", "bash", "zsh"})) {
+    return &shell_language();
+  }
+  return nullptr;
+}
+
+LexState lex_line(const Language &language, std::string_view line,
+                  LexState state, std::vector<StyledSpan> *spans) {
+  return LineLexer(language, line, spans).run(state);
+}
+
+} // namespace slayergit::ui
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace slayergit::ui {
+
+enum class TokenKind : uint8_t {
+  Plain,
+  Keyword,
+  String,
+  Number,
+  Comment,
+  Preprocessor,
+};
+
+// A styled run inside one line; bytes not covered by any span are Plain
+struct StyledSpan {
+  uint32_t begin;
+  uint32_t length;
+  TokenKind kind;
+};
+
+// Lexer state carried from the end of one line to the start of the next.
+// Only constructs that can span lines need a state of their own.
+enum class LexState : uint8_t {
+  Normal,
+  BlockComment,
+  TripleDoubleQuote,  // Python """..."""
+  TripleSingleQuote,  // Python '''...'''
+};
+
+// Just enough of a language to colour a diff: comments, strings, numbers
+// and a sorted keyword list
+struct Language {
+  std::string_view name;
+  std::string_view line_comment;   // Empty if none
+  std::string_view block_open;     // Empty if none
+  std::string_view block_close;
+  bool preprocessor = false;       // '#' at line start starts a directive
+  bool triple_quotes = false;      // Python-style multi-line strings
+  bool single_quote_strings = true;
+  std::vector<std::string_view> keywords; // Sorted
+  // Bytes that can start a comment or string; the state-only scan skips
+  // everything else without looking at it
+  std::array<bool, 256> delimiters{};
+};
+
+// Picks a language from a file's extension or name; nullptr when unknown
+const Language *language_for_path(std::string_view path);
+
+// Lexes one line starting in `state` and returns the state for the next
+// line. With `spans` == nullptr only the state is computed, which is what
+// checkpointing uses to skip over lines that are not on screen.
+LexState lex_line(const Language &language, std::string_view line,
+                  LexState state, std::vector<StyledSpan> *spans);
+
+} // namespace slayergit::ui
@@ -0,0 +1,78 @@
+#include "branches_tab.hpp"
+
+#include "core/branches.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace slayergit::ui {
+
+BranchesTab::BranchesTab(std::string name)
+    : WindowTab(std::move(name)), status_("Loading...") {
+  set_list(std::make_shared<VirtualList>(
+      [this] { return branch_count(); },
+      [this](size_t row, bool) { return render_row(row); }));
+  set_content_renderer([this] { return render_branches(); });
+}
+
+void BranchesTab::set_branches(std::vector<core::Branch> branches) {
+  size_t width = 0;
+  for (const auto &branch : branches) {
+    width = std::max(width, branch.name.size());
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  branches_ = std::move(branches);
+  name_width_ = width;
+  invalidate();
+}
+
+void BranchesTab::set_status(std::string status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  status_ = std::move(status);
+  invalidate();
+}
+
+size_t BranchesTab::branch_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return branches_.size();
+}
+
+ftxui::Element BranchesTab::render_branches() const {
+  using namespace ftxui;
+
+  Element rows = list()->render();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (status_.empty()) {
+    return rows;
+  }
+  return vbox({rows | flex, text(status_) | dim});
+}
+
+ftxui::Element BranchesTab::render_row(size_t row) const {
+  using namespace ftxui;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (row >= branches_.size()) {
+    return text("");
+  }
+  const auto &branch = branches_[row];
+  std::string name = branch.name;
+  name.resize(std::max(name_width_, name.size()), ' ');
+  Element label = text(name);
+  if (branch.is_head) {
+    label = label | color(Color::Green);
+  }
+  Elements parts{
+      text(branch.is_head ? "* " : "  ") | color(Color::Green),
+      label,
+      text(" " + branch.hash.substr(0, 7)) | color(Color::Yellow),
+  };
+  std::string tracking = core::tracking_label(branch);
+  if (!tracking.empty()) {
+    parts.push_back(text(" " + tracking) | color(Color::Cyan));
+  }
+  return hbox(std::move(parts));
+}
+
+} // namespace slayergit::ui
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core/models/branch.hpp"
+#include "ui/window_tab.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Local branches with their upstream and ahead/behind counts. The list may
+// be replaced from a background thread.
+class BranchesTab : public WindowTab {
+public:
+  explicit BranchesTab(std::string name = "Branches");
+
+  void set_branches(std::vector<core::Branch> branches);
+
+  // Shown under the list ("Loading...", error text, ...)
+  void set_status(std::string status);
+
+  [[nodiscard]] size_t branch_count() const;
+
+private:
+  [[nodiscard]] ftxui::Element render_branches() const;
+  [[nodiscard]] ftxui::Element render_row(size_t row) const;
+
+  mutable std::mutex mutex_;
+  std::vector<core::Branch> branches_;
+  size_t name_width_ = 0;
+  std::string status_;
+};
+
+} // namespace slayergit::ui
@@ -0,0 +1,95 @@
+#include "changes_tab.hpp"
+
+#include <memory>
+
+namespace slayergit::ui {
+
+ChangesTab::ChangesTab(std::string name, Side side)
+    : WindowTab(std::move(name)), side_(side), status_("Loading...") {
+  set_list(std::make_shared<VirtualList>(
+      [this] { return file_count(); },
+      [this](size_t row, bool) { return render_row(row); }));
+  set_content_renderer([this] { return render_changes(); });
+}
+
+void ChangesTab::set_files(std::vector<core::FileStatus> files) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  files_ = std::move(files);
+  loaded_ = true;
+  invalidate();
+}
+
+void ChangesTab::set_status(std::string status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  status_ = std::move(status);
+  invalidate();
+}
+
+void ChangesTab::set_cursor_callback(CursorCallback callback) {
+  list()->set_selection_callback(std::move(callback));
+}
+
+size_t ChangesTab::file_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return files_.size();
+}
+
+std::string ChangesTab::path_at(size_t row) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return row < files_.size() ? files_[row].path : std::string();
+}
+
+std::optional<core::FileStatus> ChangesTab::file_at(size_t row) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (row >= files_.size()) {
+    return std::nullopt;
+  }
+  return files_[row];
+}
+
+core::FileStatusType ChangesTab::type_of(const core::FileStatus &file) const {
+  return side_ == Side::Staged ? file.staged_status : file.unstaged_status;
+}
+
+ftxui::Element ChangesTab::render_changes() const {
+  using namespace ftxui;
+
+  std::string status;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!loaded_) {
+      return text(status_) | dim;
+    }
+    if (files_.empty()) {
+      return text(status_.empty() ? "No changes" : status_) | dim;
+    }
+    status = status_;
+  }
+  // The list takes the lock itself
+  Element rows = list()->render();
+  if (status.empty()) {
+    return rows;
+  }
+  return vbox({rows | flex, text(status) | dim});
+}
+
+ftxui::Element ChangesTab::render_row(size_t row) const {
+  using namespace ftxui;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (row >= files_.size()) {
+    return text("");
+  }
+  const core::FileStatus &file = files_[row];
+  core::FileStatusType type = type_of(file);
+  // Staged green and work tree red, as git status colours them
+  Color tint = type == core::FileStatusType::Unmerged ? Color::Magenta
+               : side_ == Side::Staged                ? Color::Green
+                                                      : Color::Red;
+  return hbox({
+      text(std::string(1, core::status_code(type)) + " ") | color(tint),
+      text(file.path),
+  });
+}
+
+} // namespace slayergit::ui
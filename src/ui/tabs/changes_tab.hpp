@@ -0,0 +1,50 @@
+#pragma once
+
+#include "core/models/file_status.hpp"
+#include "ui/window_tab.hpp"
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Changed files on one side of the index: work tree changes (and unmerged
+// paths) or staged ones, with git status' letter in front. The list may
+// be replaced from a background thread.
+class ChangesTab : public WindowTab {
+public:
+  enum class Side { Unstaged, Staged };
+  using CursorCallback = std::function<void(size_t row)>;
+
+  ChangesTab(std::string name, Side side);
+
+  void set_files(std::vector<core::FileStatus> files);
+
+  // Shown instead of the list until files arrive, and under it after
+  void set_status(std::string status);
+
+  // Told about every cursor move, e.g. to show the file's diff
+  void set_cursor_callback(CursorCallback callback);
+
+  [[nodiscard]] Side side() const { return side_; }
+  [[nodiscard]] size_t file_count() const;
+  [[nodiscard]] std::string path_at(size_t row) const;
+  // nullopt past the end
+  [[nodiscard]] std::optional<core::FileStatus> file_at(size_t row) const;
+
+private:
+  [[nodiscard]] core::FileStatusType type_of(const core::FileStatus &file) const;
+  [[nodiscard]] ftxui::Element render_changes() const;
+  [[nodiscard]] ftxui::Element render_row(size_t row) const;
+
+  Side side_;
+  mutable std::mutex mutex_;
+  std::vector<core::FileStatus> files_;
+  bool loaded_ = false;
+  std::string status_;
+};
+
+} // namespace slayergit::ui
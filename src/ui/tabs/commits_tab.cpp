@@ -0,0 +1,176 @@
+#include "commits_tab.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <iterator>
+
+namespace slayergit::ui {
+
+namespace {
+
+// Wider graphs are cut off so the subject stays visible
+constexpr size_t max_graph_columns = 16;
+
+const char *graph_glyph(uint8_t cell, bool merge) {
+  if ((cell & core::GraphNode) != 0) {
+    return merge ? "⏣" : "◯";
+  }
+  switch (cell & (core::GraphUp | core::GraphDown | core::GraphLeft |
+                  core::GraphRight)) {
+  case core::GraphUp | core::GraphDown:
+    return "│";
+  case core::GraphUp | core::GraphDown | core::GraphLeft:
+    return "┤";
+  case core::GraphUp | core::GraphDown | core::GraphRight:
+    return "├";
+  case core::GraphUp | core::GraphDown | core::GraphLeft | core::GraphRight:
+    return "┼";
+  case core::GraphUp | core::GraphLeft:
+    return "╯";
+  case core::GraphUp | core::GraphRight:
+    return "╰";
+  case core::GraphUp | core::GraphLeft | core::GraphRight:
+    return "┴";
+  case core::GraphDown | core::GraphLeft:
+    return "╮";
+  case core::GraphDown | core::GraphRight:
+    return "╭";
+  case core::GraphDown | core::GraphLeft | core::GraphRight:
+    return "┬";
+  case core::GraphLeft:
+  case core::GraphRight:
+  case core::GraphLeft | core::GraphRight:
+    return "─";
+  case core::GraphDown:
+    return "╷";
+  case core::GraphUp:
+    return "╵";
+  default:
+    return " ";
+  }
+}
+
+ftxui::Color lane_color(size_t column) {
+  using ftxui::Color;
+  static const Color palette[] = {Color::Blue,  Color::Green, Color::Magenta,
+                                  Color::Cyan,  Color::Yellow, Color::Red};
+  return palette[column % (sizeof(palette) / sizeof(palette[0]))];
+}
+
+std::string format_date(std::time_t timestamp) {
+  std::tm tm{};
+  localtime_r(&timestamp, &tm);
+  char buffer[16];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm);
+  return buffer;
+}
+
+} // namespace
+
+CommitsTab::CommitsTab(std::string name)
+    : WindowTab(std::move(name)),
+      commit_at_([this](size_t row) -> const core::Commit & {
+        return commits_[row];
+      }),
+      status_("Loading...") {
+  set_list(std::make_shared<VirtualList>(
+      [this] { return commit_count(); },
+      [this](size_t row, bool) { return render_row(row); }));
+  set_content_renderer([this] { return render_commits(); });
+}
+
+void CommitsTab::append_commits(std::vector<core::Commit> batch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  graph_.append(batch);
+  if (commits_.empty()) {
+    commits_ = std::move(batch);
+  } else {
+    commits_.insert(commits_.end(), std::make_move_iterator(batch.begin()),
+                    std::make_move_iterator(batch.end()));
+  }
+  invalidate();
+}
+
+void CommitsTab::set_topological(bool topological) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  graph_.set_topological(topological);
+  invalidate();
+}
+
+void CommitsTab::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  commits_.clear();
+  graph_.clear();
+  invalidate();
+}
+
+void CommitsTab::set_status(std::string status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  status_ = std::move(status);
+  invalidate();
+}
+
+void CommitsTab::set_cursor_callback(CursorCallback callback) {
+  list()->set_selection_callback(std::move(callback));
+}
+
+size_t CommitsTab::commit_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return commits_.size();
+}
+
+std::string CommitsTab::hash_at(size_t row) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return row < commits_.size() ? commits_[row].hash : std::string();
+}
+
+ftxui::Element CommitsTab::render_commits() const {
+  using namespace ftxui;
+
+  Element rows = list()->render();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (status_.empty()) {
+    return rows;
+  }
+  return vbox({rows | flex, text(status_) | dim});
+}
+
+ftxui::Element CommitsTab::render_row(size_t row) const {
+  using namespace ftxui;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (row >= commits_.size()) {
+    return text("");
+  }
+  const auto &commit = commits_[row];
+  return hbox({
+      render_graph(row),
+      text(commit.short_hash) | color(Color::Yellow),
+      text(" " + format_date(commit.author_date) + " ") | dim,
+      text(commit.author_name) | color(Color::Cyan),
+      text(" " + commit.subject),
+  });
+}
+
+// Caller holds mutex_
+ftxui::Element CommitsTab::render_graph(size_t row) const {
+  using namespace ftxui;
+
+  const core::GraphRow &graph = graph_.row(row, commit_at_);
+  size_t columns = std::min(graph.cells.size(), max_graph_columns);
+  Elements parts;
+  parts.reserve(columns + 1);
+  for (size_t column = 0; column < columns; ++column) {
+    uint8_t cell = graph.cells[column];
+    std::string glyph = graph_glyph(cell, graph.merge);
+    glyph += (cell & core::GraphRight) != 0 ? "─" : " ";
+    parts.push_back(text(std::move(glyph)) | color(lane_color(column)));
+  }
+  if (graph.cells.size() > max_graph_columns) {
+    parts.push_back(text("… ") | dim);
+  }
+  return hbox(std::move(parts));
+}
+
+} // namespace slayergit::ui
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "core/graph_layout.hpp"
+#include "core/models/commit.hpp"
+#include "ui/window_tab.hpp"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Commit history for the History window, with a lane graph in front of
+// each row. Batches may arrive from a background thread while the log is
+// still streaming in; the graph expects topological order unless told
+// otherwise.
+class CommitsTab : public WindowTab {
+public:
+  using CursorCallback = std::function<void(size_t row)>;
+
+  explicit CommitsTab(std::string name = "Log");
+
+  void append_commits(std::vector<core::Commit> batch);
+  void clear();
+
+  // False for a log in date order; see core::GraphLayout
+  void set_topological(bool topological);
+
+  // Shown under the list ("Loading...", error text, ...)
+  void set_status(std::string status);
+
+  // Told about every cursor move, e.g. to page in more of the log
+  void set_cursor_callback(CursorCallback callback);
+
+  [[nodiscard]] size_t commit_count() const;
+  // Full hash of the commit on `row`, or empty past the end
+  [[nodiscard]] std::string hash_at(size_t row) const;
+
+private:
+  [[nodiscard]] ftxui::Element render_commits() const;
+  [[nodiscard]] ftxui::Element render_row(size_t row) const;
+  [[nodiscard]] ftxui::Element render_graph(size_t row) const;
+
+  mutable std::mutex mutex_;
+  std::vector<core::Commit> commits_;
+  // Lanes are laid out as batches arrive; row() replays from a checkpoint
+  // while rendering, hence mutable
+  mutable core::GraphLayout graph_;
+  core::GraphLayout::CommitAt commit_at_;
+  std::string status_;
+};
+
+} // namespace slayergit::ui
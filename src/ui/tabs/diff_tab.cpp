@@ -0,0 +1,171 @@
+#include "diff_tab.hpp"
+
+#include <memory>
+
+namespace slayergit::ui {
+
+namespace {
+
+ftxui::Color token_color(TokenKind kind) {
+  using ftxui::Color;
+  switch (kind) {
+  case TokenKind::Keyword:
+    return Color::Magenta;
+  case TokenKind::String:
+    return Color::Yellow;
+  case TokenKind::Number:
+    return Color::BlueLight;
+  case TokenKind::Comment:
+    return Color::GrayDark;
+  case TokenKind::Preprocessor:
+    return Color::MagentaLight;
+  case TokenKind::Plain:
+    break;
+  }
+  return Color::Default;
+}
+
+std::string file_title(const core::FileDiff &file) {
+  std::string title = file.is_renamed ? file.old_path + " -> " + file.new_path
+                      : file.is_deleted ? file.old_path
+                                        : file.new_path;
+  if (file.is_new_file) {
+    title += " (new file)";
+  } else if (file.is_deleted) {
+    title += " (deleted)";
+  }
+  if (file.is_binary) {
+    title += " (binary)";
+  } else if (file.is_too_large) {
+    title += " (too large to diff)";
+  }
+  return title;
+}
+
+} // namespace
+
+DiffTab::DiffTab(std::string name) : WindowTab(std::move(name)) {
+  set_list(std::make_shared<VirtualList>(
+      [this] { return row_count(); },
+      [this](size_t row, bool) { return render_row(row); }));
+  set_content_renderer([this] { return render_diff(); });
+}
+
+void DiffTab::set_diff(core::Diff diff) {
+  std::vector<DiffHighlighter::FileDiffPtr> files;
+  files.reserve(diff.files.size());
+  for (auto &file : diff.files) {
+    files.push_back(std::make_shared<const core::FileDiff>(std::move(file)));
+  }
+  replace(std::move(files));
+}
+
+void DiffTab::set_file_diff(DiffHighlighter::FileDiffPtr diff) {
+  std::vector<DiffHighlighter::FileDiffPtr> files;
+  if (diff) {
+    files.push_back(std::move(diff));
+  }
+  replace(std::move(files));
+}
+
+void DiffTab::clear() { replace({}); }
+
+void DiffTab::set_status(std::string status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  status_ = std::move(status);
+  invalidate();
+}
+
+size_t DiffTab::row_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return highlighter_.row_count();
+}
+
+DiffHighlighter::Stats DiffTab::highlight_stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return highlighter_.stats();
+}
+
+void DiffTab::replace(std::vector<DiffHighlighter::FileDiffPtr> files) {
+  // Build outside the lock; only the swap blocks the render thread
+  DiffHighlighter highlighter(std::move(files));
+  std::lock_guard<std::mutex> lock(mutex_);
+  highlighter_ = std::move(highlighter);
+  scroll_to_top_ = true;
+  invalidate();
+}
+
+ftxui::Element DiffTab::render_diff() {
+  using namespace ftxui;
+
+  bool scroll_to_top = false;
+  bool empty = false;
+  std::string status;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(scroll_to_top, scroll_to_top_);
+    empty = highlighter_.row_count() == 0;
+    status = status_;
+  }
+  // The list reads the row count under mutex_, so it is driven unlocked
+  if (scroll_to_top) {
+    list()->select_first();
+  }
+  if (empty) {
+    return text(status.empty() ? "No changes" : status) | dim;
+  }
+  return list()->render();
+}
+
+ftxui::Element DiffTab::render_row(size_t row) {
+  using namespace ftxui;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (row >= highlighter_.row_count()) {
+    return text("");
+  }
+  DiffHighlighter::Row current = highlighter_.row(row);
+  switch (current.kind) {
+  case DiffHighlighter::RowKind::FileHeader:
+    return text(file_title(*current.file)) | bold;
+  case DiffHighlighter::RowKind::HunkHeader:
+    return text(current.hunk->header) | color(Color::Cyan);
+  case DiffHighlighter::RowKind::Line:
+    break;
+  }
+
+  const core::DiffLine &line = *current.line;
+  const char *marker = " ";
+  Color line_color = Color::Default;
+  if (line.type == core::DiffLine::Type::Addition) {
+    marker = "+";
+    line_color = Color::Green;
+  } else if (line.type == core::DiffLine::Type::Deletion) {
+    marker = "-";
+    line_color = Color::Red;
+  }
+
+  // Keywords, strings, ... keep their syntax colour; the marker and the
+  // plain text carry the addition/deletion colour
+  const std::string &content = line.content;
+  const auto &spans = highlighter_.spans(row);
+  Elements parts;
+  parts.reserve(2 * spans.size() + 2);
+  parts.push_back(text(marker) | color(line_color));
+  size_t pos = 0;
+  for (const auto &span : spans) {
+    if (span.begin > pos) {
+      parts.push_back(text(content.substr(pos, span.begin - pos)) |
+                      color(line_color));
+    }
+    parts.push_back(text(content.substr(span.begin, span.length)) |
+                    color(token_color(span.kind)));
+    pos = span.begin + span.length;
+  }
+  if (pos < content.size()) {
+    parts.push_back(text(content.substr(pos)) | color(line_color));
+  }
+  return hbox(std::move(parts));
+}
+
+} // namespace slayergit::ui
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core/models/diff.hpp"
+#include "ui/syntax/diff_highlighter.hpp"
+#include "ui/window_tab.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Diff of the selected commit or file. Rows go through a VirtualList and a
+// DiffHighlighter, so only the lines in the viewport are syntax-highlighted
+// and a 50k-line diff costs the same per frame as a 50-line one. Diffs may
+// be set from a background thread.
+class DiffTab : public WindowTab {
+public:
+  explicit DiffTab(std::string name = "Diff");
+
+  void set_diff(core::Diff diff);
+  // A single file, shared with whoever else holds it
+  void set_file_diff(DiffHighlighter::FileDiffPtr diff);
+  void clear();
+
+  // Shown instead of the diff while it is empty ("Loading...", errors)
+  void set_status(std::string status);
+
+  [[nodiscard]] size_t row_count() const;
+  [[nodiscard]] DiffHighlighter::Stats highlight_stats() const;
+
+private:
+  void replace(std::vector<DiffHighlighter::FileDiffPtr> files);
+  [[nodiscard]] ftxui::Element render_diff();
+  [[nodiscard]] ftxui::Element render_row(size_t row);
+
+  mutable std::mutex mutex_;
+  DiffHighlighter highlighter_;
+  std::string status_;
+  bool scroll_to_top_ = false; // A new diff arrived since the last frame
+};
+
+} // namespace slayergit::ui
@@ -0,0 +1,74 @@
+#include "refs_tab.hpp"
+
+namespace slayergit::ui {
+
+RefsTab::RefsTab(std::string name, std::string prefix)
+    : WindowTab(std::move(name)), prefix_(std::move(prefix)),
+      status_("Loading...") {
+  set_list(std::make_shared<VirtualList>(
+      [this] { return ref_count(); },
+      [this](size_t row, bool) { return render_row(row); }));
+  set_content_renderer([this] { return render_refs(); });
+}
+
+void RefsTab::set_snapshot(std::shared_ptr<const core::RefSnapshot> snapshot) {
+  auto [first, last] = snapshot ? snapshot->range(prefix_)
+                                : std::pair<size_t, size_t>{0, 0};
+  std::lock_guard<std::mutex> lock(mutex_);
+  snapshot_ = std::move(snapshot);
+  first_ = first;
+  last_ = last;
+  invalidate();
+}
+
+void RefsTab::set_status(std::string status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  status_ = std::move(status);
+  invalidate();
+}
+
+size_t RefsTab::ref_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_ - first_;
+}
+
+ftxui::Element RefsTab::render_refs() const {
+  using namespace ftxui;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!snapshot_) {
+      return text(status_) | dim;
+    }
+    if (first_ == last_) {
+      return text("None") | dim;
+    }
+  }
+  return list()->render();
+}
+
+ftxui::Element RefsTab::render_row(size_t row) const {
+  using namespace ftxui;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!snapshot_ || row >= last_ - first_) {
+    return text("");
+  }
+  size_t index = first_ + row;
+  std::string name(snapshot_->name(index).substr(prefix_.size()));
+  Elements parts{text(std::string(snapshot_->oid(index).substr(0, 7)) + " ") |
+                     color(Color::Yellow),
+                 text(name)};
+  if (!snapshot_->symref(index).empty()) {
+    parts.push_back(text(" -> " + std::string(snapshot_->symref(index))) |
+                    dim);
+  } else if (!snapshot_->peeled(index).empty()) {
+    // Annotated tag: also show the commit it tags
+    parts.push_back(
+        text(" ^" + std::string(snapshot_->peeled(index).substr(0, 7))) |
+        dim);
+  }
+  return hbox(std::move(parts));
+}
+
+} // namespace slayergit::ui
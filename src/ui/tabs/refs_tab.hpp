@@ -0,0 +1,39 @@
+#pragma once
+
+#include "core/ref_snapshot.hpp"
+#include "ui/window_tab.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace slayergit::ui {
+
+// The refs under one prefix (refs/tags/, refs/remotes/) of a RefSnapshot.
+// Rows index straight into the shared snapshot, so 60k tags cost nothing
+// until they scroll into view. The snapshot may be replaced from a
+// background thread.
+class RefsTab : public WindowTab {
+public:
+  RefsTab(std::string name, std::string prefix);
+
+  void set_snapshot(std::shared_ptr<const core::RefSnapshot> snapshot);
+
+  // Shown instead of the list while there is no snapshot
+  void set_status(std::string status);
+
+  [[nodiscard]] size_t ref_count() const;
+
+private:
+  [[nodiscard]] ftxui::Element render_refs() const;
+  [[nodiscard]] ftxui::Element render_row(size_t row) const;
+
+  std::string prefix_;
+  mutable std::mutex mutex_;
+  std::shared_ptr<const core::RefSnapshot> snapshot_;
+  size_t first_ = 0; // Range of prefix_ in snapshot_
+  size_t last_ = 0;
+  std::string status_;
+};
+
+} // namespace slayergit::ui
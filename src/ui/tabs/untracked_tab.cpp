@@ -0,0 +1,172 @@
+#include "untracked_tab.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+namespace slayergit::ui {
+
+namespace {
+
+bool is_dir(const std::string &path) {
+  return !path.empty() && path.back() == '/';
+}
+
+// Last component, keeping a directory's '/'
+std::string display_name(const std::string &path) {
+  size_t end = is_dir(path) ? path.size() - 1 : path.size();
+  size_t slash = path.rfind('/', end == 0 ? 0 : end - 1);
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+UntrackedTab::UntrackedTab(std::string name)
+    : WindowTab(std::move(name)), status_("Loading...") {
+  set_list(std::make_shared<VirtualList>(
+      [this] { return row_count(); },
+      [this](size_t row, bool) { return render_row(row); }));
+  set_content_renderer([this] { return render_untracked(); });
+  set_activate_callback([this] { toggle(list()->selected()); });
+}
+
+void UntrackedTab::set_entries(std::vector<std::string> entries) {
+  std::vector<std::string> reopen;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rows_.clear();
+    rows_.reserve(entries.size());
+    for (auto &entry : entries) {
+      bool open = open_.count(entry) != 0;
+      if (open) {
+        reopen.push_back(entry);
+      }
+      rows_.push_back({std::move(entry), 0, open});
+    }
+    invalidate();
+  }
+  for (const auto &dir : reopen) {
+    if (expand_callback_) {
+      expand_callback_(dir);
+    }
+  }
+}
+
+void UntrackedTab::set_children(const std::string &dir,
+                                std::vector<std::string> children) {
+  std::vector<std::string> reopen;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(rows_.begin(), rows_.end(), [&](const Row &row) {
+      return row.path == dir;
+    });
+    if (it == rows_.end() || !it->open) {
+      return; // Closed, or gone in a refresh, while loading
+    }
+    size_t depth = it->depth + 1;
+    auto end = std::find_if(std::next(it), rows_.end(), [&](const Row &row) {
+      return row.depth < depth;
+    });
+    it = rows_.erase(std::next(it), end);
+    std::vector<Row> inserted;
+    inserted.reserve(children.size());
+    for (auto &child : children) {
+      bool open = open_.count(child) != 0;
+      if (open) {
+        reopen.push_back(child);
+      }
+      inserted.push_back({std::move(child), depth, open});
+    }
+    rows_.insert(it, std::make_move_iterator(inserted.begin()),
+                 std::make_move_iterator(inserted.end()));
+    invalidate();
+  }
+  for (const auto &child : reopen) {
+    if (expand_callback_) {
+      expand_callback_(child);
+    }
+  }
+}
+
+void UntrackedTab::toggle(size_t row) {
+  std::string dir;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (row >= rows_.size() || !is_dir(rows_[row].path)) {
+      return;
+    }
+    Row &target = rows_[row];
+    if (target.open) {
+      // Everything below closes with it
+      target.open = false;
+      auto first = rows_.begin() + static_cast<ptrdiff_t>(row) + 1;
+      auto end = std::find_if(first, rows_.end(), [&](const Row &other) {
+        return other.depth <= target.depth;
+      });
+      rows_.erase(first, end);
+      for (auto it = open_.lower_bound(target.path);
+           it != open_.end() && it->compare(0, target.path.size(),
+                                            target.path) == 0;) {
+        it = open_.erase(it);
+      }
+      invalidate();
+      return;
+    }
+    target.open = true;
+    open_.insert(target.path);
+    dir = target.path;
+    invalidate();
+  }
+  if (expand_callback_) {
+    expand_callback_(dir);
+  }
+}
+
+void UntrackedTab::set_status(std::string status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  status_ = std::move(status);
+  invalidate();
+}
+
+size_t UntrackedTab::row_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return rows_.size();
+}
+
+std::string UntrackedTab::path_at(size_t row) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return row < rows_.size() ? rows_[row].path : std::string();
+}
+
+ftxui::Element UntrackedTab::render_untracked() const {
+  using namespace ftxui;
+
+  Element rows = list()->render();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (status_.empty()) {
+    return rows;
+  }
+  return vbox({rows | flex, text(status_) | dim});
+}
+
+ftxui::Element UntrackedTab::render_row(size_t row) const {
+  using namespace ftxui;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (row >= rows_.size()) {
+    return text("");
+  }
+  const Row &entry = rows_[row];
+  std::string indent(entry.depth * 2, ' ');
+  if (!is_dir(entry.path)) {
+    return text(indent + "  " + display_name(entry.path)) |
+           color(Color::Red);
+  }
+  return hbox({
+      text(indent + (entry.open ? "- " : "+ ")) | dim,
+      text(display_name(entry.path)) | color(Color::Blue),
+  });
+}
+
+} // namespace slayergit::ui
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ui/window_tab.hpp"
+
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace slayergit::ui {
+
+// Untracked files, with untracked directories collapsed until Enter opens
+// them. Opening asks the expand callback for the directory's entries,
+// which arrive later through set_children(); Enter on an open directory
+// closes it. The listing may be replaced from a background thread.
+class UntrackedTab : public WindowTab {
+public:
+  using ExpandCallback = std::function<void(const std::string &dir)>;
+
+  explicit UntrackedTab(std::string name = "Untracked");
+
+  // Top-level entries, as UntrackedScanner::scan() lists them. Directories
+  // that were open and are still listed are opened again.
+  void set_entries(std::vector<std::string> entries);
+  // Entries inside `dir`, as UntrackedScanner::expand() lists them
+  void set_children(const std::string &dir, std::vector<std::string> children);
+
+  void set_expand_callback(ExpandCallback callback) {
+    expand_callback_ = std::move(callback);
+  }
+
+  // Shown under the list ("Loading...", error text, ...)
+  void set_status(std::string status);
+
+  [[nodiscard]] size_t row_count() const;
+  // Path of `row`; directories end with '/'
+  [[nodiscard]] std::string path_at(size_t row) const;
+
+private:
+  struct Row {
+    std::string path;
+    size_t depth = 0;
+    bool open = false;
+  };
+
+  void toggle(size_t row);
+  [[nodiscard]] ftxui::Element render_untracked() const;
+  [[nodiscard]] ftxui::Element render_row(size_t row) const;
+
+  mutable std::mutex mutex_;
+  std::vector<Row> rows_;
+  std::set<std::string> open_; // Directories to open again after a refresh
+  std::string status_;
+  ExpandCallback expand_callback_;
+};
+
+} // namespace slayergit::ui
@@ -10,6 +10,7 @@ Window::Window(std::string title) : title_(std::move(title)) {}
 void Window::add_tab(WindowTabPtr tab) {
   tabs_.push_back(std::move(tab));
   rebuild_tab_names();
+  ++version_;
 }
 
 void Window::add_tab(const std::string &name) {
@@ -23,6 +24,7 @@ void Window::remove_tab(size_t index) {
 
   tabs_.erase(tabs_.begin() + static_cast<ptrdiff_t>(index));
   rebuild_tab_names();
+  ++version_;
 
   // Adjust selected tab if necessary
   if (!tabs_.empty()) {
@@ -56,14 +58,17 @@ WindowTabPtr Window::get_current_tab() const {
 }
 
 void Window::select_tab(int index) {
-  if (index >= 0 && index < static_cast<int>(tabs_.size())) {
+  if (index >= 0 && index < static_cast<int>(tabs_.size()) &&
+      index != selected_tab_) {
     selected_tab_ = index;
+    ++version_;
   }
 }
 
 void Window::select_next_tab() {
   if (!tabs_.empty()) {
     selected_tab_ = (selected_tab_ + 1) % static_cast<int>(tabs_.size());
+    ++version_;
   }
 }
 
@@ -71,6 +76,7 @@ void Window::select_previous_tab() {
   if (!tabs_.empty()) {
     selected_tab_ = (selected_tab_ - 1 + static_cast<int>(tabs_.size())) %
                     static_cast<int>(tabs_.size());
+    ++version_;
   }
 }
 
@@ -109,16 +115,36 @@ ftxui::Component Window::create_component() {
   return Renderer(container, [this] { return render(); });
 }
 
-ftxui::Element Window::render() {
+ftxui::Element Window::render_content() {
   using namespace ftxui;
 
-  Element content;
-  if (auto current_tab = get_current_tab()) {
-    content = current_tab->render();
-  } else {
-    content = text("No tabs") | center;
+  // The menu writes selected_tab_ directly, so the tab pointer is part of
+  // the key rather than relying on version_ alone
+  auto current_tab = get_current_tab();
+  uint64_t tab_version = current_tab ? current_tab->version() : 0;
+  if (cached_content_ && cached_tab_ == current_tab.get() &&
+      cached_tab_version_ == tab_version &&
+      cached_window_version_ == version_) {
+    ++render_stats_.cache_hits;
+    return cached_content_;
   }
 
+  ++render_stats_.renders;
+  cached_content_ =
+      current_tab ? current_tab->render() : text("No tabs") | center;
+  cached_tab_ = current_tab.get();
+  cached_tab_version_ = tab_version;
+  cached_window_version_ = version_;
+  return cached_content_;
+}
+
+ftxui::Element Window::render() {
+  using namespace ftxui;
+
+  ScopedSample sample(profiler_, FrameProfiler::Metric::WindowRender);
+
+  Element content = render_content();
+
   Element tab_element = tab_toggle_ ? tab_toggle_->Render() : text("");
 
   if (is_active_) {
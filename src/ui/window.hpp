@@ -1,22 +1,44 @@
 #pragma once
 
+#include "frame_profiler.hpp"
 #include "window_tab.hpp"
 
 #include <ftxui/component/component.hpp>
 #include <ftxui/dom/elements.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace slayergit::ui {
 
+// How often a window's content had to be rebuilt versus reused
+struct RenderStats {
+  uint64_t renders = 0;
+  uint64_t cache_hits = 0;
+
+  [[nodiscard]] double hit_ratio() const {
+    uint64_t total = renders + cache_hits;
+    return total == 0 ? 0.0 : static_cast<double>(cache_hits) / total;
+  }
+
+  RenderStats &operator+=(const RenderStats &other) {
+    renders += other.renders;
+    cache_hits += other.cache_hits;
+    return *this;
+  }
+};
+
 class Window {
 public:
   explicit Window(std::string title);
 
   [[nodiscard]] const std::string &title() const { return title_; }
-  void set_title(std::string title) { title_ = std::move(title); }
+  void set_title(std::string title) {
+    title_ = std::move(title);
+    ++version_;
+  }
 
   // Tab management
   void add_tab(WindowTabPtr tab);
@@ -34,9 +56,23 @@ public:
   void select_previous_tab();
 
   // Active state
-  void set_active(bool active) { is_active_ = active; }
+  void set_active(bool active) {
+    if (active != is_active_) {
+      is_active_ = active;
+      ++version_;
+    }
+  }
   [[nodiscard]] bool is_active() const { return is_active_; }
 
+  // Bumped by focus, tab selection and tab list changes
+  [[nodiscard]] uint64_t version() const { return version_; }
+  [[nodiscard]] const RenderStats &render_stats() const {
+    return render_stats_;
+  }
+
+  // Optional; render() times itself into it when set
+  void set_profiler(FrameProfiler *profiler) { profiler_ = profiler; }
+
   // Component creation (call once)
   [[nodiscard]] ftxui::Component create_component();
 
@@ -45,6 +81,7 @@ public:
 
 private:
   void rebuild_tab_names();
+  [[nodiscard]] ftxui::Element render_content();
 
   std::string title_;
   std::vector<WindowTabPtr> tabs_;
@@ -52,6 +89,16 @@ private:
   int selected_tab_ = 0;
   bool is_active_ = false;
   ftxui::Component tab_toggle_;
+
+  // Memoized content of the current tab and the inputs it was built from.
+  // The tab bar is not cached: the animated menu must redraw every frame.
+  uint64_t version_ = 0;
+  ftxui::Element cached_content_;
+  const WindowTab *cached_tab_ = nullptr;
+  uint64_t cached_tab_version_ = 0;
+  uint64_t cached_window_version_ = 0;
+  RenderStats render_stats_;
+  FrameProfiler *profiler_ = nullptr;
 };
 
 using WindowPtr = std::shared_ptr<Window>;
@@ -5,6 +5,7 @@
 namespace slayergit::ui {
 
 void WindowManager::add_window(WindowPtr window) {
+  window->set_profiler(profiler_);
   windows_.push_back(std::move(window));
 }
 
@@ -72,6 +73,14 @@ void WindowManager::focus_previous_window() {
   }
 }
 
+RenderStats WindowManager::render_stats() const {
+  RenderStats total;
+  for (const auto &window : windows_) {
+    total += window->render_stats();
+  }
+  return total;
+}
+
 ftxui::Component WindowManager::create_component() {
   using namespace ftxui;
 
@@ -101,4 +110,11 @@ ftxui::Component WindowManager::create_component() {
   });
 }
 
+void WindowManager::set_profiler(FrameProfiler *profiler) {
+  profiler_ = profiler;
+  for (auto &window : windows_) {
+    window->set_profiler(profiler);
+  }
+}
+
 } // namespace slayergit::ui
@@ -32,10 +32,17 @@ public:
   // Component creation - creates a vertical stack of all windows
   [[nodiscard]] ftxui::Component create_component();
 
+  // Shared by all windows, including ones added later
+  void set_profiler(FrameProfiler *profiler);
+
+  // Content re-renders versus cache hits, summed over all windows
+  [[nodiscard]] RenderStats render_stats() const;
+
 private:
   std::vector<WindowPtr> windows_;
   std::vector<ftxui::Component> window_components_;
   int focused_window_ = 0;
+  FrameProfiler *profiler_ = nullptr;
 };
 
 using WindowManagerPtr = std::shared_ptr<WindowManager>;
@@ -12,6 +12,9 @@ ftxui::Element WindowTab::render() const {
   if (content_renderer_) {
     return content_renderer_();
   }
+  if (list_) {
+    return list_->render();
+  }
   return ftxui::text("Tab: " + name_) | ftxui::center;
 }
 
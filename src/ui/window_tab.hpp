@@ -1,8 +1,12 @@
 #pragma once
 
+#include "components/virtual_list.hpp"
+
 #include <ftxui/component/component.hpp>
 #include <ftxui/dom/elements.hpp>
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -17,17 +21,51 @@ public:
   WindowTab(std::string name, ContentRenderer content_renderer);
 
   [[nodiscard]] const std::string &name() const { return name_; }
-  void set_name(std::string name) { name_ = std::move(name); }
+  void set_name(std::string name) {
+    name_ = std::move(name);
+    invalidate();
+  }
 
   void set_content_renderer(ContentRenderer renderer) {
     content_renderer_ = std::move(renderer);
+    invalidate();
+  }
+
+  // Tabs that show rows attach a list; the cursor commands move its
+  // selection, and render() draws it when there is no content renderer
+  void set_list(VirtualListPtr list) {
+    list_ = std::move(list);
+    invalidate();
+  }
+  [[nodiscard]] const VirtualListPtr &list() const { return list_; }
+
+  // Enter on the tab; tabs with rows act on the selected one
+  void set_activate_callback(std::function<void()> callback) {
+    activate_callback_ = std::move(callback);
+  }
+  void activate() const {
+    if (activate_callback_) {
+      activate_callback_();
+    }
+  }
+
+  // Changes whenever render() would return something different. Windows
+  // reuse their last content Element while it stays the same.
+  [[nodiscard]] uint64_t version() const {
+    return version_.load() + (list_ ? list_->version() : 0);
   }
+  // Call after changing anything the content renderer reads; safe from
+  // any thread
+  void invalidate() { ++version_; }
 
   [[nodiscard]] ftxui::Element render() const;
 
 private:
   std::string name_;
   ContentRenderer content_renderer_;
+  VirtualListPtr list_;
+  std::function<void()> activate_callback_;
+  std::atomic<uint64_t> version_{0};
 };
 
 using WindowTabPtr = std::shared_ptr<WindowTab>;